@@ -13,19 +13,17 @@
 #  See the License for the specific language governing permissions and
 #  limitations under the License.
 
-# Check for the presence of AVX and figure out the flags to use for it.
+# Check whether the compiler can build the AVX, AVX2 and AVX512F kernels. (Whether the CPU supports
+# these instruction sets is checked at runtime, so the kernels are only compiled here, not run.)
 macro(CHECK_FOR_AVX)
 
-    include(CheckCXXSourceRuns)
+    include(CheckCXXSourceCompiles)
     set(CMAKE_REQUIRED_FLAGS)
     
     # Check AVX
     # Identify the compiler type and set compiler specific options
-    if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
-      # using Clang
-
-    elseif (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
-      # using GCC
+    if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+      # using Clang or GCC
       set(CMAKE_REQUIRED_FLAGS "-mavx")
 
     elseif (CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
@@ -39,7 +37,7 @@ macro(CHECK_FOR_AVX)
 
 
 
-    check_cxx_source_runs("
+    check_cxx_source_compiles("
         #include <immintrin.h>
         int main()
         {
@@ -66,23 +64,20 @@ macro(CHECK_FOR_AVX)
 
     # Check AVX2
     # Identify the compiler type and set compiler specific options
-    if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
-      # using Clang
-
-    elseif (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
-      # using GCC
-      set(CMAKE_REQUIRED_FLAGS "-mavx2")
+    if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+      # using Clang or GCC
+      set(CMAKE_REQUIRED_FLAGS "-mavx2 -mfma")
 
     elseif (CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
       # using Intel C++
-      set(CMAKE_REQUIRED_FLAGS "-mavx2")
+      set(CMAKE_REQUIRED_FLAGS "-mavx2 -mfma")
 
     elseif (CMAKE_CXX_COMPILER_ID STREQUAL "MSVC")
       # using Visual Studio C++
       set(CMAKE_REQUIRED_FLAGS "/arch:AVX2")
     endif()
 
-    check_cxx_source_runs("
+    check_cxx_source_compiles("
         #include <immintrin.h>
         int main()
         {
@@ -105,49 +100,44 @@ macro(CHECK_FOR_AVX)
         HAVE_AVX2_EXTENSIONS)
 
 
-    if (DEFINED ENV{USE_AVX512})
-        # Check AVX512F instruction set
-        # Identify the compiler type and set compiler specific options
-        if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang")
-          # using Clang
-
-        elseif (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
-          # using GCC
-          set(CMAKE_REQUIRED_FLAGS "-mavx512f")
-
-        elseif (CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
-          # using Intel C++
-          set(CMAKE_REQUIRED_FLAGS "-mavx512f")
-
-        elseif (CMAKE_CXX_COMPILER_ID STREQUAL "MSVC")
-          # using Visual Studio C++
-          set(CMAKE_REQUIRED_FLAGS "/arch:AVX512F")
-        endif()
-
-        check_cxx_source_runs("
-            #include <immintrin.h>
-            int main()
-            {
-
-              __m512d a, b, c;
-              const double src[8] = { 1.0D, 2.0D, 3.0D, 4.0D, 1.0D, 2.0D, 3.0D, 4.0D };
-              double dst[8];
-              a = _mm512_loadu_pd( src );
-              b = _mm512_loadu_pd( src );
-              c = _mm512_add_pd( a, b );
-              _mm512_storeu_pd( dst, c );
-
-              for( int i = 0; i < 8; i++ ){
-                if( ( src[i] + src[i] ) != dst[i] ){
-                  return -1;
-                }
-              }
-
-              return 0;
-            }"
-            HAVE_AVX512F_EXTENSIONS)
+    # Check AVX512F instruction set
+    # Identify the compiler type and set compiler specific options
+    if (CMAKE_CXX_COMPILER_ID STREQUAL "Clang" OR CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+      # using Clang or GCC
+      set(CMAKE_REQUIRED_FLAGS "-mavx512f -mfma")
+
+    elseif (CMAKE_CXX_COMPILER_ID STREQUAL "Intel")
+      # using Intel C++
+      set(CMAKE_REQUIRED_FLAGS "-mavx512f -mfma")
+
+    elseif (CMAKE_CXX_COMPILER_ID STREQUAL "MSVC")
+      # using Visual Studio C++
+      set(CMAKE_REQUIRED_FLAGS "/arch:AVX512")
     endif()
 
+    check_cxx_source_compiles("
+        #include <immintrin.h>
+        int main()
+        {
+
+          __m512d a, b, c;
+          const double src[8] = { 1.0D, 2.0D, 3.0D, 4.0D, 1.0D, 2.0D, 3.0D, 4.0D };
+          double dst[8];
+          a = _mm512_loadu_pd( src );
+          b = _mm512_loadu_pd( src );
+          c = _mm512_add_pd( a, b );
+          _mm512_storeu_pd( dst, c );
+
+          for( int i = 0; i < 8; i++ ){
+            if( ( src[i] + src[i] ) != dst[i] ){
+              return -1;
+            }
+          }
+
+          return 0;
+        }"
+        HAVE_AVX512F_EXTENSIONS)
+
 
 
 
@@ -22,258 +22,322 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 */
 
 #include "Adam.h"
-#include "tbb/tbb.h"
 
 #include <cfloat>	
+#include <cstring>
+
+#ifdef USE_AVX
+#include <emmintrin.h>
+#endif
+
+
+/// @brief Structure containing the coefficients of one step of the Adam algorithm
+struct Adam_Step_Coefficients {
+
+    /// parameter beta1 of the Adam algorithm
+    double beta1;
+    /// parameter beta2 of the Adam algorithm
+    double beta2;
+    /// bias correction of the momentum 1/(1-beta1^t)
+    double mom_correction;
+    /// bias correction of the variance 1/(1-beta2^t)
+    double var_correction;
+    /// the learning rate
+    double eta;
+    /// the regularization parameter
+    double epsilon;
+    /// the coefficient of the weight decay
+    double weight_decay;
+
+};
+
+
+/**
+@brief Fused kernel of the Adam algorithm updating the momentum, the variance and the parameters in a single pass over the parameter range [start, end).
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function
+@param mom The momentum
+@param var The variance
+@param var_max The maximum of the variances in the previous steps (used only in the AMSGrad variant)
+@param start The first parameter index to be updated
+@param end The parameter index after the last one to be updated
+@param coeffs The coefficients of the step
+@return Returns with the sum of the updated variance elements
+*/
+template<bool amsgrad>
+static double
+adam_update_kernel( double* __restrict parameters, const double* __restrict grad, double* __restrict mom, double* __restrict var, double* __restrict var_max, const int start, const int end, const Adam_Step_Coefficients& coeffs ) {
+
+    double var_sum = 0.0;
+    int idx = start;
+
+#ifdef USE_AVX
+
+    __m128d beta1_128 = _mm_set1_pd( coeffs.beta1 );
+    __m128d beta1_complement_128 = _mm_set1_pd( 1.0-coeffs.beta1 );
+    __m128d beta2_128 = _mm_set1_pd( coeffs.beta2 );
+    __m128d beta2_complement_128 = _mm_set1_pd( 1.0-coeffs.beta2 );
+    __m128d mom_correction_128 = _mm_set1_pd( coeffs.mom_correction );
+    __m128d var_correction_128 = _mm_set1_pd( coeffs.var_correction );
+    __m128d eta_128 = _mm_set1_pd( coeffs.eta );
+    __m128d epsilon_128 = _mm_set1_pd( coeffs.epsilon );
+    __m128d weight_decay_128 = _mm_set1_pd( coeffs.weight_decay );
+    __m128d var_sum_128 = _mm_setzero_pd();
+
+    for ( ; idx+1<end; idx=idx+2 ) {
+
+        __m128d grad_128 = _mm_loadu_pd( grad+idx );
+
+        __m128d mom_128 = _mm_add_pd( _mm_mul_pd(beta1_128, _mm_loadu_pd(mom+idx)), _mm_mul_pd(beta1_complement_128, grad_128) );
+        __m128d var_128 = _mm_add_pd( _mm_mul_pd(beta2_128, _mm_loadu_pd(var+idx)), _mm_mul_pd(beta2_complement_128, _mm_mul_pd(grad_128, grad_128)) );
+        _mm_storeu_pd( mom+idx, mom_128 );
+        _mm_storeu_pd( var+idx, var_128 );
+        var_sum_128 = _mm_add_pd( var_sum_128, var_128 );
+
+        if ( amsgrad ) {
+            var_128 = _mm_max_pd( _mm_loadu_pd(var_max+idx), var_128 );
+            _mm_storeu_pd( var_max+idx, var_128 );
+        }
+
+        // bias corrected step
+        __m128d denominator_128 = _mm_add_pd( _mm_sqrt_pd(_mm_mul_pd(var_128, var_correction_128)), epsilon_128 );
+        __m128d parameters_128 = _mm_loadu_pd( parameters+idx );
+        __m128d step_128 = _mm_add_pd( _mm_div_pd(_mm_mul_pd(mom_128, mom_correction_128), denominator_128), _mm_mul_pd(weight_decay_128, parameters_128) );
+        _mm_storeu_pd( parameters+idx, _mm_sub_pd(parameters_128, _mm_mul_pd(eta_128, step_128)) );
+
+    }
+
+    double var_sum_tmp[2];
+    _mm_storeu_pd( var_sum_tmp, var_sum_128 );
+    var_sum = var_sum_tmp[0] + var_sum_tmp[1];
+
+#endif
+
+    for ( ; idx<end; idx++ ) {
+
+        mom[idx] = coeffs.beta1 * mom[idx] + (1-coeffs.beta1) * grad[idx];
+        var[idx] = coeffs.beta2 * var[idx] + (1-coeffs.beta2) * grad[idx] * grad[idx];
+        var_sum = var_sum + var[idx];
+
+        double var_loc = var[idx];
+        if ( amsgrad ) {
+            var_loc = var_max[idx] > var_loc ? var_max[idx] : var_loc;
+            var_max[idx] = var_loc;
+        }
+
+        // bias corrected step
+        double step = mom[idx]*coeffs.mom_correction/(std::sqrt(var_loc*coeffs.var_correction) + coeffs.epsilon) + coeffs.weight_decay*parameters[idx];
+        parameters[idx] = parameters[idx] - coeffs.eta * step;
+
+    }
+
+    return var_sum;
+
+}
+
+
 
 /** Nullary constructor of the class
 @return An instance of the class
 */
-Adam::Adam() {
+Adam::Adam() : Optimizer_Base( 0.001 ) {
 
     beta1 = 0.68;
     beta2 = 0.8;
     epsilon = 1e-4;
-    eta = 0.001;
-
 
+    amsgrad = false;
+    weight_decay = 0.0;
 
     reset();
-	
-#if CBLAS==1
-    num_threads = mkl_get_max_threads();
-#elif CBLAS==2
-    num_threads = openblas_get_num_threads();
-#endif
 
 }
 
 
 /** Contructor of the class
 @brief Constructor of the class.
-@param ???????????????????????????????
-@param ???????????????????????????????
-@param ???????????????????????????????
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
 @return An instance of the class
 */
-Adam::Adam( double beta1_in, double beta2_in, double epsilon_in, double eta_in ) {
+Adam::Adam( double beta1_in, double beta2_in, double epsilon_in, double eta_in ) : Optimizer_Base( eta_in ) {
 
-   
     beta1 = beta1_in;
     beta2 = beta2_in;
     epsilon = epsilon_in;
-    eta = eta_in;
 
+    amsgrad = false;
+    weight_decay = 0.0;
 
     reset();
 
-
-#if CBLAS==1
-    num_threads = mkl_get_max_threads();
-#elif CBLAS==2
-    num_threads = openblas_get_num_threads();
-#endif
-
 }
 
+
 /**
 @brief Destructor of the class
 */
-
 Adam::~Adam() {
 }
 
 
 
 /**
-@brief ?????????????
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
 */
 void Adam::reset() {
 
-
-    mom = Matrix_real(0,0);
-    var = Matrix_real(0,0);
+    Optimizer_Base::reset();
 
     iter_t = 0;
     beta1_t = 1.0;
     beta2_t = 1.0;
+    var_sum = 0.0;
 
-    // vector stroing the lates values of cost function to test local minimum
-    f0_vec = Matrix_real(1, 100); 
-    memset( f0_vec.get_data(), 0.0, f0_vec.size()*sizeof(double) );
-    f0_mean = 0.0;
-    f0_idx = 0;
-    
-    
-    // decreasing_test
-    decreasing_vec = matrix_base<int>(1, 20); 
-    memset( decreasing_vec.get_data(), -1, decreasing_vec.size()*sizeof(int) );
-    decreasing_idx = 0;
-    decreasing_test = -1.0;  
-    
-    // previous value of the cost function
-    f0_prev = DBL_MAX;  
-
+    memset( mom.get_data(), 0.0, mom.size()*sizeof(double) );
+    memset( var.get_data(), 0.0, var.size()*sizeof(double) );
+    memset( var_max.get_data(), 0.0, var_max.size()*sizeof(double) );
 
 }
 
 
 /**
-@brief ?????????????
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
 */
-void Adam::initialize_moment_and_variance(int parameter_num) {
+void Adam::initialize( int parameter_num_in ) {
 
-    mom = Matrix_real(parameter_num,1);
-    var = Matrix_real(parameter_num,1);  
+    Optimizer_Base::initialize( parameter_num_in );
+
+    if ( mom.size() != parameter_num_in ) {
+        mom = Matrix_real(parameter_num_in,1);
+        var = Matrix_real(parameter_num_in,1);
+        if ( amsgrad ) {
+            var_max = Matrix_real(parameter_num_in,1);
+        }
+    }
 
+    var_sum = 0.0;
     memset( mom.get_data(), 0.0, mom.size()*sizeof(double) );
     memset( var.get_data(), 0.0, var.size()*sizeof(double) );
+    memset( var_max.get_data(), 0.0, var_max.size()*sizeof(double) );
+
 }
 
 
 /**
-@brief Call to set the number of gate blocks to be optimized in one shot
-@param optimization_block_in The number of gate blocks to be optimized in one shot
-@return 0 optimizer is in decreasing stage, 1 converged to local minumum
+@brief Call to allocate and zero the momentum and the variance of the Adam algorithm. (Same as initialize)
+@param parameter_num The number of parameters to be optimized
 */
-int Adam::update( Matrix_real& parameters, Matrix_real& grad, const double& f0 ) {
-
-    int parameter_num = parameters.size();
-    if ( parameter_num != grad.size() ) {
-        std::string error("Adam::update: number of parameters shoulod be equal to the number of elements in gradient vector");
-        throw error;
-    }
-
-    if ( mom.size() == 0 ) {
-        initialize_moment_and_variance( parameter_num );
-    }
-
-    if ( parameter_num != mom.size() ) {
-        std::string error("Adam::update: number of parameters shoulod be equal to the number of elements in momentum vector");
-        throw error;
-    }
+void Adam::initialize_moment_and_variance(int parameter_num) {
 
+    initialize( parameter_num );
 
-    // test local minimum convergence
-    f0_mean = f0_mean + (f0 - f0_vec[ f0_idx ])/f0_vec.size();
-    f0_vec[ f0_idx ] = f0;
-    f0_idx = (f0_idx + 1) % f0_vec.size();
-    
-    double var_f0 = 0.0;
-    for (int idx=0; idx<f0_vec.size(); idx++) {
-       var_f0 = var_f0 + (f0_vec[idx]-f0_mean)*(f0_vec[idx]-f0_mean);
-    }
-    var_f0 = std::sqrt(var_f0)/f0_vec.size();
+}
 
 
-    if ( f0 < f0_prev ) {
-        if ( decreasing_vec[ decreasing_idx ] == 1 ) {
-            // the decresing test did not changed
-        }
-        else {
-            // element in decreasing vec changed from -1 to 1
-            decreasing_test = decreasing_test + 2.0/decreasing_vec.size();
-        }
+/**
+@brief Call to get the regularization parameter of the current step (reduced on barren plateaus) and to advance the bias corrections to the current step.
+@return Returns with the regularization parameter
+*/
+double Adam::prepare_step() {
 
-        decreasing_vec[ decreasing_idx ] = 1;
-    }
-    else {
-        if ( decreasing_vec[ decreasing_idx ] == 1 ) {
-            // element in decreasing vec changed from 1 to -1
-            decreasing_test = decreasing_test - 2.0/decreasing_vec.size();
-        }
-        else {
-            // the decresing test did not changed
-        }
+    // test barren plateau on the variance of the previous step
+    bool barren_plateau = var_sum < epsilon && decreasing_test > 0.7;
 
-        decreasing_vec[ decreasing_idx ] = -1;
-    }
+    iter_t++;
+    beta1_t = beta1_t * beta1;
+    beta2_t = beta2_t * beta2;
 
+    return barren_plateau ? epsilon/100 : epsilon;
 
-    decreasing_idx = (decreasing_idx + 1) % decreasing_vec.size();
+}
 
-    f0_prev = f0;
 
+/**
+@brief Call to update the parameters from the gradient. The momentum, the variance and the parameters are updated in a single pass.
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+*/
+void Adam::update_parameters( Matrix_real& parameters, Matrix_real& grad ) {
 
+    Adam_Step_Coefficients coeffs;
+    coeffs.epsilon = prepare_step();
+    coeffs.beta1 = beta1;
+    coeffs.beta2 = beta2;
+    coeffs.mom_correction = 1.0/(1.0-beta1_t);
+    coeffs.var_correction = 1.0/(1.0-beta2_t);
+    coeffs.eta = eta;
+    coeffs.weight_decay = weight_decay;
 
+    double* param_data = parameters.get_data();
+    double* grad_data = grad.get_data();
+    double* mom_data = mom.get_data();
+    double* var_data = var.get_data();
+    double* var_max_data = var_max.get_data();
 
-    // test barren plateau
-    double grad_var = 0.0;
-    for( int idx=0; idx<parameter_num; idx++ ) {
-        grad_var += var[idx];
-    }   
-        
-    int barren_plateau = 0;
-    if ( grad_var < epsilon && decreasing_test > 0.7  ) {   
-        // barren plateau
-        barren_plateau = 1;
+    if ( amsgrad ) {
+        var_sum = run_update_kernel( [&](int start, int end) {
+            return adam_update_kernel<true>( param_data, grad_data, mom_data, var_data, var_max_data, start, end, coeffs );
+        });
+    }
+    else {
+        var_sum = run_update_kernel( [&](int start, int end) {
+            return adam_update_kernel<false>( param_data, grad_data, mom_data, var_data, var_max_data, start, end, coeffs );
+        });
     }
 
-     
-    double* mom_data = mom.get_data();
-    double* var_data = var.get_data();
-    double* grad_data = grad.get_data();
-    double* param_data = parameters.get_data();
+}
 
-tbb::task_arena ta(4);
-ta.execute( [&](){
-    tbb::parallel_for( 0, parameter_num, 1, [&](int idx) {
-    //for (int idx=0; idx<parameter_num; idx++) {
-        mom_data[idx] = beta1 * mom_data[idx] + (1-beta1) * grad_data[idx];
-        var_data[idx] = beta2 * var_data[idx] + (1-beta2) * grad_data[idx] * grad_data[idx];
 
-        // bias correction step
-        beta1_t = beta1_t * beta1;
-        double mom_bias_corr = mom_data[idx]/(1-beta1_t);
 
-        beta2_t = beta2_t * beta2;
-        double var_bias_corr = var_data[idx]/(1-beta2_t);
+/** Nullary constructor of the class
+@return An instance of the class
+*/
+AMSGrad::AMSGrad() : Adam() {
 
-        // update parameters
-        if ( barren_plateau ) {
-            param_data[idx] = param_data[idx] - eta * mom_bias_corr/(sqrt(var_bias_corr) + epsilon/100);
-        }
-        else {
-            param_data[idx] = param_data[idx] - eta * mom_bias_corr/(sqrt(var_bias_corr) + epsilon);
-        }
-        /*
-        if ( std::abs(eta * mom_bias_corr/(sqrt(var_bias_corr) + epsilon)) > 1e-3 ) {
-            std::cout << std::abs(eta * mom_bias_corr/(sqrt(var_bias_corr) + epsilon)) << std::endl;
-        }
-        */
-        
-    //}
-    });
+    amsgrad = true;
 
-});
+}
 
 
-    iter_t++;
+/** Contructor of the class
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
+@return An instance of the class
+*/
+AMSGrad::AMSGrad( double beta1_in, double beta2_in, double epsilon_in, double eta_in ) : Adam( beta1_in, beta2_in, epsilon_in, eta_in ) {
 
+    amsgrad = true;
 
+}
 
-    int ADAM_status = 0;
-    if ( std::abs( f0_mean - f0) < 1e-6 && decreasing_test <= 0.7 && var_f0/f0_mean < 1e-6 ) {
-        // local minimum
-        ADAM_status = 1;
-    }
-    else {
-        ADAM_status = 0;
-    }    
 
-    return ADAM_status;
 
+/** Nullary constructor of the class
+@return An instance of the class
+*/
+AdamW::AdamW() : Adam() {
 
+    weight_decay = 1e-4;
 
 }
 
 
-/**
-@brief ?????????????
+/** Contructor of the class
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
+@param weight_decay_in The coefficient of the weight decay
+@return An instance of the class
 */
-double Adam::get_decreasing_test() {
+AdamW::AdamW( double beta1_in, double beta2_in, double epsilon_in, double eta_in, double weight_decay_in ) : Adam( beta1_in, beta2_in, epsilon_in, eta_in ) {
 
-    return decreasing_test;
+    weight_decay = weight_decay_in;
 
 }
-
@@ -0,0 +1,308 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file LBFGS.cpp
+    \brief A class implementing the limited memory BFGS optimization algorithm with a batched backtracking line search.
+*/
+
+#include "LBFGS.h"
+
+#include <cfloat>
+#include <cstring>
+
+
+/// The parameter of the sufficient decrease (Armijo) condition of the line search
+static const double sufficient_decrease_coeff = 1e-4;
+/// The longest trial step length of the line search (in units of the quasi-Newton step)
+static const double max_step_length = 2.0;
+/// The maximal number of batches of trial step lengths evaluated in one line search
+static const int line_search_round_max = 8;
+
+
+/**
+@brief Call to calculate the scalar product of two vectors
+@param a Pointer to the first vector
+@param b Pointer to the second vector
+@param size The number of elements in the vectors
+@return Returns with the scalar product
+*/
+static inline double
+scalar_product( const double* a, const double* b, const int size ) {
+
+    double ret = 0.0;
+    for (int idx=0; idx<size; idx++) {
+        ret = ret + a[idx]*b[idx];
+    }
+
+    return ret;
+
+}
+
+
+/**
+@brief Constructor of the class.
+@param parameter_num_in The number of free parameters
+@param cost_and_gradient_in Function to calculate the cost function and its gradient
+@param batched_cost_in Function to calculate the cost function for a batch of parameter vectors
+@param meta_data_in Pointer passed to the cost functions
+@param history_length_in The maximal number of correction pairs stored in the history
+@param trial_num_in The number of trial step lengths evaluated together in the line search
+@return An instance of the class
+*/
+LBFGS::LBFGS( int parameter_num_in, lbfgs_cost_and_gradient_function cost_and_gradient_in, lbfgs_batched_cost_function batched_cost_in, void* meta_data_in, int history_length_in, int trial_num_in ) {
+
+    if ( parameter_num_in <= 0 || history_length_in <= 0 || trial_num_in <= 0 ) {
+        std::string error("LBFGS::LBFGS: the number of parameters, the history length and the number of trial steps should be positive");
+        throw error;
+    }
+
+    parameter_num = parameter_num_in;
+    history_length = history_length_in;
+    trial_num = trial_num_in;
+
+    cost_and_gradient = cost_and_gradient_in;
+    batched_cost = batched_cost_in;
+    meta_data = meta_data_in;
+
+    x = Matrix_real(1, parameter_num);
+    grad = Matrix_real(1, parameter_num);
+    f = DBL_MAX;
+
+    direction = Matrix_real(1, parameter_num);
+    x_new = Matrix_real(1, parameter_num);
+    grad_new = Matrix_real(1, parameter_num);
+    trial_parameters = Matrix_real(trial_num, parameter_num);
+
+    s_history = Matrix_real(history_length, parameter_num);
+    y_history = Matrix_real(history_length, parameter_num);
+    rho_history = Matrix_real(1, history_length);
+    alpha = Matrix_real(1, history_length);
+
+    memset( x.get_data(), 0.0, x.size()*sizeof(double) );
+    memset( grad.get_data(), 0.0, grad.size()*sizeof(double) );
+
+    history_num = 0;
+    history_idx = 0;
+
+}
+
+
+/**
+@brief Destructor of the class
+*/
+LBFGS::~LBFGS() {
+}
+
+
+/**
+@brief Call to (re)start the optimization from the given parameters. The history of the previous iterations is discarded.
+@param parameters The starting parameters
+*/
+void LBFGS::set( const Matrix_real& parameters ) {
+
+    if ( parameters.size() != parameter_num ) {
+        std::string error("LBFGS::set: the number of parameters should be equal to the number of parameters given in the constructor");
+        throw error;
+    }
+
+    memcpy( x.get_data(), parameters.get_data(), parameter_num*sizeof(double) );
+    cost_and_gradient( x, meta_data, &f, grad );
+
+    history_num = 0;
+    history_idx = 0;
+
+}
+
+
+/**
+@brief Call to calculate the search direction from the gradient and the stored correction pairs via the two loop recursion.
+*/
+void LBFGS::calculate_direction() {
+
+    double* q = direction.get_data();
+    for (int idx=0; idx<parameter_num; idx++) {
+        q[idx] = -grad[idx];
+    }
+
+    if ( history_num == 0 ) {
+        return;
+    }
+
+    // from the latest correction pair to the oldest one
+    for (int jdx=0; jdx<history_num; jdx++) {
+        int row = (history_idx - 1 - jdx + history_length) % history_length;
+        double* s = s_history.get_data() + row*s_history.stride;
+        double* y = y_history.get_data() + row*y_history.stride;
+
+        alpha[row] = rho_history[row]*scalar_product( s, q, parameter_num );
+        for (int idx=0; idx<parameter_num; idx++) {
+            q[idx] = q[idx] - alpha[row]*y[idx];
+        }
+    }
+
+    // scaling of the initial Hessian approximation by the latest correction pair
+    int latest = (history_idx - 1 + history_length) % history_length;
+    double* y_latest = y_history.get_data() + latest*y_history.stride;
+    double gamma = 1.0/(rho_history[latest]*scalar_product( y_latest, y_latest, parameter_num ));
+    for (int idx=0; idx<parameter_num; idx++) {
+        q[idx] = gamma*q[idx];
+    }
+
+    // from the oldest correction pair to the latest one
+    for (int jdx=history_num-1; jdx>=0; jdx--) {
+        int row = (history_idx - 1 - jdx + history_length) % history_length;
+        double* s = s_history.get_data() + row*s_history.stride;
+        double* y = y_history.get_data() + row*y_history.stride;
+
+        double beta = rho_history[row]*scalar_product( y, q, parameter_num );
+        for (int idx=0; idx<parameter_num; idx++) {
+            q[idx] = q[idx] + (alpha[row]-beta)*s[idx];
+        }
+    }
+
+}
+
+
+/**
+@brief Call to perform one iteration of the optimization.
+@return Returns with 0 if the cost function was decreased, and with 1 if the cost function could not be decreased beyond its rounding error along the search direction.
+*/
+int LBFGS::iterate() {
+
+    calculate_direction();
+    double slope = scalar_product( direction.get_data(), grad.get_data(), parameter_num );
+
+    // the history is discarded if the quasi-Newton direction does not point downhill
+    if ( slope >= 0.0 && history_num > 0 ) {
+        history_num = 0;
+        history_idx = 0;
+        calculate_direction();
+        slope = scalar_product( direction.get_data(), grad.get_data(), parameter_num );
+    }
+
+    if ( slope >= 0.0 ) {
+        return 1;
+    }
+
+    // backtracking line search: the trial step lengths step, step/2, ..., step/2^(trial_num-1) are evaluated together
+    double step = max_step_length;
+    int accepted = -1;
+    for (int round=0; round<line_search_round_max && accepted<0; round++) {
+
+        double step_loc = step;
+        for (int tdx=0; tdx<trial_num; tdx++) {
+            double* trial = trial_parameters.get_data() + tdx*trial_parameters.stride;
+            for (int idx=0; idx<parameter_num; idx++) {
+                trial[idx] = x[idx] + step_loc*direction[idx];
+            }
+            step_loc = 0.5*step_loc;
+        }
+
+        Matrix_real costs = batched_cost( trial_parameters, meta_data );
+
+        // the lowest cost function satisfying the sufficient decrease condition is accepted
+        step_loc = step;
+        for (int tdx=0; tdx<trial_num; tdx++) {
+            if ( costs[tdx] <= f + sufficient_decrease_coeff*step_loc*slope && (accepted < 0 || costs[tdx] < costs[accepted]) ) {
+                accepted = tdx;
+            }
+            step_loc = 0.5*step_loc;
+        }
+
+        step = step_loc;
+    }
+
+    if ( accepted < 0 ) {
+        return 1;
+    }
+
+    double f_new;
+    memcpy( x_new.get_data(), trial_parameters.get_data() + accepted*trial_parameters.stride, parameter_num*sizeof(double) );
+    cost_and_gradient( x_new, meta_data, &f_new, grad_new );
+
+    // store the new correction pair if it keeps the Hessian approximation positive definite
+    double* s = s_history.get_data() + history_idx*s_history.stride;
+    double* y = y_history.get_data() + history_idx*y_history.stride;
+    for (int idx=0; idx<parameter_num; idx++) {
+        s[idx] = x_new[idx] - x[idx];
+        y[idx] = grad_new[idx] - grad[idx];
+    }
+
+    double sy = scalar_product( s, y, parameter_num );
+    double yy = scalar_product( y, y, parameter_num );
+    if ( sy > DBL_EPSILON*yy ) {
+        rho_history[history_idx] = 1.0/sy;
+        history_idx = (history_idx + 1) % history_length;
+        history_num = history_num < history_length ? history_num + 1 : history_length;
+    }
+
+    // a decrease comparable to the rounding error of the cost function means that a local minimum is reached
+    bool progress = f - f_new > DBL_EPSILON*std::fabs(f);
+
+    memcpy( x.get_data(), x_new.get_data(), parameter_num*sizeof(double) );
+    memcpy( grad.get_data(), grad_new.get_data(), parameter_num*sizeof(double) );
+    f = f_new;
+
+    return progress ? 0 : 1;
+
+}
+
+
+/**
+@brief Call to get the cost function at the current parameters
+@return Returns with the cost function
+*/
+double LBFGS::get_f() {
+
+    return f;
+
+}
+
+
+/**
+@brief Call to get the current parameters
+@return Returns with the parameters (the data is owned by the optimizer)
+*/
+Matrix_real LBFGS::get_x() {
+
+    return x;
+
+}
+
+
+/**
+@brief Call to get the gradient of the cost function at the current parameters
+@return Returns with the gradient (the data is owned by the optimizer)
+*/
+Matrix_real LBFGS::get_gradient() {
+
+    return grad;
+
+}
+
+
+/**
+@brief Call to get the euclidean norm of the gradient at the current parameters
+@return Returns with the norm of the gradient
+*/
+double LBFGS::get_gradient_norm() {
+
+    return std::sqrt( scalar_product( grad.get_data(), grad.get_data(), parameter_num ) );
+
+}
@@ -0,0 +1,113 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file Momentum_SGD.cpp
+    \brief A class implementing the stochastic gradient descent optimization with momentum.
+*/
+
+#include "Momentum_SGD.h"
+
+#include <cstring>
+
+
+/** Nullary constructor of the class
+@return An instance of the class
+*/
+Momentum_SGD::Momentum_SGD() : Optimizer_Base( 0.001 ) {
+
+    momentum = 0.9;
+
+}
+
+
+/** Contructor of the class
+@param momentum_in The momentum parameter
+@param eta_in The learning rate
+@return An instance of the class
+*/
+Momentum_SGD::Momentum_SGD( double momentum_in, double eta_in ) : Optimizer_Base( eta_in ) {
+
+    momentum = momentum_in;
+
+}
+
+
+/**
+@brief Destructor of the class
+*/
+Momentum_SGD::~Momentum_SGD() {
+}
+
+
+/**
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
+*/
+void Momentum_SGD::reset() {
+
+    Optimizer_Base::reset();
+
+    memset( velocity.get_data(), 0.0, velocity.size()*sizeof(double) );
+
+}
+
+
+/**
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
+*/
+void Momentum_SGD::initialize( int parameter_num_in ) {
+
+    Optimizer_Base::initialize( parameter_num_in );
+
+    if ( velocity.size() != parameter_num_in ) {
+        velocity = Matrix_real(parameter_num_in,1);
+    }
+
+    memset( velocity.get_data(), 0.0, velocity.size()*sizeof(double) );
+
+}
+
+
+/**
+@brief Call to update the parameters from the gradient. The velocity and the parameters are updated in a single pass.
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+*/
+void Momentum_SGD::update_parameters( Matrix_real& parameters, Matrix_real& grad ) {
+
+    double* __restrict param_data = parameters.get_data();
+    const double* __restrict grad_data = grad.get_data();
+    double* __restrict velocity_data = velocity.get_data();
+
+    double momentum_loc = momentum;
+    double eta_loc = eta;
+
+    run_update_kernel( [&](int start, int end) {
+
+        // branch free loop vectorized by the compiler
+        for (int idx=start; idx<end; idx++) {
+            velocity_data[idx] = momentum_loc*velocity_data[idx] + grad_data[idx];
+            param_data[idx] = param_data[idx] - eta_loc*velocity_data[idx];
+        }
+
+        return 0.0;
+
+    });
+
+}
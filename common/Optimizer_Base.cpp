@@ -0,0 +1,184 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file Optimizer_Base.cpp
+    \brief Base class of the first order gradient based optimizers.
+*/
+
+#include "Optimizer_Base.h"
+
+#include <cfloat>
+#include <cstring>
+
+
+/** Constructor of the class
+@param eta_in The learning rate
+@return An instance of the class
+*/
+Optimizer_Base::Optimizer_Base( double eta_in ) {
+
+    eta = eta_in;
+    parameter_num = 0;
+
+    // vector stroing the lates values of cost function to test local minimum
+    f0_vec = Matrix_real(1, 100); 
+
+    // decreasing_test
+    decreasing_vec = matrix_base<int>(1, 20); 
+
+    Optimizer_Base::reset();
+
+}
+
+
+/**
+@brief Destructor of the class
+*/
+Optimizer_Base::~Optimizer_Base() {
+}
+
+
+/**
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
+*/
+void Optimizer_Base::reset() {
+
+    memset( f0_vec.get_data(), 0.0, f0_vec.size()*sizeof(double) );
+    f0_mean = 0.0;
+    f0_square_sum = 0.0;
+    f0_idx = 0;
+    
+    memset( decreasing_vec.get_data(), -1, decreasing_vec.size()*sizeof(int) );
+    decreasing_idx = 0;
+    decreasing_test = -1.0;  
+    
+    // previous value of the cost function
+    f0_prev = DBL_MAX;  
+
+}
+
+
+/**
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
+*/
+void Optimizer_Base::initialize( int parameter_num_in ) {
+
+    if ( parameter_num != parameter_num_in || partial_sums.size() == 0 ) {
+        parameter_num = parameter_num_in;
+        int chunk_num = parameter_num/OPTIMIZER_PARALLEL_MIN_PARAMETERS;
+        partial_sums = Matrix_real(1, chunk_num > 0 ? chunk_num : 1);
+    }
+
+}
+
+
+/**
+@brief Call to perform one step of the optimization
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+@param f0 The cost function at the parameters
+@return 0 optimizer is in decreasing stage, 1 converged to local minumum
+*/
+int Optimizer_Base::update( Matrix_real& parameters, Matrix_real& grad, const double& f0 ) {
+
+    int parameter_num_loc = parameters.size();
+    if ( parameter_num_loc != grad.size() ) {
+        std::string error("Optimizer_Base::update: number of parameters shoulod be equal to the number of elements in gradient vector");
+        throw error;
+    }
+
+    if ( parameter_num == 0 ) {
+        initialize( parameter_num_loc );
+    }
+
+    if ( parameter_num_loc != parameter_num ) {
+        std::string error("Optimizer_Base::update: number of parameters shoulod be equal to the number of parameters of the optimizer");
+        throw error;
+    }
+
+
+    // test local minimum convergence (the mean and the variance of the latest cost function values are updated incrementally)
+    int window_size = f0_vec.size();
+    double f0_old = f0_vec[ f0_idx ];
+    f0_mean = f0_mean + (f0 - f0_old)/window_size;
+    f0_square_sum = f0_square_sum + f0*f0 - f0_old*f0_old;
+    f0_vec[ f0_idx ] = f0;
+    f0_idx = (f0_idx + 1) % window_size;
+
+    // the rounding errors of the incremental update are cleared after each cycle over the window
+    if ( f0_idx == 0 ) {
+        f0_mean = 0.0;
+        f0_square_sum = 0.0;
+        for (int idx=0; idx<window_size; idx++) {
+            f0_mean = f0_mean + f0_vec[idx];
+            f0_square_sum = f0_square_sum + f0_vec[idx]*f0_vec[idx];
+        }
+        f0_mean = f0_mean/window_size;
+    }
+
+    double var_f0 = f0_square_sum - window_size*f0_mean*f0_mean;
+    var_f0 = var_f0 > 0.0 ? std::sqrt(var_f0)/window_size : 0.0;
+
+
+    if ( f0 < f0_prev ) {
+        if ( decreasing_vec[ decreasing_idx ] != 1 ) {
+            // element in decreasing vec changed from -1 to 1
+            decreasing_test = decreasing_test + 2.0/decreasing_vec.size();
+        }
+
+        decreasing_vec[ decreasing_idx ] = 1;
+    }
+    else {
+        if ( decreasing_vec[ decreasing_idx ] == 1 ) {
+            // element in decreasing vec changed from 1 to -1
+            decreasing_test = decreasing_test - 2.0/decreasing_vec.size();
+        }
+
+        decreasing_vec[ decreasing_idx ] = -1;
+    }
+
+    decreasing_idx = (decreasing_idx + 1) % decreasing_vec.size();
+
+    f0_prev = f0;
+
+
+    update_parameters( parameters, grad );
+
+
+    int status = 0;
+    if ( std::abs( f0_mean - f0) < 1e-6 && decreasing_test <= 0.7 && var_f0/f0_mean < 1e-6 ) {
+        // local minimum
+        status = 1;
+    }
+
+    return status;
+
+}
+
+
+/**
+@brief Call to get the fraction of the latest iterations decreasing the cost function (mapped onto the interval [-1,1])
+@return Returns with the decreasing test
+*/
+double Optimizer_Base::get_decreasing_test() {
+
+    return decreasing_test;
+
+}
@@ -105,6 +105,32 @@ dot( Matrix &A, Matrix &B ) {
 
 
 
+/**
+@brief Call to calculate the product of two 2x2 gate kernels. (Evaluated without memory allocation.)
+@param A The first kernel in the product.
+@param B The second kernel in the product.
+@return Returns with the resulted kernel.
+*/
+QGD_Kernel2x2
+dot( QGD_Kernel2x2 &A, QGD_Kernel2x2 &B ) {
+
+    QGD_Kernel2x2 C;
+
+    for (int row_idx=0; row_idx<2; row_idx++) {
+        for (int col_idx=0; col_idx<2; col_idx++) {
+            QGD_Complex16 tmp1 = mult(A[2*row_idx], B[col_idx]);
+            QGD_Complex16 tmp2 = mult(A[2*row_idx+1], B[2+col_idx]);
+            C[2*row_idx+col_idx].real = tmp1.real + tmp2.real;
+            C[2*row_idx+col_idx].imag = tmp1.imag + tmp2.imag;
+        }
+    }
+
+    return C;
+
+}
+
+
+
 /**
 @brief Call to check the shape of the matrices for method dot. (Called in DEBUG mode)
 @param A The first matrix in the product of type matrix.
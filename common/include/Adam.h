@@ -24,29 +24,17 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #ifndef ADAM_H
 #define ADAM_H
 
-#include "matrix_real.h"
-#include <map>
-#include <cstdlib>
-#include <time.h>
-#include <ctime>
+#include "Optimizer_Base.h"
 
 
 /**
 @brief A class for Adam optimization according to https://towardsdatascience.com/how-to-implement-an-adam-optimizer-from-scratch-76e7b217f1cc
 */
-class Adam  {
-
-
-public:
-  
-    // learning rate of the Adam algorithm
-    double eta;  
+class Adam : public Optimizer_Base {
 
 
 protected:
 
-    /// Store the number of OpenMP threads. (During the calculations OpenMP multithreading is turned off.)
-    int num_threads;
     /// parameter beta1 of the Adam algorithm
     double beta1;
     /// parameter beta2 of the Adam algorithm
@@ -58,6 +46,8 @@ protected:
     Matrix_real mom;
     /// variance parameter of the Adam algorithm
     Matrix_real var;
+    /// The sum of the elements of the variance (used to detect barren plateaus)
+    double var_sum;
     /// iteration index
     int64_t iter_t;
 
@@ -66,21 +56,12 @@ protected:
     /// beta2^t
     double beta2_t;   
 
-    /// vector stroing the lates values of cost function values to test local minimum
-    Matrix_real f0_vec; 
-    /// Mean of the latest cost function values to test local minimum
-    double f0_mean;
-    /// current index in the f0_vec array
-    int f0_idx;
-    
-    /// vector containing 1 if cost function decreased from previous value, and -1 if it increased
-    matrix_base<int> decreasing_vec; 
-    /// current index in the decreasing_vec array
-    int decreasing_idx = 0;
-    /// decreasing_test
-    double decreasing_test;
-    /// previous value of the cost function
-    double f0_prev;
+    /// set true to normalize the steps by the maximum of the variances in the previous steps (AMSGrad variant)
+    bool amsgrad;
+    /// the maximum of the variances in the previous steps (allocated for the AMSGrad variant)
+    Matrix_real var_max;
+    /// coefficient of the weight decay decoupled from the gradient based step (AdamW variant)
+    double weight_decay;
 
 
 public:
@@ -92,9 +73,10 @@ Adam();
 
 /** Contructor of the class
 @brief Constructor of the class.
-@param Umtx_in The unitary matrix to be decomposed
-@param qbit_num_in The number of qubits spanning the unitary to be decomposed.
-@param initial_guess_in Type to guess the initial values for the optimization. Possible values: ZEROS=0, RANDOM=1, CLOSE_TO_ZERO=2
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
 @return An instance of the class
 */
 Adam( double beta1_in, double beta2_in, double epsilon_in, double eta_in);
@@ -106,27 +88,88 @@ virtual ~Adam();
 
 
 /**
-@brief ?????????????
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
 */
-void reset();
+virtual void reset();
 
+/**
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
+*/
+virtual void initialize( int parameter_num_in );
 
 /**
-@brief ?????????????
+@brief Call to allocate and zero the momentum and the variance of the Adam algorithm. (Same as initialize)
+@param parameter_num The number of parameters to be optimized
 */
 void initialize_moment_and_variance(int parameter_num);
 
+
+protected:
+
 /**
-@brief Call to set the number of gate blocks to be optimized in one shot
-@param optimization_block_in The number of gate blocks to be optimized in one shot
+@brief Call to update the parameters from the gradient. The momentum, the variance and the parameters are updated in a single pass.
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+*/
+virtual void update_parameters( Matrix_real& parameters, Matrix_real& grad );
+
+/**
+@brief Call to get the regularization parameter of the current step (reduced on barren plateaus) and to advance the bias corrections to the current step.
+@return Returns with the regularization parameter
+*/
+double prepare_step();
+
+};
+
+
+
+/**
+@brief A class for the AMSGrad variant of the Adam optimization (S. J. Reddi, S. Kale, S. Kumar, On the Convergence of Adam and Beyond, ICLR 2018). The steps are normalized by the maximum of the variances in the previous steps.
+*/
+class AMSGrad : public Adam {
+
+public:
+
+/** Nullary constructor of the class
+@return An instance of the class
 */
-int update( Matrix_real& parameters, Matrix_real& grad, const double& f0 );
+AMSGrad();
+
+/** Contructor of the class
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
+@return An instance of the class
+*/
+AMSGrad( double beta1_in, double beta2_in, double epsilon_in, double eta_in);
+
+};
+
 
 
 /**
-@brief ?????????????
+@brief A class for the AdamW variant of the Adam optimization (I. Loshchilov, F. Hutter, Decoupled Weight Decay Regularization, ICLR 2019). The parameters are decayed independently of the gradient based step.
+*/
+class AdamW : public Adam {
+
+public:
+
+/** Nullary constructor of the class
+@return An instance of the class
+*/
+AdamW();
+
+/** Contructor of the class
+@param beta1_in Parameter beta1 of the Adam algorithm
+@param beta2_in Parameter beta2 of the Adam algorithm
+@param epsilon_in Regularization parameter of the Adam algorithm
+@param eta_in The learning rate
+@param weight_decay_in The coefficient of the weight decay
+@return An instance of the class
 */
-double get_decreasing_test();
+AdamW( double beta1_in, double beta2_in, double epsilon_in, double eta_in, double weight_decay_in);
 
 };
 
@@ -0,0 +1,155 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file LBFGS.h
+    \brief Header file for a class implementing the limited memory BFGS optimization algorithm.
+*/
+
+#ifndef LBFGS_H
+#define LBFGS_H
+
+#include "matrix_real.h"
+
+
+/// Function type to calculate the cost function and its gradient at the given parameters
+typedef void (*lbfgs_cost_and_gradient_function)( const Matrix_real& parameters, void* meta_data, double* f0, Matrix_real& grad );
+
+/// Function type to calculate the cost function for a batch of parameter vectors (one vector per row). Returns with a column vector of the cost function values.
+typedef Matrix_real (*lbfgs_batched_cost_function)( Matrix_real& parameters, void* meta_data );
+
+
+/**
+@brief A class for the limited memory BFGS optimization algorithm (see J. Nocedal, Updating quasi-Newton matrices with limited storage, Math. Comp. 35, 773 (1980)). All the working arrays are allocated in the constructor, so the optimization can be restarted from new starting points without memory allocation. The trial step lengths of the backtracking line search are evaluated together in one call of the batched cost function.
+*/
+class LBFGS  {
+
+
+protected:
+
+    /// The number of free parameters
+    int parameter_num;
+    /// The maximal number of correction pairs stored in the history
+    int history_length;
+    /// The number of trial step lengths evaluated together in the line search
+    int trial_num;
+
+    /// Function to calculate the cost function and its gradient
+    lbfgs_cost_and_gradient_function cost_and_gradient;
+    /// Function to calculate the cost function for a batch of parameter vectors
+    lbfgs_batched_cost_function batched_cost;
+    /// Pointer passed to the cost functions
+    void* meta_data;
+
+    /// The current parameters
+    Matrix_real x;
+    /// The gradient of the cost function at the current parameters
+    Matrix_real grad;
+    /// The cost function at the current parameters
+    double f;
+
+    /// The search direction
+    Matrix_real direction;
+    /// The parameters accepted by the line search
+    Matrix_real x_new;
+    /// The gradient at the parameters accepted by the line search
+    Matrix_real grad_new;
+    /// The trial parameters of the line search (one parameter vector per row)
+    Matrix_real trial_parameters;
+
+    /// The parameter differences s_k = x_{k+1} - x_k of the latest iterations (one vector per row, used as a ring buffer)
+    Matrix_real s_history;
+    /// The gradient differences y_k = g_{k+1} - g_k of the latest iterations (one vector per row, used as a ring buffer)
+    Matrix_real y_history;
+    /// The values 1/(y_k*s_k) of the stored correction pairs
+    Matrix_real rho_history;
+    /// Work array of the two loop recursion
+    Matrix_real alpha;
+    /// The number of correction pairs stored in the history
+    int history_num;
+    /// The row of the history to be overwritten by the next correction pair
+    int history_idx;
+
+
+public:
+
+/**
+@brief Constructor of the class.
+@param parameter_num_in The number of free parameters
+@param cost_and_gradient_in Function to calculate the cost function and its gradient
+@param batched_cost_in Function to calculate the cost function for a batch of parameter vectors
+@param meta_data_in Pointer passed to the cost functions
+@param history_length_in The maximal number of correction pairs stored in the history
+@param trial_num_in The number of trial step lengths evaluated together in the line search
+@return An instance of the class
+*/
+LBFGS( int parameter_num_in, lbfgs_cost_and_gradient_function cost_and_gradient_in, lbfgs_batched_cost_function batched_cost_in, void* meta_data_in, int history_length_in=10, int trial_num_in=4 );
+
+/**
+@brief Destructor of the class
+*/
+virtual ~LBFGS();
+
+/**
+@brief Call to (re)start the optimization from the given parameters. The history of the previous iterations is discarded.
+@param parameters The starting parameters
+*/
+void set( const Matrix_real& parameters );
+
+/**
+@brief Call to perform one iteration of the optimization.
+@return Returns with 0 if the cost function was decreased, and with 1 if the cost function could not be decreased beyond its rounding error along the search direction.
+*/
+int iterate();
+
+/**
+@brief Call to get the cost function at the current parameters
+@return Returns with the cost function
+*/
+double get_f();
+
+/**
+@brief Call to get the current parameters
+@return Returns with the parameters (the data is owned by the optimizer)
+*/
+Matrix_real get_x();
+
+/**
+@brief Call to get the gradient of the cost function at the current parameters
+@return Returns with the gradient (the data is owned by the optimizer)
+*/
+Matrix_real get_gradient();
+
+/**
+@brief Call to get the euclidean norm of the gradient at the current parameters
+@return Returns with the norm of the gradient
+*/
+double get_gradient_norm();
+
+
+protected:
+
+/**
+@brief Call to calculate the search direction from the gradient and the stored correction pairs via the two loop recursion.
+*/
+void calculate_direction();
+
+};
+
+
+#endif //LBFGS
@@ -0,0 +1,87 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file Momentum_SGD.h
+    \brief Header file for a class implementing the stochastic gradient descent optimization with momentum.
+*/
+
+#ifndef MOMENTUM_SGD_H
+#define MOMENTUM_SGD_H
+
+#include "Optimizer_Base.h"
+
+
+/**
+@brief A class for gradient descent optimization with (heavy ball) momentum.
+*/
+class Momentum_SGD : public Optimizer_Base {
+
+
+protected:
+
+    /// The momentum parameter (the decay factor of the velocity)
+    double momentum;
+    /// The velocity of the parameters
+    Matrix_real velocity;
+
+
+public:
+
+/** Nullary constructor of the class
+@return An instance of the class
+*/
+Momentum_SGD();
+
+/** Contructor of the class
+@param momentum_in The momentum parameter
+@param eta_in The learning rate
+@return An instance of the class
+*/
+Momentum_SGD( double momentum_in, double eta_in );
+
+/**
+@brief Destructor of the class
+*/
+virtual ~Momentum_SGD();
+
+/**
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
+*/
+virtual void reset();
+
+/**
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
+*/
+virtual void initialize( int parameter_num_in );
+
+
+protected:
+
+/**
+@brief Call to update the parameters from the gradient. The velocity and the parameters are updated in a single pass.
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+*/
+virtual void update_parameters( Matrix_real& parameters, Matrix_real& grad );
+
+};
+
+
+#endif //MOMENTUM_SGD_H
@@ -0,0 +1,157 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file Optimizer_Base.h
+    \brief Header file for the base class of the first order gradient based optimizers.
+*/
+
+#ifndef OPTIMIZER_BASE_H
+#define OPTIMIZER_BASE_H
+
+#include "matrix_real.h"
+#include <tbb/parallel_for.h>
+
+
+#ifndef OPTIMIZER_PARALLEL_MIN_PARAMETERS
+/// The minimal number of parameters updated by one parallel task of the optimizers (smaller tasks would not amortize the scheduling overhead)
+#define OPTIMIZER_PARALLEL_MIN_PARAMETERS 1024
+#endif
+
+
+/**
+@brief Base class of the first order optimizers updating the parameters from the gradient of the cost function. The derived classes implement the update step, while the base class tracks the latest cost function values to detect local minima. The workspaces of the optimizers are allocated once and reused after the restarts of the optimization.
+*/
+class Optimizer_Base  {
+
+
+public:
+  
+    /// learning rate of the optimizer
+    double eta;  
+
+
+protected:
+
+    /// The number of parameters the workspaces are allocated for
+    int parameter_num;
+
+    /// vector stroing the lates values of cost function values to test local minimum
+    Matrix_real f0_vec; 
+    /// Mean of the latest cost function values to test local minimum
+    double f0_mean;
+    /// Sum of the squares of the latest cost function values to test local minimum
+    double f0_square_sum;
+    /// current index in the f0_vec array
+    int f0_idx;
+    
+    /// vector containing 1 if cost function decreased from previous value, and -1 if it increased
+    matrix_base<int> decreasing_vec; 
+    /// current index in the decreasing_vec array
+    int decreasing_idx;
+    /// decreasing_test
+    double decreasing_test;
+    /// previous value of the cost function
+    double f0_prev;
+
+    /// Partial sums of the parallel update kernels (one element per task)
+    Matrix_real partial_sums;
+
+
+public:
+
+/** Constructor of the class
+@param eta_in The learning rate
+@return An instance of the class
+*/
+Optimizer_Base( double eta_in );
+
+/**
+@brief Destructor of the class
+*/
+virtual ~Optimizer_Base();
+
+/**
+@brief Call to reset the state of the optimizer (used when the optimization is restarted from new parameters). The allocated workspaces are kept.
+*/
+virtual void reset();
+
+/**
+@brief Call to allocate (if the number of parameters changed) and zero the workspaces of the optimizer
+@param parameter_num_in The number of parameters to be optimized
+*/
+virtual void initialize( int parameter_num_in );
+
+/**
+@brief Call to perform one step of the optimization
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+@param f0 The cost function at the parameters
+@return 0 optimizer is in decreasing stage, 1 converged to local minumum
+*/
+int update( Matrix_real& parameters, Matrix_real& grad, const double& f0 );
+
+/**
+@brief Call to get the fraction of the latest iterations decreasing the cost function (mapped onto the interval [-1,1])
+@return Returns with the decreasing test
+*/
+double get_decreasing_test();
+
+
+protected:
+
+/**
+@brief Call to update the parameters from the gradient. (Implemented by the derived classes)
+@param parameters The parameters to be updated
+@param grad The gradient of the cost function at the parameters
+*/
+virtual void update_parameters( Matrix_real& parameters, Matrix_real& grad ) = 0;
+
+/**
+@brief Call to run an update kernel over the parameters. The kernel is called with the range [start, end) of the parameter indices and returns with a partial sum. Large problems are split into fixed chunks processed in parallel, so the summation order does not depend on the scheduling.
+@param kernel The update kernel
+@return Returns with the sum of the partial sums returned by the kernel
+*/
+template<typename Kernel>
+double run_update_kernel( const Kernel& kernel ) {
+
+    if ( parameter_num < 2*OPTIMIZER_PARALLEL_MIN_PARAMETERS ) {
+        return kernel( 0, parameter_num );
+    }
+
+    int chunk_num = partial_sums.size();
+
+    tbb::parallel_for( 0, chunk_num, 1, [&](int chunk_idx) {
+        int start = chunk_idx*OPTIMIZER_PARALLEL_MIN_PARAMETERS;
+        int end = chunk_idx == chunk_num-1 ? parameter_num : start + OPTIMIZER_PARALLEL_MIN_PARAMETERS;
+        partial_sums[chunk_idx] = kernel( start, end );
+    });
+
+    double ret = 0.0;
+    for (int chunk_idx=0; chunk_idx<chunk_num; chunk_idx++) {
+        ret = ret + partial_sums[chunk_idx];
+    }
+
+    return ret;
+
+}
+
+};
+
+
+#endif //OPTIMIZER_BASE_H
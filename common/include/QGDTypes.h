@@ -43,6 +43,30 @@ struct QGD_Complex16 {
   double imag;
 };
 
+/// @brief Structure type representing the 2x2 kernel of a one-qubit gate in row-major order. In contrast to class Matrix it is stored on the stack, so creating a kernel does not allocate memory.
+struct QGD_Kernel2x2 {
+  /// the elements of the kernel
+  QGD_Complex16 data[4];
+
+  /// Call to get the idx-th element of the kernel (row-major order)
+  QGD_Complex16& operator[](int idx) { return data[idx]; }
+
+  /// Call to get the pointer to the elements of the kernel
+  QGD_Complex16* get_data() { return data; }
+};
+
+/// @brief Structure type representing the 4x4 kernel of a two-qubit gate in row-major order. Similarly to QGD_Kernel2x2 it is stored on the stack, so creating a kernel does not allocate memory.
+struct QGD_Kernel4x4 {
+  /// the elements of the kernel
+  QGD_Complex16 data[16];
+
+  /// Call to get the idx-th element of the kernel (row-major order)
+  QGD_Complex16& operator[](int idx) { return data[idx]; }
+
+  /// Call to get the pointer to the elements of the kernel
+  QGD_Complex16* get_data() { return data; }
+};
+
 /// @brief Structure type conatining numbers of gates.
 struct gates_num {
   /// The number of U3 gates
@@ -49,6 +49,15 @@ void vzConj(int num, QGD_Complex16* input, QGD_Complex16* output);
 Matrix dot( Matrix &A, Matrix &B );
 
 
+/**
+@brief Call to calculate the product of two 2x2 gate kernels. (Evaluated without memory allocation.)
+@param A The first kernel in the product.
+@param B The second kernel in the product.
+@return Returns with the resulted kernel.
+*/
+QGD_Kernel2x2 dot( QGD_Kernel2x2 &A, QGD_Kernel2x2 &B );
+
+
 
 /**
 @brief Call to check the shape of the matrices for method dot. (Called in DEBUG mode)
@@ -96,6 +96,9 @@ Decomposition_Base::Decomposition_Base() {
     // seedign the random generator
     gen = std::mt19937(rd());
 
+    // the optimization can not be cancelled by default
+    cancellation_flag = NULL;
+
 #if CBLAS==1
     num_threads = mkl_get_max_threads();
 #elif CBLAS==2
@@ -178,6 +181,9 @@ Decomposition_Base::Decomposition_Base( Matrix Umtx_in, int qbit_num_in, guess_t
     // seedign the random generator
     gen = std::mt19937(rd());
 
+    // the optimization can not be cancelled by default
+    cancellation_flag = NULL;
+
 #if CBLAS==1
     num_threads = mkl_get_max_threads();
 #elif CBLAS==2
@@ -462,6 +468,7 @@ void  Decomposition_Base::solve_optimization_problem( double* solution_guess, in
         int block_idx_end;
         int block_idx_start = gates.size();
         gates.clear();
+        invalidate_tape();
         int block_parameter_num;
         Gate* fixed_gate_post = new Gate( qbit_num );
         std::vector<Matrix, tbb::cache_aligned_allocator<Matrix>> gates_mtxs_post;
@@ -539,6 +546,7 @@ void  Decomposition_Base::solve_optimization_problem( double* solution_guess, in
             for ( int idx=block_idx_end; idx<block_idx_start; idx++ ) {
                 gates.push_back( gates_loc[idx] );
             }
+            invalidate_tape();
 
 
             // constructing solution guess for the optimization
@@ -604,6 +612,9 @@ void  Decomposition_Base::solve_optimization_problem( double* solution_guess, in
 		print(sstream, 1);  		               
                 break;
             }
+            else if ( is_cancelled() ) {
+                break;
+            }
 
 
         }
@@ -621,6 +632,7 @@ void  Decomposition_Base::solve_optimization_problem( double* solution_guess, in
         // store the result of the optimization
         gates.clear();
         gates = gates_loc;
+        invalidate_tape();
 
         parameter_num = parameter_num_loc;
 /*
@@ -683,6 +695,28 @@ bool Decomposition_Base::check_optimization_solution() {
 }
 
 
+/**
+@brief Call to set the flag used to cancel the optimization from an other thread (e.g. when a concurrent optimization already reached the optimization tolerance)
+@param cancellation_flag_in Pointer to the flag (NULL to disable the cancellation)
+*/
+void Decomposition_Base::set_cancellation_flag( std::atomic<bool>* cancellation_flag_in ) {
+
+    cancellation_flag = cancellation_flag_in;
+
+}
+
+
+/**
+@brief Call to check whether the optimization was cancelled
+@return Returns with true if the cancellation flag is set, or false otherwise.
+*/
+bool Decomposition_Base::is_cancelled() {
+
+    return cancellation_flag != NULL && cancellation_flag->load( std::memory_order_relaxed );
+
+}
+
+
 /**
 @brief Call to retrive a pointer to the unitary to be transformed
 @return Return with the unitary Umtx
@@ -906,100 +940,25 @@ Decomposition_Base::get_gate_products(double* parameters, std::vector<Gate*>::it
     }
 
 
-    double* parameters_loc = parameters;
+    // the gates are compiled into a tape in reversed order, so they are applied from the right starting from the end of the tape
+    std::vector<Tape_Instruction> tape;
+    compile_tape( gates_it, num_of_gates, 0, tape );
+
     Matrix mtx = create_identity(matrix_size);
 
+    int tape_end = tape.size();
     for (int idx=0; idx<num_of_gates; idx++) {
-       
-
-        // get the matrix representation of the gate
-        Gate* gate = *gates_it;        
-        Matrix_real parameters_loc_mtx( parameters_loc, 1, gate->get_parameter_num() );
 
-        if (gate->get_type() == CNOT_OPERATION ) {
-            CNOT* cnot_gate = static_cast<CNOT*>(gate);
-            cnot_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == CZ_OPERATION ) {
-            CZ* cz_gate = static_cast<CZ*>(gate);
-            cz_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == CH_OPERATION ) {
-            CH* ch_gate = static_cast<CH*>(gate);
-            ch_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == SYC_OPERATION ) {
-            SYC* syc_gate = static_cast<SYC*>(gate);
-            syc_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == GENERAL_OPERATION ) {
-            gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == U3_OPERATION ) {
-            U3* u3_gate = static_cast<U3*>(gate);
-            u3_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == RX_OPERATION ) {
-            RX* rx_gate = static_cast<RX*>(gate);
-            rx_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == RY_OPERATION ) {
-            RY* ry_gate = static_cast<RY*>(gate);
-            ry_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == CRY_OPERATION ) {
-            CRY* cry_gate = static_cast<CRY*>(gate);
-            cry_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == RZ_OPERATION ) {
-            RZ* rz_gate = static_cast<RZ*>(gate);
-            rz_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == X_OPERATION ) {
-            X* x_gate = static_cast<X*>(gate);
-            x_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == Y_OPERATION ) {
-            Y* y_gate = static_cast<Y*>(gate);
-            y_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == Z_OPERATION ) {
-            Z* z_gate = static_cast<Z*>(gate);
-            z_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == SX_OPERATION ) {
-            SX* sx_gate = static_cast<SX*>(gate);
-            sx_gate->apply_from_right(mtx);
-        }
-        else if (gate->get_type() == UN_OPERATION ) {
-            UN* un_gate = static_cast<UN*>(gate);
-            un_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == ON_OPERATION ) {
-            ON* on_gate = static_cast<ON*>(gate);
-            on_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == COMPOSITE_OPERATION ) {
-            Composite* com_gate = static_cast<Composite*>(gate);
-            com_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == BLOCK_OPERATION ) {
-            Gates_block* block_gate = static_cast<Gates_block*>(gate);
-            block_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else if (gate->get_type() == ADAPTIVE_OPERATION ) {
-            Adaptive* ad_gate = static_cast<Adaptive*>(gate);
-            ad_gate->apply_from_right(parameters_loc_mtx, mtx);
-        }
-        else {
-            std::string err("Decomposition_Base::get_gate_products: unimplemented gate");
-            throw err;
+        // the instructions of the idx-th gate
+        int tape_start = tape_end;
+        while ( tape_start > 0 && tape[tape_start-1].gate_idx == idx ) {
+            tape_start--;
         }
 
-        parameters_loc = parameters_loc + gate->get_parameter_num();
+        apply_tape_from_right( tape, tape_start, tape_end, parameters, mtx );
+        tape_end = tape_start;
 
         gate_mtxs[idx] = mtx.copy();     
-        gates_it++;   
 
     }
 
@@ -1181,6 +1140,7 @@ void Decomposition_Base::prepare_gates_to_export() {
     // release the gates and replace them with the ones prepared to export
     gates.clear();
     gates = gates_tmp;
+    invalidate_tape();
 
 }
 
@@ -25,8 +25,11 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include "N_Qubit_Decomposition_Base.h"
 #include "N_Qubit_Decomposition_Cost_Function.h"
 #include "Adam.h"
+#include "Momentum_SGD.h"
+#include "LBFGS.h"
 
 #include <fstream>
+#include <memory>
 
 
 #ifdef __DFE__
@@ -38,6 +41,12 @@ static double adam_time = 0;
 static double bfgs_time = 0;
 static double pure_DFE_time = 0;
 
+/// The memory size (in bytes) of a column tile of the unitary in the tiled evaluation of the cost function (chosen to fit into the L2 cache)
+static const int column_tile_bytes = 1 << 18;
+
+/// The allowed standard error of the estimated cost function relative to its distance from the optimization tolerance (the number of probe vectors is doubled above this limit)
+static const double trace_estimation_relative_error = 0.1;
+
 
 /**
 @brief Nullary constructor of the class.
@@ -80,6 +89,13 @@ N_Qubit_Decomposition_Base::N_Qubit_Decomposition_Base() {
     // set the trace offset
     trace_offset = 0;
 
+    // the trace is calculated exactly by default
+    trace_estimation_probe_num = 0;
+    trace_probe_num = 0;
+
+    // the gates are applied on the unitary in a single sweep by default
+    meet_in_the_middle = false;
+
     // unique id indentifying the instance of the class
     std::uniform_int_distribution<> distrib_int(0, INT_MAX);  
     int id = distrib_int(gen);
@@ -137,6 +153,13 @@ N_Qubit_Decomposition_Base::N_Qubit_Decomposition_Base( Matrix Umtx_in, int qbit
     // set the trace offset
     trace_offset = 0;
 
+    // the trace is calculated exactly by default
+    trace_estimation_probe_num = 0;
+    trace_probe_num = 0;
+
+    // the gates are applied on the unitary in a single sweep by default
+    meet_in_the_middle = false;
+
     // unique id indentifying the instance of the class
     std::uniform_int_distribution<> distrib_int(0, INT_MAX);  
     id = distrib_int(gen);
@@ -322,35 +345,158 @@ void  N_Qubit_Decomposition_Base::final_optimization() {
 */
 void N_Qubit_Decomposition_Base::solve_layer_optimization_problem( int num_of_parameters, gsl_vector *solution_guess_gsl) {
 
+    // the fixed gates following the optimized gates are merged into the unitary for the time of the optimization
+    Gate* fixed_gate_post = NULL;
+    Matrix Umtx_orig;
+    if ( use_fixed_gate_environment() ) {
+
+        fixed_gate_post = gates[0];
+        gates.erase( gates.begin() );
+        invalidate_tape();
+
+        Umtx_orig = Umtx;
+        Umtx = Umtx_orig.copy();
+        fixed_gate_post->apply_from_right( Umtx );
+    }
+
+    // restores the gates, the unitary and the exact evaluation of the cost function after the optimization (also when the optimization throws)
+    auto restore_state = [&]() {
+
+        trace_probe_num = 0;
+        trace_probes = Matrix();
+        Umtx_probes = Matrix();
+
+        if ( fixed_gate_post != NULL ) {
+            gates.insert( gates.begin(), fixed_gate_post );
+            invalidate_tape();
+            Umtx = Umtx_orig;
+            fixed_gate_post = NULL;
+        }
+
+    };
+
+    try {
+
+        // the probe vectors are drawn for the current unitary (the estimation is not worth for small unitaries)
+        // The estimated cost function is noisy, so it is used only by the first order optimizers. (The line search of the BFGS optimizers compares cost functions evaluated at different points.)
+        if ( is_first_order_optimizer(alg) && trace_estimation_probe_num > 0 && trace_estimation_probe_num < Umtx.cols ) {
+            trace_probe_num = trace_estimation_probe_num;
+            generate_trace_probes();
+        }
+
+        switch ( alg ) {
+            case ADAM:
+            case AMSGRAD:
+            case ADAMW:
+            case MOMENTUM_SGD:
+                solve_layer_optimization_problem_ADAM( num_of_parameters, solution_guess_gsl);
+                break;
+            case ADAM_BATCHED:
+                solve_layer_optimization_problem_ADAM_BATCHED( num_of_parameters, solution_guess_gsl);
+                break;
+            case BFGS:
+                solve_layer_optimization_problem_BFGS( num_of_parameters, solution_guess_gsl);
+                break;
+            case BFGS2:
+                solve_layer_optimization_problem_BFGS2( num_of_parameters, solution_guess_gsl);
+                break;
+            default:
+                std::string error("N_Qubit_Decomposition_Base::solve_layer_optimization_problem: unimplemented optimization algorithm");
+                throw error;
+        }
+
+    }
+    catch (...) {
+        restore_state();
+        throw;
+    }
+
+    // the cost function is evaluated exactly outside of the optimization
+    restore_state();
+
+}
+
+
+/**
+@brief Call to determine whether the fixed gates following the optimized gates can be merged into the unitary during the optimization of a block of gates. In the layer by layer optimization (see Decomposition_Base::solve_optimization_problem) the product P of the fixed gates applied after the optimized gates W is given by a general gate in front of the gate list, so the cost function depends on Tr(P*W*Umtx). If the cost function depends only on the trace, then Tr(P*W*Umtx) = Tr(W*(Umtx*P)), so the environment Umtx*P can be calculated once for the whole optimization of the block, and only the optimized gates are applied in the individual cost function and gradient evaluations instead of multiplying with the dense matrix P.
+@return Returns with true if the environment of the fixed gates can be used, false otherwise.
+*/
+bool N_Qubit_Decomposition_Base::use_fixed_gate_environment() {
+
+    if ( gates.size() < 2 || gates[0]->get_type() != GENERAL_OPERATION || gates[0]->get_parameter_num() > 0 ) {
+        return false;
+    }
+
+    // the corrections and the shifted trace are not invariant under the cyclic permutation of the product
+    if ( cost_fnc != FROBENIUS_NORM && cost_fnc != HILBERT_SCHMIDT_TEST ) {
+        return false;
+    }
+
+    return trace_offset == 0 && Umtx.rows == Umtx.cols && accelerator_num == 0;
+
+}
+
+
+/**
+@brief Call to solve layer by layer the optimization problem via batched ADAM algorithm. (optimal for larger problems) The ADAM optimization (see solve_layer_optimization_problem_ADAM) is run on randomly chosen column slices of the unitary. The slices are redrawn during the optimization, while the state of the optimizer is kept. The optimalized parameters are stored in attribute optimized_parameters.
+@param num_of_parameters Number of parameters to be optimized
+@param solution_guess_gsl A GNU Scientific Library vector containing the solution guess.
+*/
+void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_ADAM_BATCHED( int num_of_parameters, gsl_vector *solution_guess_gsl) {
+
+    // the slices are cut from the original unitary
+    Matrix Umtx_orig = Umtx;
+    int trace_offset_orig = trace_offset;
+
+    try {
+        solve_layer_optimization_problem_ADAM( num_of_parameters, solution_guess_gsl, &Umtx_orig );
+    }
+    catch (...) {
+        Umtx = Umtx_orig;
+        trace_offset = trace_offset_orig;
+        throw;
+    }
+
+    Umtx = Umtx_orig;
+    trace_offset = trace_offset_orig;
+
+}
+
+/**
+@brief Call to create the first order optimizer corresponding to the attribute alg
+@return Returns with a pointer to the created optimizer. (The caller is responsible for its deletion)
+*/
+Optimizer_Base* N_Qubit_Decomposition_Base::create_first_order_optimizer() {
 
     switch ( alg ) {
         case ADAM:
-            solve_layer_optimization_problem_ADAM( num_of_parameters, solution_guess_gsl);
-            return;
         case ADAM_BATCHED:
-            solve_layer_optimization_problem_ADAM_BATCHED( num_of_parameters, solution_guess_gsl);
-            return;
-        case BFGS:
-            solve_layer_optimization_problem_BFGS( num_of_parameters, solution_guess_gsl);
-            return;
-        case BFGS2:
-            solve_layer_optimization_problem_BFGS2( num_of_parameters, solution_guess_gsl);
-            return;
+            return new Adam();
+
+        case AMSGRAD:
+            return new AMSGrad();
+
+        case ADAMW:
+            return new AdamW();
+
+        case MOMENTUM_SGD:
+            return new Momentum_SGD();
+
         default:
-            std::string error("N_Qubit_Decomposition_Base::solve_layer_optimization_problem: unimplemented optimization algorithm");
+            std::string error("N_Qubit_Decomposition_Base::create_first_order_optimizer: the optimization algorithm is not a first order optimizer");
             throw error;
     }
 
-
 }
 
 
 /**
-@brief Call to solve layer by layer the optimization problem via batched ADAM algorithm. (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
+@brief Call to solve layer by layer the optimization problem via ADAM algorithm or via an other first order optimizer chosen by the attribute alg (see create_first_order_optimizer). (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
 @param num_of_parameters Number of parameters to be optimized
 @param solution_guess_gsl A GNU Scientific Library vector containing the solution guess.
+@param Umtx_batched If not NULL, the cost function is evaluated on randomly chosen column slices of this matrix (see solve_layer_optimization_problem_ADAM_BATCHED). A new slice is drawn after every iter_max iterations, up to 100 slices, while the state of the optimizer, the learning rate and the randomization counters are kept across the slices. (The attributes Umtx and trace_offset are overwritten by the slices.)
 */
-void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_ADAM_BATCHED( int num_of_parameters, gsl_vector *solution_guess_gsl) {
+void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_ADAM( int num_of_parameters, gsl_vector *solution_guess_gsl, Matrix* Umtx_batched) {
 
 #ifdef __DFE__
         if ( qbit_num >= 5 ) {
@@ -376,16 +522,12 @@ void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_ADAM_BATCHED(
         }
 
 
-        int random_shift_count = 0;
-        int sub_iter_idx = 0;
-        double current_minimum_hold = current_minimum;
-    
-
         tbb::tick_count adam_start = tbb::tick_count::now();
         adam_time = 0.0;
 pure_DFE_time = 0.0;
-        Adam optimizer;
-        optimizer.initialize_moment_and_variance( num_of_parameters );
+        // the state of the optimization (the workspaces of the optimizer are allocated once and reused after the randomizations)
+        First_Order_State state;
+        initialize_first_order_state( state, num_of_parameters );
 
 
 
@@ -404,70 +546,42 @@ pure_DFE_time = 0.0;
         sstream << "iter_max: " << iter_max << ", randomization threshold: " << iteration_threshold_of_randomization << ", randomization radius: " << radius << std::endl;
         print(sstream, 2); 
 
-        int ADAM_status = 0;
-
-
+        // the number of the column slices used in the batched optimization
+        int batch_num = Umtx_batched == NULL ? 1 : 100;
+        int iter_max_loc = batch_num*iter_max;
+        
 
-Matrix Umtx_orig = Umtx;
-int batch_size_min = Umtx_orig.cols*5/6;
-std::uniform_int_distribution<> distrib_trace_offset(0, Umtx_orig.cols-batch_size_min);
+        for ( int iter_idx=0; iter_idx<iter_max_loc; iter_idx++ ) {
 
+            if ( Umtx_batched != NULL && iter_idx % iter_max == 0 ) {
 
-int batch_num = 100;
-for (int batch_idx=0; batch_idx<batch_num; batch_idx++ ) {
+                // draw a new slice of the columns
+                int batch_size_min = Umtx_batched->cols*5/6;
+                std::uniform_int_distribution<> distrib_trace_offset(0, Umtx_batched->cols-batch_size_min);
+                trace_offset = distrib_trace_offset(gen);
 
-    trace_offset = distrib_trace_offset(gen);
+                std::uniform_int_distribution<> distrib_col_num(batch_size_min, Umtx_batched->cols-trace_offset);
+                int col_num = distrib_col_num(gen);
 
-    std::uniform_int_distribution<> distrib_col_num(batch_size_min, Umtx_orig.cols-trace_offset);
-    int col_num = distrib_col_num(gen);
-std::cout << "trace offset: " << trace_offset << " col_num: " << col_num << " iter_max: " << iter_max << std::endl;
+                std::stringstream sstream;
+                sstream << "ADAM: optimizing on columns " << trace_offset << " - " << trace_offset+col_num-1 << std::endl;
+                print(sstream, 2);
 
-    // create a slice from the original Umtx
-    Matrix Umtx_slice(Umtx_orig.rows, col_num);
-    for (int row_idx=0; row_idx<Umtx_orig.rows; row_idx++) {
-        memcpy( Umtx_slice.get_data() + row_idx*Umtx_slice.stride, Umtx_orig.get_data() + row_idx*Umtx_orig.stride + trace_offset, col_num*sizeof(QGD_Complex16) );
-    }
+                Matrix Umtx_slice(Umtx_batched->rows, col_num);
+                for (int row_idx=0; row_idx<Umtx_batched->rows; row_idx++) {
+                    memcpy( Umtx_slice.get_data() + row_idx*Umtx_slice.stride, Umtx_batched->get_data() + row_idx*Umtx_batched->stride + trace_offset, col_num*sizeof(QGD_Complex16) );
+                }
 
-    Umtx = Umtx_slice;
+                Umtx = Umtx_slice;
 
-        for ( int iter_idx=0; iter_idx<iter_max; iter_idx++ ) {
+            }
 
-            
+            number_of_iters++;
 
 
             optimization_problem_combined( solution_guess_tmp, (void*)(this), &f0, grad_gsl );
 
-            prev_cost_fnv_val = f0;
-  
-            if (sub_iter_idx == 1 ) {
-                current_minimum_hold = f0;   
-               
-                if ( adaptive_eta )  { 
-                    optimizer.eta = optimizer.eta > 1e-3 ? optimizer.eta : 1e-3; 
-                    //std::cout << "reset learning rate to " << optimizer.eta << std::endl;
-                }                 
-
-            }
-
-
-            if (current_minimum_hold*0.95 > f0 || (current_minimum_hold*0.97 > f0 && f0 < 1e-3) ||  (current_minimum_hold*0.99 > f0 && f0 < 1e-4) ) {
-                sub_iter_idx = 0;
-                current_minimum_hold = f0;        
-            }
-    
-    
-            if (current_minimum > f0 ) {
-                current_minimum = f0;
-                memcpy( optimized_parameters_mtx.get_data(),  solution_guess_tmp->data, num_of_parameters*sizeof(double) );
-                //double new_eta = 1e-3 * f0 * f0;
-                
-                if ( adaptive_eta )  {
-                    double new_eta = 1e-3 * f0;
-                    optimizer.eta = new_eta > 1e-6 ? new_eta : 1e-6;
-                    optimizer.eta = new_eta < 1e-1 ? new_eta : 1e-1;
-                }
-                
-            }
+            bool proceed = first_order_iteration( state, solution_guess_tmp_mtx, grad_mtx, f0 );
     
 
             if ( iter_idx % 5000 == 0 ) {
@@ -475,72 +589,18 @@ std::cout << "trace offset: " << trace_offset << " col_num: " << col_num << " it
                 Matrix matrix_new = get_transformed_matrix( optimized_parameters_mtx, gates.begin(), gates.size(), Umtx );
 
                 std::stringstream sstream;
-                sstream << "ADAM: processed iterations " << (double)iter_idx/iter_max*100 << "\%, current minimum:" << current_minimum << ", pure cost function:" << get_cost_function(matrix_new, trace_offset) << std::endl;
+                sstream << "ADAM: processed iterations " << (double)iter_idx/iter_max_loc*100 << "\%, current minimum:" << current_minimum << ", pure cost function:" << get_cost_function(matrix_new, trace_offset) << std::endl;
                 print(sstream, 0);   
                 std::string filename("initial_circuit_iteration.binary");
                 export_gate_list_to_binary(optimized_parameters_mtx, this, filename, verbose);
 
             }
 
-//std::cout << grad_norm  << std::endl;
-            if (f0 < optimization_tolerance || random_shift_count > random_shift_count_max ) {
+            if ( !proceed ) {
                 break;
             }
 
-
-
-                // calculate the gradient norm
-                double norm = 0.0;
-                for ( int grad_idx=0; grad_idx<num_of_parameters; grad_idx++ ) {
-                    norm += grad_gsl->data[grad_idx]*grad_gsl->data[grad_idx];
-                }
-                norm = std::sqrt(norm);
-                    
-
-            if ( sub_iter_idx> iteration_threshold_of_randomization || ADAM_status != 0 ) {
-
-                //random_shift_count++;
-                sub_iter_idx = 0;
-                random_shift_count++;
-                current_minimum_hold = current_minimum;   
-
-
-                
-                std::stringstream sstream;
-                if ( ADAM_status == 0 ) {
-                    sstream << "ADAM: initiate randomization at " << f0 << ", gradient norm " << norm << std::endl;
-                }
-                else {
-                    sstream << "ADAM: leaving local minimum " << f0 << ", gradient norm " << norm << " eta: " << optimizer.eta << std::endl;
-                }
-                print(sstream, 0);   
-                    
-                 int randomization_successful = 1;
-                randomize_parameters(optimized_parameters_mtx, solution_guess_tmp, randomization_successful, f0 );
-                randomization_successful = 0;
-        
-                optimizer.reset();
-                optimizer.initialize_moment_and_variance( num_of_parameters );   
-
-                ADAM_status = 0;   
-
-                //optimizer.eta = 1e-3;
-        
-            }
-
-            else {
-                ADAM_status = optimizer.update(solution_guess_tmp_mtx, grad_mtx, f0);
-            }
-
-            sub_iter_idx++;
-
         }
-
-
-
-
-}
-
         sstream.str("");
         sstream << "obtained minimum: " << current_minimum << std::endl;
 
@@ -550,212 +610,162 @@ std::cout << "trace offset: " << trace_offset << " col_num: " << col_num << " it
         tbb::tick_count adam_end = tbb::tick_count::now();
         adam_time  = adam_time + (adam_end-adam_start).seconds();
         sstream << "adam time: " << adam_time << ", pure DFE time:  " << pure_DFE_time << " " << f0 << std::endl;
-        
+
         print(sstream, 0); 
 
 }
 
+
+
 /**
-@brief Call to solve layer by layer the optimization problem via ADAM algorithm. (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
+@brief Call to initialize the state of a first order optimization (see first_order_iteration) with the optimizer chosen by the attribute alg.
+@param state The state to be initialized
 @param num_of_parameters Number of parameters to be optimized
-@param solution_guess_gsl A GNU Scientific Library vector containing the solution guess.
 */
-void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_ADAM( int num_of_parameters, gsl_vector *solution_guess_gsl) {
-
-#ifdef __DFE__
-        if ( qbit_num >= 5 ) {
-            upload_Umtx_to_DFE();
-        }
-#endif
-
-
-
-        if (gates.size() == 0 ) {
-            return;
-        }
-
-
-        if (solution_guess_gsl == NULL) {
-            solution_guess_gsl = gsl_vector_alloc(num_of_parameters);
-        }
-//memset( solution_guess_gsl->data, 0.0, solution_guess_gsl->size*sizeof(double) );
-
-        if (optimized_parameters_mtx.size() == 0) {
-            optimized_parameters_mtx = Matrix_real(1, num_of_parameters);
-            memcpy(optimized_parameters_mtx.get_data(), solution_guess_gsl->data, num_of_parameters*sizeof(double) );
-        }
-
-
-        int random_shift_count = 0;
-        int sub_iter_idx = 0;
-        double current_minimum_hold = current_minimum;
-    
-
-        tbb::tick_count adam_start = tbb::tick_count::now();
-        adam_time = 0.0;
-pure_DFE_time = 0.0;
-        Adam optimizer;
-        optimizer.initialize_moment_and_variance( num_of_parameters );
-
-
-
-        // the array storing the optimized parameters
-        gsl_vector* grad_gsl = gsl_vector_alloc(num_of_parameters);
-        gsl_vector* solution_guess_tmp = gsl_vector_alloc(num_of_parameters);
-        memcpy(solution_guess_tmp->data, solution_guess_gsl->data, num_of_parameters*sizeof(double) );
-
-        Matrix_real solution_guess_tmp_mtx = Matrix_real( solution_guess_tmp->data, num_of_parameters, 1 );
-        Matrix_real grad_mtx = Matrix_real( grad_gsl->data, num_of_parameters, 1 );
-        //solution_guess_tmp_mtx.print_matrix();
-
-
-        double f0 = DBL_MAX;
-        std::stringstream sstream;
-        sstream << "iter_max: " << iter_max << ", randomization threshold: " << iteration_threshold_of_randomization << ", randomization radius: " << radius << std::endl;
-        print(sstream, 2); 
+void N_Qubit_Decomposition_Base::initialize_first_order_state( First_Order_State& state, int num_of_parameters ) {
 
-        int ADAM_status = 0;
+    state.optimizer.reset( create_first_order_optimizer() );
+    state.optimizer->initialize( num_of_parameters );
 
-        int randomization_successful = 0;
-        
+    state.sub_iter_idx = 0;
+    state.current_minimum_hold = current_minimum;
+    state.random_shift_count = 0;
+    state.randomization_successful = 0;
+    state.ADAM_status = 0;
 
-        for ( int iter_idx=0; iter_idx<iter_max; iter_idx++ ) {
+}
 
-            number_of_iters++;
 
+/**
+@brief Call to perform one iteration of a first order optimization from the cost function and the gradient evaluated at the current parameters: the current minimum is updated, then the parameters are either updated by the optimizer or randomized around the current minimum when the cost function stops decreasing. (Used by solve_layer_optimization_problem_ADAM and by the batched decompositions evaluating several problems in lockstep.)
+@param state The state of the optimization (see initialize_first_order_state)
+@param parameters The current parameters. On exit they are replaced by the parameters of the next iteration.
+@param grad The gradient of the cost function at the current parameters
+@param f0 The cost function at the current parameters
+@return Returns with false if the optimization is finished (the cost function reached the optimization tolerance, the number of the randomizations exceeded random_shift_count_max or the optimization was cancelled), true otherwise.
+*/
+bool N_Qubit_Decomposition_Base::first_order_iteration( First_Order_State& state, Matrix_real& parameters, Matrix_real& grad, double f0 ) {
 
-            optimization_problem_combined( solution_guess_tmp, (void*)(this), &f0, grad_gsl );
+    int num_of_parameters = parameters.size();
+    Optimizer_Base* optimizer = state.optimizer.get();
 
-            prev_cost_fnv_val = f0;
+    prev_cost_fnv_val = f0;
   
-            if (sub_iter_idx == 1 ) {
-                current_minimum_hold = f0;   
-               
-                if ( adaptive_eta )  { 
-                    optimizer.eta = optimizer.eta > 1e-3 ? optimizer.eta : 1e-3; 
-                    //std::cout << "reset learning rate to " << optimizer.eta << std::endl;
-                }                 
+    if (state.sub_iter_idx == 1 ) {
+        state.current_minimum_hold = f0;   
+       
+        if ( adaptive_eta )  { 
+            optimizer->eta = optimizer->eta > 1e-3 ? optimizer->eta : 1e-3; 
+            //std::cout << "reset learning rate to " << optimizer->eta << std::endl;
+        }                 
 
-            }
+    }
 
 
-            if (current_minimum_hold*0.95 > f0 || (current_minimum_hold*0.97 > f0 && f0 < 1e-3) ||  (current_minimum_hold*0.99 > f0 && f0 < 1e-4) ) {
-                sub_iter_idx = 0;
-                current_minimum_hold = f0;        
-            }
+    if (state.current_minimum_hold*0.95 > f0 || (state.current_minimum_hold*0.97 > f0 && f0 < 1e-3) ||  (state.current_minimum_hold*0.99 > f0 && f0 < 1e-4) ) {
+        state.sub_iter_idx = 0;
+        state.current_minimum_hold = f0;        
+    }
     
     
-            if (current_minimum > f0 ) {
-                current_minimum = f0;
-                memcpy( optimized_parameters_mtx.get_data(),  solution_guess_tmp->data, num_of_parameters*sizeof(double) );
-                //double new_eta = 1e-3 * f0 * f0;
-                
-                if ( adaptive_eta )  {
-                    double new_eta = 1e-3 * f0;
-                    optimizer.eta = new_eta > 1e-6 ? new_eta : 1e-6;
-                    optimizer.eta = new_eta < 1e-1 ? new_eta : 1e-1;
-                }
-                
-                randomization_successful = 1;
-            }
+    if (current_minimum > f0 ) {
+        current_minimum = f0;
+        memcpy( optimized_parameters_mtx.get_data(),  parameters.get_data(), num_of_parameters*sizeof(double) );
+        //double new_eta = 1e-3 * f0 * f0;
+        
+        if ( adaptive_eta )  {
+            double new_eta = 1e-3 * f0;
+            optimizer->eta = new_eta > 1e-6 ? new_eta : 1e-6;
+            optimizer->eta = new_eta < 1e-1 ? new_eta : 1e-1;
+        }
+        
+        state.randomization_successful = 1;
+    }
     
 
-            if ( iter_idx % 5000 == 0 ) {
-
-                Matrix matrix_new = get_transformed_matrix( optimized_parameters_mtx, gates.begin(), gates.size(), Umtx );
-
-                std::stringstream sstream;
-                sstream << "ADAM: processed iterations " << (double)iter_idx/iter_max*100 << "\%, current minimum:" << current_minimum << ", pure cost function:" << get_cost_function(matrix_new, trace_offset) << std::endl;
-                print(sstream, 0);   
-                std::string filename("initial_circuit_iteration.binary");
-                export_gate_list_to_binary(optimized_parameters_mtx, this, filename, verbose);
-
-            }
-
 //std::cout << grad_norm  << std::endl;
-            if (f0 < optimization_tolerance || random_shift_count > random_shift_count_max ) {
-                break;
-            }
-
+    if (f0 < optimization_tolerance || state.random_shift_count > random_shift_count_max || is_cancelled() ) {
+        return false;
+    }
 
 
-                // calculate the gradient norm
-                double norm = 0.0;
-                for ( int grad_idx=0; grad_idx<num_of_parameters; grad_idx++ ) {
-                    norm += grad_gsl->data[grad_idx]*grad_gsl->data[grad_idx];
-                }
-                norm = std::sqrt(norm);
-                
+    // calculate the gradient norm
+    double norm = 0.0;
+    for ( int grad_idx=0; grad_idx<num_of_parameters; grad_idx++ ) {
+        norm += grad[grad_idx]*grad[grad_idx];
+    }
+    norm = std::sqrt(norm);
+        
 //grad_mtx.print_matrix();
 /*
-            if ( ADAM_status == 0 && norm > 0.01 && optimizer.eta < 1e-4) {
+    if ( ADAM_status == 0 && norm > 0.01 && optimizer->eta < 1e-4) {
 
-                std::uniform_real_distribution<> distrib_prob(0.0, 1.0);
-                if ( distrib_prob(gen) < 0.05 ) {
-                    optimizer.eta = optimizer.eta*10;
-                    std::cout << "Increasing learning rate at " << f0 << " to " << optimizer.eta << std::endl;
-                }
+        std::uniform_real_distribution<> distrib_prob(0.0, 1.0);
+        if ( distrib_prob(gen) < 0.05 ) {
+            optimizer->eta = optimizer->eta*10;
+            std::cout << "Increasing learning rate at " << f0 << " to " << optimizer->eta << std::endl;
+        }
 
-            }
+    }
 */
 /*
 
-            if ( ADAM_status == 1 && norm > 0.01 ) {
-                optimizer.eta = optimizer.eta > 1e-5 ? optimizer.eta/10 : 1e-6;
-                std::cout << "Decreasing learning rate at " << f0 << " to " << optimizer.eta << std::endl;
-                ADAM_status = 0;
-            }
+    if ( ADAM_status == 1 && norm > 0.01 ) {
+        optimizer->eta = optimizer->eta > 1e-5 ? optimizer->eta/10 : 1e-6;
+        std::cout << "Decreasing learning rate at " << f0 << " to " << optimizer->eta << std::endl;
+        ADAM_status = 0;
+    }
 
   */       
 
-            if ( sub_iter_idx> iteration_threshold_of_randomization || ADAM_status != 0 ) {
+    if ( state.sub_iter_idx> iteration_threshold_of_randomization || state.ADAM_status != 0 ) {
 
-                //random_shift_count++;
-                sub_iter_idx = 0;
-                random_shift_count++;
-                current_minimum_hold = current_minimum;   
+        //random_shift_count++;
+        state.sub_iter_idx = 0;
+        state.random_shift_count++;
+        state.current_minimum_hold = current_minimum;   
 
 
-                
-                std::stringstream sstream;
-                if ( ADAM_status == 0 ) {
-                    sstream << "ADAM: initiate randomization at " << f0 << ", gradient norm " << norm << std::endl;
-                }
-                else {
-                    sstream << "ADAM: leaving local minimum " << f0 << ", gradient norm " << norm << " eta: " << optimizer.eta << std::endl;
-                }
-                print(sstream, 0);   
-                    
-                randomize_parameters(optimized_parameters_mtx, solution_guess_tmp, randomization_successful, f0 );
-                randomization_successful = 0;
         
-                optimizer.reset();
-                optimizer.initialize_moment_and_variance( num_of_parameters );   
-
-                ADAM_status = 0;   
+        std::stringstream sstream;
+        if ( state.ADAM_status == 0 ) {
+            sstream << "ADAM: initiate randomization at " << f0 << ", gradient norm " << norm << std::endl;
+        }
+        else {
+            sstream << "ADAM: leaving local minimum " << f0 << ", gradient norm " << norm << " eta: " << optimizer->eta << std::endl;
+        }
+        print(sstream, 0);   
+
+        // create GSL wrappers around the parameters
+        gsl_block block_tmp;
+        block_tmp.data = parameters.get_data();
+        block_tmp.size = num_of_parameters;
+
+        gsl_vector parameters_gsl;
+        parameters_gsl.data = parameters.get_data();
+        parameters_gsl.size = num_of_parameters;
+        parameters_gsl.stride = 1;
+        parameters_gsl.block = &block_tmp;
+        parameters_gsl.owner = 0;
+            
+        randomize_parameters(optimized_parameters_mtx, &parameters_gsl, state.randomization_successful, f0 );
+        state.randomization_successful = 0;
 
-                //optimizer.eta = 1e-3;
-        
-            }
+        optimizer->reset();
 
-            else {
-                ADAM_status = optimizer.update(solution_guess_tmp_mtx, grad_mtx, f0);
-            }
+        state.ADAM_status = 0;   
 
-            sub_iter_idx++;
+        //optimizer->eta = 1e-3;
 
-        }
-        sstream.str("");
-        sstream << "obtained minimum: " << current_minimum << std::endl;
+    }
 
+    else {
+        state.ADAM_status = optimizer->update(parameters, grad, f0);
+    }
 
-        gsl_vector_free(grad_gsl);
-        gsl_vector_free(solution_guess_tmp);
-        tbb::tick_count adam_end = tbb::tick_count::now();
-        adam_time  = adam_time + (adam_end-adam_start).seconds();
-        sstream << "adam time: " << adam_time << ", pure DFE time:  " << pure_DFE_time << " " << f0 << std::endl;
+    state.sub_iter_idx++;
 
-        print(sstream, 0); 
+    return true;
 
 }
 
@@ -803,51 +813,30 @@ void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_BFGS( int num_
         std::uniform_real_distribution<> distrib_real(0.0, 2*M_PI);
 
 
+        // the working arrays of the optimizer are allocated once and reused in the restarts
+        LBFGS lbfgs( num_of_parameters, optimization_problem_combined, optimization_problem_batch, this );
+        Matrix_real solution_guess_mtx( solution_guess_gsl->data, 1, num_of_parameters );
+
         // do the optimization loops
         for (int idx=0; idx<iteration_loops_max; idx++) {
 	    
             int iter = 0;
-            int status;
 
-            const gsl_multimin_fdfminimizer_type *T;
-            gsl_multimin_fdfminimizer *s;
-
-            N_Qubit_Decomposition_Base* par = this;
-
-
-            gsl_multimin_function_fdf my_func;
-
-
-            my_func.n = num_of_parameters;
-            my_func.f = optimization_problem;
-            my_func.df = optimization_problem_grad;
-            my_func.fdf = optimization_problem_combined;
-            my_func.params = par;
-
-
-            T = gsl_multimin_fdfminimizer_vector_bfgs2;
-            s = gsl_multimin_fdfminimizer_alloc (T, num_of_parameters);
-
-            gsl_multimin_fdfminimizer_set(s, &my_func, solution_guess_gsl, 0.01, 0.1);
+            lbfgs.set( solution_guess_mtx );
 
             do {
                 iter++;
                 number_of_iters++;
-                gsl_set_error_handler_off();
-                status = gsl_multimin_fdfminimizer_iterate (s);
 
-                if (status) {
+                if ( lbfgs.iterate() != 0 ) {
                   break;
                 }
 
-                status = gsl_multimin_test_gradient (s->gradient, gradient_threshold);
+            } while (lbfgs.get_gradient_norm() >= gradient_threshold && iter < iter_max && !is_cancelled());
 
-            } while (status == GSL_CONTINUE && iter < iter_max);
-
-            if (current_minimum > s->f) {
-                current_minimum = s->f;
-                memcpy( optimized_parameters_mtx.get_data(), s->x->data, num_of_parameters*sizeof(double) );
-                gsl_multimin_fdfminimizer_free (s);
+            if (current_minimum > lbfgs.get_f()) {
+                current_minimum = lbfgs.get_f();
+                memcpy( optimized_parameters_mtx.get_data(), lbfgs.get_x().get_data(), num_of_parameters*sizeof(double) );
 
                 for ( int jdx=0; jdx<num_of_parameters; jdx++) {
                     solution_guess_gsl->data[jdx] = solution_guess_gsl->data[jdx] + distrib_real(gen)/100;
@@ -857,14 +846,15 @@ void N_Qubit_Decomposition_Base::solve_layer_optimization_problem_BFGS( int num_
                 for ( int jdx=0; jdx<num_of_parameters; jdx++) {
                     solution_guess_gsl->data[jdx] = solution_guess_gsl->data[jdx] + distrib_real(gen);
                 }
-                gsl_multimin_fdfminimizer_free (s);
             }
 
 #ifdef __MPI__        
             MPI_Bcast( (void*)solution_guess_gsl->data, num_of_parameters, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 #endif
 
-
+            if ( is_cancelled() ) {
+                break;
+            }
 
         }
 
@@ -927,40 +917,25 @@ bfgs_time = 0.0;
         // random generator of integers   
         std::uniform_int_distribution<> distrib_int(0, 5000);  
 
+        // the working arrays of the optimizer are allocated once and reused in the restarts
+        LBFGS lbfgs( num_of_parameters, optimization_problem_combined, optimization_problem_batch, this );
+        Matrix_real solution_guess_mtx( solution_guess_gsl->data, 1, num_of_parameters );
+
         // do the optimization loops
         for (int idx=0; idx<iteration_loops_max; idx++) {
 
             int iter_idx = 0;
-            int status = GSL_CONTINUE;
-
-            const gsl_multimin_fdfminimizer_type *T;
-            gsl_multimin_fdfminimizer *s;
-
-            N_Qubit_Decomposition_Base* par = this;
-
+            // true if the optimizer got stuck (small gradient or no progress along the search direction)
+            bool stuck = false;
 
-            gsl_multimin_function_fdf my_func;
-
-
-            my_func.n = num_of_parameters;
-            my_func.f = optimization_problem;
-            my_func.df = optimization_problem_grad;
-            my_func.fdf = optimization_problem_combined;
-            my_func.params = par;
-
-
-            T = gsl_multimin_fdfminimizer_vector_bfgs2;
-            s = gsl_multimin_fdfminimizer_alloc (T, num_of_parameters);
-
-            gsl_multimin_fdfminimizer_set(s, &my_func, solution_guess_gsl, 0.01, 0.1);
+            lbfgs.set( solution_guess_mtx );
 
             do {
-                gsl_set_error_handler_off();
                 
-                if ( sub_iter_idx > iteration_threshold_of_randomization || status != GSL_CONTINUE ) {
+                if ( sub_iter_idx > iteration_threshold_of_randomization || stuck ) {
 
                     std::stringstream sstream;
-                    sstream << "BFGS2: initiate randomization at " << s->f << std::endl;
+                    sstream << "BFGS2: initiate randomization at " << lbfgs.get_f() << std::endl;
                     print(sstream, 2); 
                     
                     sub_iter_idx = 0;
@@ -970,46 +945,40 @@ bfgs_time = 0.0;
                     int factor = distrib_int(gen) % 10 + 1;
              
                     for ( int jdx=0; jdx<num_of_parameters; jdx++) {
-                        solution_guess_gsl->data[jdx] = optimized_parameters_mtx[jdx] + distrib_real(gen)*2*M_PI*std::sqrt(s->f)/factor;
+                        solution_guess_gsl->data[jdx] = optimized_parameters_mtx[jdx] + distrib_real(gen)*2*M_PI*std::sqrt(lbfgs.get_f())/factor;
                     } 
 
 #ifdef __MPI__        
                     MPI_Bcast( (void*)solution_guess_gsl->data, num_of_parameters, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 #endif
                     
-                    status = 0;    
+                    stuck = false;    
                     
-                    gsl_multimin_fdfminimizer_free (s);                     
-                    s = gsl_multimin_fdfminimizer_alloc (T, num_of_parameters);  
-                    gsl_multimin_fdfminimizer_set(s, &my_func, solution_guess_gsl, 0.01, 0.1);                             
+                    // warm restart without reallocating the optimizer
+                    lbfgs.set( solution_guess_mtx );
         
                 }
                 else {
-                    status = gsl_multimin_fdfminimizer_iterate (s);
+                    stuck = lbfgs.iterate() != 0;
                 }
                                 
-/*
-                if (status) {
-                  break;
-                }
-*/
-                status = gsl_multimin_test_gradient (s->gradient, gradient_threshold);
+                stuck = stuck || lbfgs.get_gradient_norm() < gradient_threshold;
                 
                 
                 if (sub_iter_idx == 1 ) {
-                     current_minimum_hold = s->f;    
+                     current_minimum_hold = lbfgs.get_f();    
                 }
 
 
-                if (current_minimum_hold*0.95 > s->f || (current_minimum_hold*0.97 > s->f && s->f < 1e-3) ||  (current_minimum_hold*0.99 > s->f && s->f < 1e-4) ) {
+                if (current_minimum_hold*0.95 > lbfgs.get_f() || (current_minimum_hold*0.97 > lbfgs.get_f() && lbfgs.get_f() < 1e-3) ||  (current_minimum_hold*0.99 > lbfgs.get_f() && lbfgs.get_f() < 1e-4) ) {
                      sub_iter_idx = 0;
-                     current_minimum_hold = s->f;        
+                     current_minimum_hold = lbfgs.get_f();        
                 }
     
     
-                if (current_minimum > s->f ) {
-                     current_minimum = s->f;
-                     memcpy( optimized_parameters_mtx.get_data(),  s->x->data, num_of_parameters*sizeof(double) );
+                if (current_minimum > lbfgs.get_f() ) {
+                     current_minimum = lbfgs.get_f();
+                     memcpy( optimized_parameters_mtx.get_data(), lbfgs.get_x().get_data(), num_of_parameters*sizeof(double) );
                 }
     
 
@@ -1023,7 +992,7 @@ bfgs_time = 0.0;
                 }
 
 
-                if (s->f < optimization_tolerance || random_shift_count > random_shift_count_max ) {
+                if (lbfgs.get_f() < optimization_tolerance || random_shift_count > random_shift_count_max || is_cancelled() ) {
                     break;
                 }
 
@@ -1032,11 +1001,11 @@ bfgs_time = 0.0;
                 iter_idx++;
                 number_of_iters++;
 
-            } while (iter_idx < iter_max && s->f > optimization_tolerance);
+            } while (iter_idx < iter_max && lbfgs.get_f() > optimization_tolerance);
 
-            if (current_minimum > s->f) {
-                current_minimum = s->f;
-                memcpy( optimized_parameters_mtx.get_data(), s->x->data, num_of_parameters*sizeof(double) );                
+            if (current_minimum > lbfgs.get_f()) {
+                current_minimum = lbfgs.get_f();
+                memcpy( optimized_parameters_mtx.get_data(), lbfgs.get_x().get_data(), num_of_parameters*sizeof(double) );                
 
                 for ( int jdx=0; jdx<num_of_parameters; jdx++) {
                     solution_guess_gsl->data[jdx] = optimized_parameters_mtx[jdx] + distrib_real(gen)*2*M_PI/100;
@@ -1052,9 +1021,7 @@ bfgs_time = 0.0;
             MPI_Bcast( (void*)solution_guess_gsl->data, num_of_parameters, MPI_DOUBLE, 0, MPI_COMM_WORLD);
 #endif
             
-            gsl_multimin_fdfminimizer_free (s);
-            
-            if (current_minimum < optimization_tolerance ) {
+            if (current_minimum < optimization_tolerance || is_cancelled() ) {
                 break;
             }
 
@@ -1159,6 +1126,22 @@ double N_Qubit_Decomposition_Base::optimization_problem( double* parameters ) {
 
     // get the transformed matrix with the gates in the list
     Matrix_real parameters_mtx(parameters, 1, parameter_num );
+
+    if ( use_trace_estimation() ) {
+        Matrix&& traces = get_trace_with_correction_estimated( parameters_mtx );
+        return get_cost_function_from_traces( traces );
+    }
+
+    if ( use_meet_in_the_middle() ) {
+        Matrix&& traces = get_trace_meet_in_the_middle( parameters_mtx );
+        return get_cost_function_from_traces( traces );
+    }
+
+    if ( use_column_tiles() ) {
+        Matrix&& traces = get_trace_with_correction_tiled( parameters_mtx );
+        return get_cost_function_from_traces( traces );
+    }
+
     Matrix matrix_new = get_transformed_matrix( parameters_mtx, gates.begin(), gates.size(), Umtx );
 
 
@@ -1210,6 +1193,20 @@ double N_Qubit_Decomposition_Base::optimization_problem( Matrix_real& parameters
         exit(-1);
     }
 
+    if ( use_trace_estimation() ) {
+        Matrix&& traces = get_trace_with_correction_estimated( parameters );
+        return get_cost_function_from_traces( traces );
+    }
+
+    if ( use_meet_in_the_middle() ) {
+        Matrix&& traces = get_trace_meet_in_the_middle( parameters );
+        return get_cost_function_from_traces( traces );
+    }
+
+    if ( use_column_tiles() ) {
+        Matrix&& traces = get_trace_with_correction_tiled( parameters );
+        return get_cost_function_from_traces( traces );
+    }
 
     Matrix matrix_new = get_transformed_matrix( parameters, gates.begin(), gates.size(), Umtx );
 //matrix_new.print_matrix();
@@ -1261,10 +1258,31 @@ double N_Qubit_Decomposition_Base::optimization_problem( const gsl_vector* param
     // get the transformed matrix with the gates in the list
     Matrix Umtx_loc = instance->get_Umtx();
     Matrix_real parameters_mtx(parameters->data, 1, instance->get_parameter_num() );
+    cost_function_type cost_fnc = instance->get_cost_function_variant();
+
+    if ( instance->use_trace_estimation() || instance->use_meet_in_the_middle() || instance->use_column_tiles() ) {
+
+        Matrix traces;
+        if ( instance->use_trace_estimation() ) {
+            traces = instance->get_trace_with_correction_estimated( parameters_mtx );
+        }
+        else if ( instance->use_meet_in_the_middle() ) {
+            traces = instance->get_trace_meet_in_the_middle( parameters_mtx );
+        }
+        else {
+            traces = instance->get_trace_with_correction_tiled( parameters_mtx );
+        }
+
+        if ( cost_fnc == HILBERT_SCHMIDT_TEST || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ) {
+            int trace_num = ret_temp.size() < 3 ? ret_temp.size() : 3;
+            memcpy( ret_temp.get_data(), traces.get_data(), trace_num*sizeof(QGD_Complex16) );
+        }
+
+        return instance->get_cost_function_from_traces( traces );
+    }
+
     Matrix matrix_new = instance->get_transformed_matrix( parameters_mtx, gates_loc.begin(), gates_loc.size(), Umtx_loc );
 
-  
-    cost_function_type cost_fnc = instance->get_cost_function_variant();
 
     if ( cost_fnc == FROBENIUS_NORM ) {
         return get_cost_function(matrix_new, instance->get_trace_offset());
@@ -1272,7 +1290,7 @@ double N_Qubit_Decomposition_Base::optimization_problem( const gsl_vector* param
     else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
         double correction1_scale    = instance->get_correction1_scale();
         Matrix_real&& ret = get_cost_function_with_correction(matrix_new, instance->get_qbit_num(), instance->get_trace_offset());
-        return ret[0] - 0*std::sqrt(instance->get_previous_cost_function_value())*ret[1]*correction1_scale;
+        return ret[0] - std::sqrt(instance->get_previous_cost_function_value())*ret[1]*correction1_scale;
     }
     else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
         double correction1_scale    = instance->get_correction1_scale();
@@ -1325,6 +1343,20 @@ double N_Qubit_Decomposition_Base::optimization_problem( const gsl_vector* param
 
 Matrix_real N_Qubit_Decomposition_Base::optimization_problem_batch( int batchsize, const gsl_vector* parameters, void* void_instance) {
     N_Qubit_Decomposition_Base* instance = reinterpret_cast<N_Qubit_Decomposition_Base*>(void_instance);
+    Matrix_real parameters_mtx(parameters->data, batchsize, instance->get_parameter_num());
+    return optimization_problem_batch( parameters_mtx, void_instance );
+}
+
+
+/**
+@brief The cost function evaluated for a batch of parameter vectors
+@param parameters The parameter vectors stored in the rows of the matrix
+@param void_instance A void pointer pointing to the instance of the current class.
+@return Returns with a column vector of the cost function values.
+*/
+Matrix_real N_Qubit_Decomposition_Base::optimization_problem_batch( Matrix_real& parameters, void* void_instance) {
+    N_Qubit_Decomposition_Base* instance = reinterpret_cast<N_Qubit_Decomposition_Base*>(void_instance);
+    int batchsize = parameters.rows;
     Matrix_real costs(batchsize,1);
     // the number of free parameters
     int parameter_num_loc = instance->get_parameter_num();
@@ -1341,7 +1373,7 @@ Matrix_real N_Qubit_Decomposition_Base::optimization_problem_batch( int batchsiz
         Matrix&& Umtx_loc = instance->get_Umtx();
         Matrix_real trace_DFE_mtx(batchsize, 3);
         int gatesNum;
-        Matrix_real parameters_mtx(parameters->data, 1, parameters->size);
+        Matrix_real parameters_mtx(parameters.get_data(), 1, batchsize*parameter_num_loc);
         DFEgate_kernel_type* DFEgates = instance->convert_to_DFE_gates( parameters_mtx, gatesNum);
         lock_lib();
         calcqgdKernelDFE( Umtx_loc.rows, Umtx_loc.cols, DFEgates, parameter_num_loc, batchsize, trace_offset_loc, trace_DFE_mtx.get_data() );
@@ -1350,7 +1382,7 @@ Matrix_real N_Qubit_Decomposition_Base::optimization_problem_batch( int batchsiz
             if ( cost_fnc == FROBENIUS_NORM ) {
                 costs[idx] = 1-trace_DFE_mtx[3*idx]/Umtx_loc.cols;
             } else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
-                costs[idx] = 1 - (trace_DFE_mtx[3*idx] + 0*std::sqrt(prev_cost_fnv_val)*trace_DFE_mtx[3*idx+1]*correction1_scale)/Umtx_loc.cols;
+                costs[idx] = 1 - (trace_DFE_mtx[3*idx] + std::sqrt(prev_cost_fnv_val)*trace_DFE_mtx[3*idx+1]*correction1_scale)/Umtx_loc.cols;
             }
             else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
                 costs[idx] = 1 - (trace_DFE_mtx[3*idx] + std::sqrt(prev_cost_fnv_val)*(trace_DFE_mtx[3*idx+1]*correction1_scale + trace_DFE_mtx[3*idx+2]*correction2_scale))/Umtx_loc.cols;
@@ -1362,13 +1394,29 @@ Matrix_real N_Qubit_Decomposition_Base::optimization_problem_batch( int batchsiz
         }
     } else {
 #else
-    tbb::parallel_for( tbb::blocked_range<int>(0,batchsize,2), [&](tbb::blocked_range<int> r) {
-        Matrix ret(batchsize,3);
-        for (int idx=r.begin(); idx<r.end(); ++idx) {
-            gsl_vector_view view = gsl_vector_subvector(parameters, parameter_num_loc * idx, parameter_num_loc);
-            costs[idx] = instance->optimization_problem(&view.vector, void_instance, ret);
+    if ( instance->use_trace_estimation() ) {
+        tbb::parallel_for( tbb::blocked_range<int>(0,batchsize,2), [&](tbb::blocked_range<int> r) {
+            Matrix ret(batchsize,3);
+            for (int idx=r.begin(); idx<r.end(); ++idx) {
+                gsl_vector parameters_gsl;
+                parameters_gsl.data = parameters.get_data() + idx*parameters.stride;
+                parameters_gsl.size = parameter_num_loc;
+                parameters_gsl.stride = 1;
+                parameters_gsl.block = NULL;
+                parameters_gsl.owner = 0;
+                costs[idx] = instance->optimization_problem(&parameters_gsl, void_instance, ret);
+            }
+        });
+    }
+    else {
+        // the parameter vectors are evaluated together in a single pass over the tiles of the unitary
+        Matrix&& traces = instance->get_trace_with_correction_batched( parameters );
+
+        for (int idx=0; idx<batchsize; idx++) {
+            Matrix traces_loc( traces.get_data() + idx*traces.stride, 1, 3 );
+            costs[idx] = instance->get_cost_function_from_traces( traces_loc );
         }
-    });
+    }
 #endif
 #ifdef __DFE__
     }
@@ -1404,6 +1452,8 @@ void N_Qubit_Decomposition_Base::optimization_problem_combined( const gsl_vector
 
     N_Qubit_Decomposition_Base* instance = reinterpret_cast<N_Qubit_Decomposition_Base*>(void_instance);
 
+#ifdef __DFE__
+
     // the number of free parameters
     int parameter_num_loc = instance->get_parameter_num();
 
@@ -1415,11 +1465,8 @@ void N_Qubit_Decomposition_Base::optimization_problem_combined( const gsl_vector
     double correction1_scale    = instance->get_correction1_scale();
     double correction2_scale    = instance->get_correction2_scale();    
 
-    int qbit_num = instance->get_qbit_num();
     int trace_offset_loc = instance->get_trace_offset();
 
-#ifdef __DFE__
-
 ///////////////////////////////////////
 //std::cout << "number of qubits: " << instance->qbit_num << std::endl;
 //tbb::tick_count t0_DFE = tbb::tick_count::now();/////////////////////////////////    
@@ -1465,7 +1512,7 @@ if ( instance->qbit_num >= 2 && instance->get_accelerator_num() > 0 ) {
         *f0 = 1-trace_DFE_mtx[0]/Umtx_loc.cols;
     }
     else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
-        *f0 = 1 - (trace_DFE_mtx[0] + 0*std::sqrt(prev_cost_fnv_val)*trace_DFE_mtx[1]*correction1_scale)/Umtx_loc.cols;
+        *f0 = 1 - (trace_DFE_mtx[0] + std::sqrt(prev_cost_fnv_val)*trace_DFE_mtx[1]*correction1_scale)/Umtx_loc.cols;
     }
     else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
         *f0 = 1 - (trace_DFE_mtx[0] + std::sqrt(prev_cost_fnv_val)*(trace_DFE_mtx[1]*correction1_scale + trace_DFE_mtx[2]*correction2_scale))/Umtx_loc.cols;
@@ -1515,67 +1562,35 @@ else {
 tbb::tick_count t0_CPU = tbb::tick_count::now();/////////////////////////////////
 #endif
 
-    Matrix_real cost_function_terms;
-
-    // vector containing gradients of the transformed matrix
-    std::vector<Matrix> Umtx_deriv;
-    Matrix trace_tmp(1,3);
-
-    tbb::parallel_invoke(
-        [&]{
-            *f0 = instance->optimization_problem(parameters, reinterpret_cast<void*>(instance), trace_tmp); 
-        },
-        [&]{
-            Matrix&& Umtx_loc = instance->get_Umtx();   
-            Matrix_real parameters_mtx(parameters->data, 1, parameters->size);
-            Umtx_deriv = instance->apply_derivate_to( parameters_mtx, Umtx_loc );
-        });
+    Matrix_real parameters_mtx(parameters->data, 1, parameters->size);
+    Matrix_real grad_mtx(grad->data, 1, grad->size);
 
+    bool estimated = false;
 
+    if ( instance->use_trace_estimation() ) {
 
+        // estimate the cost function and the gradient components from the sampled columns
+        double standard_error;
+        *f0 = instance->get_cost_function_and_gradient_estimated( parameters_mtx, grad_mtx, standard_error );
 
-    tbb::parallel_for( tbb::blocked_range<int>(0,parameter_num_loc,2), [&](tbb::blocked_range<int> r) {
-        for (int idx=r.begin(); idx<r.end(); ++idx) { 
+        // adjust the number of probe vectors to the accuracy needed at the current cost function
+        estimated = instance->update_trace_estimation( *f0, standard_error );
+    }
 
-            double grad_comp;
-            if ( cost_fnc == FROBENIUS_NORM ) {
-                grad_comp = (get_cost_function(Umtx_deriv[idx], trace_offset_loc) - 1.0);
-            }
-            else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
-                Matrix_real deriv_tmp = get_cost_function_with_correction( Umtx_deriv[idx], qbit_num, trace_offset_loc );
-                grad_comp = (deriv_tmp[0] - std::sqrt(prev_cost_fnv_val)*deriv_tmp[1]*correction1_scale - 1.0);
-            }
-            else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
-                Matrix_real deriv_tmp = get_cost_function_with_correction2( Umtx_deriv[idx], qbit_num, trace_offset_loc );
-                grad_comp = (deriv_tmp[0] - std::sqrt(prev_cost_fnv_val)*(deriv_tmp[1]*correction1_scale + deriv_tmp[2]*correction2_scale) - 1.0);
-            }
-            else if (cost_fnc == HILBERT_SCHMIDT_TEST){
-                double d = 1.0/Umtx_deriv[idx].cols;
-                QGD_Complex16 deriv_tmp = get_trace(Umtx_deriv[idx]);
-                grad_comp = -2.0*d*d*trace_tmp[0].real*deriv_tmp.real-2.0*d*d*trace_tmp[0].imag*deriv_tmp.imag;
-            }
-            else if ( cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 ){
-                Matrix&&  deriv_tmp = get_trace_with_correction( Umtx_deriv[idx], qbit_num);
-                double d = 1.0/Umtx_deriv[idx].cols;
-                grad_comp = -2.0*d*d* (trace_tmp[0].real*deriv_tmp[0].real+trace_tmp[0].imag*deriv_tmp[0].imag+std::sqrt(prev_cost_fnv_val)*correction1_scale*(trace_tmp[1].real*deriv_tmp[1].real+trace_tmp[1].imag*deriv_tmp[1].imag));
-            }
-            else if ( cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ){
-                Matrix&& deriv_tmp = get_trace_with_correction2( Umtx_deriv[idx], qbit_num);
-                double d = 1.0/Umtx_deriv[idx].cols;
-                grad_comp = -2.0*d*d* (trace_tmp[0].real*deriv_tmp[0].real+trace_tmp[0].imag*deriv_tmp[0].imag+std::sqrt(prev_cost_fnv_val)*(correction1_scale*(trace_tmp[1].real*deriv_tmp[1].real+trace_tmp[1].imag*deriv_tmp[1].imag) + correction2_scale*(trace_tmp[2].real*deriv_tmp[2].real+trace_tmp[2].imag*deriv_tmp[2].imag)));
-            }
-            else {
-                std::string err("N_Qubit_Decomposition_Base::optimization_problem_combined: Cost function variant not implmented.");
-                throw err;
-            }
-            
-//            grad->data[idx] = grad_comp;
-            gsl_vector_set(grad, idx, grad_comp);
+    if ( !estimated ) {
 
+        // calculate the transformed matrix
+        Matrix&& Umtx_loc = instance->get_Umtx();
+        Matrix transformed = Umtx_loc.copy();
+        instance->apply_to( parameters_mtx, transformed );
 
+        // calculate the cost function and its derivative with respect to the elements of the transformed matrix
+        Matrix adjoint_seed;
+        *f0 = instance->get_cost_function_with_adjoint_seed( transformed, adjoint_seed );
 
-        }
-    });
+        // calculate the gradient components in a single sweep through the inverted gates
+        instance->apply_adjoint_derivate_to( parameters_mtx, transformed, adjoint_seed, grad_mtx );
+    }
 
     std::stringstream sstream;
     sstream << *f0 << std::endl;
@@ -1621,6 +1636,725 @@ std::string error("N_Qubit_Decomposition_Base::optimization_problem_combined");
 
 
 
+/**
+@brief Call to calculate the cost function from the transformed matrix and the seed matrix of the adjoint gradient calculation. The seed is the derivative of the cost function with respect to the elements of the transformed matrix, so that the gradient component corresponding to a parameter p is given by Re Tr(seed^dagger * d(transformed)/dp).
+@param matrix_new The transformed matrix.
+@param seed The calculated seed matrix (returned by reference, shaped as matrix_new)
+@return Returns with the cost function.
+*/
+double N_Qubit_Decomposition_Base::get_cost_function_with_adjoint_seed( Matrix& matrix_new, Matrix& seed ) {
+
+    seed = Matrix( matrix_new.rows, matrix_new.cols );
+    memset( seed.get_data(), 0.0, seed.size()*sizeof(QGD_Complex16) );
+
+    int matrix_size = matrix_new.cols;
+
+    double correction1_weight = std::sqrt(prev_cost_fnv_val)*correction1_scale;
+    double correction2_weight = std::sqrt(prev_cost_fnv_val)*correction2_scale;
+
+    // complex weights of the trace, the first and the second corrections in the seed matrix
+    QGD_Complex16 weight0, weight1, weight2;
+    double cost_function;
+
+    if ( cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
+
+        weight0.real = -1.0/matrix_size;
+        weight0.imag = 0.0;
+        weight1.real = cost_fnc == FROBENIUS_NORM ? 0.0 : -correction1_weight/matrix_size;
+        weight1.imag = 0.0;
+        weight2.real = cost_fnc == FROBENIUS_NORM_CORRECTION2 ? -correction2_weight/matrix_size : 0.0;
+        weight2.imag = 0.0;
+
+        if ( cost_fnc == FROBENIUS_NORM ) {
+            cost_function = get_cost_function(matrix_new, trace_offset);
+        }
+        else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
+            Matrix_real&& ret = get_cost_function_with_correction(matrix_new, qbit_num, trace_offset);
+            cost_function = ret[0] - correction1_weight*ret[1];
+        }
+        else {
+            Matrix_real&& ret = get_cost_function_with_correction2(matrix_new, qbit_num, trace_offset);
+            cost_function = ret[0] - (ret[1]*correction1_weight + ret[2]*correction2_weight);
+        }
+
+    }
+    else if ( cost_fnc == HILBERT_SCHMIDT_TEST || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ) {
+
+        double d = 1.0/matrix_size;
+        Matrix&& ret = get_trace_with_correction2(matrix_new, qbit_num);
+
+        weight0.real = -2.0*d*d*ret[0].real;
+        weight0.imag = -2.0*d*d*ret[0].imag;
+        weight1.real = cost_fnc == HILBERT_SCHMIDT_TEST ? 0.0 : -2.0*d*d*correction1_weight*ret[1].real;
+        weight1.imag = cost_fnc == HILBERT_SCHMIDT_TEST ? 0.0 : -2.0*d*d*correction1_weight*ret[1].imag;
+        weight2.real = cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ? -2.0*d*d*correction2_weight*ret[2].real : 0.0;
+        weight2.imag = cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ? -2.0*d*d*correction2_weight*ret[2].imag : 0.0;
+
+        double trace0_sqr = ret[0].real*ret[0].real + ret[0].imag*ret[0].imag;
+        double trace1_sqr = ret[1].real*ret[1].real + ret[1].imag*ret[1].imag;
+        double trace2_sqr = ret[2].real*ret[2].real + ret[2].imag*ret[2].imag;
+
+        if ( cost_fnc == HILBERT_SCHMIDT_TEST ) {
+            cost_function = 1.0 - d*d*trace0_sqr;
+        }
+        else if ( cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 ) {
+            cost_function = 1.0 - d*d*(trace0_sqr + correction1_weight*trace1_sqr);
+        }
+        else {
+            cost_function = 1.0 - d*d*(trace0_sqr + correction1_weight*trace1_sqr + correction2_weight*trace2_sqr);
+        }
+
+    }
+    else {
+        std::string err("N_Qubit_Decomposition_Base::get_cost_function_with_adjoint_seed: Cost function variant not implmented.");
+        throw err;
+    }
+
+    // the Hilbert Schmidt test does not use the trace offset
+    int offset = (cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2) ? trace_offset : 0;
+
+    for (int col_idx=0; col_idx<matrix_size; col_idx++) {
+
+        int row_idx = col_idx + offset;
+        seed[row_idx*seed.stride + col_idx] = weight0;
+
+        if ( weight1.real == 0.0 && weight1.imag == 0.0 && weight2.real == 0.0 && weight2.imag == 0.0 ) {
+            continue;
+        }
+
+        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
+
+            // elements with one bit error at the given qbit_idx
+            int row_idx_error = row_idx ^ (1 << qbit_idx);
+            seed[row_idx_error*seed.stride + col_idx] = weight1;
+
+            // elements with two bit errors
+            for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
+                int row_idx_error2 = row_idx ^ ((1 << qbit_idx) + (1 << qbit_idx2));
+                seed[row_idx_error2*seed.stride + col_idx] = weight2;
+            }
+
+        }
+
+    }
+
+    return cost_function;
+
+}
+
+
+
+/**
+@brief Call to determine whether the cost function is evaluated over column tiles of the unitary. (The tiles are used when the unitary does not fit into the cache memory.)
+@return Returns with true if the column tiles are used, false otherwise.
+*/
+bool N_Qubit_Decomposition_Base::use_column_tiles() {
+
+    return Umtx.rows*Umtx.cols*(int)sizeof(QGD_Complex16) > column_tile_bytes;
+
+}
+
+
+/**
+@brief Call to calculate the (shifted) trace of the transformed unitary and its corrections needed by the chosen cost function variant. The columns of the unitary are transformed independently in tiles fitting into the cache memory: the whole gate sequence is applied on one tile (in parallel over the tiles) and only the contribution of the tile to the traces is kept, so the transformed unitary is never stored.
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the trace (index 0), the first correction (index 1) and the second correction (index 2). (The Hilbert Schmidt test variants use zero trace offset.)
+*/
+Matrix N_Qubit_Decomposition_Base::get_trace_with_correction_tiled( Matrix_real& parameters ) {
+
+    Matrix_real parameters_batch( parameters.get_data(), 1, parameters.size() );
+    return get_trace_with_correction_batched( parameters_batch );
+
+}
+
+
+/**
+@brief Call to calculate the (shifted) traces of the unitary transformed with several parameter vectors and their corrections needed by the chosen cost function variant. The unitary is processed in column tiles fitting into the cache memory (see get_trace_with_correction_tiled): each tile is read from the memory once and transformed by the gates with all the parameter vectors while it is in the cache. The tiles and the parameter vectors are processed in parallel.
+@param parameters The parameter vectors of the gates stored in the rows of the matrix.
+@return Returns with the matrix containing the trace (column 0), the first correction (column 1) and the second correction (column 2) in the rows corresponding to the parameter vectors. (The Hilbert Schmidt test variants use zero trace offset.)
+*/
+Matrix N_Qubit_Decomposition_Base::get_trace_with_correction_batched( Matrix_real& parameters ) {
+
+    int correction_num;
+
+    if ( cost_fnc == FROBENIUS_NORM || cost_fnc == HILBERT_SCHMIDT_TEST ) {
+        correction_num = 0;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 ) {
+        correction_num = 1;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ) {
+        correction_num = 2;
+    }
+    else {
+        std::string err("N_Qubit_Decomposition_Base::get_trace_with_correction_batched: Cost function variant not implmented.");
+        throw err;
+    }
+
+    // the Hilbert Schmidt test does not use the trace offset
+    int offset = (cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2) ? trace_offset : 0;
+
+    int batch_size = parameters.rows;
+
+    // the number of columns in a tile
+    int tile_cols = column_tile_bytes/(Umtx.rows*(int)sizeof(QGD_Complex16));
+    tile_cols = tile_cols < 1 ? 1 : tile_cols;
+    int tile_num = (Umtx.cols + tile_cols - 1)/tile_cols;
+
+    std::vector<Matrix> partial_traces(tile_num*batch_size);
+
+    // the gates are compiled once and fused once for each parameter vector
+    std::vector<Tape_Instruction>& tape = get_tape();
+    std::vector< std::vector<Fused_Gate> > fused_gates(batch_size);
+
+    tbb::parallel_for( 0, batch_size, 1, [&](int batch_idx) {
+        fused_gates[batch_idx] = get_fused_gates( tape, 0, tape.size(), parameters.get_data() + batch_idx*parameters.stride );
+    });
+
+    tbb::parallel_for( 0, tile_num, 1, [&](int tile_idx) {
+
+        int col_offset = tile_idx*tile_cols;
+        int cols_loc = (col_offset + tile_cols > Umtx.cols) ? Umtx.cols - col_offset : tile_cols;
+
+        // copy the columns of the tile into a contiguous buffer
+        Matrix tile( Umtx.rows, cols_loc );
+        for (int row_idx=0; row_idx<Umtx.rows; row_idx++) {
+            memcpy( tile.get_data() + row_idx*tile.stride, Umtx.get_data() + row_idx*Umtx.stride + col_offset, cols_loc*sizeof(QGD_Complex16) );
+        }
+
+        tbb::parallel_for( 0, batch_size, 1, [&](int batch_idx) {
+
+            // a single parameter vector transforms the tile in place
+            Matrix tile_loc = batch_size > 1 ? tile.copy() : tile;
+
+            apply_fused_gates_to( fused_gates[batch_idx], tile_loc );
+
+            partial_traces[tile_idx*batch_size + batch_idx] = get_trace_with_correction_of_columns( tile_loc, col_offset, qbit_num, offset, correction_num );
+
+        });
+
+    });
+
+
+    // sum up the contributions of the tiles in a fixed order to get reproducible results
+    Matrix ret(batch_size,3);
+    memset( ret.get_data(), 0.0, ret.rows*ret.stride*sizeof(QGD_Complex16) );
+
+    for (int batch_idx=0; batch_idx<batch_size; batch_idx++) {
+        for (int tile_idx=0; tile_idx<tile_num; tile_idx++) {
+            Matrix& partial_trace = partial_traces[tile_idx*batch_size + batch_idx];
+            for (int idx=0; idx<3; idx++) {
+                ret[batch_idx*ret.stride + idx].real += partial_trace[idx].real;
+                ret[batch_idx*ret.stride + idx].imag += partial_trace[idx].imag;
+            }
+        }
+    }
+
+    return ret;
+
+}
+
+
+/**
+@brief Call to calculate the cost function from the traces returned by get_trace_with_correction_tiled.
+@param traces The matrix containing the trace (index 0), the first correction (index 1) and the second correction (index 2).
+@return Returns with the cost function.
+*/
+double N_Qubit_Decomposition_Base::get_cost_function_from_traces( Matrix& traces ) {
+
+    double d = 1.0/Umtx.cols;
+
+    if ( cost_fnc == FROBENIUS_NORM ) {
+        return 1.0 - d*traces[0].real;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 ) {
+        return 1.0 - d*traces[0].real - std::sqrt(prev_cost_fnv_val)*d*traces[1].real*correction1_scale;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
+        return 1.0 - d*traces[0].real - std::sqrt(prev_cost_fnv_val)*d*(traces[1].real*correction1_scale + traces[2].real*correction2_scale);
+    }
+    else if ( cost_fnc == HILBERT_SCHMIDT_TEST){
+        return 1.0 - d*d*(traces[0].real*traces[0].real+traces[0].imag*traces[0].imag);
+    }
+    else if ( cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 ){
+        return 1.0 - d*d*(traces[0].real*traces[0].real+traces[0].imag*traces[0].imag+std::sqrt(prev_cost_fnv_val)*correction1_scale*(traces[1].real*traces[1].real+traces[1].imag*traces[1].imag));
+    }
+    else if ( cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ){
+        return 1.0 - d*d*(traces[0].real*traces[0].real+traces[0].imag*traces[0].imag+std::sqrt(prev_cost_fnv_val)*(correction1_scale*(traces[1].real*traces[1].real+traces[1].imag*traces[1].imag)+correction2_scale*(traces[2].real*traces[2].real+traces[2].imag*traces[2].imag)));
+    }
+    else {
+        std::string err("N_Qubit_Decomposition_Base::get_cost_function_from_traces: Cost function variant not implmented.");
+        throw err;
+    }
+
+}
+
+
+/**
+@brief Call to calculate the trace of the product of two square matrices, Tr(left*right) = sum_ij left_ij*right_ji, without calculating the product. The rows of the left matrix are processed in parallel in blocks, and the elements are visited in square tiles, so the transposed access of the right matrix stays in the cache.
+@param left The matrix on the left side of the product
+@param right The matrix on the right side of the product
+@return Returns with the trace of the product
+*/
+static QGD_Complex16
+get_trace_of_product( Matrix& left, Matrix& right ) {
+
+    int block_size = left.rows < 32 ? left.rows : 32;
+    int block_num = (left.rows + block_size - 1)/block_size;
+
+    std::vector<QGD_Complex16> partial_traces(block_num);
+
+    tbb::parallel_for( 0, block_num, 1, [&](int block_idx) {
+
+        int row_start = block_idx*block_size;
+        int row_end = row_start + block_size < left.rows ? row_start + block_size : left.rows;
+
+        double trace_real = 0.0;
+        double trace_imag = 0.0;
+
+        for (int col_start=0; col_start<left.cols; col_start=col_start+block_size) {
+
+            int col_end = col_start + block_size < left.cols ? col_start + block_size : left.cols;
+
+            for (int row_idx=row_start; row_idx<row_end; row_idx++) {
+                for (int col_idx=col_start; col_idx<col_end; col_idx++) {
+                    QGD_Complex16& element_left = left[row_idx*left.stride + col_idx];
+                    QGD_Complex16& element_right = right[col_idx*right.stride + row_idx];
+                    trace_real = trace_real + element_left.real*element_right.real - element_left.imag*element_right.imag;
+                    trace_imag = trace_imag + element_left.real*element_right.imag + element_left.imag*element_right.real;
+                }
+            }
+
+        }
+
+        partial_traces[block_idx].real = trace_real;
+        partial_traces[block_idx].imag = trace_imag;
+
+    });
+
+    // sum up the contributions of the blocks in a fixed order to get reproducible results
+    QGD_Complex16 trace;
+    trace.real = 0.0;
+    trace.imag = 0.0;
+    for (int block_idx=0; block_idx<block_num; block_idx++) {
+        trace.real = trace.real + partial_traces[block_idx].real;
+        trace.imag = trace.imag + partial_traces[block_idx].imag;
+    }
+
+    return trace;
+
+}
+
+
+/**
+@brief Call to determine whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle. (Possible when the cost function depends only on the trace of the transformed unitary.)
+@return Returns with true if the trace is evaluated from the two halves of the gate sequence, false otherwise.
+*/
+bool N_Qubit_Decomposition_Base::use_meet_in_the_middle() {
+
+    if ( !meet_in_the_middle || Umtx.rows != Umtx.cols ) {
+        return false;
+    }
+
+    return (cost_fnc == FROBENIUS_NORM && trace_offset == 0) || cost_fnc == HILBERT_SCHMIDT_TEST;
+
+}
+
+
+/**
+@brief Call to calculate the trace of the transformed unitary by meeting the two halves of the gate sequence in the middle. The gates are split into the sequences R applied first and L applied last on the unitary, so Tr(L*R*Umtx) = sum_ij L_ij (R*Umtx)_ji. The first half is applied on the unitary while the second half is applied from the right on the identity, which are two independent sweeps executed in parallel, followed by an elementwise product of the two matrices. (The chain of the dependent gate applications is halved compared to a single sweep through the gates.)
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the trace (index 0). (The corrections at indices 1 and 2 are set to zero.)
+*/
+Matrix N_Qubit_Decomposition_Base::get_trace_meet_in_the_middle( Matrix_real& parameters ) {
+
+    std::vector<Tape_Instruction>& tape = get_tape();
+    int tape_size = tape.size();
+
+    // the second half should contain only gates that can be applied from the right
+    int tape_middle = tape_size/2;
+    for (int idx=tape_size-1; idx>=tape_middle; idx--) {
+        if ( tape[idx].kernel_type == TAPE_GATE && tape[idx].gate->get_type() != GENERAL_OPERATION ) {
+            tape_middle = idx+1;
+            break;
+        }
+    }
+
+    Matrix right = Umtx.copy();
+    Matrix left = create_identity( Umtx.rows );
+
+    tbb::parallel_invoke(
+        [&]{ 
+            std::vector<Fused_Gate>&& fused_gates = get_fused_gates( tape, 0, tape_middle, parameters.get_data() );
+            apply_fused_gates_to( fused_gates, right ); 
+        },
+        [&]{ apply_tape_from_right( tape, tape_middle, tape_size, parameters.get_data(), left ); }
+    );
+
+    Matrix ret(1,3);
+    memset( ret.get_data(), 0.0, 3*sizeof(QGD_Complex16) );
+    ret[0] = get_trace_of_product( left, right );
+
+    return ret;
+
+}
+
+
+/**
+@brief Call to determine whether the trace in the cost function is estimated by column sampling.
+@return Returns with true if the trace is estimated, false if it is calculated exactly.
+*/
+bool N_Qubit_Decomposition_Base::use_trace_estimation() {
+
+    return trace_probe_num > 0;
+
+}
+
+
+/**
+@brief Call to sample new columns for the trace estimation and to apply the unitary Umtx on them. The trace is estimated by column sampling: the probe vectors are sqrt(N) times distinct unit vectors e_j chosen uniformly at random, so the mean of z^dagger*A*z = N*A_jj over the probes is an unbiased estimate of Tr(A) for any NxN matrix A. Umtx applied on the probes is given by the sampled columns of Umtx, so new columns can be sampled in O(probe number * N) time before every gradient evaluation.
+*/
+void N_Qubit_Decomposition_Base::generate_trace_probes() {
+
+    int matrix_size = Umtx.cols;
+    double norm = std::sqrt( (double)matrix_size );
+
+    // choose distinct columns by a partial Fisher-Yates shuffle
+    std::vector<int> columns( matrix_size );
+    for (int idx=0; idx<matrix_size; idx++) {
+        columns[idx] = idx;
+    }
+
+    for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+        std::uniform_int_distribution<> distrib_col(probe_idx, matrix_size-1);
+        std::swap( columns[probe_idx], columns[distrib_col(gen)] );
+    }
+
+    trace_probes = Matrix( matrix_size, trace_probe_num );
+    memset( trace_probes.get_data(), 0.0, trace_probes.size()*sizeof(QGD_Complex16) );
+
+    Umtx_probes = Matrix( Umtx.rows, trace_probe_num );
+
+    for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+
+        int col_idx = columns[probe_idx];
+
+        trace_probes[col_idx*trace_probes.stride + probe_idx].real = norm;
+
+        for (int row_idx=0; row_idx<Umtx.rows; row_idx++) {
+            QGD_Complex16& element = Umtx[row_idx*Umtx.stride + col_idx];
+            QGD_Complex16& element_probe = Umtx_probes[row_idx*Umtx_probes.stride + probe_idx];
+            element_probe.real = norm*element.real;
+            element_probe.imag = norm*element.imag;
+        }
+
+    }
+
+}
+
+
+/**
+@brief Call to estimate the (shifted) trace of the transformed unitary and its corrections needed by the chosen cost function variant from the random probe vectors. Only the probe vectors are transformed by the gates, so the cost is proportional to the number of the probes instead of the dimension of the unitary.
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the estimated trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+Matrix N_Qubit_Decomposition_Base::get_trace_with_correction_estimated( Matrix_real& parameters ) {
+
+    Matrix transformed = Umtx_probes.copy();
+    apply_to( parameters, transformed );
+
+    double standard_error;
+    return get_trace_with_correction_of_probes( transformed, standard_error );
+
+}
+
+
+/**
+@brief Call to get the bit masks of the elements contributing to the (shifted) trace and to the corrections needed by the chosen cost function variant. The element of column j contributes through row (j+offset)^mask.
+@param masks The bit masks with zero, one or two bits set (returned by reference)
+@param mask_terms The index of the term to which the elements of the masks contribute: 0 for the trace, 1 and 2 for the first and second corrections (returned by reference)
+*/
+void N_Qubit_Decomposition_Base::get_trace_masks( std::vector<int>& masks, std::vector<int>& mask_terms ) {
+
+    int correction_num;
+
+    if ( cost_fnc == FROBENIUS_NORM || cost_fnc == HILBERT_SCHMIDT_TEST ) {
+        correction_num = 0;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION1 ) {
+        correction_num = 1;
+    }
+    else if ( cost_fnc == FROBENIUS_NORM_CORRECTION2 || cost_fnc == HILBERT_SCHMIDT_TEST_CORRECTION2 ) {
+        correction_num = 2;
+    }
+    else {
+        std::string err("N_Qubit_Decomposition_Base::get_trace_masks: Cost function variant not implmented.");
+        throw err;
+    }
+
+    masks.push_back( 0 );
+    mask_terms.push_back( 0 );
+
+    if ( correction_num > 0 ) {
+        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
+            masks.push_back( 1 << qbit_idx );
+            mask_terms.push_back( 1 );
+        }
+    }
+
+    if ( correction_num > 1 ) {
+        for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
+            for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
+                masks.push_back( (1 << qbit_idx) + (1 << qbit_idx2) );
+                mask_terms.push_back( 2 );
+            }
+        }
+    }
+
+}
+
+
+/**
+@brief Call to estimate the (shifted) trace and its corrections from the probe vectors transformed by the unitary and the gates. The trace of the bit errors given by mask is estimated by the average of sum_j conj(z_j) * (A*z)_{(j+offset)^mask} over the probe vectors z.
+@param transformed_probes The probe vectors transformed by the unitary and the gates.
+@param standard_error The standard error of the estimated cost function calculated from the scattering of the traces estimated from the individual probes (returned by reference)
+@return Returns with the matrix containing the estimated trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+Matrix N_Qubit_Decomposition_Base::get_trace_with_correction_of_probes( Matrix& transformed_probes, double& standard_error ) {
+
+    // the bit masks of the elements contributing to the trace and to the corrections
+    std::vector<int> masks, mask_terms;
+    get_trace_masks( masks, mask_terms );
+
+    // the Hilbert Schmidt test does not use the trace offset
+    int offset = (cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2) ? trace_offset : 0;
+
+    // the traces estimated from the individual probes (rows: trace, first and second corrections)
+    Matrix probe_traces( 3, trace_probe_num );
+    memset( probe_traces.get_data(), 0.0, probe_traces.size()*sizeof(QGD_Complex16) );
+
+    for (int col_idx=0; col_idx<Umtx.cols; col_idx++) {
+
+        QGD_Complex16* probe_row = trace_probes.get_data() + col_idx*trace_probes.stride;
+        int row_idx = col_idx + offset;
+
+        for (int mask_idx=0; mask_idx<(int)masks.size(); mask_idx++) {
+
+            int row_idx_error = row_idx ^ masks[mask_idx];
+            if ( row_idx_error >= transformed_probes.rows ) {
+                continue;
+            }
+
+            QGD_Complex16* transformed_row = transformed_probes.get_data() + row_idx_error*transformed_probes.stride;
+            QGD_Complex16* probe_traces_row = probe_traces.get_data() + mask_terms[mask_idx]*probe_traces.stride;
+
+            for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+                probe_traces_row[probe_idx].real += probe_row[probe_idx].real*transformed_row[probe_idx].real + probe_row[probe_idx].imag*transformed_row[probe_idx].imag;
+                probe_traces_row[probe_idx].imag += probe_row[probe_idx].real*transformed_row[probe_idx].imag - probe_row[probe_idx].imag*transformed_row[probe_idx].real;
+            }
+
+        }
+
+    }
+
+    // average the traces over the probes
+    Matrix ret(1,3);
+    memset( ret.get_data(), 0.0, 3*sizeof(QGD_Complex16) );
+
+    for (int idx=0; idx<3; idx++) {
+        for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+            ret[idx].real += probe_traces[idx*probe_traces.stride + probe_idx].real/trace_probe_num;
+            ret[idx].imag += probe_traces[idx*probe_traces.stride + probe_idx].imag/trace_probe_num;
+        }
+    }
+
+    // the standard error of the cost function is estimated from the scattering of the real part of the trace
+    double variance = 0.0;
+    for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+        double diff = probe_traces[probe_idx].real - ret[0].real;
+        variance += diff*diff;
+    }
+    variance = trace_probe_num > 1 ? variance/(trace_probe_num-1) : variance;
+
+    standard_error = std::sqrt(variance/trace_probe_num)/Umtx.cols;
+
+    return ret;
+
+}
+
+
+/**
+@brief Call to estimate the cost function from the transformed probe vectors and to calculate the seed matrix of the adjoint gradient calculation. The estimated traces are linear in the transformed probe vectors, hence the seed is given by the probe vectors weighted by the derivatives of the cost function with respect to the traces.
+@param transformed_probes The probe vectors transformed by the unitary and the gates.
+@param seed The calculated seed matrix (returned by reference, shaped as transformed_probes)
+@param standard_error The standard error of the estimated cost function (returned by reference)
+@return Returns with the estimated cost function.
+*/
+double N_Qubit_Decomposition_Base::get_cost_function_with_adjoint_seed_estimated( Matrix& transformed_probes, Matrix& seed, double& standard_error ) {
+
+    Matrix&& traces = get_trace_with_correction_of_probes( transformed_probes, standard_error );
+    double cost_function = get_cost_function_from_traces( traces );
+
+    double d = 1.0/Umtx.cols;
+    double correction1_weight = std::sqrt(prev_cost_fnv_val)*correction1_scale;
+    double correction2_weight = std::sqrt(prev_cost_fnv_val)*correction2_scale;
+
+    // complex weights of the trace, the first and the second corrections in the seed matrix (divided by the number of probes)
+    QGD_Complex16 weights[3];
+
+    if ( cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2 ) {
+        weights[0].real = -d;
+        weights[1].real = cost_fnc == FROBENIUS_NORM ? 0.0 : -correction1_weight*d;
+        weights[2].real = cost_fnc == FROBENIUS_NORM_CORRECTION2 ? -correction2_weight*d : 0.0;
+        for (int idx=0; idx<3; idx++) {
+            weights[idx].imag = 0.0;
+        }
+    }
+    else {
+        double trace_weights[3] = {1.0, correction1_weight, correction2_weight};
+        for (int idx=0; idx<3; idx++) {
+            weights[idx].real = -2.0*d*d*trace_weights[idx]*traces[idx].real;
+            weights[idx].imag = -2.0*d*d*trace_weights[idx]*traces[idx].imag;
+        }
+    }
+
+    for (int idx=0; idx<3; idx++) {
+        weights[idx].real = weights[idx].real/trace_probe_num;
+        weights[idx].imag = weights[idx].imag/trace_probe_num;
+    }
+
+    std::vector<int> masks, mask_terms;
+    get_trace_masks( masks, mask_terms );
+
+    int offset = (cost_fnc == FROBENIUS_NORM || cost_fnc == FROBENIUS_NORM_CORRECTION1 || cost_fnc == FROBENIUS_NORM_CORRECTION2) ? trace_offset : 0;
+
+    seed = Matrix( transformed_probes.rows, transformed_probes.cols );
+    memset( seed.get_data(), 0.0, seed.size()*sizeof(QGD_Complex16) );
+
+    for (int col_idx=0; col_idx<Umtx.cols; col_idx++) {
+
+        QGD_Complex16* probe_row = trace_probes.get_data() + col_idx*trace_probes.stride;
+        int row_idx = col_idx + offset;
+
+        for (int mask_idx=0; mask_idx<(int)masks.size(); mask_idx++) {
+
+            int row_idx_error = row_idx ^ masks[mask_idx];
+            if ( row_idx_error >= seed.rows ) {
+                continue;
+            }
+
+            QGD_Complex16* seed_row = seed.get_data() + row_idx_error*seed.stride;
+            QGD_Complex16& weight = weights[mask_terms[mask_idx]];
+
+            for (int probe_idx=0; probe_idx<trace_probe_num; probe_idx++) {
+                seed_row[probe_idx].real += weight.real*probe_row[probe_idx].real - weight.imag*probe_row[probe_idx].imag;
+                seed_row[probe_idx].imag += weight.real*probe_row[probe_idx].imag + weight.imag*probe_row[probe_idx].real;
+            }
+
+        }
+
+    }
+
+    return cost_function;
+
+}
+
+
+/**
+@brief Call to estimate the cost function and to calculate the gradient components of the estimate from the currently sampled columns. Only the sampled columns are transformed by the gates.
+@param parameters An array of the free parameters of the gates.
+@param grad An array storing the calculated gradient components
+@param standard_error The standard error of the estimated cost function (returned by reference)
+@return Returns with the estimated cost function.
+*/
+double N_Qubit_Decomposition_Base::get_cost_function_and_gradient_estimated( Matrix_real& parameters, Matrix_real& grad, double& standard_error ) {
+
+    // transform the sampled columns instead of the whole unitary
+    Matrix transformed = Umtx_probes.copy();
+    apply_to( parameters, transformed );
+
+    // estimate the cost function and calculate the gradient components from the transformed columns
+    Matrix adjoint_seed;
+    double cost_function = get_cost_function_with_adjoint_seed_estimated( transformed, adjoint_seed, standard_error );
+    apply_adjoint_derivate_to( parameters, transformed, adjoint_seed, grad );
+
+    return cost_function;
+
+}
+
+
+/**
+@brief Call to estimate both the cost function and its gradient components from probe_num newly sampled columns of the unitary (the estimator used by the optimizers when the trace estimation is turned on). The state of the trace estimation is left unchanged.
+@param parameters The parameters for which the cost fuction shoule be estimated
+@param probe_num The number of the distinct columns to be sampled
+@param f0 The estimated value of the cost function
+@param grad An array storing the calculated gradient components of the estimate
+*/
+void N_Qubit_Decomposition_Base::optimization_problem_combined_estimated( const Matrix_real& parameters, int probe_num, double* f0, Matrix_real& grad ) {
+
+    if ( probe_num < 1 || probe_num > Umtx.cols ) {
+        std::string err("N_Qubit_Decomposition_Base::optimization_problem_combined_estimated: the number of the sampled columns should be between 1 and the dimension of the unitary.");
+        throw err;
+    }
+
+    // keep the state of the trace estimation used by the optimizers
+    int trace_probe_num_saved = trace_probe_num;
+    Matrix trace_probes_saved = trace_probes;
+    Matrix Umtx_probes_saved = Umtx_probes;
+
+    trace_probe_num = probe_num;
+    generate_trace_probes();
+
+    Matrix_real parameters_mtx( parameters.get_data(), 1, parameters.size() );
+    double standard_error;
+    *f0 = get_cost_function_and_gradient_estimated( parameters_mtx, grad, standard_error );
+
+    trace_probe_num = trace_probe_num_saved;
+    trace_probes = trace_probes_saved;
+    Umtx_probes = Umtx_probes_saved;
+
+}
+
+
+/**
+@brief Call to adjust the number of probe vectors to the accuracy needed at the current value of the cost function and to draw new probe vectors for the next gradient evaluation. (With fixed probes the optimization would fit the gates to the probes instead of the unitary.) The number of probes is doubled when the standard error of the estimate is large compared to the distance of the cost function from the optimization tolerance. The trace is calculated exactly from the point when the cost function gets below the optimization tolerance or when the number of probes would reach the dimension of the unitary.
+@param cost_function The estimated cost function
+@param standard_error The standard error of the estimated cost function
+@return Returns with true if the estimate is accepted, or false if the cost function should be recalculated with the exact trace.
+*/
+bool N_Qubit_Decomposition_Base::update_trace_estimation( double cost_function, double standard_error ) {
+
+    if ( cost_function > optimization_tolerance && standard_error > trace_estimation_relative_error*(cost_function - optimization_tolerance) && 2*trace_probe_num < Umtx.cols ) {
+
+        trace_probe_num = 2*trace_probe_num;
+
+        std::stringstream sstream;
+        sstream << "N_Qubit_Decomposition_Base::update_trace_estimation: number of sampled columns increased to " << trace_probe_num << std::endl;
+        print(sstream, 3);
+
+    }
+    else if ( cost_function <= optimization_tolerance || standard_error > trace_estimation_relative_error*(cost_function - optimization_tolerance) ) {
+
+        // the final tuning is done with the exact trace
+        trace_probe_num = 0;
+        trace_probes = Matrix();
+        Umtx_probes = Matrix();
+
+        std::stringstream sstream;
+        sstream << "N_Qubit_Decomposition_Base::update_trace_estimation: switching to the exact trace at cost function " << cost_function << std::endl;
+        print(sstream, 3);
+
+        return false;
+    }
+
+    generate_trace_probes();
+
+    return true;
+
+}
+
+
+
 /**
 @brief Call to calculate both the cost function and the its gradient components.
 @param parameters The parameters for which the cost fuction shoule be calculated
@@ -1674,6 +2408,21 @@ void N_Qubit_Decomposition_Base::optimization_problem_combined( const Matrix_rea
 }
 
 
+/**
+@brief Call to calculate both the cost function and the its gradient components. (Used as a callback of the LBFGS optimizer)
+@param parameters The parameters for which the cost fuction shoule be calculated
+@param void_instance A void pointer pointing to the instance of the current class.
+@param f0 The value of the cost function at x0.
+@param grad An array storing the calculated gradient components
+*/
+void N_Qubit_Decomposition_Base::optimization_problem_combined( const Matrix_real& parameters, void* void_instance, double* f0, Matrix_real& grad ) {
+
+    N_Qubit_Decomposition_Base* instance = reinterpret_cast<N_Qubit_Decomposition_Base*>(void_instance);
+    instance->optimization_problem_combined( parameters, f0, grad );
+
+}
+
+
 /**
 @brief Call to get the variant of the cost function used in the calculations
 */
@@ -1733,6 +2482,9 @@ void N_Qubit_Decomposition_Base::set_optimizer( optimization_aglorithms alg_in )
 
     switch ( alg ) {
         case ADAM:
+        case AMSGRAD:
+        case ADAMW:
+        case MOMENTUM_SGD:
             iter_max = 1e5;
             random_shift_count_max = 100;
             gradient_threshold = 1e-8;
@@ -1926,6 +2678,64 @@ N_Qubit_Decomposition_Base::set_trace_offset(int trace_offset_in) {
 }
 
 
+/**
+@brief Get the number of columns sampled to estimate the trace in the cost function
+*/
+int 
+N_Qubit_Decomposition_Base::get_trace_estimation() {
+
+    return trace_estimation_probe_num;
+
+}
+
+
+/**
+@brief Set the number of columns sampled to estimate the trace in the cost function and its gradient (0 to calculate the trace exactly). The trace is estimated by column sampling: Tr(A) is estimated by N/k times the sum of the diagonal elements of k distinct columns chosen uniformly at random.
+*/
+void 
+N_Qubit_Decomposition_Base::set_trace_estimation(int probe_num_in) {
+
+    if ( probe_num_in < 0 ) {
+        std::string error("N_Qubit_Decomposition_Base::set_trace_estimation: the number of sampled columns must be non-negative.");
+        throw error;
+    }
+
+    // at least two probes are needed to estimate the statistical error
+    trace_estimation_probe_num = probe_num_in == 1 ? 2 : probe_num_in;
+
+    std::stringstream sstream;
+    sstream << "N_Qubit_Decomposition_Base::set_trace_estimation: number of sampled columns set to " << trace_estimation_probe_num << std::endl;
+    print(sstream, 2);	
+
+}
+
+
+/**
+@brief Get whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle
+*/
+bool 
+N_Qubit_Decomposition_Base::get_meet_in_the_middle() {
+
+    return meet_in_the_middle;
+
+}
+
+
+/**
+@brief Set true to evaluate the trace in the cost function by meeting the two halves of the gate sequence in the middle (used with the cost functions depending only on the trace of the transformed unitary).
+*/
+void 
+N_Qubit_Decomposition_Base::set_meet_in_the_middle(bool meet_in_the_middle_in) {
+
+    meet_in_the_middle = meet_in_the_middle_in;
+
+    std::stringstream sstream;
+    sstream << "N_Qubit_Decomposition_Base::set_meet_in_the_middle: meet in the middle evaluation set to " << meet_in_the_middle << std::endl;
+    print(sstream, 2);	
+
+}
+
+
 #ifdef __DFE__
 
 void 
@@ -22,9 +22,223 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 */
 
 #include "N_Qubit_Decomposition_Cost_Function.h"
+#include "apply_kernel_to_small_input.h"
+#include "kernel_indexing.h"
+#include <vector>
 //#include <tbb/parallel_for.h>
 
 
+#ifndef TRACE_COL_BLOCK_SIZE
+/// The number of columns in a block of the fused trace calculation (the partial sums of the blocks are calculated in parallel)
+#define TRACE_COL_BLOCK_SIZE 512
+#endif
+
+
+/// @brief Type definition of the functions calculating the trace and its corrections of a small matrix
+typedef void (*small_trace_fnc)( Matrix& matrix, QGD_Complex16* traces );
+
+
+/**
+@brief Call to calculate the trace of a square matrix of QBIT_NUM qubits stored without padding together with its first CORRECTION_NUM corrections according to https://arxiv.org/pdf/2210.09191.pdf. The loop bounds and the strides are compile time constants, so the loops are unrolled by the compiler. (The elements are summed up in the same order as in the general functions.)
+@param matrix The square shaped complex matrix from which the trace is calculated.
+@param traces Array of three complex numbers to store the trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+template<int QBIT_NUM, int CORRECTION_NUM>
+static void
+get_small_trace_with_correction( Matrix& matrix, QGD_Complex16* traces ) {
+
+    const int matrix_size = 1 << QBIT_NUM;
+    QGD_Complex16* data = matrix.get_data();
+
+    double trace_real = 0.0;
+    double trace_imag = 0.0;
+
+    for (int idx=0; idx<matrix_size; idx++) {
+        trace_real += data[idx*matrix_size + idx].real;
+        trace_imag += data[idx*matrix_size + idx].imag;
+    }
+
+    traces[0].real = trace_real;
+    traces[0].imag = trace_imag;
+
+    if ( CORRECTION_NUM < 1 ) {
+        return;
+    }
+
+    trace_real = 0.0;
+    trace_imag = 0.0;
+
+    for (int qbit_idx=0; qbit_idx<QBIT_NUM; qbit_idx++) {
+        for (int col_idx=0; col_idx<matrix_size; col_idx++) {
+
+            // determine the row index pair with one bit error at the given qbit_idx
+            int row_idx = col_idx ^ (1 << qbit_idx);
+
+            trace_real += data[row_idx*matrix_size + col_idx].real;
+            trace_imag += data[row_idx*matrix_size + col_idx].imag;
+        }
+    }
+
+    traces[1].real = trace_real;
+    traces[1].imag = trace_imag;
+
+    if ( CORRECTION_NUM < 2 ) {
+        return;
+    }
+
+    trace_real = 0.0;
+    trace_imag = 0.0;
+
+    for (int qbit_idx=0; qbit_idx<QBIT_NUM-1; qbit_idx++) {
+        for (int qbit_idx2=qbit_idx+1; qbit_idx2<QBIT_NUM; qbit_idx2++) {
+            for (int col_idx=0; col_idx<matrix_size; col_idx++) {
+
+                // determine the row index pair with two bit errors at the given qbit_idx and qbit_idx2
+                int row_idx = col_idx ^ ((1 << qbit_idx) + (1 << qbit_idx2));
+
+                trace_real += data[row_idx*matrix_size + col_idx].real;
+                trace_imag += data[row_idx*matrix_size + col_idx].imag;
+            }
+        }
+    }
+
+    traces[2].real = trace_real;
+    traces[2].imag = trace_imag;
+
+}
+
+
+// row of the dispatch table for the possible number of corrections
+#define SMALL_TRACE_CORRECTIONS(Q) { &get_small_trace_with_correction<Q,0>, &get_small_trace_with_correction<Q,1>, &get_small_trace_with_correction<Q,2> }
+
+/// dispatch table of the trace functions indexed by [qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][correction_num]
+static const small_trace_fnc small_traces[SMALL_KERNEL_MAX_QBIT_NUM-SMALL_KERNEL_MIN_QBIT_NUM+1][3] = {
+    SMALL_TRACE_CORRECTIONS(2), SMALL_TRACE_CORRECTIONS(3), SMALL_TRACE_CORRECTIONS(4), SMALL_TRACE_CORRECTIONS(5), SMALL_TRACE_CORRECTIONS(6) };
+
+
+/**
+@brief Call to look up the trace function specialized for the size of the matrix
+@param matrix The square shaped complex matrix from which the trace is calculated.
+@param correction_num The number of corrections to be calculated (0, 1 or 2)
+@return Returns with the specialized function, or with NULL if the matrix is not a square matrix of SMALL_KERNEL_MIN_QBIT_NUM to SMALL_KERNEL_MAX_QBIT_NUM qubits stored without padding
+*/
+static small_trace_fnc
+get_small_trace_function( Matrix& matrix, int correction_num ) {
+
+    int matrix_size = matrix.cols;
+
+    if ( matrix.rows != matrix_size || matrix.stride != matrix_size ) {
+        return NULL;
+    }
+
+    for (int qbit_num=SMALL_KERNEL_MIN_QBIT_NUM; qbit_num<=SMALL_KERNEL_MAX_QBIT_NUM; qbit_num++) {
+        if ( (1 << qbit_num) == matrix_size ) {
+            return small_traces[qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][correction_num];
+        }
+    }
+
+    return NULL;
+
+}
+
+
+
+/**
+@brief Call to add up the elements A_{ij} of a block of columns of a matrix for which i = (j+trace_offset)^mask.
+@param matrix The complex matrix
+@param trace_offset The offset in the first columns from which the "trace" is calculated.
+@param mask The bit mask of the bit errors
+@param col_start The first column of the block
+@param col_end The column after the last one of the block
+@param sum Array of two doubles to which the real and the imaginary parts of the sum are added.
+*/
+static inline void
+add_masked_diagonal( Matrix& matrix, int trace_offset, int mask, int col_start, int col_end, double* sum ) {
+
+    double sum_real = 0.0;
+    double sum_imag = 0.0;
+
+    for (int col_idx=col_start; col_idx<col_end; col_idx++) {
+
+        int row_idx = (col_idx+trace_offset) ^ mask;
+        if ( row_idx < matrix.rows ) {
+            QGD_Complex16& element = matrix[row_idx*matrix.stride + col_idx];
+            sum_real += element.real;
+            sum_imag += element.imag;
+        }
+    }
+
+    sum[0] += sum_real;
+    sum[1] += sum_imag;
+
+}
+
+
+/**
+@brief Call to calculate the (shifted) trace of a matrix together with its first correction_num corrections according to https://arxiv.org/pdf/2210.09191.pdf in a single sweep over the matrix. The columns are processed in blocks: within a block the (shifted) diagonal and the diagonals of the bit errors are traversed one after the other, so each of them is read as a regular strided stream, while the cache lines shared by the diagonals of the low qubits are still in the cache. The partial sums of the column blocks are calculated in parallel and added up in a fixed order.
+@param matrix The complex matrix from which the trace is calculated.
+@param qbit_num The number of qubits
+@param trace_offset The offset in the first columns from which the "trace" is calculated. In this case Tr(A) = sum_(i-offset=j) A_{ij}
+@param correction_num The number of corrections to be calculated (0, 1 or 2)
+@param traces Array of three complex numbers to store the trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+static void
+get_trace_with_correction_fused( Matrix& matrix, int qbit_num, int trace_offset, int correction_num, QGD_Complex16* traces ) {
+
+    int block_num = (matrix.cols + TRACE_COL_BLOCK_SIZE - 1)/TRACE_COL_BLOCK_SIZE;
+
+    int diagonal_num = 1;
+    if ( correction_num > 0 ) {
+        diagonal_num += qbit_num;
+    }
+    if ( correction_num > 1 ) {
+        diagonal_num += qbit_num*(qbit_num-1)/2;
+    }
+
+    // the partial sums of the blocks: the trace and the corrections with the real and imaginary parts
+    std::vector<double> partial_sums( 6*block_num, 0.0 );
+
+    kernel_parallel_for( block_num, TRACE_COL_BLOCK_SIZE*diagonal_num, [&](tbb::blocked_range<int> r) {
+
+        for (int block_idx=r.begin(); block_idx<r.end(); block_idx++) {
+
+            double* sums = partial_sums.data() + 6*block_idx;
+
+            int col_start = block_idx*TRACE_COL_BLOCK_SIZE;
+            int col_end = col_start + TRACE_COL_BLOCK_SIZE;
+            col_end = col_end < matrix.cols ? col_end : matrix.cols;
+
+            add_masked_diagonal( matrix, trace_offset, 0, col_start, col_end, sums );
+
+            if ( correction_num > 0 ) {
+                for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
+                    add_masked_diagonal( matrix, trace_offset, 1 << qbit_idx, col_start, col_end, sums+2 );
+                }
+            }
+
+            if ( correction_num > 1 ) {
+                for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
+                    for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
+                        add_masked_diagonal( matrix, trace_offset, (1 << qbit_idx) + (1 << qbit_idx2), col_start, col_end, sums+4 );
+                    }
+                }
+            }
+
+        }
+
+    });
+
+    memset( traces, 0.0, 3*sizeof(QGD_Complex16) );
+
+    for (int block_idx=0; block_idx<block_num; block_idx++) {
+        for (int idx=0; idx<3; idx++) {
+            traces[idx].real += partial_sums[6*block_idx + 2*idx];
+            traces[idx].imag += partial_sums[6*block_idx + 2*idx + 1];
+        }
+    }
+
+}
+
 
 /**
 @brief Call co calculate the cost function during the final optimization process.
@@ -98,7 +312,15 @@ double get_cost_function(Matrix matrix, int trace_offset) {
 
     double trace_real = 0.0;
 
-    if ( trace_offset == 0 ) {
+    small_trace_fnc small_trace = trace_offset == 0 ? get_small_trace_function( matrix, 0 ) : NULL;
+
+    if ( small_trace != NULL ) {
+
+        QGD_Complex16 traces[3];
+        small_trace( matrix, traces );
+        trace_real = traces[0].real;
+    }
+    else if ( trace_offset == 0 ) {
 
         for (int idx=0; idx<matrix_size; idx++) {
          
@@ -135,68 +357,27 @@ Matrix_real get_cost_function_with_correction(Matrix matrix, int qbit_num, int t
 
     Matrix_real ret(1,2);
 
-    // calculate the cost function
-    ret[0] = get_cost_function( matrix, trace_offset );
-
-
+    // calculate the trace and the first correction in a single sweep
+    QGD_Complex16 traces[3];
 
-    // calculate teh first correction
-
-    int matrix_size = matrix.cols;
-
-    double trace_real = 0.0;
-
-    if ( trace_offset == 0 ) {
-        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
-
-            int qbit_error_mask = 1 << qbit_idx;
-
-            for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                // determine the row index pair with one bit error at the given qbit_idx
-                int row_idx = col_idx ^ qbit_error_mask;
- 
-                trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            }
-        }
+    small_trace_fnc small_trace = trace_offset == 0 && matrix.cols == (1 << qbit_num) ? get_small_trace_function( matrix, 1 ) : NULL;
 
+    if ( small_trace != NULL ) {
+        small_trace( matrix, traces );
     }
     else {
-
-
-        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
-
-            int qbit_error_mask = 1 << qbit_idx;
-
-            for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                // determine the row index pair with one bit error at the given qbit_idx
-                int row_idx = (col_idx + trace_offset) ^ qbit_error_mask;
-// std::cout << matrix[row_idx*matrix.stride + col_idx].real << " " << row_idx << " " << col_idx << std::endl;
-                trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            }
-        }
-
-
+        get_trace_with_correction_fused( matrix, qbit_num, trace_offset, 1, traces );
     }
 
-    //double cost_function = std::sqrt(1.0 - trace_real/matrix_size);
-    double cost_function = trace_real/matrix_size;
-
-//std::cout << cost_function << std::endl;
-//exit(1);
-
-    ret[1] = cost_function;
+    ret[0] = 1.0 - traces[0].real/matrix.cols;
+    ret[1] = traces[1].real/matrix.cols;
 
     return ret;
 
-    
-
 }
 
 
 
-
 /**
 @brief Call co calculate the cost function of the optimization process, and the first correction to the cost finction according to https://arxiv.org/pdf/2210.09191.pdf
 @param matrix The square shaped complex matrix from which the cost function is calculated.
@@ -205,115 +386,29 @@ Matrix_real get_cost_function_with_correction(Matrix matrix, int qbit_num, int t
 */
 Matrix_real get_cost_function_with_correction2(Matrix matrix, int qbit_num, int trace_offset) {
 
-
     Matrix_real ret(1,3);
 
-    // calculate the cost function
-    ret[0] = get_cost_function( matrix, trace_offset );
-
-
-
-    // calculate the first correction
+    // calculate the trace and the first and second corrections in a single sweep
+    QGD_Complex16 traces[3];
 
-    int matrix_size = matrix.cols;
-
-    double trace_real = 0.0;
-
-    if ( trace_offset == 0 ) {
-        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
-
-            int qbit_error_mask = 1 << qbit_idx;
-
-            for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                // determine the row index pair with one bit error at the given qbit_idx
-                int row_idx = col_idx ^ qbit_error_mask;
- 
-                trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            }
-        }
+    small_trace_fnc small_trace = trace_offset == 0 && matrix.cols == (1 << qbit_num) ? get_small_trace_function( matrix, 2 ) : NULL;
 
+    if ( small_trace != NULL ) {
+        small_trace( matrix, traces );
     }
     else {
-
-
-        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
-
-            int qbit_error_mask = 1 << qbit_idx;
-
-            for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                // determine the row index pair with one bit error at the given qbit_idx
-                int row_idx = (col_idx+trace_offset) ^ qbit_error_mask;
- 
-                trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            }
-        }
-
-
+        get_trace_with_correction_fused( matrix, qbit_num, trace_offset, 2, traces );
     }
 
-    double cost_function = trace_real/matrix_size;
-
-    ret[1] = cost_function;
-
-
-
-
-    // calculate the second correction
-
-    trace_real = 0.0;
-
-    if ( trace_offset == 0 ) {
-        for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
-            for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
-
-                int qbit_error_mask = (1 << qbit_idx) + (1 << qbit_idx2);
-
-                for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                    // determine the row index pair with one bit error at the given qbit_idx
-                    int row_idx = col_idx ^ qbit_error_mask;
- 
-                    trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-                }
-
-            }
-        }
-    }
-    else {
-
-        for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
-            for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
-
-                int qbit_error_mask = (1 << qbit_idx) + (1 << qbit_idx2);
-
-                for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
-
-                    // determine the row index pair with one bit error at the given qbit_idx
-                    int row_idx = (col_idx+trace_offset) ^ qbit_error_mask;
- 
-                    trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-                }
-
-            }
-        }
-
-
-    }
-
-    double cost_function2 = trace_real/matrix_size;
-
-    ret[2] = cost_function2;
+    ret[0] = 1.0 - traces[0].real/matrix.cols;
+    ret[1] = traces[1].real/matrix.cols;
+    ret[2] = traces[2].real/matrix.cols;
 
     return ret;
 
-
-
-
-
 }
 
+
 /**
 @brief Call to calculate the real and imaginary parts of the trace
 @param matrix The square shaped complex matrix from which the trace is calculated.
@@ -325,6 +420,14 @@ QGD_Complex16 get_trace(Matrix& matrix){
     double trace_real=0.0;
     double trace_imag=0.0;
     QGD_Complex16 ret;
+
+    small_trace_fnc small_trace = get_small_trace_function( matrix, 0 );
+
+    if ( small_trace != NULL ) {
+        QGD_Complex16 traces[3];
+        small_trace( matrix, traces );
+        return traces[0];
+    }
     
     for (int idx=0; idx<matrix_size; idx++) {
         
@@ -362,32 +465,20 @@ double get_hilbert_schmidt_test(Matrix& matrix){
 Matrix get_trace_with_correction(Matrix& matrix, int qbit_num) {
     
     Matrix ret(1,2);
-    
-    QGD_Complex16 trace_tmp = get_trace(matrix);
-    
-    int matrix_size = matrix.cols;
-
-    double trace_real = 0.0;
-    double trace_imag = 0.0;
-
-    for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
 
-        int qbit_error_mask = 1 << qbit_idx;
+    // calculate the trace and the first correction in a single sweep
+    QGD_Complex16 traces[3];
 
-        for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
+    small_trace_fnc small_trace = matrix.cols == (1 << qbit_num) ? get_small_trace_function( matrix, 1 ) : NULL;
 
-            // determine the row index pair with one bit error at the given qbit_idx
-            int row_idx = col_idx ^ qbit_error_mask;
- 
-            trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            trace_imag += matrix[row_idx*matrix.stride + col_idx].imag;
-        }
+    if ( small_trace != NULL ) {
+        small_trace( matrix, traces );
     }
-    
-    ret[0].real = trace_tmp.real;
-    ret[0].imag = trace_tmp.imag;
-    ret[1].real = trace_real;
-    ret[1].imag = trace_imag;
+    else {
+        get_trace_with_correction_fused( matrix, qbit_num, 0, 1, traces );
+    }
+
+    memcpy( ret.get_data(), traces, 2*sizeof(QGD_Complex16) );
     
     return ret;
 }
@@ -402,63 +493,75 @@ Matrix get_trace_with_correction(Matrix& matrix, int qbit_num) {
 Matrix get_trace_with_correction2(Matrix& matrix, int qbit_num) {
 
     Matrix ret(1,3);
-    
-    QGD_Complex16 trace_tmp = get_trace(matrix);
-    
-    int matrix_size = matrix.cols;
 
-    double trace_real = 0.0;
-    double trace_imag = 0.0;
+    // calculate the trace and the first and second corrections in a single sweep
+    small_trace_fnc small_trace = matrix.cols == (1 << qbit_num) ? get_small_trace_function( matrix, 2 ) : NULL;
 
-    for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
+    if ( small_trace != NULL ) {
+        small_trace( matrix, ret.get_data() );
+    }
+    else {
+        get_trace_with_correction_fused( matrix, qbit_num, 0, 2, ret.get_data() );
+    }
+    
+    return ret;
+}
 
-        int qbit_error_mask = 1 << qbit_idx;
 
-        for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
+/**
+@brief Call to calculate the contribution of a column tile of the transformed matrix to the (shifted) trace and to its corrections. Summing up the contributions of all the tiles gives the trace and the corrections of the whole matrix.
+@param matrix A tile of consecutive columns of the transformed matrix (containing all the rows).
+@param col_offset The index of the first column of the tile in the whole matrix.
+@param qbit_num The number of qubits
+@param trace_offset The offset in the first columns from which the "trace" is calculated. In this case Tr(A) = sum_(i-offset=j) A_{ij}
+@param correction_num The number of corrections to be calculated (0, 1 or 2)
+@return Returns with the matrix containing the partial trace (index 0), the partial first correction (index 1) and the partial second correction (index 2).
+*/
+Matrix get_trace_with_correction_of_columns(Matrix& matrix, int col_offset, int qbit_num, int trace_offset, int correction_num) {
 
-            // determine the row index pair with one bit error at the given qbit_idx
-            int row_idx = col_idx ^ qbit_error_mask;
- 
-            trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-            trace_imag += matrix[row_idx*matrix.stride + col_idx].imag;
-        }
-    }
+    Matrix ret(1,3);
+    memset( ret.get_data(), 0.0, 3*sizeof(QGD_Complex16) );
 
+    for (int col_idx=0; col_idx<matrix.cols; col_idx++) {
 
-    ret[1].real = trace_real;
-    ret[1].imag = trace_imag;
+        // the row index of the "diagonal" element in the column
+        int diag_row_idx = col_offset + col_idx + trace_offset;
 
+        ret[0].real += matrix[diag_row_idx*matrix.stride + col_idx].real;
+        ret[0].imag += matrix[diag_row_idx*matrix.stride + col_idx].imag;
 
+        if ( correction_num < 1 ) {
+            continue;
+        }
 
-    // calculate the second correction
+        for (int qbit_idx=0; qbit_idx<qbit_num; qbit_idx++) {
 
-    trace_real = 0.0;
-    trace_imag = 0.0;
+            // determine the row index pair with one bit error at the given qbit_idx
+            int row_idx = diag_row_idx ^ (1 << qbit_idx);
 
-    for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
-        for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
+            ret[1].real += matrix[row_idx*matrix.stride + col_idx].real;
+            ret[1].imag += matrix[row_idx*matrix.stride + col_idx].imag;
+        }
 
-            int qbit_error_mask = (1 << qbit_idx) + (1 << qbit_idx2);
+        if ( correction_num < 2 ) {
+            continue;
+        }
 
-            for (int col_idx=0; col_idx<matrix_size; col_idx++) {        
+        for (int qbit_idx=0; qbit_idx<qbit_num-1; qbit_idx++) {
+            for (int qbit_idx2=qbit_idx+1; qbit_idx2<qbit_num; qbit_idx2++) {
 
-                // determine the row index pair with one bit error at the given qbit_idx
-                int row_idx = col_idx ^ qbit_error_mask;
- 
-                trace_real += matrix[row_idx*matrix.stride + col_idx].real;
-                trace_imag += matrix[row_idx*matrix.stride + col_idx].imag;
-            }
+                // determine the row index pair with two bit errors at the given qbit_idx and qbit_idx2
+                int row_idx = diag_row_idx ^ ((1 << qbit_idx) + (1 << qbit_idx2));
 
+                ret[2].real += matrix[row_idx*matrix.stride + col_idx].real;
+                ret[2].imag += matrix[row_idx*matrix.stride + col_idx].imag;
+            }
         }
-    }
 
+    }
 
-    ret[2].real = trace_real;
-    ret[2].imag = trace_imag;
-    ret[0].real = trace_tmp.real;
-    ret[0].imag = trace_tmp.imag;
-    
     return ret;
+
 }
 
 /**
@@ -31,6 +31,9 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include "X.h"
 
 #include <time.h>
+#include <cfloat>
+#include <atomic>
+#include <tbb/task_arena.h>
 #include <stdlib.h>
 
 
@@ -39,6 +42,10 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #endif
 
 
+/// The number of layers on each side of a removed layer that are re-optimized in the environment of the fixed layers in the windowed gate structure compression
+static const int compression_window_layer_num = 2;
+
+
 
 
 
@@ -72,6 +79,21 @@ N_Qubit_Decomposition_adaptive::N_Qubit_Decomposition_adaptive() : N_Qubit_Decom
     // Boolean variable to determine whether randomized adaptive layers are used or not
     randomized_adaptive_layers = false;
 
+    // the initial gate structure is optimized from a single starting point by default
+    multi_start_num = 1;
+
+    // the layer removal candidates of the gate structure compression are all evaluated by default
+    speculative_compression = false;
+
+    // the whole circuit is re-optimized after the removal of a layer by default
+    window_compression = false;
+
+    // each circuit depth is optimized from scratch by default
+    warm_start_levels = false;
+
+    // the circuit depths are optimized one after the other by default
+    concurrent_level_num = 1;
+
 
 }
 
@@ -115,6 +137,21 @@ N_Qubit_Decomposition_adaptive::N_Qubit_Decomposition_adaptive( Matrix Umtx_in,
     // Boolean variable to determine whether randomized adaptive layers are used or not
     randomized_adaptive_layers = false;
 
+    // the initial gate structure is optimized from a single starting point by default
+    multi_start_num = 1;
+
+    // the layer removal candidates of the gate structure compression are all evaluated by default
+    speculative_compression = false;
+
+    // the whole circuit is re-optimized after the removal of a layer by default
+    window_compression = false;
+
+    // each circuit depth is optimized from scratch by default
+    warm_start_levels = false;
+
+    // the circuit depths are optimized one after the other by default
+    concurrent_level_num = 1;
+
 
 }
 
@@ -164,6 +201,21 @@ N_Qubit_Decomposition_adaptive::N_Qubit_Decomposition_adaptive( Matrix Umtx_in,
     // Boolean variable to determine whether randomized adaptive layers are used or not
     randomized_adaptive_layers = false;
 
+    // the initial gate structure is optimized from a single starting point by default
+    multi_start_num = 1;
+
+    // the layer removal candidates of the gate structure compression are all evaluated by default
+    speculative_compression = false;
+
+    // the whole circuit is re-optimized after the removal of a layer by default
+    window_compression = false;
+
+    // each circuit depth is optimized from scratch by default
+    warm_start_levels = false;
+
+    // the circuit depths are optimized one after the other by default
+    concurrent_level_num = 1;
+
 }
 
 
@@ -425,8 +477,10 @@ N_Qubit_Decomposition_adaptive::optimize_imported_gate_structure(Matrix_real& op
     cDecomp_custom.set_iteration_loops( iteration_loops );
     cDecomp_custom.set_optimization_tolerance( optimization_tolerance ); 
     cDecomp_custom.set_trace_offset( trace_offset ); 
+    cDecomp_custom.set_trace_estimation( trace_estimation_probe_num );
+    cDecomp_custom.set_meet_in_the_middle( meet_in_the_middle );
     cDecomp_custom.set_optimizer( alg );  
-    if (alg==ADAM || alg==BFGS2) { 
+    if (is_first_order_optimizer(alg) || alg==BFGS2) { 
         int param_num_loc = gate_structure_loc->get_parameter_num();
         int iter_max_loc = (double)param_num_loc/852 * 1e7;
         cDecomp_custom.set_iter_max( iter_max_loc );  
@@ -481,6 +535,148 @@ N_Qubit_Decomposition_adaptive::optimize_imported_gate_structure(Matrix_real& op
 
 }
 
+/**
+@brief Call to optimize a gate structure in the search for the initial gate structure. The optimization is started from multi_start_num different initial parameters in parallel, and the remaining optimizations are cancelled once one of them reaches the optimization tolerance.
+@param gate_structure_loc The gate structure to be optimized
+@param warm_start_parameters The initial parameters of the first start (continued from a previous circuit depth), or an empty array to start from the initial value strategy
+@param solution_found Flag set when an optimization reaches the optimization tolerance (or when a shallower circuit is solved concurrently). The optimizations are cancelled once the flag is set.
+@param optimized_parameters_mtx_loc The optimized parameters of the chosen start
+@param initial_guess_loc The initial value strategy of the chosen start
+@param iteration_num The number of iterations spent on the optimizations
+@param verbose_output Set true to print the output messages of the first start
+@return Returns with the minimum of the cost function obtained by the chosen start
+*/
+double 
+N_Qubit_Decomposition_adaptive::optimize_initial_gate_structure( Gates_block* gate_structure_loc, Matrix_real& warm_start_parameters, std::atomic<bool>* solution_found, Matrix_real& optimized_parameters_mtx_loc, guess_type& initial_guess_loc, int& iteration_num, bool verbose_output ) {
+
+    // the results of the optimizations started from different initial parameters
+    int start_num = multi_start_num > 1 ? multi_start_num : 1;
+    std::vector<double> minimum_starts( start_num, DBL_MAX );
+    std::vector<Matrix_real> optimized_parameters_starts( start_num );
+    std::vector<guess_type> initial_guess_starts( start_num, RANDOM );
+    std::vector<int> iteration_num_starts( start_num, 0 );
+
+    auto solve_from_start = [&]( int start_idx ) {
+
+        // the starts not launched before a solution was found are skipped
+        if ( solution_found->load() ) {
+            return;
+        }
+
+        // the second start is close to zero, the others are from random parameters (with different seeds)
+        initial_guess_starts[start_idx] = start_idx == 1 ? CLOSE_TO_ZERO : RANDOM;
+
+        // solve the optimization problem in isolated optimization process
+        N_Qubit_Decomposition_custom cDecomp_custom( Umtx.copy(), qbit_num, false, initial_guess_starts[start_idx], accelerator_num );
+        cDecomp_custom.set_custom_gate_structure( gate_structure_loc );
+        if ( start_idx == 0 && warm_start_parameters.size() > 0 ) {
+            // the first start is continued from the optimized parameters of the previous circuit depth
+            cDecomp_custom.set_optimized_parameters( warm_start_parameters.get_data(), warm_start_parameters.size() );
+        }
+        cDecomp_custom.set_optimization_blocks( gate_structure_loc->get_gate_num() );
+        cDecomp_custom.set_max_iteration( max_iterations );
+#ifndef __DFE__
+        cDecomp_custom.set_verbose( start_idx == 0 && verbose_output ? verbose : 0 );
+#else
+        cDecomp_custom.set_verbose(0);
+#endif
+        cDecomp_custom.set_cost_function_variant( cost_fnc );
+        cDecomp_custom.set_debugfile("");
+        cDecomp_custom.set_optimization_tolerance( optimization_tolerance );
+        cDecomp_custom.set_trace_offset( trace_offset ); 
+        cDecomp_custom.set_trace_estimation( trace_estimation_probe_num );
+        cDecomp_custom.set_meet_in_the_middle( meet_in_the_middle );
+        cDecomp_custom.set_optimizer( alg );
+        if ( is_first_order_optimizer(alg) || alg == BFGS2 ) {
+            int param_num_loc = gate_structure_loc->get_parameter_num();
+            int iter_max_loc = (double)param_num_loc/852 * 1e7;
+            cDecomp_custom.set_iter_max( iter_max_loc );  
+            cDecomp_custom.set_random_shift_count_max( 10000 );       
+            cDecomp_custom.set_adaptive_eta( true );    
+            cDecomp_custom.set_randomized_radius( radius );
+        }
+        else if ( alg==ADAM_BATCHED ) {
+            cDecomp_custom.set_optimizer( alg );  
+            int iter_max_loc = 2000;
+            cDecomp_custom.set_iter_max( iter_max_loc );  
+            cDecomp_custom.set_random_shift_count_max( 5 );   
+            cDecomp_custom.set_adaptive_eta( true );      
+            cDecomp_custom.set_randomized_radius( radius );   
+        }
+        cDecomp_custom.set_iteration_threshold_of_randomization( iteration_threshold_of_randomization );
+        cDecomp_custom.set_cancellation_flag( solution_found );
+        cDecomp_custom.start_decomposition(true);
+
+        minimum_starts[start_idx] = cDecomp_custom.get_current_minimum();
+        optimized_parameters_starts[start_idx] = cDecomp_custom.get_optimized_parameters();
+        iteration_num_starts[start_idx] = cDecomp_custom.get_num_iters(); // retrive the number of iterations spent on optimization
+
+        if ( minimum_starts[start_idx] < optimization_tolerance ) {
+            solution_found->store( true );
+        }
+
+    };
+
+
+#ifdef __DFE__
+    // the optimizations share the accelerator, so they are run one after the other
+    for (int start_idx=0; start_idx<start_num; start_idx++) {
+        solve_from_start( start_idx );
+    }
+#else
+    if ( start_num == 1 ) {
+        solve_from_start( 0 );
+    }
+    else {
+        // each optimization gets a fair share of the cores in its own task arena
+        int thread_num_per_start = tbb::this_task_arena::max_concurrency()/start_num;
+        thread_num_per_start = thread_num_per_start > 1 ? thread_num_per_start : 1;
+
+        tbb::parallel_for( 0, start_num, 1, [&](int start_idx) {
+            tbb::task_arena arena( thread_num_per_start );
+            arena.execute( [&]() {
+                solve_from_start( start_idx );
+            });
+        });
+    }
+#endif
+
+    iteration_num = 0;
+    for (int start_idx=0; start_idx<start_num; start_idx++) {
+        iteration_num += iteration_num_starts[start_idx];
+    }
+
+
+    // select between the results obtained for different initial values: among the solutions the one with the lowest panelty is chosen, otherwise the lowest minimum
+    int selected_idx = -1;
+    unsigned int panelty_selected = 0;
+    for (int start_idx=0; start_idx<start_num; start_idx++) {
+        if ( minimum_starts[start_idx] < optimization_tolerance ) {
+            unsigned int panelty = get_panelty(gate_structure_loc, optimized_parameters_starts[start_idx]);
+            if ( selected_idx < 0 || panelty < panelty_selected ) {
+                selected_idx = start_idx;
+                panelty_selected = panelty;
+            }
+        }
+    }
+
+    if ( selected_idx < 0 ) {
+        selected_idx = 0;
+        for (int start_idx=1; start_idx<start_num; start_idx++) {
+            if ( minimum_starts[start_idx] < minimum_starts[selected_idx] ) {
+                selected_idx = start_idx;
+            }
+        }
+    }
+
+    optimized_parameters_mtx_loc = optimized_parameters_starts[selected_idx];
+    initial_guess_loc = initial_guess_starts[selected_idx];
+
+    return minimum_starts[selected_idx];
+
+}
+
+
 /**
 @brief ??????????????
 */
@@ -491,194 +687,202 @@ N_Qubit_Decomposition_adaptive::determine_initial_gate_structure(Matrix_real& op
     std::vector<double> minimum_vec;
     std::vector<Gates_block*> gate_structure_vec;
     std::vector<Matrix_real> optimized_parameters_vec;
+    // the number of the decomposing layers added to the stored gate structures
+    std::vector<int> level_vec;
+
+    // the index of the stored gate structure from which the next circuit depths are continued (the one with the lowest minimum in the previous round)
+    int warm_start_idx = -1;
 
     int level = level_limit_min;
     while ( current_minimum > optimization_tolerance && level <= level_limit) {
 
-        // reset optimized parameters
-        optimized_parameters_mtx_loc = Matrix_real(0,0);
+        // the number of circuit depths optimized concurrently in this round
+        int level_num = concurrent_level_num > 1 ? concurrent_level_num : 1;
+        if ( level + level_num - 1 > level_limit ) {
+            level_num = level_limit - level + 1;
+        }
 
+        // create gate structures to be optimized
+        std::vector<Gates_block*> gate_structures_round( level_num, NULL );
 
-        // create gate structure to be optimized
-        Gates_block* gate_structure_loc = new Gates_block(qbit_num);
+        // initial parameters continued from the previous circuit depth
+        std::vector<Matrix_real> warm_start_parameters_round( level_num );
 
-        for (int idx=0; idx<level; idx++) {
+        for (int level_idx=0; level_idx<level_num; level_idx++) {
 
-            // create the new decomposing layer and add to the gate staructure
-            add_adaptive_layers( gate_structure_loc );
+            if ( warm_start_levels && warm_start_idx >= 0 && optimized_parameters_vec[warm_start_idx].size() > 0 ) {
 
-        }
+                // extend the best gate structure of the previous round by new decomposing layers (the parameters of the new layers are placed after the previous ones)
+                Gates_block* gate_structure_loc = gate_structure_vec[warm_start_idx]->clone();
+                for (int idx=level_vec[warm_start_idx]; idx<level+level_idx; idx++) {
+                    add_adaptive_layers( gate_structure_loc );
+                }
+
+                // the new layers start close to the identity, so the optimization continues from the previous minimum
+                Matrix_real& parameters_prev = optimized_parameters_vec[warm_start_idx];
+                Matrix_real warm_start_parameters( 1, gate_structure_loc->get_parameter_num() );
+                memcpy( warm_start_parameters.get_data(), parameters_prev.get_data(), parameters_prev.size()*sizeof(double) );
+
+                std::uniform_real_distribution<> distrib_real(0.0, 2*M_PI);
+                for (int idx=parameters_prev.size(); idx<warm_start_parameters.size(); idx++) {
+                    warm_start_parameters[idx] = distrib_real(gen)/100;
+                }
+
+#ifdef __MPI__        
+                MPI_Bcast( (void*)warm_start_parameters.get_data(), warm_start_parameters.size(), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+#endif
+
+                gate_structures_round[level_idx] = gate_structure_loc;
+                warm_start_parameters_round[level_idx] = warm_start_parameters;
+
+            }
+            else {
+
+                Gates_block* gate_structure_loc = new Gates_block(qbit_num);
+
+                for (int idx=0; idx<level+level_idx; idx++) {
+
+                    // create the new decomposing layer and add to the gate staructure
+                    add_adaptive_layers( gate_structure_loc );
+
+                }
            
-        // add finalyzing layer to the top of the gate structure
-        add_finalyzing_layer( gate_structure_loc );
+                // add finalyzing layer to the top of the gate structure
+                add_finalyzing_layer( gate_structure_loc );
+
+                gate_structures_round[level_idx] = gate_structure_loc;
+
+            }
+
+            std::stringstream sstream;
+            sstream << "Starting optimization with " << gate_structures_round[level_idx]->get_gate_num() << " decomposing layers." << std::endl;
+            print(sstream, 1);	
+
+        }
 
         //measure the time for the decompositin
         tbb::tick_count start_time_loc = tbb::tick_count::now();
 
+        // the results of the optimizations of the different circuit depths
+        std::vector<double> minimum_round( level_num, DBL_MAX );
+        std::vector<Matrix_real> optimized_parameters_round( level_num );
+        std::vector<guess_type> initial_guess_round( level_num, RANDOM );
+        std::vector<int> iteration_num_round( level_num, 0 );
+
+        // cancellation flags of the circuit depths. A circuit depth reaching the optimization tolerance cancels only the deeper circuits, since the
+        // shallowest solution is kept. (The flag of a circuit depth is shared by its starts, so they are cancelled once one of them is solved.)
+        std::vector< std::atomic<bool> > solution_found( level_num );
+        for (int level_idx=0; level_idx<level_num; level_idx++) {
+            solution_found[level_idx].store( false );
+        }
 
-        N_Qubit_Decomposition_custom cDecomp_custom_random, cDecomp_custom_close_to_zero;
+        auto solve_level = [&]( int level_idx ) {
+            minimum_round[level_idx] = optimize_initial_gate_structure( gate_structures_round[level_idx], warm_start_parameters_round[level_idx], &solution_found[level_idx], optimized_parameters_round[level_idx], initial_guess_round[level_idx], iteration_num_round[level_idx], level_idx == 0 );
 
-        std::stringstream sstream;
-        sstream << "Starting optimization with " << gate_structure_loc->get_gate_num() << " decomposing layers." << std::endl;
-        print(sstream, 1);	
-/*
-#ifndef __DFE__
-        // try the decomposition withrandom and with close to zero initial values
-        tbb::parallel_invoke(
-            [&]{            
-#endif
-*/
-                // solve the optimization problem in isolated optimization process
-                cDecomp_custom_random = N_Qubit_Decomposition_custom( Umtx.copy(), qbit_num, false, RANDOM, accelerator_num);
-                cDecomp_custom_random.set_custom_gate_structure( gate_structure_loc );
-                cDecomp_custom_random.set_optimization_blocks( gate_structure_loc->get_gate_num() );
-                cDecomp_custom_random.set_max_iteration( max_iterations );
-#ifndef __DFE__
-                cDecomp_custom_random.set_verbose(verbose);
-#else
-                cDecomp_custom_random.set_verbose(0);
-#endif
-                cDecomp_custom_random.set_cost_function_variant( cost_fnc );
-                cDecomp_custom_random.set_debugfile("");
-                cDecomp_custom_random.set_optimization_tolerance( optimization_tolerance );
-                cDecomp_custom_random.set_trace_offset( trace_offset ); 
-                cDecomp_custom_random.set_optimizer( alg );
-                if ( alg == ADAM || alg == BFGS2 ) {
-                    int param_num_loc = gate_structure_loc->get_parameter_num();
-                    int iter_max_loc = (double)param_num_loc/852 * 1e7;
-                    cDecomp_custom_random.set_iter_max( iter_max_loc );  
-                    cDecomp_custom_random.set_random_shift_count_max( 10000 );       
-                    cDecomp_custom_random.set_adaptive_eta( true );    
-                    cDecomp_custom_random.set_randomized_radius( radius );
+            if ( minimum_round[level_idx] < optimization_tolerance ) {
+                for (int level_idx_cancel=level_idx+1; level_idx_cancel<level_num; level_idx_cancel++) {
+                    solution_found[level_idx_cancel].store( true );
                 }
-                else if ( alg==ADAM_BATCHED ) {
-                    cDecomp_custom_random.set_optimizer( alg );  
-                    int iter_max_loc = 2000;
-                    cDecomp_custom_random.set_iter_max( iter_max_loc );  
-                    cDecomp_custom_random.set_random_shift_count_max( 5 );   
-                    cDecomp_custom_random.set_adaptive_eta( true );      
-                    cDecomp_custom_random.set_randomized_radius( radius );   
-                }
-                cDecomp_custom_random.set_iteration_threshold_of_randomization( iteration_threshold_of_randomization );
-                cDecomp_custom_random.start_decomposition(true);
-                number_of_iters += cDecomp_custom_random.get_num_iters(); // retrive the number of iterations spent on optimization
-/*
-#ifndef __DFE__
-            },
-            [&]{
-                // solve the optimization problem in isolated optimization process
-                cDecomp_custom_close_to_zero = N_Qubit_Decomposition_custom( Umtx.copy(), qbit_num, false, CLOSE_TO_ZERO);
-                cDecomp_custom_close_to_zero.set_custom_gate_structure( gate_structure_loc );
-                cDecomp_custom_close_to_zero.set_optimization_blocks( gate_structure_loc->get_gate_num() );    
-                cDecomp_custom_close_to_zero.set_max_iteration( max_iterations );
-                cDecomp_custom_close_to_zero.set_verbose(0);
-                cDecomp_custom_close_to_zero.set_cost_function_variant( cost_fnc );
-                cDecomp_custom_close_to_zero.set_debugfile("");
-                cDecomp_custom_close_to_zero.set_optimization_tolerance( optimization_tolerance );  
-                cDecomp_custom_close_to_zero.set_optimizer( alg );
-                if ( alg == ADAM || alg == BFGS2 ) {
-                    int param_num_loc = gate_structure_loc->get_parameter_num();
-                    int iter_max_loc = (double)param_num_loc/852 * 1e7;
-                    cDecomp_custom_close_to_zero.set_iter_max( iter_max_loc );  
-                    cDecomp_custom_close_to_zero.set_random_shift_count_max( 10000 );       
-                    cDecomp_custom_close_to_zero.set_adaptive_eta( true );    
-                    cDecomp_custom_close_to_zero.set_randomized_radius( radius );
-                }
-                cDecomp_custom_close_to_zero.set_iteration_threshold_of_randomization( iteration_threshold_of_randomization );
-                cDecomp_custom.close_to_zero.set_trace_offset( trace_offset ); 
-                cDecomp_custom_close_to_zero.start_decomposition(true);
-                number_of_iters += cDecomp_custom_close_to_zero.get_num_iters();
-               }
-         );
-#endif
-*/
-         tbb::tick_count end_time_loc = tbb::tick_count::now();
-/*
-#ifdef __DFE__
-return NULL;
-#endif
-*/
-         double current_minimum_random         = cDecomp_custom_random.get_current_minimum();
-         double current_minimum_close_to_zero = cDecomp_custom_close_to_zero.get_current_minimum();
-         double current_minimum_loc;
-
-
-         // select between the results obtained for different initial value strategy
-         if ( current_minimum_random < optimization_tolerance && current_minimum_close_to_zero > optimization_tolerance ) {
-             current_minimum_loc = current_minimum_random;
-             optimized_parameters_mtx_loc = cDecomp_custom_random.get_optimized_parameters();
-             initial_guess = RANDOM;
-         }
-         else if ( current_minimum_random > optimization_tolerance && current_minimum_close_to_zero < optimization_tolerance ) {
-             current_minimum_loc = current_minimum_close_to_zero;
-             optimized_parameters_mtx_loc = cDecomp_custom_close_to_zero.get_optimized_parameters();
-             initial_guess = CLOSE_TO_ZERO;
-         }
-         else if ( current_minimum_random < optimization_tolerance && current_minimum_close_to_zero < optimization_tolerance ) {
-             Matrix_real optimized_parameters_mtx_random = cDecomp_custom_random.get_optimized_parameters();
-             Matrix_real optimized_parameters_mtx_close_to_zero = cDecomp_custom_close_to_zero.get_optimized_parameters();
-
-             int panelty_random         = get_panelty(gate_structure_loc, optimized_parameters_mtx_random);
-             int panelty_close_to_zero = get_panelty(gate_structure_loc, optimized_parameters_mtx_close_to_zero );
-
-             if ( panelty_random < panelty_close_to_zero ) {
-                 current_minimum_loc = current_minimum_random;
-                 optimized_parameters_mtx_loc = cDecomp_custom_random.get_optimized_parameters();
-                 initial_guess = RANDOM;
-             }
-             else {
-                 current_minimum_loc = current_minimum_close_to_zero;
-                 optimized_parameters_mtx_loc = cDecomp_custom_close_to_zero.get_optimized_parameters();
-                 initial_guess = CLOSE_TO_ZERO;
-             }
+            }
+        };
 
+#ifdef __DFE__
+        // the optimizations share the accelerator, so they are run one after the other
+        for (int level_idx=0; level_idx<level_num; level_idx++) {
+            solve_level( level_idx );
+        }
+#else
+        if ( level_num == 1 ) {
+            solve_level( 0 );
         }
         else {
-           if ( current_minimum_random < current_minimum_close_to_zero ) {
-                current_minimum_loc = current_minimum_random;
-                optimized_parameters_mtx_loc = cDecomp_custom_random.get_optimized_parameters();
-                initial_guess = RANDOM;
-           }
-           else {
-                current_minimum_loc = current_minimum_close_to_zero;
-                optimized_parameters_mtx_loc = cDecomp_custom_close_to_zero.get_optimized_parameters();
-                initial_guess = CLOSE_TO_ZERO;
-           }
-
+            // each circuit depth gets a fair share of the cores in its own task arena
+            int thread_num_per_level = tbb::this_task_arena::max_concurrency()/level_num;
+            thread_num_per_level = thread_num_per_level > 1 ? thread_num_per_level : 1;
+
+            tbb::parallel_for( 0, level_num, 1, [&](int level_idx) {
+                tbb::task_arena arena( thread_num_per_level );
+                arena.execute( [&]() {
+                    solve_level( level_idx );
+                });
+            });
         }
+#endif
+
+        tbb::tick_count end_time_loc = tbb::tick_count::now();
+
+        bool solved = false;
+        for (int level_idx=0; level_idx<level_num; level_idx++) {
+
+            Gates_block* gate_structure_loc = gate_structures_round[level_idx];
+            double current_minimum_loc = minimum_round[level_idx];
+
+            number_of_iters += iteration_num_round[level_idx];
 
-        minimum_vec.push_back(current_minimum_loc);
-        gate_structure_vec.push_back(gate_structure_loc);
-        optimized_parameters_vec.push_back(optimized_parameters_mtx_loc);
+            minimum_vec.push_back(current_minimum_loc);
+            gate_structure_vec.push_back(gate_structure_loc);
+            optimized_parameters_vec.push_back(optimized_parameters_round[level_idx]);
+            level_vec.push_back(level+level_idx);
 
 
+            if ( current_minimum_loc < optimization_tolerance ) {
+                std::stringstream sstream;
+                sstream << "Optimization problem solved with " << gate_structure_loc->get_gate_num() << " decomposing layers in " << (end_time_loc-start_time_loc).seconds() << " seconds." << std::endl;
+                print(sstream, 1);	       
+
+                // the initial value strategy of the found solution is kept for the further optimizations
+                if ( !solved ) {
+                    initial_guess = initial_guess_round[level_idx];
+                }
+                solved = true;
+            }   
+            else {
+                std::stringstream sstream;
+                sstream << "Optimization problem converged to " << current_minimum_loc << " with " <<  gate_structure_loc->get_gate_num() << " decomposing layers in "   << (end_time_loc-start_time_loc).seconds() << " seconds." << std::endl;
+                print(sstream, 1);  
+            }
 
-        if ( current_minimum_loc < optimization_tolerance ) {
-	    std::stringstream sstream;
-            sstream << "Optimization problem solved with " << gate_structure_loc->get_gate_num() << " decomposing layers in " << (end_time_loc-start_time_loc).seconds() << " seconds." << std::endl;
-            print(sstream, 1);	       
+        }
+
+        if ( solved ) {
             break;
-        }   
-        else {
-            std::stringstream sstream;
-            sstream << "Optimization problem converged to " << current_minimum_loc << " with " <<  gate_structure_loc->get_gate_num() << " decomposing layers in "   << (end_time_loc-start_time_loc).seconds() << " seconds." << std::endl;
-            print(sstream, 1);  
         }
 
-        level++;
+        // the next circuit depths are continued from the circuit depth with the lowest minimum
+        int level_idx_best = 0;
+        for (int level_idx=1; level_idx<level_num; level_idx++) {
+            if ( minimum_round[level_idx] < minimum_round[level_idx_best] ) {
+                level_idx_best = level_idx;
+            }
+        }
+
+        initial_guess = initial_guess_round[level_idx_best];
+        warm_start_idx = gate_structure_vec.size() - level_num + level_idx_best;
+
+        level += level_num;
     }
 
 //exit(-1);
 
-    // find the best decomposition
-    int idx_min = 0;
-    double current_minimum = minimum_vec[0];
-    for (int idx=1; idx<(int)minimum_vec.size(); idx++) {
-        if( current_minimum > minimum_vec[idx] ) {
+    // find the best decomposition: the shallowest circuit reaching the optimization tolerance (the circuit depths are stored in increasing order), or the one with the lowest cost if none of them reached it
+    int idx_min = -1;
+    for (int idx=0; idx<(int)minimum_vec.size(); idx++) {
+        if( minimum_vec[idx] < optimization_tolerance ) {
             idx_min = idx;
-            current_minimum = minimum_vec[idx];
+            break;
         }
     }
+
+    if ( idx_min < 0 ) {
+        idx_min = 0;
+        for (int idx=1; idx<(int)minimum_vec.size(); idx++) {
+            if( minimum_vec[idx_min] > minimum_vec[idx] ) {
+                idx_min = idx;
+            }
+        }
+    }
+
+    double current_minimum = minimum_vec[idx_min];
      
     Gates_block* gate_structure_loc = gate_structure_vec[idx_min];
     optimized_parameters_mtx_loc = optimized_parameters_vec[idx_min];
@@ -693,6 +897,7 @@ return NULL;
     minimum_vec.clear();
     gate_structure_vec.clear();
     optimized_parameters_vec.clear();
+    level_vec.clear();
     
 
     if (current_minimum > optimization_tolerance) {
@@ -756,16 +961,36 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
     std::vector<double> current_minimum_vec(panelties_num, DBL_MAX);
     std::vector<Matrix> Umtx_vec(panelties_num);
     std::vector<int> iteration_num_vec(panelties_num, 0);
+    std::vector<int> trivial_gates_iteration_num_vec(panelties_num, 0);
 
+    // Every layer contributes to the penalty, and a candidate removes one layer and at most one further trivial layer (see remove_trivial_gates),
+    // so the penalty of any candidate is at least the number of layers minus two.
+    int panelty_lower_bound = gate_structure->get_gate_num() - 2;
+
+    // cancellation flags of the candidates. In speculative compression a converged candidate reaching the lower bound of the penalties cancels
+    // the candidates of higher indices, while the candidates of lower indices are evaluated completely. Since equal penalties are resolved in
+    // favor of the lowest index, the same candidate is chosen as with the evaluation of all the candidates.
+    std::vector< std::atomic<bool> > candidate_cancelled( panelties_num );
     for (int idx=0; idx<panelties_num; idx++) {
+        candidate_cancelled[idx].store( false );
+    }
 
-        Umtx = Umtx_orig.copy();
+    auto evaluate_candidate = [&]( int idx ) {
+
+        // candidates not launched before the speculative cancellation are left unevaluated
+        if ( candidate_cancelled[idx].load() ) {
+            return;
+        }
+
+        std::atomic<bool>* cancellation_flag_loc = speculative_compression ? &candidate_cancelled[idx] : NULL;
+
+        Matrix Umtx_loc = Umtx_orig.copy();
 
         double current_minimum_loc = DBL_MAX;//current_minimum;
         int iteration_num = 0;
         Matrix_real optimized_parameters_loc = optimized_parameters_mtx.copy();
 
-        Gates_block* gate_structure_reduced = compress_gate_structure( gate_structure, layers_to_remove[idx], optimized_parameters_loc,  current_minimum_loc, iteration_num  );
+        Gates_block* gate_structure_reduced = compress_gate_structure( gate_structure, layers_to_remove[idx], optimized_parameters_loc,  current_minimum_loc, iteration_num, Umtx_loc, cancellation_flag_loc );
         if ( optimized_parameters_loc.size() == 0 ) optimized_parameters_loc = optimized_parameters_mtx.copy();
 
         // remove further adaptive gates if possible
@@ -774,29 +999,55 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
             gate_structure_tmp = gate_structure_reduced->clone();
         }
         else {
-            gate_structure_tmp = remove_trivial_gates( gate_structure_reduced, optimized_parameters_loc, current_minimum_loc );
+            gate_structure_tmp = remove_trivial_gates( gate_structure_reduced, optimized_parameters_loc, current_minimum_loc, Umtx_loc, trivial_gates_iteration_num_vec[idx], cancellation_flag_loc );
         }
         panelties[idx] = get_panelty(gate_structure_tmp, optimized_parameters_loc);
         gate_structures_vec[idx] = gate_structure_tmp;
         optimized_parameters_vec[idx] = optimized_parameters_loc;
         current_minimum_vec[idx] = current_minimum_loc;
         iteration_num_vec[idx] = iteration_num;
-        Umtx_vec[idx] = Umtx;
+        Umtx_vec[idx] = Umtx_loc;
         
 
         delete(gate_structure_reduced);
 
+        // none of the candidates of higher indices can be chosen instead of the present one
+        if ( speculative_compression && current_minimum_loc < optimization_tolerance && (int)panelties[idx] <= panelty_lower_bound ) {
+            for (int idx_cancel=idx+1; idx_cancel<panelties_num; idx_cancel++) {
+                candidate_cancelled[idx_cancel].store( true );
+            }
+        }
+
+    };
+
 #ifdef __DFE__
+    for (int idx=0; idx<panelties_num; idx++) {
+
+        evaluate_candidate( idx );
+
         if ( current_minimum_vec[idx] < optimization_tolerance ) {
             break;
         }
+    }
+#else
+    // the candidates are re-optimized concurrently. The evaluation of a candidate is isolated, so a thread waiting for the nested parallel
+    // regions of the optimization does not start a further candidate, and at most one candidate per thread is kept in memory.
+    tbb::parallel_for( 0, panelties_num, 1, [&](int idx) {
+        tbb::this_task_arena::isolate( [&]() {
+            evaluate_candidate( idx );
+        });
+    });
 #endif
+
+    for (int idx=0; idx<panelties_num; idx++) {
+        number_of_iters += trivial_gates_iteration_num_vec[idx];
     }
 
 
 //panelties.print_matrix();
 
-    // determine the reduction with the lowest penalty
+    // determine the reduction with the lowest penalty (identical penalties are resolved in favor of the lowest index, so the choice does not
+    // depend on which candidates were cancelled in speculative compression)
     unsigned int panelty_min = panelties[0];
     unsigned int idx_min = 0;
     for (size_t idx=0; idx<panelties.size(); idx++) {
@@ -804,16 +1055,6 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
             panelty_min = panelties[idx];
             idx_min = idx;
         }
-        else if ( panelty_min == panelties[idx] ) {
-
-            // randomly choose the solution between identical penalties
-            if ( (distrib_int(gen) % 2) == 1 ) {
-                idx_min = idx;
-
-                panelty_min = panelties[idx];
-            }
-
-        }
     }
     
 #ifdef __MPI__        
@@ -861,7 +1102,9 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
 @brief ???????????????
 */
 Gates_block* 
-N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_structure, int layer_idx, Matrix_real& optimized_parameters, double& current_minimum_loc, int& iteration_num ) {
+N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_structure, int layer_idx, Matrix_real& optimized_parameters, double& current_minimum_loc, int& iteration_num, Matrix& Umtx_loc, std::atomic<bool>* cancellation_flag_loc ) {
+
+    iteration_num = 0;
 
     // create reduced gate structure without layer indexed by layer_idx
     Gates_block* gate_structure_reduced = gate_structure->clone();
@@ -877,10 +1120,27 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
     
 
 
+    // try to compensate the removed layer by re-optimizing only the neighbouring layers in the environment of the fixed layers
+    if ( window_compression && parameters_reduced.size() > 0 ) {
+
+        int window_start = layer_idx - compression_window_layer_num > 0 ? layer_idx - compression_window_layer_num : 0;
+        int window_end = layer_idx + compression_window_layer_num < gate_structure_reduced->get_gate_num() ? layer_idx + compression_window_layer_num : gate_structure_reduced->get_gate_num();
+
+        double current_minimum_window = optimize_layer_window( gate_structure_reduced, parameters_reduced, window_start, window_end, Umtx_loc, iteration_num, cancellation_flag_loc );
+
+        if ( current_minimum_window < optimization_tolerance ) {
+            optimized_parameters = parameters_reduced;
+            current_minimum_loc = current_minimum_window;
+            return gate_structure_reduced;
+        }
+
+    }
+
+
     N_Qubit_Decomposition_custom cDecomp_custom;
        
     // solve the optimization problem in isolated optimization process
-    cDecomp_custom = N_Qubit_Decomposition_custom( Umtx.copy(), qbit_num, false, initial_guess, accelerator_num);
+    cDecomp_custom = N_Qubit_Decomposition_custom( Umtx_loc.copy(), qbit_num, false, initial_guess, accelerator_num);
     cDecomp_custom.set_custom_gate_structure( gate_structure_reduced );
     cDecomp_custom.set_optimized_parameters( parameters_reduced.get_data(), parameters_reduced.size() );
     cDecomp_custom.set_verbose(0);
@@ -891,16 +1151,19 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
     cDecomp_custom.set_optimization_blocks( gate_structure_reduced->get_gate_num() ) ;
     cDecomp_custom.set_optimization_tolerance( optimization_tolerance );
     cDecomp_custom.set_trace_offset( trace_offset ); 
+    cDecomp_custom.set_trace_estimation( trace_estimation_probe_num );
+    cDecomp_custom.set_meet_in_the_middle( meet_in_the_middle );
     cDecomp_custom.set_optimizer( alg );
-    if ( alg == ADAM || alg==BFGS2) {
+    if ( is_first_order_optimizer(alg) || alg==BFGS2) {
         cDecomp_custom.set_iter_max( 1e5 );  
         cDecomp_custom.set_random_shift_count_max( 1 );     
         cDecomp_custom.set_adaptive_eta( false );
         cDecomp_custom.set_randomized_radius( radius );        
     }
     cDecomp_custom.set_iteration_threshold_of_randomization( 2500 );
+    cDecomp_custom.set_cancellation_flag( cancellation_flag_loc );
     cDecomp_custom.start_decomposition(true);
-    iteration_num = cDecomp_custom.get_num_iters();
+    iteration_num += cDecomp_custom.get_num_iters();
     double current_minimum_tmp = cDecomp_custom.get_current_minimum();
 
     if ( current_minimum_tmp < optimization_tolerance ) {
@@ -916,6 +1179,133 @@ N_Qubit_Decomposition_adaptive::compress_gate_structure( Gates_block* gate_struc
 }
 
 
+/**
+@brief Call to re-optimize a window of consecutive layers of a gate structure while the other layers are kept fixed. The gates are applied on the unitary as L*W*R*Umtx, where W stands for the layers of the window, L for the preceding and R for the following layers of the gate structure. For cost functions depending only on the trace of the transformed unitary Tr(L*W*R*Umtx) = Tr(W*(R*Umtx*L)), so the environment R*Umtx*L is calculated once, and only the layers of the window are applied in the cost function and gradient evaluations of the optimization.
+@param gate_structure The gate structure
+@param parameters The parameters of the gate structure. The parameters of the window are replaced by the optimized ones. (returned by reference)
+@param window_start The index of the first layer in the window
+@param window_end The index after the last layer in the window
+@param Umtx_loc The unitary to be decomposed
+@param iteration_num The number of iterations spent on the optimization (returned by reference)
+@param cancellation_flag_loc Pointer to a flag cancelling the optimization once set (or NULL)
+@return Returns with the cost function of the whole gate structure with the optimized parameters, or with DBL_MAX if the window can not be optimized separately for the current cost function variant.
+*/
+double
+N_Qubit_Decomposition_adaptive::optimize_layer_window( Gates_block* gate_structure, Matrix_real& parameters, int window_start, int window_end, Matrix& Umtx_loc, int& iteration_num, std::atomic<bool>* cancellation_flag_loc ) {
+
+    iteration_num = 0;
+
+    // the corrections and the shifted trace are not invariant under the cyclic permutation of the product
+    if ( (cost_fnc != FROBENIUS_NORM && cost_fnc != HILBERT_SCHMIDT_TEST) || trace_offset != 0 || Umtx_loc.rows != Umtx_loc.cols || accelerator_num > 0 ) {
+        return DBL_MAX;
+    }
+
+    int layer_num = gate_structure->get_gate_num();
+
+    // the layers are expected to be gate blocks
+    for (int idx=0; idx<layer_num; idx++) {
+        if ( gate_structure->get_gate(idx)->get_type() != BLOCK_OPERATION ) {
+            return DBL_MAX;
+        }
+    }
+
+    // split the gate structure into the preceding layers, the window and the following layers
+    Gates_block* layers_pre = new Gates_block(qbit_num);
+    Gates_block* layers_window = new Gates_block(qbit_num);
+    Gates_block* layers_post = new Gates_block(qbit_num);
+
+    int parameter_num_pre = 0;
+    int parameter_num_window = 0;
+    int parameter_num_post = 0;
+
+    for (int idx=0; idx<layer_num; idx++) {
+
+        Gates_block* layer = static_cast<Gates_block*>( gate_structure->get_gate(idx) );
+        Gates_block* layer_cloned = layer->clone();
+
+        if ( idx < window_start ) {
+            layers_pre->add_gate_to_end( (Gate*)layer_cloned );
+            parameter_num_pre += layer->get_parameter_num();
+        }
+        else if ( idx < window_end ) {
+            layers_window->add_gate_to_end( (Gate*)layer_cloned );
+            parameter_num_window += layer->get_parameter_num();
+        }
+        else {
+            layers_post->add_gate_to_end( (Gate*)layer_cloned );
+            parameter_num_post += layer->get_parameter_num();
+        }
+
+    }
+
+    if ( parameter_num_window == 0 ) {
+        delete( layers_pre );
+        delete( layers_window );
+        delete( layers_post );
+        return DBL_MAX;
+    }
+
+    // the environment of the window
+    Matrix environment = Umtx_loc.copy();
+
+    if ( layers_post->get_gate_num() > 0 ) {
+        Matrix_real parameters_post( parameters.get_data() + parameter_num_pre + parameter_num_window, 1, parameter_num_post );
+        layers_post->apply_to( parameters_post, environment );
+    }
+
+    if ( layers_pre->get_gate_num() > 0 ) {
+        Matrix_real parameters_pre( parameters.get_data(), 1, parameter_num_pre );
+        layers_pre->apply_from_right( parameters_pre, environment );
+    }
+
+    Matrix_real parameters_window = Matrix_real( parameters.get_data() + parameter_num_pre, 1, parameter_num_window ).copy();
+
+    N_Qubit_Decomposition_custom cDecomp_custom( environment, qbit_num, false, initial_guess, accelerator_num );
+    cDecomp_custom.set_custom_gate_structure( layers_window );
+    cDecomp_custom.set_optimized_parameters( parameters_window.get_data(), parameters_window.size() );
+    cDecomp_custom.set_verbose(0);
+    cDecomp_custom.set_cost_function_variant( cost_fnc );
+    cDecomp_custom.set_debugfile("");
+    cDecomp_custom.set_max_iteration( max_iterations );
+    cDecomp_custom.set_iteration_loops( iteration_loops );
+    cDecomp_custom.set_optimization_blocks( layers_window->get_gate_num() ) ;
+    cDecomp_custom.set_optimization_tolerance( optimization_tolerance );
+    cDecomp_custom.set_optimizer( alg );
+    if ( is_first_order_optimizer(alg) || alg==BFGS2) {
+        cDecomp_custom.set_iter_max( 1e5 );  
+        cDecomp_custom.set_random_shift_count_max( 1 );     
+        cDecomp_custom.set_adaptive_eta( false );
+        cDecomp_custom.set_randomized_radius( radius );        
+    }
+    cDecomp_custom.set_iteration_threshold_of_randomization( 2500 );
+    cDecomp_custom.set_cancellation_flag( cancellation_flag_loc );
+    cDecomp_custom.start_decomposition(false);
+    iteration_num = cDecomp_custom.get_num_iters();
+
+    delete( layers_pre );
+    delete( layers_window );
+    delete( layers_post );
+
+    // the optimized parameters of the window are inserted into the parameters of the whole gate structure
+    Matrix_real parameters_window_optimized = cDecomp_custom.get_optimized_parameters();
+    if ( parameters_window_optimized.size() == parameter_num_window ) {
+        memcpy( parameters.get_data() + parameter_num_pre, parameters_window_optimized.get_data(), parameter_num_window*sizeof(double) );
+    }
+
+    // the cost function of the whole gate structure (the decomposition of the window might change the global phase of the environment)
+    Matrix transformed = Umtx_loc.copy();
+    gate_structure->apply_to( parameters, transformed );
+
+    if ( cost_fnc == FROBENIUS_NORM ) {
+        return get_cost_function( transformed, trace_offset );
+    }
+    else {
+        return get_hilbert_schmidt_test( transformed );
+    }
+
+}
+
+
 /**
 @brief ???????????????
 */
@@ -1100,7 +1490,7 @@ N_Qubit_Decomposition_adaptive::replace_trivial_CRY_gates( Gates_block* gate_str
 @brief ???????????????
 */
 Gates_block*
-N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structure, Matrix_real& optimized_parameters, double& current_minimum_loc ) {
+N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structure, Matrix_real& optimized_parameters, double& current_minimum_loc, Matrix& Umtx_loc, int& iteration_num, std::atomic<bool>* cancellation_flag_loc ) {
 
 
     int layer_num = gate_structure->get_gate_num();
@@ -1182,12 +1572,12 @@ N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structur
 
 
                 Matrix_real param1( &optimized_parameters_loc[parameter_idx_to_be_removed], 1, U_gate_to_be_removed->get_parameter_num() );
-                Matrix U3_matrix1 = U_gate_to_be_removed->calc_one_qubit_u3(param1[0], param1[1], param1[2] );
+                QGD_Kernel2x2 U3_matrix1 = U_gate_to_be_removed->calc_one_qubit_u3(param1[0], param1[1], param1[2] );
 
                 Matrix_real param2( &optimized_parameters_loc[parameter_idx_loc], 1, matching_gate->get_parameter_num() );
-                Matrix U3_matrix2 = matching_gate->calc_one_qubit_u3(param2[0], param2[1], param2[2] );
+                QGD_Kernel2x2 U3_matrix2 = matching_gate->calc_one_qubit_u3(param2[0], param2[1], param2[2] );
 
-                Matrix U3_prod = dot(U3_matrix2, U3_matrix1);
+                QGD_Kernel2x2 U3_prod = dot(U3_matrix2, U3_matrix1);
 
                 optimized_parameters_loc[parameter_idx_to_be_removed] = 0.0;
                 optimized_parameters_loc[parameter_idx_to_be_removed+1] = 0.0;
@@ -1215,11 +1605,12 @@ N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structur
 		}
 
                 // the product U3 matrix
-		Matrix U3_new = matching_gate->calc_one_qubit_u3(theta3_over2,phi3,lambda3);
+		QGD_Kernel2x2 U3_new = matching_gate->calc_one_qubit_u3(theta3_over2,phi3,lambda3);
 		QGD_Complex16 global_phase_factor_new;
 		global_phase_factor_new.real = std::cos(alpha);
 		global_phase_factor_new.imag = std::sin(alpha);
-		apply_global_phase_factor(global_phase_factor_new, U3_new);
+		Matrix U3_new_mtx(U3_new.get_data(), 2, 2);
+		apply_global_phase_factor(global_phase_factor_new, U3_new_mtx);
                 // test for the product U3 matrix
 		if (std::sqrt((U3_new[3].real-U3_prod[3].real)*(U3_new[3].real-U3_prod[3].real)) + std::sqrt((U3_new[3].imag-U3_prod[3].imag)*(U3_new[3].imag-U3_prod[3].imag)) < 1e-8 && (stheta3_over2*stheta3_over2+ctheta3_over2*ctheta3_over2) > 0.99) {
 
@@ -1227,7 +1618,7 @@ N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structur
 		    param2[0] = theta3_over2;
 		    param2[1] = phi3;
 		    param2[2] = lambda3;
-    		apply_global_phase_factor(global_phase_factor_new, Umtx);
+    		apply_global_phase_factor(global_phase_factor_new, Umtx_loc);
 		}
 /*
 	        N_Qubit_Decomposition_custom cDecomp_custom_( Umtx.copy(), qbit_num, false, initial_guess);
@@ -1244,8 +1635,8 @@ N_Qubit_Decomposition_adaptive::remove_trivial_gates( Gates_block* gate_structur
                
             // remove gate from the structure
             int iteration_num_loc = 0;
-            Gates_block* gate_structure_tmp = compress_gate_structure( gate_structure_loc, idx, optimized_parameters_loc, current_minimum_loc, iteration_num_loc );
-	    number_of_iters += iteration_num_loc;
+            Gates_block* gate_structure_tmp = compress_gate_structure( gate_structure_loc, idx, optimized_parameters_loc, current_minimum_loc, iteration_num_loc, Umtx_loc, cancellation_flag_loc );
+	    iteration_num += iteration_num_loc;
 	    
             optimized_parameters = optimized_parameters_loc;
             delete( gate_structure_loc );
@@ -1632,8 +2023,123 @@ N_Qubit_Decomposition_adaptive::add_layer_to_imported_gate_structure() {
 
 
 
+/**
+@brief Call to set the number of optimizations started in parallel from different initial parameters when determining the initial gate structure. The remaining optimizations are cancelled once one of them reaches the optimization tolerance.
+@param multi_start_num_in The number of starting points (values smaller than 2 run a single optimization)
+*/
+void 
+N_Qubit_Decomposition_adaptive::set_multi_start_num( int multi_start_num_in ) {
+
+    multi_start_num = multi_start_num_in;
+
+}
+
+
+/**
+@brief Call to get the number of optimizations started in parallel when determining the initial gate structure.
+@return Returns with the number of starting points
+*/
+int 
+N_Qubit_Decomposition_adaptive::get_multi_start_num() {
+
+    return multi_start_num;
+
+}
+
+
+
+/**
+@brief Call to set whether the gate structure compression is speculative. In speculative compression the layer removal candidates still being optimized are cancelled once a candidate converges with a penalty no other candidate can go below (i.e. removing two layers in one step), so the number of the remaining layers is the same as when all the candidates are evaluated.
+@param speculative_compression_in Set true to cancel the remaining candidates after a converged candidate reaching the lowest possible penalty
+*/
+void 
+N_Qubit_Decomposition_adaptive::set_speculative_compression( bool speculative_compression_in ) {
+
+    speculative_compression = speculative_compression_in;
+
+}
+
+
+/**
+@brief Call to get whether the gate structure compression is speculative.
+@return Returns with true if the remaining layer removal candidates are cancelled after the first converged one
+*/
+bool 
+N_Qubit_Decomposition_adaptive::get_speculative_compression() {
+
+    return speculative_compression;
+
+}
+
+
+/**
+@brief Call to set whether the gate structure compression re-optimizes the layers next to a removed layer in the environment of the fixed layers before re-optimizing the whole circuit. The whole circuit is re-optimized only if the re-optimization of the window does not reach the optimization tolerance. (Applied for the FROBENIUS_NORM and HILBERT_SCHMIDT_TEST cost functions without trace offset.)
+@param window_compression_in Set true to re-optimize the layers next to a removed layer first
+*/
+void 
+N_Qubit_Decomposition_adaptive::set_window_compression( bool window_compression_in ) {
+
+    window_compression = window_compression_in;
+
+}
+
+
+/**
+@brief Call to get whether the gate structure compression re-optimizes the layers next to a removed layer first.
+@return Returns with true if the layers next to a removed layer are re-optimized first
+*/
+bool 
+N_Qubit_Decomposition_adaptive::get_window_compression() {
+
+    return window_compression;
 
+}
 
 
 
+/**
+@brief Call to set whether the circuit depths are warm started in the search for the initial gate structure. In the warm started search the gate structure of the next depth is obtained by adding a new decomposing layer to the previous one, and the optimization is continued from the optimized parameters of the previous depth with close to identity parameters of the new layer.
+@param warm_start_levels_in Set true to warm start the circuit depths
+*/
+void 
+N_Qubit_Decomposition_adaptive::set_warm_start_levels( bool warm_start_levels_in ) {
 
+    warm_start_levels = warm_start_levels_in;
+
+}
+
+
+/**
+@brief Call to get whether the circuit depths are warm started in the search for the initial gate structure.
+@return Returns with true if the circuit depths are warm started
+*/
+bool 
+N_Qubit_Decomposition_adaptive::get_warm_start_levels() {
+
+    return warm_start_levels;
+
+}
+
+
+/**
+@brief Call to set the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure. The remaining optimizations are cancelled once one of the depths reaches the optimization tolerance.
+@param concurrent_level_num_in The number of concurrently optimized circuit depths (values smaller than 2 optimize the depths one after the other)
+*/
+void 
+N_Qubit_Decomposition_adaptive::set_concurrent_level_num( int concurrent_level_num_in ) {
+
+    concurrent_level_num = concurrent_level_num_in;
+
+}
+
+
+/**
+@brief Call to get the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure.
+@return Returns with the number of concurrently optimized circuit depths
+*/
+int 
+N_Qubit_Decomposition_adaptive::get_concurrent_level_num() {
+
+    return concurrent_level_num;
+
+}
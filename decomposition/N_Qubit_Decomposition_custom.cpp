@@ -25,6 +25,9 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include "N_Qubit_Decomposition_custom.h"
 #include "N_Qubit_Decomposition_Cost_Function.h"
 
+#include <atomic>
+#include <tbb/task_arena.h>
+
 
 
 /**
@@ -197,6 +200,307 @@ std::cout << "ooooooooooooo " <<  optimized_parameters_mtx.size() << std::endl;
 }
 
 
+/// The maximal number of problems evaluated in lockstep in the lanes of a batch by start_decomposition_batched (two AVX2 registers or one AVX-512 register of doubles)
+static const int batched_lane_num_max = 8;
+
+
+/**
+@brief Call to determine whether two compiled gate tapes describe the same gate structure.
+@param tape The first tape
+@param tape_other The second tape
+@return Returns with true if the gates, their qubits and parameters agree in the two tapes, false otherwise.
+*/
+static bool
+is_same_gate_structure( std::vector<Tape_Instruction>& tape, std::vector<Tape_Instruction>& tape_other ) {
+
+    if ( tape.size() != tape_other.size() ) {
+        return false;
+    }
+
+    for (size_t idx=0; idx<tape.size(); idx++) {
+
+        Tape_Instruction& instruction = tape[idx];
+        Tape_Instruction& instruction_other = tape_other[idx];
+
+        if ( instruction.kernel_type != instruction_other.kernel_type || instruction.gate->get_type() != instruction_other.gate->get_type() ||
+             instruction.target_qbit != instruction_other.target_qbit || instruction.control_qbit != instruction_other.control_qbit ||
+             instruction.parameter_idx != instruction_other.parameter_idx || instruction.parameter_num != instruction_other.parameter_num ) {
+            return false;
+        }
+
+    }
+
+    return true;
+
+}
+
+
+/**
+@brief Call to decompose a batch of unitaries sharing the same custom gate structure. The problems are packed into the lanes of structure of arrays batches (see Gates_block::get_trace_derivatives_batched), so the cost functions and the gradients of the problems in a batch are evaluated in lockstep, while the batches are processed in parallel. Each problem is optimized by its own first order optimizer (see first_order_iteration), and a problem is retired from its batch as soon as it converges or runs out of iterations, giving its lane to the next unsolved problem. Only the FROBENIUS_NORM and HILBERT_SCHMIDT_TEST cost functions evaluated on the whole unitary are supported.
+@param decompositions The decompositions of the unitaries. The gate structure, the optimizer and the parameters of the optimization are set individually for each of them.
+@param prepare_export Logical parameter. Set true to prepare the list of gates to be exported, or false otherwise.
+*/
+void
+N_Qubit_Decomposition_custom::start_decomposition_batched( std::vector<N_Qubit_Decomposition_custom*>& decompositions, bool prepare_export ) {
+
+    int problem_num = decompositions.size();
+
+    if ( problem_num == 0 ) {
+        return;
+    }
+
+    // the gates of the first problem are used to evaluate all the batches
+    N_Qubit_Decomposition_custom* decomp_first = decompositions[0];
+
+    for (int idx=0; idx<problem_num; idx++) {
+
+        N_Qubit_Decomposition_custom* decomp = decompositions[idx];
+
+        if ( !is_first_order_optimizer( decomp->alg ) ) {
+            std::string err("N_Qubit_Decomposition_custom::start_decomposition_batched: the problems should be optimized by a first order optimizer (ADAM, AMSGRAD, ADAMW or MOMENTUM_SGD).");
+            throw err;
+        }
+
+        if ( decomp->cost_fnc != FROBENIUS_NORM && decomp->cost_fnc != HILBERT_SCHMIDT_TEST ) {
+            std::string err("N_Qubit_Decomposition_custom::start_decomposition_batched: only the FROBENIUS_NORM and HILBERT_SCHMIDT_TEST cost functions are supported.");
+            throw err;
+        }
+
+        if ( decomp->trace_offset != 0 || decomp->Umtx.rows != decomp->Umtx.cols || decomp->Umtx.rows != decomp_first->Umtx.rows ) {
+            std::string err("N_Qubit_Decomposition_custom::start_decomposition_batched: the unitaries should be square matrices of the same size.");
+            throw err;
+        }
+
+        // setting the gate structure for optimization
+        decomp->add_gate_layers();
+
+        if ( !is_same_gate_structure( decomp->get_tape(), decomp_first->get_tape() ) ) {
+            std::string err("N_Qubit_Decomposition_custom::start_decomposition_batched: the problems should share the same gate structure.");
+            throw err;
+        }
+
+    }
+
+
+    // temporarily turn off OpenMP parallelism (the batches are processed in parallel)
+#if BLAS==0 // undefined BLAS
+    int num_threads_loc = omp_get_max_threads();
+    omp_set_num_threads(1);
+#elif BLAS==1 // MKL
+    int num_threads_loc = mkl_get_max_threads();
+    MKL_Set_Num_Threads(1);
+#elif BLAS==2 //OpenBLAS
+    int num_threads_loc = openblas_get_num_threads();
+    openblas_set_num_threads(1);
+#endif
+
+    //measure the time for the decompositions
+    tbb::tick_count start_time = tbb::tick_count::now();
+
+    int parameter_num_loc = decomp_first->get_parameter_num();
+    int matrix_size_loc = decomp_first->Umtx.rows;
+
+    // the states of the optimizations and the current parameters and gradients of the problems
+    std::vector<First_Order_State> states( problem_num );
+    std::vector<Matrix_real> parameters( problem_num );
+    std::vector<Matrix_real> grads( problem_num );
+    std::vector<int> iter_nums( problem_num, 0 );
+
+    std::uniform_real_distribution<> distrib_real(0.0, 2*M_PI);
+
+    for (int idx=0; idx<problem_num; idx++) {
+
+        N_Qubit_Decomposition_custom* decomp = decompositions[idx];
+
+        decomp->global_target_minimum = 0;
+        decomp->current_minimum = DBL_MAX;
+
+        // preparing the solution guess (the imported parameters are used if available)
+        if ( decomp->optimized_parameters_mtx.size() == parameter_num_loc ) {
+            parameters[idx] = decomp->optimized_parameters_mtx.copy();
+        }
+        else {
+
+            parameters[idx] = Matrix_real(1, parameter_num_loc);
+
+            for (int jdx=0; jdx<parameter_num_loc; jdx++) {
+                if ( decomp->initial_guess == ZEROS ) {
+                    parameters[idx][jdx] = 0.0;
+                }
+                else if ( decomp->initial_guess == RANDOM ) {
+                    parameters[idx][jdx] = distrib_real(decomp->gen);
+                }
+                else {
+                    parameters[idx][jdx] = distrib_real(decomp->gen)/100;
+                }
+            }
+
+            decomp->optimized_parameters_mtx = parameters[idx].copy();
+        }
+
+        grads[idx] = Matrix_real(1, parameter_num_loc);
+        decomp->initialize_first_order_state( states[idx], parameter_num_loc );
+
+    }
+
+
+    // The problems are distributed in batches of at most batched_lane_num_max lanes over the workers, so each of the workers gets a batch
+    // even if there are only a few problems. The unsolved problems are handed out by a shared counter, when a lane of a batch is retired.
+    int worker_num = tbb::this_task_arena::max_concurrency();
+    int lane_num_max = (problem_num + worker_num - 1)/worker_num;
+    lane_num_max = lane_num_max < batched_lane_num_max ? lane_num_max : batched_lane_num_max;
+    worker_num = (problem_num + lane_num_max - 1)/lane_num_max;
+
+    std::atomic<int> next_problem_idx(0);
+
+    if ( parameter_num_loc > 0 ) {
+
+        tbb::parallel_for( tbb::blocked_range<int>(0, worker_num, 1), [&](tbb::blocked_range<int> r) {
+
+            for (int worker_idx=r.begin(); worker_idx<r.end(); worker_idx++) {
+
+                // the indices of the problems in the lanes of the batch
+                std::vector<int> lane_problems;
+
+                while ( (int)lane_problems.size() < lane_num_max ) {
+                    int problem_idx = next_problem_idx++;
+                    if ( problem_idx >= problem_num ) {
+                        break;
+                    }
+                    lane_problems.push_back( problem_idx );
+                }
+
+                Matrix_real batch;
+                Matrix_real parameters_batch;
+                Matrix traces;
+                Matrix trace_derivatives;
+
+                while ( lane_problems.size() > 0 ) {
+
+                    int lane_num = lane_problems.size();
+
+                    if ( batch.cols != lane_num ) {
+                        batch = Matrix_real(2*matrix_size_loc*matrix_size_loc, lane_num);
+                        parameters_batch = Matrix_real(lane_num, parameter_num_loc);
+                        traces = Matrix(1, lane_num);
+                        trace_derivatives = Matrix(lane_num, parameter_num_loc);
+                    }
+
+                    // pack the unitaries and the parameters of the problems into the lanes (the batch is overwritten in each evaluation)
+                    for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+
+                        Matrix& Umtx_loc = decompositions[ lane_problems[lane_idx] ]->Umtx;
+
+                        for (int row_idx=0; row_idx<matrix_size_loc; row_idx++) {
+                            for (int col_idx=0; col_idx<matrix_size_loc; col_idx++) {
+                                QGD_Complex16& element = Umtx_loc[row_idx*Umtx_loc.stride + col_idx];
+                                int element_idx = 2*(row_idx*matrix_size_loc + col_idx);
+                                batch[element_idx*batch.stride + lane_idx] = element.real;
+                                batch[(element_idx+1)*batch.stride + lane_idx] = element.imag;
+                            }
+                        }
+
+                        memcpy( parameters_batch.get_data() + lane_idx*parameters_batch.stride, parameters[ lane_problems[lane_idx] ].get_data(), parameter_num_loc*sizeof(double) );
+
+                    }
+
+                    decomp_first->get_trace_derivatives_batched( parameters_batch, batch, traces, trace_derivatives );
+
+                    std::vector<int> lane_problems_new;
+                    lane_problems_new.reserve( lane_num_max );
+
+                    for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+
+                        int problem_idx = lane_problems[lane_idx];
+                        N_Qubit_Decomposition_custom* decomp = decompositions[problem_idx];
+                        Matrix_real& grad = grads[problem_idx];
+
+                        // the cost function and its gradient from the trace and its derivatives
+                        QGD_Complex16& trace = traces[lane_idx];
+                        QGD_Complex16* trace_derivatives_lane = trace_derivatives.get_data() + lane_idx*trace_derivatives.stride;
+                        double f0;
+
+                        if ( decomp->cost_fnc == FROBENIUS_NORM ) {
+                            f0 = 1.0 - trace.real/matrix_size_loc;
+                            for (int parameter_idx=0; parameter_idx<parameter_num_loc; parameter_idx++) {
+                                grad[parameter_idx] = -trace_derivatives_lane[parameter_idx].real/matrix_size_loc;
+                            }
+                        }
+                        else {
+                            double d = 1.0/matrix_size_loc;
+                            f0 = 1.0 - d*d*(trace.real*trace.real + trace.imag*trace.imag);
+                            for (int parameter_idx=0; parameter_idx<parameter_num_loc; parameter_idx++) {
+                                grad[parameter_idx] = -2.0*d*d*(trace.real*trace_derivatives_lane[parameter_idx].real + trace.imag*trace_derivatives_lane[parameter_idx].imag);
+                            }
+                        }
+
+                        decomp->number_of_iters++;
+                        iter_nums[problem_idx]++;
+
+                        bool proceed = decomp->first_order_iteration( states[problem_idx], parameters[problem_idx], grad, f0 );
+
+                        if ( proceed && iter_nums[problem_idx] < decomp->iter_max ) {
+                            lane_problems_new.push_back( problem_idx );
+                        }
+
+                    }
+
+                    // give the lanes of the retired problems to the unsolved ones
+                    while ( (int)lane_problems_new.size() < lane_num_max ) {
+                        int problem_idx = next_problem_idx++;
+                        if ( problem_idx >= problem_num ) {
+                            break;
+                        }
+                        lane_problems_new.push_back( problem_idx );
+                    }
+
+                    lane_problems.swap( lane_problems_new );
+
+                }
+
+            }
+
+        });
+
+    }
+
+
+    // prepare the gates to export and calculate the final errors of the decompositions
+    tbb::parallel_for( tbb::blocked_range<int>(0, problem_num, 1), [&](tbb::blocked_range<int> r) {
+
+        for (int idx=r.begin(); idx<r.end(); idx++) {
+
+            N_Qubit_Decomposition_custom* decomp = decompositions[idx];
+
+            if (prepare_export) {
+                decomp->prepare_gates_to_export();
+            }
+
+            Matrix matrix_decomposed = decomp->get_transformed_matrix(decomp->optimized_parameters_mtx, decomp->gates.begin(), decomp->gates.size(), decomp->Umtx );
+            decomp->calc_decomposition_error( matrix_decomposed );
+
+        }
+
+    });
+
+
+    std::stringstream sstream;
+    tbb::tick_count current_time = tbb::tick_count::now();
+    sstream << "--- In total " << (current_time - start_time).seconds() << " seconds elapsed during the batched decomposition of " << problem_num << " unitaries ---" << std::endl;
+    decomp_first->print(sstream, 1);
+
+
+#if BLAS==0 // undefined BLAS
+    omp_set_num_threads(num_threads_loc);
+#elif BLAS==1 //MKL
+    MKL_Set_Num_Threads(num_threads_loc);
+#elif BLAS==2 //OpenBLAS
+    openblas_set_num_threads(num_threads_loc);
+#endif
+
+}
+
+
 /**
 @brief Call to add further layer to the gate structure used in the subdecomposition.
 */
@@ -52,6 +52,7 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include <tbb/cache_aligned_allocator.h>
 
 #include <random>
+#include <atomic>
 
 /// @brief Type definition of the types of the initial guess
 typedef enum guess_type {ZEROS, RANDOM, CLOSE_TO_ZERO} guess_type;
@@ -134,6 +135,9 @@ protected:
     /// Standard mersenne_twister_engine seeded with rd()
     std::mt19937 gen; 
 
+    /// Pointer to a flag shared by concurrent optimizations: the optimization is stopped once the flag is set. (NULL if the optimization can not be cancelled)
+    std::atomic<bool>* cancellation_flag;
+
 
 
 public:
@@ -222,6 +226,19 @@ virtual double optimization_problem( const double* parameters );
 bool check_optimization_solution();
 
 
+/**
+@brief Call to set the flag used to cancel the optimization from an other thread (e.g. when a concurrent optimization already reached the optimization tolerance)
+@param cancellation_flag_in Pointer to the flag (NULL to disable the cancellation)
+*/
+void set_cancellation_flag( std::atomic<bool>* cancellation_flag_in );
+
+/**
+@brief Call to check whether the optimization was cancelled
+@return Returns with true if the cancellation flag is set, or false otherwise.
+*/
+bool is_cancelled();
+
+
 /**
 @brief Calculate the list of gate gate matrices such that the i>0-th element in the result list is the product of the gates of all 0<=n<i gates from the input list and the 0th element in the result list is the identity.
 @param parameters An array containing the parameters of the U3 gates.
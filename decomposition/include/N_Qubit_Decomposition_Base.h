@@ -25,6 +25,9 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #define N_Qubit_Decomposition_Base_H
 
 #include "Decomposition_Base.h"
+#include "Optimizer_Base.h"
+
+#include <memory>
 
 /// @brief Type definition of the fifferent types of the cost function
 typedef enum cost_function_type {FROBENIUS_NORM, FROBENIUS_NORM_CORRECTION1, FROBENIUS_NORM_CORRECTION2, HILBERT_SCHMIDT_TEST, HILBERT_SCHMIDT_TEST_CORRECTION1, HILBERT_SCHMIDT_TEST_CORRECTION2} cost_function_type;
@@ -59,7 +62,41 @@ int LAPACKE_zggev 	( 	int  	matrix_layout,
 
 
 /// implemented optimization algorithms
-enum optimization_aglorithms{ ADAM, BFGS, BFGS2, ADAM_BATCHED };
+enum optimization_aglorithms{ ADAM, BFGS, BFGS2, ADAM_BATCHED, AMSGRAD, ADAMW, MOMENTUM_SGD };
+
+
+/**
+@brief Call to determine whether the optimization algorithm is a first order optimizer run by solve_layer_optimization_problem_ADAM
+@param alg The optimization algorithm
+@return Returns with true for the first order optimizers, false otherwise
+*/
+inline bool
+is_first_order_optimizer( optimization_aglorithms alg ) {
+
+    return alg == ADAM || alg == AMSGRAD || alg == ADAMW || alg == MOMENTUM_SGD;
+
+}
+
+
+/**
+@brief Structure containing the state of a first order optimization (see N_Qubit_Decomposition_Base::first_order_iteration)
+*/
+struct First_Order_State {
+
+    /// The optimizer updating the parameters (its workspaces are reused after the randomizations)
+    std::unique_ptr<Optimizer_Base> optimizer;
+    /// The number of iterations since the last significant decrease of the cost function
+    int sub_iter_idx;
+    /// The value of the cost function at the last significant decrease
+    double current_minimum_hold;
+    /// The number of the randomizations of the parameters
+    int random_shift_count;
+    /// Set to 1 if the current minimum was improved since the last randomization, 0 otherwise
+    int randomization_successful;
+    /// The status returned by the last update of the optimizer (nonzero in a local minimum)
+    int ADAM_status;
+
+};
 
 
 /**
@@ -117,6 +154,18 @@ protected:
     /// The offset in the first columns from which the "trace" is calculated. In this case Tr(A) = sum_(i-offset=j) A_{ij}
     int trace_offset;
 
+    /// The number of columns requested to be sampled to estimate the trace in the cost function (0 if the trace is calculated exactly)
+    int trace_estimation_probe_num;
+    /// The number of columns sampled in the current optimization problem (0 if the trace is calculated exactly)
+    int trace_probe_num;
+    /// The probe vectors of the trace estimation (sqrt(N) times the unit vectors of the sampled columns) stored in the columns of the matrix
+    Matrix trace_probes;
+    /// The unitary Umtx applied on the probe vectors
+    Matrix Umtx_probes;
+
+    /// Set true to evaluate the trace in the cost function by meeting the two halves of the gate sequence in the middle
+    bool meet_in_the_middle;
+
 
     Matrix_real randomization_probs;
     matrix_base<int> randomized_probs;
@@ -180,6 +229,13 @@ void final_optimization();
 void solve_layer_optimization_problem( int num_of_parameters, gsl_vector *solution_guess_gsl);
 
 
+/**
+@brief Call to determine whether the fixed gates following the optimized gates can be merged into the unitary during the optimization of a block of gates. (Possible when the cost function depends only on the trace of the transformed unitary.)
+@return Returns with true if the environment of the fixed gates can be used, false otherwise.
+*/
+bool use_fixed_gate_environment();
+
+
 
 
 /**
@@ -199,18 +255,42 @@ void solve_layer_optimization_problem_BFGS( int num_of_parameters, gsl_vector *s
 void solve_layer_optimization_problem_BFGS2( int num_of_parameters, gsl_vector *solution_guess_gsl);
 
 /**
-@brief Call to solve layer by layer the optimization problem via batched ADAM algorithm. (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
+@brief Call to solve layer by layer the optimization problem via batched ADAM algorithm. (optimal for larger problems) The ADAM optimization (see solve_layer_optimization_problem_ADAM) is run on randomly chosen column slices of the unitary. The slices are redrawn during the optimization, while the state of the optimizer is kept. The optimalized parameters are stored in attribute optimized_parameters.
 @param num_of_parameters Number of parameters to be optimized
 @param solution_guess_gsl A GNU Scientific Library vector containing the solution guess.
 */
 void solve_layer_optimization_problem_ADAM_BATCHED( int num_of_parameters, gsl_vector *solution_guess_gsl);
 
 /**
-@brief Call to solve layer by layer the optimization problem via ADAM algorithm. (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
+@brief Call to solve layer by layer the optimization problem via ADAM algorithm or via an other first order optimizer chosen by the attribute alg (see create_first_order_optimizer). (optimal for larger problems) The optimalized parameters are stored in attribute optimized_parameters.
 @param num_of_parameters Number of parameters to be optimized
 @param solution_guess_gsl A GNU Scientific Library vector containing the solution guess.
+@param Umtx_batched If not NULL, the cost function is evaluated on randomly chosen column slices of this matrix (see solve_layer_optimization_problem_ADAM_BATCHED). A new slice is drawn after every iter_max iterations, up to 100 slices, while the state of the optimizer, the learning rate and the randomization counters are kept across the slices. (The attributes Umtx and trace_offset are overwritten by the slices.)
+*/
+void solve_layer_optimization_problem_ADAM( int num_of_parameters, gsl_vector *solution_guess_gsl, Matrix* Umtx_batched=NULL);
+
+/**
+@brief Call to create the first order optimizer corresponding to the attribute alg
+@return Returns with a pointer to the created optimizer. (The caller is responsible for its deletion)
+*/
+Optimizer_Base* create_first_order_optimizer();
+
+/**
+@brief Call to initialize the state of a first order optimization (see first_order_iteration) with the optimizer chosen by the attribute alg.
+@param state The state to be initialized
+@param num_of_parameters Number of parameters to be optimized
+*/
+void initialize_first_order_state( First_Order_State& state, int num_of_parameters );
+
+/**
+@brief Call to perform one iteration of a first order optimization from the cost function and the gradient evaluated at the current parameters: the current minimum is updated, then the parameters are either updated by the optimizer or randomized around the current minimum when the cost function stops decreasing. (Used by solve_layer_optimization_problem_ADAM and by the batched decompositions evaluating several problems in lockstep.)
+@param state The state of the optimization (see initialize_first_order_state)
+@param parameters The current parameters. On exit they are replaced by the parameters of the next iteration.
+@param grad The gradient of the cost function at the current parameters
+@param f0 The cost function at the current parameters
+@return Returns with false if the optimization is finished (the cost function reached the optimization tolerance, the number of the randomizations exceeded random_shift_count_max or the optimization was cancelled), true otherwise.
 */
-void solve_layer_optimization_problem_ADAM( int num_of_parameters, gsl_vector *solution_guess_gsl);
+bool first_order_iteration( First_Order_State& state, Matrix_real& parameters, Matrix_real& grad, double f0 );
 
 /**
 @brief ?????????????
@@ -261,6 +341,15 @@ static double optimization_problem( const gsl_vector* parameters, void* void_ins
 static Matrix_real optimization_problem_batch( int batchsize, const gsl_vector* parameters, void* void_instance );
 
 
+/**
+@brief The cost function evaluated for a batch of parameter vectors
+@param parameters The parameter vectors stored in the rows of the matrix
+@param void_instance A void pointer pointing to the instance of the current class.
+@return Returns with a column vector of the cost function values.
+*/
+static Matrix_real optimization_problem_batch( Matrix_real& parameters, void* void_instance );
+
+
 /**
 @brief Calculate the approximate derivative (f-f0)/(x-x0) of the cost function with respect to the free parameters.
 @param parameters A GNU Scientific Library vector containing the free parameters to be optimized.
@@ -291,6 +380,148 @@ static void optimization_problem_combined( const gsl_vector* parameters, void* v
 void optimization_problem_combined( const Matrix_real& parameters, double* f0, Matrix_real& grad );
 
 
+/**
+@brief Call to estimate both the cost function and its gradient components from probe_num newly sampled columns of the unitary (the estimator used by the optimizers when the trace estimation is turned on). The state of the trace estimation is left unchanged.
+@param parameters The parameters for which the cost fuction shoule be estimated
+@param probe_num The number of the distinct columns to be sampled
+@param f0 The estimated value of the cost function
+@param grad An array storing the calculated gradient components of the estimate
+*/
+void optimization_problem_combined_estimated( const Matrix_real& parameters, int probe_num, double* f0, Matrix_real& grad );
+
+
+/**
+@brief Call to calculate both the cost function and the its gradient components. (Used as a callback of the LBFGS optimizer)
+@param parameters The parameters for which the cost fuction shoule be calculated
+@param void_instance A void pointer pointing to the instance of the current class.
+@param f0 The value of the cost function at x0.
+@param grad An array storing the calculated gradient components
+*/
+static void optimization_problem_combined( const Matrix_real& parameters, void* void_instance, double* f0, Matrix_real& grad );
+
+
+/**
+@brief Call to calculate the cost function from the transformed matrix and the seed matrix of the adjoint gradient calculation. (The seed is the derivative of the cost function with respect to the elements of the transformed matrix.)
+@param matrix_new The transformed matrix.
+@param seed The calculated seed matrix (returned by reference, shaped as matrix_new)
+@return Returns with the cost function.
+*/
+double get_cost_function_with_adjoint_seed( Matrix& matrix_new, Matrix& seed );
+
+
+/**
+@brief Call to determine whether the cost function is evaluated over column tiles of the unitary. (The tiles are used when the unitary does not fit into the cache memory.)
+@return Returns with true if the column tiles are used, false otherwise.
+*/
+bool use_column_tiles();
+
+
+/**
+@brief Call to calculate the (shifted) trace of the transformed unitary and its corrections needed by the chosen cost function variant. The gates are applied on cache sized column tiles of the unitary in parallel, and only the contributions of the tiles to the traces are kept.
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+Matrix get_trace_with_correction_tiled( Matrix_real& parameters );
+
+
+/**
+@brief Call to calculate the (shifted) traces of the unitary transformed with several parameter vectors and their corrections needed by the chosen cost function variant. Each cache sized column tile of the unitary is transformed with all the parameter vectors while it is in the cache.
+@param parameters The parameter vectors of the gates stored in the rows of the matrix.
+@return Returns with the matrix containing the trace (column 0), the first correction (column 1) and the second correction (column 2) in the rows corresponding to the parameter vectors.
+*/
+Matrix get_trace_with_correction_batched( Matrix_real& parameters );
+
+
+/**
+@brief Call to calculate the cost function from the traces returned by get_trace_with_correction_tiled.
+@param traces The matrix containing the trace (index 0), the first correction (index 1) and the second correction (index 2).
+@return Returns with the cost function.
+*/
+double get_cost_function_from_traces( Matrix& traces );
+
+
+/**
+@brief Call to determine whether the trace in the cost function is estimated by column sampling.
+@return Returns with true if the trace is estimated, false if it is calculated exactly.
+*/
+bool use_trace_estimation();
+
+
+/**
+@brief Call to sample new columns for the trace estimation and to apply the unitary Umtx on them. The probe vectors are sqrt(N) times the unit vectors of distinct columns chosen uniformly at random.
+*/
+void generate_trace_probes();
+
+
+/**
+@brief Call to estimate the (shifted) trace of the transformed unitary and its corrections needed by the chosen cost function variant from the random probe vectors.
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the estimated trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+Matrix get_trace_with_correction_estimated( Matrix_real& parameters );
+
+
+/**
+@brief Call to get the bit masks of the elements contributing to the (shifted) trace and to the corrections needed by the chosen cost function variant.
+@param masks The bit masks with zero, one or two bits set (returned by reference)
+@param mask_terms The index of the term to which the elements of the masks contribute: 0 for the trace, 1 and 2 for the first and second corrections (returned by reference)
+*/
+void get_trace_masks( std::vector<int>& masks, std::vector<int>& mask_terms );
+
+
+/**
+@brief Call to estimate the (shifted) trace and its corrections from the probe vectors transformed by the unitary and the gates.
+@param transformed_probes The probe vectors transformed by the unitary and the gates.
+@param standard_error The standard error of the estimated cost function (returned by reference)
+@return Returns with the matrix containing the estimated trace (index 0), the first correction (index 1) and the second correction (index 2).
+*/
+Matrix get_trace_with_correction_of_probes( Matrix& transformed_probes, double& standard_error );
+
+
+/**
+@brief Call to estimate the cost function from the transformed probe vectors and to calculate the seed matrix of the adjoint gradient calculation.
+@param transformed_probes The probe vectors transformed by the unitary and the gates.
+@param seed The calculated seed matrix (returned by reference, shaped as transformed_probes)
+@param standard_error The standard error of the estimated cost function (returned by reference)
+@return Returns with the estimated cost function.
+*/
+double get_cost_function_with_adjoint_seed_estimated( Matrix& transformed_probes, Matrix& seed, double& standard_error );
+
+
+/**
+@brief Call to estimate the cost function and to calculate the gradient components of the estimate from the currently sampled columns. Only the sampled columns are transformed by the gates.
+@param parameters An array of the free parameters of the gates.
+@param grad An array storing the calculated gradient components
+@param standard_error The standard error of the estimated cost function (returned by reference)
+@return Returns with the estimated cost function.
+*/
+double get_cost_function_and_gradient_estimated( Matrix_real& parameters, Matrix_real& grad, double& standard_error );
+
+
+/**
+@brief Call to adjust the number of probe vectors to the accuracy needed at the current value of the cost function and to draw new probe vectors for the next gradient evaluation.
+@param cost_function The estimated cost function
+@param standard_error The standard error of the estimated cost function
+@return Returns with true if the estimate is accepted, or false if the cost function should be recalculated with the exact trace.
+*/
+bool update_trace_estimation( double cost_function, double standard_error );
+
+
+/**
+@brief Call to determine whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle. (Possible when the cost function depends only on the trace of the transformed unitary.)
+@return Returns with true if the trace is evaluated from the two halves of the gate sequence, false otherwise.
+*/
+bool use_meet_in_the_middle();
+
+
+/**
+@brief Call to calculate the trace of the transformed unitary by applying the first half of the gates on the unitary and the second half from the right on the identity in parallel, and by taking the elementwise product of the two matrices.
+@param parameters An array of the free parameters of the gates.
+@return Returns with the matrix containing the trace (index 0). (The corrections at indices 1 and 2 are set to zero.)
+*/
+Matrix get_trace_meet_in_the_middle( Matrix_real& parameters );
+
+
 /**
 // @brief The optimization problem of the final optimization
 @param parameters A GNU Scientific Library containing the parameters to be optimized.
@@ -401,6 +632,28 @@ int get_trace_offset();
 void set_trace_offset(int trace_offset_in);
 
 
+/**
+@brief Get the number of columns sampled to estimate the trace in the cost function
+*/
+int get_trace_estimation();
+
+/**
+@brief Set the number of columns sampled to estimate the trace in the cost function and its gradient (0 to calculate the trace exactly). The trace is estimated by column sampling: Tr(A) is estimated by N/k times the sum of the diagonal elements of k distinct columns chosen uniformly at random. The number of probes is increased during the optimization if needed, and the exact trace is used when the cost function gets below the optimization tolerance. The trace is estimated only with the first order optimizers.
+*/
+void set_trace_estimation(int probe_num_in);
+
+
+/**
+@brief Get whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle
+*/
+bool get_meet_in_the_middle();
+
+/**
+@brief Set true to evaluate the trace in the cost function by meeting the two halves of the gate sequence in the middle. The two halves of the gates are applied in parallel, which reduces the latency of a single cost function evaluation when one sweep through the gates cannot use all the cores. (Has effect with the cost functions depending only on the trace of the transformed unitary.)
+*/
+void set_meet_in_the_middle(bool meet_in_the_middle_in);
+
+
 /**
 @brief Get the number of processed iterations during the optimization process
 */
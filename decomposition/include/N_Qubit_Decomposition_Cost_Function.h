@@ -90,6 +90,18 @@ Matrix get_trace_with_correction(Matrix& matrix, int qbit_num);
 */
 Matrix get_trace_with_correction2(Matrix& matrix, int qbit_num);
 
+
+/**
+@brief Call to calculate the contribution of a column tile of the transformed matrix to the (shifted) trace and to its corrections. Summing up the contributions of all the tiles gives the trace and the corrections of the whole matrix.
+@param matrix A tile of consecutive columns of the transformed matrix (containing all the rows).
+@param col_offset The index of the first column of the tile in the whole matrix.
+@param qbit_num The number of qubits
+@param trace_offset The offset in the first columns from which the "trace" is calculated. In this case Tr(A) = sum_(i-offset=j) A_{ij}
+@param correction_num The number of corrections to be calculated (0, 1 or 2)
+@return Returns with the matrix containing the partial trace (index 0), the partial first correction (index 1) and the partial second correction (index 2).
+*/
+Matrix get_trace_with_correction_of_columns(Matrix& matrix, int col_offset, int qbit_num, int trace_offset, int correction_num);
+
 /**
 @brief Function operator class to calculate the partial cost function of the final optimization process.
 */
@@ -73,6 +73,16 @@ protected:
     std::vector<matrix_base<int>> topology;
     /// Boolean variable to determine whether randomized adaptive layers are used or not
     bool randomized_adaptive_layers;
+    /// The number of optimizations started in parallel from different initial parameters when determining the initial gate structure
+    int multi_start_num;
+    /// Boolean variable to determine whether the remaining layer removal candidates of the gate structure compression are cancelled once one of them converges
+    bool speculative_compression;
+    /// Boolean variable to determine whether the layers next to a removed layer are re-optimized in the environment of the fixed layers before the whole circuit is re-optimized in the gate structure compression
+    bool window_compression;
+    /// Boolean variable to determine whether the circuit depths are warm started from the optimized parameters of the previous depth in the search for the initial gate structure
+    bool warm_start_levels;
+    /// The number of consecutive circuit depths optimized concurrently in the search for the initial gate structure
+    int concurrent_level_num;
     
     
 
@@ -127,6 +137,19 @@ virtual void start_decomposition(bool prepare_export=true);
 Gates_block* optimize_imported_gate_structure(Matrix_real& optimized_parameters_mtx_loc);
 
 
+/**
+@brief Call to optimize a gate structure in the search for the initial gate structure. The optimization is started from multi_start_num different initial parameters in parallel, and the remaining optimizations are cancelled once one of them reaches the optimization tolerance.
+@param gate_structure_loc The gate structure to be optimized
+@param warm_start_parameters The initial parameters of the first start (continued from a previous circuit depth), or an empty array to start from the initial value strategy
+@param solution_found Flag set when an optimization reaches the optimization tolerance (or when a shallower circuit is solved concurrently). The optimizations are cancelled once the flag is set.
+@param optimized_parameters_mtx_loc The optimized parameters of the chosen start
+@param initial_guess_loc The initial value strategy of the chosen start
+@param iteration_num The number of iterations spent on the optimizations
+@param verbose_output Set true to print the output messages of the first start
+@return Returns with the minimum of the cost function obtained by the chosen start
+*/
+double optimize_initial_gate_structure( Gates_block* gate_structure_loc, Matrix_real& warm_start_parameters, std::atomic<bool>* solution_found, Matrix_real& optimized_parameters_mtx_loc, guess_type& initial_guess_loc, int& iteration_num, bool verbose_output );
+
 /**
 @brief ??????????????
 */
@@ -142,7 +165,20 @@ Gates_block* compress_gate_structure( Gates_block* gate_structure );
 /**
 @brief ???????????????
 */
-Gates_block* compress_gate_structure( Gates_block* gate_structure, int layer_idx, Matrix_real& optimized_parameters, double& currnt_minimum_loc, int& iteration_num );
+Gates_block* compress_gate_structure( Gates_block* gate_structure, int layer_idx, Matrix_real& optimized_parameters, double& currnt_minimum_loc, int& iteration_num, Matrix& Umtx_loc, std::atomic<bool>* cancellation_flag_loc=NULL );
+
+/**
+@brief Call to re-optimize a window of consecutive layers of a gate structure while the other layers are kept fixed. The fixed layers are merged into the unitary, so only the layers of the window are applied in the cost function and gradient evaluations.
+@param gate_structure The gate structure
+@param parameters The parameters of the gate structure. The parameters of the window are replaced by the optimized ones. (returned by reference)
+@param window_start The index of the first layer in the window
+@param window_end The index after the last layer in the window
+@param Umtx_loc The unitary to be decomposed
+@param iteration_num The number of iterations spent on the optimization (returned by reference)
+@param cancellation_flag_loc Pointer to a flag cancelling the optimization once set (or NULL)
+@return Returns with the cost function of the whole gate structure with the optimized parameters, or with DBL_MAX if the window can not be optimized separately for the current cost function variant.
+*/
+double optimize_layer_window( Gates_block* gate_structure, Matrix_real& parameters, int window_start, int window_end, Matrix& Umtx_loc, int& iteration_num, std::atomic<bool>* cancellation_flag_loc=NULL );
 
 /**
 @brief ???????????????
@@ -158,7 +194,7 @@ virtual unsigned int get_panelty( Gates_block* gate_structure, Matrix_real& opti
 /**
 @brief ???????????????
 */
-virtual Gates_block* remove_trivial_gates( Gates_block* gate_structure, Matrix_real& optimized_parameters, double& currnt_minimum_loc );
+virtual Gates_block* remove_trivial_gates( Gates_block* gate_structure, Matrix_real& optimized_parameters, double& currnt_minimum_loc, Matrix& Umtx_loc, int& iteration_num, std::atomic<bool>* cancellation_flag_loc=NULL );
 
 /**
 @brief ???????????????
@@ -240,6 +276,66 @@ void apply_imported_gate_structure();
 */
 void add_layer_to_imported_gate_structure();
 
+/**
+@brief Call to set the number of optimizations started in parallel from different initial parameters when determining the initial gate structure. The remaining optimizations are cancelled once one of them reaches the optimization tolerance.
+@param multi_start_num_in The number of starting points (values smaller than 2 run a single optimization)
+*/
+void set_multi_start_num( int multi_start_num_in );
+
+/**
+@brief Call to get the number of optimizations started in parallel when determining the initial gate structure.
+@return Returns with the number of starting points
+*/
+int get_multi_start_num();
+
+/**
+@brief Call to set whether the gate structure compression is speculative. In speculative compression the layer removal candidates still being optimized are cancelled once a candidate converges with a penalty no other candidate can go below (i.e. removing two layers in one step), so the number of the remaining layers is the same as when all the candidates are evaluated.
+@param speculative_compression_in Set true to cancel the remaining candidates after a converged candidate reaching the lowest possible penalty
+*/
+void set_speculative_compression( bool speculative_compression_in );
+
+/**
+@brief Call to get whether the gate structure compression is speculative.
+@return Returns with true if the remaining layer removal candidates are cancelled after the first converged one
+*/
+bool get_speculative_compression();
+
+/**
+@brief Call to set whether the gate structure compression re-optimizes the layers next to a removed layer in the environment of the fixed layers before re-optimizing the whole circuit. The whole circuit is re-optimized only if the re-optimization of the window does not reach the optimization tolerance.
+@param window_compression_in Set true to re-optimize the layers next to a removed layer first
+*/
+void set_window_compression( bool window_compression_in );
+
+/**
+@brief Call to get whether the gate structure compression re-optimizes the layers next to a removed layer first.
+@return Returns with true if the layers next to a removed layer are re-optimized first
+*/
+bool get_window_compression();
+
+/**
+@brief Call to set whether the circuit depths are warm started in the search for the initial gate structure. In the warm started search the gate structure of the next depth is obtained by adding a new decomposing layer to the previous one, and the optimization is continued from the optimized parameters of the previous depth with close to identity parameters of the new layer.
+@param warm_start_levels_in Set true to warm start the circuit depths
+*/
+void set_warm_start_levels( bool warm_start_levels_in );
+
+/**
+@brief Call to get whether the circuit depths are warm started in the search for the initial gate structure.
+@return Returns with true if the circuit depths are warm started
+*/
+bool get_warm_start_levels();
+
+/**
+@brief Call to set the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure. The remaining optimizations are cancelled once one of the depths reaches the optimization tolerance.
+@param concurrent_level_num_in The number of concurrently optimized circuit depths (values smaller than 2 optimize the depths one after the other)
+*/
+void set_concurrent_level_num( int concurrent_level_num_in );
+
+/**
+@brief Call to get the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure.
+@return Returns with the number of concurrently optimized circuit depths
+*/
+int get_concurrent_level_num();
+
 
 };
 
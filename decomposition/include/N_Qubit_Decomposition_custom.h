@@ -78,6 +78,14 @@ virtual ~N_Qubit_Decomposition_custom();
 virtual void start_decomposition(bool prepare_export=true);
 
 
+/**
+@brief Call to decompose a batch of unitaries sharing the same custom gate structure. The problems are packed into the lanes of structure of arrays batches (see Gates_block::get_trace_derivatives_batched), so the cost functions and the gradients of the problems in a batch are evaluated in lockstep, while the batches are processed in parallel. Each problem is optimized by its own first order optimizer (see first_order_iteration), and a problem is retired from its batch as soon as it converges or runs out of iterations, giving its lane to the next unsolved problem. Only the FROBENIUS_NORM and HILBERT_SCHMIDT_TEST cost functions evaluated on the whole unitary are supported.
+@param decompositions The decompositions of the unitaries. The gate structure, the optimizer and the parameters of the optimization are set individually for each of them.
+@param prepare_export Logical parameter. Set true to prepare the list of gates to be exported, or false otherwise.
+*/
+static void start_decomposition_batched( std::vector<N_Qubit_Decomposition_custom*>& decompositions, bool prepare_export=true );
+
+
 
 /**
 @brief Call to add further layer to the gate structure used in the subdecomposition.
@@ -126,6 +126,23 @@ Phi_transformed[0] = Phi - M_PI;
 
 
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+Adaptive::calc_kernel( Matrix_real& parameters ) {
+
+    Matrix_real Phi_transformed(1,1);
+    Phi_transformed[0] = activation_function( parameters[0], limit );
+
+    return CRY::calc_kernel( Phi_transformed );
+
+}
+
+
+
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
@@ -162,6 +179,32 @@ Phi_transformed[0] = Phi - M_PI;
 
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by Adaptive^dagger*input
+@param parameters An array of parameters to calculate the matrix of the gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+Adaptive::apply_inverse_to( Matrix_real& parameters, Matrix& input ) {
+
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in Adaptive apply_inverse_to" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+    // get the kernel of the gate (including the activation function)
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
+
+    apply_kernel_inverse_to( u3_1qbit, input );
+
+
+}
+
+
+
 /**
 @brief Call to apply the gate on the input array/matrix by U3*input
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
@@ -201,6 +244,23 @@ Phi_transformed[0] = Phi - M_PI;
 
 }
 
+
+
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+std::vector<QGD_Kernel2x2>
+Adaptive::calc_derivate_kernels( Matrix_real& parameters ) {
+
+    Matrix_real Phi_transformed(1,1);
+    Phi_transformed[0] = activation_function( parameters[0], limit );
+
+    return CRY::calc_derivate_kernels( Phi_transformed );
+
+}
+
 /**
 @brief Call to create a clone of the present class
 @return Return with a pointer pointing to the cloned object
@@ -122,13 +122,30 @@ void
 CH::apply_to( Matrix& input ) {
 
     // the Hadamard gate of one qubit
-    Matrix h_1qbit(2,2);
-    h_1qbit[0].real = 1.0/sqrt(2); h_1qbit[0].imag = 0.0; 
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 h_1qbit = calc_kernel( parameters_mtx );
+
+    apply_kernel_to(h_1qbit, input);
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+CH::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 h_1qbit;
+    h_1qbit[0].real = 1.0/sqrt(2); h_1qbit[0].imag = 0.0;
     h_1qbit[1].real = 1.0/sqrt(2); h_1qbit[1].imag = 0.0;
     h_1qbit[2].real = 1.0/sqrt(2); h_1qbit[2].imag = 0.0;
     h_1qbit[3].real = -1.0/sqrt(2); h_1qbit[3].imag = 0.0;
 
-    apply_kernel_to(h_1qbit, input);
+    return h_1qbit;
 
 }
 
@@ -142,7 +159,7 @@ void
 CH::apply_from_right( Matrix& input ) {
 
     // the Hadamard gate of one qubit
-    Matrix h_1qbit(2,2);
+    QGD_Kernel2x2 h_1qbit;
     h_1qbit[0].real = 1.0/sqrt(2); h_1qbit[0].imag = 0.0; 
     h_1qbit[1].real = 1.0/sqrt(2); h_1qbit[1].imag = 0.0;
     h_1qbit[2].real = 1.0/sqrt(2); h_1qbit[2].imag = 0.0;
@@ -121,15 +121,32 @@ void
 CNOT::apply_to( Matrix& input ) {
  
     // the not gate of one qubit
-    Matrix not_1qbit(2,2);
-    not_1qbit[0].real = 0.0; not_1qbit[0].imag = 0.0; 
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 not_1qbit = calc_kernel( parameters_mtx );
+
+
+    apply_antidiagonal_kernel_to(not_1qbit, input);
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+CNOT::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 not_1qbit;
+    not_1qbit[0].real = 0.0; not_1qbit[0].imag = 0.0;
     not_1qbit[1].real = 1.0; not_1qbit[1].imag = 0.0;
     not_1qbit[2].real = 1.0; not_1qbit[2].imag = 0.0;
     not_1qbit[3].real = 0.0; not_1qbit[3].imag = 0.0;
 
-
-    apply_kernel_to(not_1qbit, input);
-
+    return not_1qbit;
 
 }
 
@@ -144,13 +161,13 @@ CNOT::apply_from_right( Matrix& input ) {
 
    
     // the not gate of one qubit
-    Matrix not_1qbit(2,2);
+    QGD_Kernel2x2 not_1qbit;
     not_1qbit[0].real = 0.0; not_1qbit[0].imag = 0.0; 
     not_1qbit[1].real = 1.0; not_1qbit[1].imag = 0.0;
     not_1qbit[2].real = 1.0; not_1qbit[2].imag = 0.0;
     not_1qbit[3].real = 0.0; not_1qbit[3].imag = 0.0;
 
-    apply_kernel_from_right(not_1qbit, input);
+    apply_antidiagonal_kernel_from_right(not_1qbit, input);
 
 
 
@@ -25,9 +25,11 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include "Gate.h"
 #include "common.h"
 
-#ifdef USE_AVX 
-#include "apply_kernel_to_input_AVX.h"
-#endif
+#include "apply_kernel_to_input.h"
+#include "apply_kernel_from_right.h"
+#include "apply_sparse_kernel_to_input.h"
+#include "kernel_indexing.h"
+#include <tbb/combinable.h>
 
 
 /**
@@ -105,16 +107,48 @@ Gate::get_matrix() {
 }
 
 /**
-@brief Call to apply the gate on the input array/matrix by U3*input
-@param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@brief Call to apply the gate on a list of input arrays/matrices by Gate*input. The inputs are placed side by side into a single matrix, so the gate is applied by one matrix product for all of them.
+@param input The list of the input arrays on which the gate is applied
 */
 void 
 Gate::apply_to_list( std::vector<Matrix>& input ) {
 
+    if ( input.size() == 0 ) {
+        return;
+    }
+
+    // the number of the columns of the merged inputs
+    int col_num = 0;
+    for ( std::vector<Matrix>::iterator it=input.begin(); it != input.end(); it++ ) {
+
+        if (it->rows != matrix_size ) {
+            std::stringstream sstream;
+	    sstream << "Wrong matrix size in Gate apply_to_list" << std::endl;
+            print(sstream, 0);	        
+            exit(-1);
+        }
+
+        col_num = col_num + it->cols;
+    }
+
+    Matrix input_merged( matrix_size, col_num );
 
+    int col_offset = 0;
     for ( std::vector<Matrix>::iterator it=input.begin(); it != input.end(); it++ ) {
-        apply_to( *it );
+        for (int row_idx=0; row_idx<matrix_size; row_idx++) {
+            memcpy( input_merged.get_data() + row_idx*input_merged.stride + col_offset, it->get_data() + row_idx*it->stride, it->cols*sizeof(QGD_Complex16) );
+        }
+        col_offset = col_offset + it->cols;
+    }
+
+    Matrix ret = dot(matrix_alloc, input_merged);
+
+    col_offset = 0;
+    for ( std::vector<Matrix>::iterator it=input.begin(); it != input.end(); it++ ) {
+        for (int row_idx=0; row_idx<matrix_size; row_idx++) {
+            memcpy( it->get_data() + row_idx*it->stride, ret.get_data() + row_idx*ret.stride + col_offset, it->cols*sizeof(QGD_Complex16) );
+        }
+        col_offset = col_offset + it->cols;
     }
 
 }
@@ -146,6 +180,24 @@ Gate::apply_from_right( Matrix& input ) {
 }
 
 
+/**
+@brief Call to apply the inverse (i.e. the adjoint) of the gate on the input array/matrix by Gate^dagger*input
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+Gate::apply_inverse_to( Matrix& input ) {
+
+    // the adjoint of the stored matrix (the conjugation and the transposition is done in the CBLAS call)
+    Matrix matrix_adj = matrix_alloc;
+    matrix_adj.conjugate();
+    matrix_adj.transpose();
+
+    Matrix ret = dot(matrix_adj, input);
+    memcpy( input.get_data(), ret.get_data(), ret.size()*sizeof(QGD_Complex16) );
+
+}
+
+
 /**
 @brief Call to set the stored matrix in the operation.
 @param input The operation matrix to be stored. The matrix is stored by attribute matrix_alloc.
@@ -249,168 +301,264 @@ Gate* Gate::clone() {
 
 
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit. (Implemented by the gates acting on a single target qubit, optionally controlled by another qubit.)
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+Gate::calc_kernel( Matrix_real& parameters ) {
+
+    std::stringstream sstream;
+    sstream << "Gate::calc_kernel: the kernel of the gate is not available" << std::endl;
+    print(sstream, 0);	
+    exit(-1);
+
+    QGD_Kernel2x2 ret;
+    return ret;
+
+}
+
+
+
 /**
 @brief ???????????
 */
 void 
-Gate::apply_kernel_to(Matrix& u3_1qbit, Matrix& input, bool deriv) {
+Gate::apply_kernel_to(QGD_Kernel2x2& u3_1qbit, Matrix& input, bool deriv) {
 
+    apply_kernel_to( u3_1qbit, input, target_qbit, control_qbit, deriv );
 
-#ifdef USE_AVX
+}
 
-    if ( qbit_num < 4 ) {
-        apply_kernel_to_input_AVX_small(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
-    }
-    else {
-        apply_kernel_to_input_AVX(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
-     }
-    return;
 
-#else
-   
-    int index_step_target = 1 << target_qbit;
-    int current_idx = 0;
-    int current_idx_pair = current_idx+index_step_target;
+/**
+@brief Call to apply a 2x2 kernel on the given target qubit of the input array/matrix. (Used to apply the kernels of fused gates)
+@param u3_1qbit The 2x2 kernel to be applied
+@param input The input array on which the kernel is applied
+@param target_qbit_loc The index of the target qubit
+@param control_qbit_loc The index of the control qubit (-1 for no control)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>, false to leave them unchanged
+*/
+void 
+Gate::apply_kernel_to(QGD_Kernel2x2& u3_1qbit, Matrix& input, int target_qbit_loc, int control_qbit_loc, bool deriv) {
 
+    // the instruction set of the kernel is chosen at runtime
+    apply_kernel_to_input(u3_1qbit, input, deriv, target_qbit_loc, control_qbit_loc, matrix_size);
 
-    while ( current_idx_pair < matrix_size ) {
+}
 
-        for(int idx=0; idx<index_step_target; idx++) {  
-        //tbb::parallel_for(0, index_step_target, 1, [&](int idx) {  
 
-            int current_idx_loc = current_idx + idx;
-            int current_idx_pair_loc = current_idx_pair + idx;
 
-            int row_offset = current_idx_loc*input.stride;
-            int row_offset_pair = current_idx_pair_loc*input.stride;
 
-           if ( control_qbit<0 || ((current_idx_loc >> control_qbit) & 1) ) {
 
-                for ( int col_idx=0; col_idx<input.cols; col_idx++) {
-   			
-                    int index      = row_offset+col_idx;
-                    int index_pair = row_offset_pair+col_idx;                
+/**
+@brief Call to apply the gate on the input array/matrix by input*CNOT
+@param input The input array on which the gate is applied
+*/
+void 
+Gate::apply_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input ) {
 
-                    QGD_Complex16 element      = input[index];
-                    QGD_Complex16 element_pair = input[index_pair];              
+    ::apply_kernel_from_right(u3_1qbit, input, target_qbit, control_qbit);
 
-                    QGD_Complex16 tmp1 = mult(u3_1qbit[0], element);
-                    QGD_Complex16 tmp2 = mult(u3_1qbit[1], element_pair);
- 
-                    input[index].real = tmp1.real + tmp2.real;
-                    input[index].imag = tmp1.imag + tmp2.imag;
+}
 
-                    tmp1 = mult(u3_1qbit[2], element);
-                    tmp2 = mult(u3_1qbit[3], element_pair);
 
-                    input[index_pair].real = tmp1.real + tmp2.real;
-                    input[index_pair].imag = tmp1.imag + tmp2.imag;
 
-                }
+/**
+@brief Call to apply the adjoint of a 2x2 kernel on the input array/matrix. (Used to apply the inverse of the gates)
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input array on which the adjoint kernel is applied
+*/
+void 
+Gate::apply_kernel_inverse_to( QGD_Kernel2x2& u3_1qbit, Matrix& input ) {
 
+    QGD_Kernel2x2 u3_1qbit_adj;
 
-            }
-            else if (deriv) {
-                // when calculating derivatives, the constant element should be zeros
-                memset( input.get_data()+row_offset, 0.0, input.cols*sizeof(QGD_Complex16));
-                memset( input.get_data()+row_offset_pair, 0.0, input.cols*sizeof(QGD_Complex16));
-            }
-            else {
-                // leave the state as it is
-                continue; 
-            }
+    u3_1qbit_adj[0].real = u3_1qbit[0].real;
+    u3_1qbit_adj[0].imag = -u3_1qbit[0].imag;
+    u3_1qbit_adj[1].real = u3_1qbit[2].real;
+    u3_1qbit_adj[1].imag = -u3_1qbit[2].imag;
+    u3_1qbit_adj[2].real = u3_1qbit[1].real;
+    u3_1qbit_adj[2].imag = -u3_1qbit[1].imag;
+    u3_1qbit_adj[3].real = u3_1qbit[3].real;
+    u3_1qbit_adj[3].imag = -u3_1qbit[3].imag;
 
+    apply_kernel_to( u3_1qbit_adj, input );
+
+}
 
-        
-        //});
-        }
 
 
-        current_idx = current_idx + (index_step_target << 1);
-        current_idx_pair = current_idx_pair + (index_step_target << 1);
+/**
+@brief Call to apply a diagonal 2x2 kernel on the input array/matrix by rescaling the rows. (Used to apply the Z, CZ and RZ gates without the full complex 2x2 multiplication)
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>, false to leave them unchanged
+*/
+void 
+Gate::apply_diagonal_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input, bool deriv ) {
 
+    apply_diagonal_kernel_to_input(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
 
-    }
+}
 
 
-#endif // USE_AVX
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel on the input array/matrix by swapping the pairs of rows. (Used to apply the X, Y and CNOT gates without the full complex 2x2 multiplication)
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+*/
+void 
+Gate::apply_antidiagonal_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input ) {
 
+    apply_antidiagonal_kernel_to_input(u3_1qbit, input, false, target_qbit, control_qbit, matrix_size);
 
 }
 
 
+/**
+@brief Call to apply a diagonal 2x2 kernel on the input array/matrix from the right by rescaling the columns.
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+*/
+void 
+Gate::apply_diagonal_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input ) {
 
+    ::apply_diagonal_kernel_from_right(u3_1qbit, input, target_qbit, control_qbit);
+
+}
 
 
 /**
-@brief Call to apply the gate on the input array/matrix by input*CNOT
-@param input The input array on which the gate is applied
+@brief Call to apply an anti-diagonal 2x2 kernel on the input array/matrix from the right by swapping the pairs of columns.
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
 */
 void 
-Gate::apply_kernel_from_right( Matrix& u3_1qbit, Matrix& input ) {
+Gate::apply_antidiagonal_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input ) {
+
+    ::apply_antidiagonal_kernel_from_right(u3_1qbit, input, target_qbit, control_qbit);
+
+}
+
+
+
+/**
+@brief Call to evaluate the real part of the overlap Tr( adjoint^dagger * K * input ) of a 2x2 kernel K applied on the input, without modifying the input and without storing the transformed matrix. (Used to contract the derivatives of the gates in the adjoint gradient)
+@param u3_1qbit The 2x2 kernel of the gate
+@param adjoint The matrix against which the transformed input is contracted
+@param input The input array/matrix on which the kernel would be applied
+@param deriv Set true to treat the rows where the control qubit is in state |0> as zero (derivative of a controlled gate), false to leave them as identity
+@return Returns with the real part of the overlap
+*/
+double
+Gate::get_kernel_overlap( QGD_Kernel2x2& u3_1qbit, Matrix& adjoint, Matrix& input, bool deriv ) {
 
-   
     int index_step_target = 1 << target_qbit;
-    int current_idx = 0;
-    int current_idx_pair = current_idx+index_step_target;
 
-//std::cout << "target qbit: " << target_qbit << std::endl;
+    // only the row pairs where the control qubit is in state |1> are transformed by the kernel
+    int pair_num = get_pair_num(matrix_size, control_qbit);
 
-    while ( current_idx_pair < input.cols ) {
+    QGD_Complex16 u00 = u3_1qbit[0];
+    QGD_Complex16 u01 = u3_1qbit[1];
+    QGD_Complex16 u10 = u3_1qbit[2];
+    QGD_Complex16 u11 = u3_1qbit[3];
 
-        for(int idx=0; idx<index_step_target; idx++) { 
-        //tbb::parallel_for(0, index_step_target, 1, [&](int idx) {  
+    bool diagonal = u01.real == 0.0 && u01.imag == 0.0 && u10.real == 0.0 && u10.imag == 0.0;
 
-            int current_idx_loc = current_idx + idx;
-            int current_idx_pair_loc = current_idx_pair + idx;
+    // partial overlaps of the parallel tasks
+    tbb::combinable<double> priv_overlaps{[](){return 0.0;}};
 
-            // determine the action according to the state of the control qubit
-            if ( control_qbit<0 || ((current_idx_loc >> control_qbit) & 1) ) {
+    kernel_parallel_for( pair_num, 2*input.cols, [&](tbb::blocked_range<int> r) {
 
-                for ( int row_idx=0; row_idx<matrix_size; row_idx++) {
+        double ret = 0.0;
 
-                    int row_offset = row_idx*input.stride;
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
 
+            int current_idx = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int current_idx_pair = current_idx | index_step_target;
 
-                    int index      = row_offset+current_idx_loc;
-                    int index_pair = row_offset+current_idx_pair_loc;
+            QGD_Complex16* input_row      = input.get_data() + current_idx*input.stride;
+            QGD_Complex16* input_row_pair = input.get_data() + current_idx_pair*input.stride;
+            QGD_Complex16* adjoint_row      = adjoint.get_data() + current_idx*adjoint.stride;
+            QGD_Complex16* adjoint_row_pair = adjoint.get_data() + current_idx_pair*adjoint.stride;
 
-                    QGD_Complex16 element      = input[index];
-                    QGD_Complex16 element_pair = input[index_pair];
+            if ( diagonal ) {
+
+                // the rows are only rescaled by a diagonal kernel (derivatives of the RZ gates)
+                for ( int col_idx=0; col_idx<input.cols; col_idx++) {
 
-                    QGD_Complex16 tmp1 = mult(u3_1qbit[0], element);
-                    QGD_Complex16 tmp2 = mult(u3_1qbit[2], element_pair);
-                    input[index].real = tmp1.real + tmp2.real;
-                    input[index].imag = tmp1.imag + tmp2.imag;
+                    QGD_Complex16& element      = input_row[col_idx];
+                    QGD_Complex16& element_pair = input_row_pair[col_idx];
 
-                    tmp1 = mult(u3_1qbit[1], element);
-                    tmp2 = mult(u3_1qbit[3], element_pair);
-                    input[index_pair].real = tmp1.real + tmp2.real;
-                    input[index_pair].imag = tmp1.imag + tmp2.imag;
+                    double res_real      = u00.real*element.real - u00.imag*element.imag;
+                    double res_imag      = u00.real*element.imag + u00.imag*element.real;
+                    double res_pair_real = u11.real*element_pair.real - u11.imag*element_pair.imag;
+                    double res_pair_imag = u11.real*element_pair.imag + u11.imag*element_pair.real;
+
+                    ret += adjoint_row[col_idx].real*res_real + adjoint_row[col_idx].imag*res_imag;
+                    ret += adjoint_row_pair[col_idx].real*res_pair_real + adjoint_row_pair[col_idx].imag*res_pair_imag;
 
                 }
 
             }
             else {
-                // leave the state as it is
-                continue;
-            }        
 
+                for ( int col_idx=0; col_idx<input.cols; col_idx++) {
+
+                    QGD_Complex16& element      = input_row[col_idx];
+                    QGD_Complex16& element_pair = input_row_pair[col_idx];
 
-//std::cout << current_idx_target << " " << current_idx_target_pair << std::endl;
+                    // rows of the kernel applied on the pair of elements (the complex products are inlined to let the compiler vectorize the loop)
+                    double res_real      = u00.real*element.real - u00.imag*element.imag + u01.real*element_pair.real - u01.imag*element_pair.imag;
+                    double res_imag      = u00.real*element.imag + u00.imag*element.real + u01.real*element_pair.imag + u01.imag*element_pair.real;
+                    double res_pair_real = u10.real*element.real - u10.imag*element.imag + u11.real*element_pair.real - u11.imag*element_pair.imag;
+                    double res_pair_imag = u10.real*element.imag + u10.imag*element.real + u11.real*element_pair.imag + u11.imag*element_pair.real;
 
+                    // Re( conj(a) * b ) = a.real*b.real + a.imag*b.imag
+                    ret += adjoint_row[col_idx].real*res_real + adjoint_row[col_idx].imag*res_imag;
+                    ret += adjoint_row_pair[col_idx].real*res_pair_real + adjoint_row_pair[col_idx].imag*res_pair_imag;
+
+                }
+
+            }
 
-        //});
         }
 
+        priv_overlaps.local() += ret;
 
-        current_idx = current_idx + (index_step_target << 1);
-        current_idx_pair = current_idx_pair + (index_step_target << 1);
+    });
 
 
-    }
+    if ( control_qbit >= 0 && !deriv ) {
 
+        // the rows where the control qubit is in state |0> are left as they are (when calculating derivatives the constant element is zero)
+        int row_num = matrix_size >> 1;
 
-}
+        kernel_parallel_for( row_num, input.cols, [&](tbb::blocked_range<int> r) {
+
+            double ret = 0.0;
 
+            for (int idx=r.begin(); idx<r.end(); idx++) {
 
+                int row_idx = insert_zero_bit(idx, control_qbit);
+
+                QGD_Complex16* input_row   = input.get_data() + row_idx*input.stride;
+                QGD_Complex16* adjoint_row = adjoint.get_data() + row_idx*adjoint.stride;
+
+                for ( int col_idx=0; col_idx<input.cols; col_idx++) {
+                    ret += adjoint_row[col_idx].real*input_row[col_idx].real + adjoint_row[col_idx].imag*input_row[col_idx].imag;
+                }
+
+            }
+
+            priv_overlaps.local() += ret;
+
+        });
+
+    }
+
+    return priv_overlaps.combine([](double a, double b) {return a+b;});
+
+}
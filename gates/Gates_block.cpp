@@ -39,9 +39,433 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include "Adaptive.h"
 #include "Composite.h"
 #include "Gates_block.h"
+#include "apply_kernel_to_input.h"
+#include "apply_kernel_from_right.h"
+#include "apply_kernel_to_batched_input.h"
+#include "apply_sparse_kernel_to_input.h"
+#include "apply_two_qubit_kernel_to_input.h"
+#include "kernel_indexing.h"
+#include "dot.h"
 
+#include <algorithm>
 
 
+/**
+@brief Call to apply a single gate on the input array/matrix
+@param operation The gate to be applied
+@param parameters_mtx An array of the parameters of the gate
+@param input The input array on which the gate is applied
+*/
+static void
+apply_gate_to( Gate* operation, Matrix_real& parameters_mtx, Matrix& input ) {
+
+    if (operation->get_type() == CNOT_OPERATION) {
+        CNOT* cnot_operation = static_cast<CNOT*>(operation);
+        cnot_operation->apply_to(input);
+    }
+    else if (operation->get_type() == CZ_OPERATION) {
+        CZ* cz_operation = static_cast<CZ*>(operation);
+        cz_operation->apply_to(input);
+    }
+    else if (operation->get_type() == CH_OPERATION) {
+        CH* ch_operation = static_cast<CH*>(operation);
+        ch_operation->apply_to(input);
+    }
+    else if (operation->get_type() == SYC_OPERATION) {
+        SYC* syc_operation = static_cast<SYC*>(operation);
+        syc_operation->apply_to(input);
+    }
+    else if (operation->get_type() == U3_OPERATION) {
+        U3* u3_operation = static_cast<U3*>(operation);
+        u3_operation->apply_to( parameters_mtx, input );    
+    }
+    else if (operation->get_type() == RX_OPERATION) {
+        RX* rx_operation = static_cast<RX*>(operation);
+        rx_operation->apply_to( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == RY_OPERATION) {
+        RY* ry_operation = static_cast<RY*>(operation);
+        ry_operation->apply_to( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == CRY_OPERATION) {
+        CRY* cry_operation = static_cast<CRY*>(operation);
+        cry_operation->apply_to( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == RZ_OPERATION) {
+        RZ* rz_operation = static_cast<RZ*>(operation);
+        rz_operation->apply_to( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == X_OPERATION) {
+        X* x_operation = static_cast<X*>(operation);
+        x_operation->apply_to( input ); 
+    }
+    else if (operation->get_type() == Y_OPERATION) {
+        Y* y_operation = static_cast<Y*>(operation);
+        y_operation->apply_to( input ); 
+    }
+    else if (operation->get_type() == Z_OPERATION) {
+        Z* z_operation = static_cast<Z*>(operation);
+        z_operation->apply_to( input ); 
+    }
+    else if (operation->get_type() == SX_OPERATION) {
+        SX* sx_operation = static_cast<SX*>(operation);
+        sx_operation->apply_to( input ); 
+    }
+    else if (operation->get_type() == GENERAL_OPERATION) {
+        operation->apply_to(input);
+    }
+    else if (operation->get_type() == UN_OPERATION) {
+        UN* un_operation = static_cast<UN*>(operation);
+        un_operation->apply_to(parameters_mtx, input);
+    }
+    else if (operation->get_type() == ON_OPERATION) {
+        ON* on_operation = static_cast<ON*>(operation);
+        on_operation->apply_to(parameters_mtx, input);
+    }
+    else if (operation->get_type() == BLOCK_OPERATION) {
+        Gates_block* block_operation = static_cast<Gates_block*>(operation);
+        block_operation->apply_to(parameters_mtx, input);
+    }
+    else if (operation->get_type() == COMPOSITE_OPERATION) {
+        Composite* com_operation = static_cast<Composite*>(operation);
+        com_operation->apply_to(parameters_mtx, input);
+    }
+    else if (operation->get_type() == ADAPTIVE_OPERATION) {
+        Adaptive* ad_operation = static_cast<Adaptive*>(operation);
+        ad_operation->apply_to( parameters_mtx, input ); 
+    }
+    else {
+        std::string err("Gates_block::apply_to: unimplemented gate"); 
+        throw err;
+    }
+
+}
+
+
+/**
+@brief Call to apply a single gate on the input array/matrix by input*Gate
+@param operation The gate to be applied
+@param parameters_mtx An array of the parameters of the gate
+@param input The input array on which the gate is applied
+*/
+static void
+apply_gate_from_right( Gate* operation, Matrix_real& parameters_mtx, Matrix& input ) {
+
+    if (operation->get_type() == CNOT_OPERATION) {
+        CNOT* cnot_operation = static_cast<CNOT*>(operation);
+        cnot_operation->apply_from_right(input);
+    }
+    else if (operation->get_type() == CZ_OPERATION) {
+        CZ* cz_operation = static_cast<CZ*>(operation);
+        cz_operation->apply_from_right(input);
+    }
+    else if (operation->get_type() == CH_OPERATION) {
+        CH* ch_operation = static_cast<CH*>(operation);
+        ch_operation->apply_from_right(input);
+    }
+    else if (operation->get_type() == SYC_OPERATION) {
+        SYC* syc_operation = static_cast<SYC*>(operation);
+        syc_operation->apply_from_right(input);
+    }
+    else if (operation->get_type() == U3_OPERATION) {
+        U3* u3_operation = static_cast<U3*>(operation);
+        u3_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == RX_OPERATION) {
+        RX* rx_operation = static_cast<RX*>(operation);
+        rx_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == RY_OPERATION) {
+        RY* ry_operation = static_cast<RY*>(operation);
+        ry_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == CRY_OPERATION) {
+        CRY* cry_operation = static_cast<CRY*>(operation);
+        cry_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == RZ_OPERATION) {
+        RZ* rz_operation = static_cast<RZ*>(operation);
+        rz_operation->apply_from_right( parameters_mtx, input );         
+    }
+    else if (operation->get_type() == X_OPERATION) {
+        X* x_operation = static_cast<X*>(operation);
+        x_operation->apply_from_right( input ); 
+    }
+    else if (operation->get_type() == Y_OPERATION) {
+        Y* y_operation = static_cast<Y*>(operation);
+        y_operation->apply_from_right( input ); 
+    }
+    else if (operation->get_type() == Z_OPERATION) {
+        Z* z_operation = static_cast<Z*>(operation);
+        z_operation->apply_from_right( input ); 
+    }
+    else if (operation->get_type() == SX_OPERATION) {
+        SX* sx_operation = static_cast<SX*>(operation);
+        sx_operation->apply_from_right( input ); 
+    }
+    else if (operation->get_type() == GENERAL_OPERATION) {
+        operation->apply_from_right(input);
+    }
+    else if (operation->get_type() == UN_OPERATION) {
+        UN* un_operation = static_cast<UN*>(operation);
+        un_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == ON_OPERATION) {
+        ON* on_operation = static_cast<ON*>(operation);
+        on_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == BLOCK_OPERATION) {
+        Gates_block* block_operation = static_cast<Gates_block*>(operation);
+        block_operation->apply_from_right(parameters_mtx, input);
+    }
+    else if (operation->get_type() == COMPOSITE_OPERATION) {
+        Composite* com_operation = static_cast<Composite*>(operation);
+        com_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else if (operation->get_type() == ADAPTIVE_OPERATION) {
+        Adaptive* ad_operation = static_cast<Adaptive*>(operation);
+        ad_operation->apply_from_right( parameters_mtx, input ); 
+    }
+    else {
+        std::string err("Gates_block::apply_from_right: unimplemented gate"); 
+        throw err;
+    }
+
+}
+
+
+/**
+@brief Call to apply the derivatives of a single gate with respect to its free parameters on the input array/matrix
+@param operation The gate to be differentiated
+@param parameters_mtx An array of the parameters of the gate
+@param input The input array on which the derivatives are applied
+@return Returns with the transformed matrices (one for each free parameter of the gate)
+*/
+static std::vector<Matrix>
+apply_gate_derivate_to( Gate* operation, Matrix_real& parameters_mtx, Matrix& input ) {
+
+    if (operation->get_type() == U3_OPERATION) {
+        U3* u3_operation = static_cast<U3*>(operation);
+        return u3_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == RX_OPERATION) {
+        RX* rx_operation = static_cast<RX*>(operation);
+        return rx_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == RY_OPERATION) {
+        RY* ry_operation = static_cast<RY*>(operation);
+        return ry_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == CRY_OPERATION) {
+        CRY* cry_operation = static_cast<CRY*>(operation);
+        return cry_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == RZ_OPERATION) {
+        RZ* rz_operation = static_cast<RZ*>(operation);
+        return rz_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == BLOCK_OPERATION) {
+        Gates_block* block_operation = static_cast<Gates_block*>(operation);
+        return block_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else if (operation->get_type() == ADAPTIVE_OPERATION) {
+        Adaptive* ad_operation = static_cast<Adaptive*>(operation);
+        return ad_operation->apply_derivate_to( parameters_mtx, input );
+    }
+    else {
+        std::string err("Gates_block::apply_derivate_to: unimplemented gate"); 
+        throw err;
+    }
+
+}
+
+
+/**
+@brief Call to determine the kind of the kernel by which a gate is applied in a compiled tape. (Gates given by a 2x2 kernel acting on the target qubit, optionally controlled by another qubit, can also be merged with their neighbours into fused one- or two-qubit kernels.)
+@param operation The gate
+@return Returns with the kind of the kernel, or TAPE_GATE if the gate is applied by its own methods.
+*/
+static tape_kernel_type
+get_tape_kernel_type( Gate* operation ) {
+
+    gate_type type = operation->get_type();
+
+    if ( type == CNOT_OPERATION || type == X_OPERATION || type == Y_OPERATION ) {
+        return TAPE_ANTIDIAGONAL_KERNEL;
+    }
+    else if ( type == CZ_OPERATION || type == Z_OPERATION || type == RZ_OPERATION ) {
+        return TAPE_DIAGONAL_KERNEL;
+    }
+    else if ( type == CH_OPERATION || type == U3_OPERATION || type == RX_OPERATION || type == RY_OPERATION || type == CRY_OPERATION ||
+              type == SX_OPERATION || type == ADAPTIVE_OPERATION ) {
+        return TAPE_KERNEL;
+    }
+
+    return TAPE_GATE;
+
+}
+
+
+/**
+@brief Call to point a view of the parameter array to the parameters of a compiled gate.
+@param instruction The instruction of the gate
+@param parameters The parameter array of the compiled gates
+@param parameters_loc The view to be pointed to the parameters of the gate. (The same view is reused for all the instructions, so no view is allocated per gate.)
+*/
+static inline void
+set_tape_parameters( Tape_Instruction& instruction, double* parameters, Matrix_real& parameters_loc ) {
+
+    parameters_loc.data = parameters + instruction.parameter_idx;
+    parameters_loc.cols = instruction.parameter_num;
+    parameters_loc.stride = instruction.parameter_num;
+
+}
+
+
+/**
+@brief Call to calculate the 2x2 kernel of a compiled gate for the given parameters.
+@param instruction The instruction of the gate
+@param parameters The parameter array of the compiled gates
+@param parameters_loc A view of the parameter array used to evaluate the kernel (see set_tape_parameters)
+@return Returns with the 2x2 kernel of the gate
+*/
+static inline QGD_Kernel2x2
+calc_tape_kernel( Tape_Instruction& instruction, double* parameters, Matrix_real& parameters_loc ) {
+
+    if ( instruction.parameter_num == 0 ) {
+        return instruction.kernel;
+    }
+
+    set_tape_parameters( instruction, parameters, parameters_loc );
+
+    return instruction.gate->calc_kernel( parameters_loc );
+
+}
+
+
+/**
+@brief Call to apply a 2x2 kernel of the given kind on the input array/matrix.
+@param kernel_type The kind of the kernel (TAPE_KERNEL, TAPE_DIAGONAL_KERNEL or TAPE_ANTIDIAGONAL_KERNEL)
+@param kernel The 2x2 kernel
+@param input The input array on which the kernel is applied
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+static inline void
+apply_tape_kernel_to( tape_kernel_type kernel_type, QGD_Kernel2x2& kernel, Matrix& input, int target_qbit, int control_qbit, int matrix_size ) {
+
+    if ( kernel_type == TAPE_DIAGONAL_KERNEL ) {
+        apply_diagonal_kernel_to_input( kernel, input, false, target_qbit, control_qbit, matrix_size );
+    }
+    else if ( kernel_type == TAPE_ANTIDIAGONAL_KERNEL ) {
+        apply_antidiagonal_kernel_to_input( kernel, input, false, target_qbit, control_qbit, matrix_size );
+    }
+    else {
+        apply_kernel_to_input( kernel, input, false, target_qbit, control_qbit, matrix_size );
+    }
+
+}
+
+
+/**
+@brief Call to apply a 2x2 kernel of the given kind on the input array/matrix from the right.
+@param kernel_type The kind of the kernel (TAPE_KERNEL, TAPE_DIAGONAL_KERNEL or TAPE_ANTIDIAGONAL_KERNEL)
+@param kernel The 2x2 kernel
+@param input The input array on which the kernel is applied
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+static inline void
+apply_tape_kernel_from_right( tape_kernel_type kernel_type, QGD_Kernel2x2& kernel, Matrix& input, int target_qbit, int control_qbit ) {
+
+    if ( kernel_type == TAPE_DIAGONAL_KERNEL ) {
+        apply_diagonal_kernel_from_right( kernel, input, target_qbit, control_qbit );
+    }
+    else if ( kernel_type == TAPE_ANTIDIAGONAL_KERNEL ) {
+        apply_antidiagonal_kernel_from_right( kernel, input, target_qbit, control_qbit );
+    }
+    else {
+        apply_kernel_from_right( kernel, input, target_qbit, control_qbit );
+    }
+
+}
+
+
+/**
+@brief Call to add a qubit to the list of the qubits involved in a fused kernel if it is not in the list yet.
+@param qbits The list of the involved qubits
+@param qbit_num The number of the qubits in the list (incremented if the qubit is added)
+@param qbit The index of the qubit (negative indices are ignored)
+*/
+static inline void
+add_involved_qbit( int* qbits, int& qbit_num, int qbit ) {
+
+    if ( qbit < 0 || std::find(qbits, qbits+qbit_num, qbit) != qbits+qbit_num ) {
+        return;
+    }
+
+    qbits[qbit_num] = qbit;
+    qbit_num++;
+
+}
+
+
+/**
+@brief Call to estimate the number of complex multiplications per element of the input needed to apply a gate given by a 2x2 kernel.
+@param instruction The compiled instruction of the gate
+@return Returns with the estimated cost
+*/
+static int
+get_kernel_cost( Tape_Instruction& instruction ) {
+
+    // a controlled kernel transforms only half of the rows
+    return instruction.control_qbit < 0 ? 2 : 1;
+
+}
+
+
+/**
+@brief Call to multiply a 4x4 matrix of the two-qubit space from the left by a 2x2 kernel acting on the target qubit (optionally controlled by the control qubit). The rows and columns of the matrix are labeled by the local index x_inner + 2*x_outer.
+@param kernel The 2x2 kernel
+@param target_qbit_loc The target qubit of the kernel
+@param control_qbit_loc The control qubit of the kernel (-1 for no control)
+@param inner_qbit The inner (lower) qubit of the two-qubit space
+@param mtx The 4x4 matrix to be transformed
+*/
+static void
+apply_kernel_to_4x4( QGD_Kernel2x2& kernel, int target_qbit_loc, int control_qbit_loc, int inner_qbit, QGD_Kernel4x4& mtx ) {
+
+    // bit masks of the target and control qubits in the local index
+    int target_mask = target_qbit_loc == inner_qbit ? 1 : 2;
+    int control_mask = control_qbit_loc < 0 ? 0 : ( control_qbit_loc == inner_qbit ? 1 : 2 );
+
+    for (int row_idx=0; row_idx<4; row_idx++) {
+
+        // the rows are transformed in pairs, the rows with an inactive control qubit are left as they are
+        if ( (row_idx & target_mask) != 0 || (control_mask != 0 && (row_idx & control_mask) == 0) ) {
+            continue;
+        }
+
+        QGD_Complex16* row = mtx.get_data() + 4*row_idx;
+        QGD_Complex16* row_pair = mtx.get_data() + 4*(row_idx | target_mask);
+
+        for (int col_idx=0; col_idx<4; col_idx++) {
+
+            QGD_Complex16 element = row[col_idx];
+            QGD_Complex16 element_pair = row_pair[col_idx];
+
+            row[col_idx].real = kernel[0].real*element.real - kernel[0].imag*element.imag + kernel[1].real*element_pair.real - kernel[1].imag*element_pair.imag;
+            row[col_idx].imag = kernel[0].real*element.imag + kernel[0].imag*element.real + kernel[1].real*element_pair.imag + kernel[1].imag*element_pair.real;
+            row_pair[col_idx].real = kernel[2].real*element.real - kernel[2].imag*element.imag + kernel[3].real*element_pair.real - kernel[3].imag*element_pair.imag;
+            row_pair[col_idx].imag = kernel[2].real*element.imag + kernel[2].imag*element.real + kernel[3].real*element_pair.imag + kernel[3].imag*element_pair.real;
+
+        }
+
+    }
+
+}
+
 
 //static tbb::spin_mutex my_mutex;
 /**
@@ -53,6 +477,10 @@ Gates_block::Gates_block() : Gate() {
     type = BLOCK_OPERATION;
     // number of operation layers
     layer_num = 0;
+    // the version of the stored gates (see invalidate_tape)
+    structure_version = 0;
+    // no tape was compiled yet
+    tape_version = -1;
 }
 
 
@@ -67,6 +495,45 @@ Gates_block::Gates_block(int qbit_num_in) : Gate(qbit_num_in) {
     type = BLOCK_OPERATION;
     // number of operation layers
     layer_num = 0;
+    // the version of the stored gates (see invalidate_tape)
+    structure_version = 0;
+    // no tape was compiled yet
+    tape_version = -1;
+}
+
+
+/**
+@brief Copy constructor of the class. The cached tape is not copied, it is compiled again for the copy when needed.
+@param block The gate block to be copied
+*/
+Gates_block::Gates_block(const Gates_block& block) : Gate(block) {
+
+    gates = block.gates;
+    layer_num = block.layer_num;
+    structure_version = block.structure_version;
+    // no tape was compiled yet
+    tape_version = -1;
+}
+
+
+/**
+@brief Assignment operator of the class. The cached tape is not copied, it is compiled again when needed.
+@param block The gate block to be copied
+@return Returns with the instance of the class.
+*/
+Gates_block& 
+Gates_block::operator=(const Gates_block& block) {
+
+    Gate::operator=(block);
+
+    gates = block.gates;
+    layer_num = block.layer_num;
+    structure_version = block.structure_version;
+    // the tape compiled for the previous gates is released
+    tape_cache.clear();
+    tape_version = -1;
+
+    return *this;
 }
 
 
@@ -197,87 +664,714 @@ Gates_block::release_gates() {
     layer_num = 0;
     parameter_num = 0;
 
+    invalidate_tape();
+
+}
+
+
+/**
+@brief Call to release one gate in the list
+*/
+void
+Gates_block::release_gate( int idx) {
+
+    if ( idx>= (int)gates.size() ) return;
+
+    // fist decrese the number of parameters
+    Gate* gate = gates[idx];
+    parameter_num -= gate->get_parameter_num();
+
+    gates.erase( gates.begin() + idx );
+
+    invalidate_tape();
+
+}
+
+/**
+@brief Call to retrieve the operation matrix (Which is the product of all the operation matrices stored in the operation block)
+@param parameters An array pointing to the parameters of the gates
+@return Returns with the operation matrix
+*/
+Matrix
+Gates_block::get_matrix( Matrix_real& parameters ) {
+
+    //The stringstream input to store the output messages.
+    std::stringstream sstream;
+
+    // create matrix representation of the gate operations
+    Matrix block_mtx = create_identity(matrix_size);
+    apply_to(parameters, block_mtx);
+
+#ifdef DEBUG
+    if (block_mtx.isnan()) {
+        std::stringstream sstream;
+	sstream << "Gates_block::get_matrix: block_mtx contains NaN." << std::endl;
+        print(sstream, 0);		       
+    }
+#endif
+
+    return block_mtx;
+
+
+}
+
+
+
+/**
+@brief Call to apply the gates on a list of input arrays/matrices by Gates_block*input. The gates are fused once for all the inputs (see apply_fused_gates_to_list).
+@param parameters An array of parameters to calculate the matrices of the gates.
+@param input The list of the input arrays on which the gates are applied
+*/
+void 
+Gates_block::apply_to_list( Matrix_real& parameters_mtx, std::vector<Matrix> input ) {
+
+    // the gates are fused once for all the inputs
+    std::vector<Fused_Gate>&& fused_gates = get_fused_gates( parameters_mtx );
+
+    apply_fused_gates_to_list( fused_gates, input );
+
+}
+
+
+/**
+@brief Call to apply the gate on the input array/matrix Gates_block*input. Consecutive gates acting on the same one or two qubits are fused into a single 2x2 or 4x4 kernel before they are applied on the input.
+@param parameters An array of parameters to calculate the matrix of the U3 gate.
+@param input The input array on which the gate is applied
+*/
+void 
+Gates_block::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
+
+    std::vector<Fused_Gate>&& fused_gates = get_fused_gates( parameters_mtx );
+    apply_fused_gates_to( fused_gates, input );
+
+}
+
+
+/**
+@brief Call to compile the gates into a linear tape of instructions. (The compilation depends only on the structure of the gates, so the tape can be applied with any parameter vector by apply_tape_to and apply_tape_from_right.)
+@return Returns with the instructions in the order of their application on the input (the last gate first).
+*/
+std::vector<Tape_Instruction> 
+Gates_block::compile_tape() {
+
+    std::vector<Tape_Instruction> tape;
+    tape.reserve( gates.size() );
+
+    compile_tape( gates.begin(), gates.size(), 0, tape );
+
+    return tape;
+
 }
 
 
-/**
-@brief Call to release one gate in the list
-*/
-void
-Gates_block::release_gate( int idx) {
+/**
+@brief Call to get the compiled tape of the gates. The tape is compiled by compile_tape at the first call and cached until the gates are modified (see invalidate_tape).
+@return Returns with a reference to the cached tape.
+*/
+std::vector<Tape_Instruction>& 
+Gates_block::get_tape() {
+
+    int64_t current_version = get_structure_version();
+
+    if ( tape_version.load() != current_version ) {
+
+        // the tape is compiled by a single thread when the gates are applied concurrently
+        tbb::spin_mutex::scoped_lock tape_lock{tape_mutex};
+
+        if ( tape_version.load() != current_version ) {
+            tape_cache = compile_tape();
+            tape_version.store( current_version );
+        }
+
+    }
+
+    return tape_cache;
+
+}
+
+
+/// The last structure version given to a modified gate block (see invalidate_tape)
+static std::atomic<int64_t> structure_version_counter(0);
+
+
+/**
+@brief Call to invalidate the cached tape of the gates. It should be called after any modification of the stored gates.
+*/
+void 
+Gates_block::invalidate_tape() {
+
+    // a version not used by any block before, so the modification can not be missed by the outer blocks (see get_structure_version)
+    structure_version = ++structure_version_counter;
+
+}
+
+
+/**
+@brief Call to get the structure version of the gates: the latest version of the gate block and of the nested gate blocks. (It changes whenever the block or any nested block is modified, so the cached tape of the outer block is recompiled as well.)
+@return Returns with the structure version.
+*/
+int64_t 
+Gates_block::get_structure_version() {
+
+    // any modification gives a version larger than all the previous ones, so the maximum changes whenever any of the blocks is modified
+    int64_t version = structure_version;
+
+    for( size_t idx=0; idx<gates.size(); idx++) {
+        if ( gates[idx]->get_type() == BLOCK_OPERATION ) {
+            version = std::max( version, static_cast<Gates_block*>(gates[idx])->get_structure_version() );
+        }
+    }
+
+    return version;
+
+}
+
+
+/**
+@brief Call to compile a sequence of gates into a linear tape of instructions in the order of their application on the input (the last gate first). Nested gate blocks are flattened into the tape.
+@param gates_it An iterator pointing to the first gate.
+@param num_of_gates The number of gates to be compiled
+@param parameter_idx The offset of the parameters of the first gate in the parameter array
+@param tape The tape to which the instructions are appended
+@param gate_idx The gate index recorded in the instructions (-1 to record the index of the gates in the sequence)
+*/
+void 
+Gates_block::compile_tape( std::vector<Gate*>::iterator gates_it, int num_of_gates, int parameter_idx, std::vector<Tape_Instruction>& tape, int gate_idx ) {
+
+    int parameter_idx_loc = parameter_idx;
+    for( int idx=0; idx<num_of_gates; idx++) {
+        parameter_idx_loc = parameter_idx_loc + gates_it[idx]->get_parameter_num();
+    }
+
+    // the kernels of the gates without free parameters are calculated with an empty parameter array
+    Matrix_real parameters_mtx_empty;
+
+    for( int idx=num_of_gates-1; idx>=0; idx--) {
+
+        Gate* operation = gates_it[idx];
+        parameter_idx_loc = parameter_idx_loc - operation->get_parameter_num();
+
+        int gate_idx_loc = gate_idx < 0 ? idx : gate_idx;
+
+        if ( operation->get_type() == BLOCK_OPERATION ) {
+            // the gates of the nested block are flattened into the tape
+            Gates_block* block_operation = static_cast<Gates_block*>(operation);
+            compile_tape( block_operation->gates.begin(), block_operation->gates.size(), parameter_idx_loc, tape, gate_idx_loc );
+            continue;
+        }
+
+        Tape_Instruction instruction;
+        instruction.kernel_type = get_tape_kernel_type( operation );
+        instruction.gate = operation;
+        instruction.target_qbit = operation->get_target_qbit();
+        instruction.control_qbit = operation->get_control_qbit();
+        instruction.parameter_idx = parameter_idx_loc;
+        instruction.parameter_num = operation->get_parameter_num();
+        instruction.gate_idx = gate_idx_loc;
+
+        if ( instruction.kernel_type != TAPE_GATE && instruction.parameter_num == 0 ) {
+            instruction.kernel = operation->calc_kernel( parameters_mtx_empty );
+        }
+
+        tape.push_back( instruction );
+
+    }
+
+}
+
+
+/**
+@brief Call to apply a range of instructions of a compiled tape on the input array/matrix in the order of the tape.
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be applied
+@param tape_end The index after the last instruction to be applied
+@param parameters The parameter array of the compiled gates
+@param input The input array on which the instructions are applied
+*/
+void 
+Gates_block::apply_tape_to( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, Matrix& input ) {
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in Gates_block apply" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+    // the view pointed to the parameters of the individual gates
+    Matrix_real parameters_loc( parameters, 1, 0 );
+
+    for (int idx=tape_start; idx<tape_end; idx++) {
+
+        Tape_Instruction& instruction = tape[idx];
+
+        if ( instruction.kernel_type == TAPE_GATE ) {
+            set_tape_parameters( instruction, parameters, parameters_loc );
+            apply_gate_to( instruction.gate, parameters_loc, input );
+        }
+        else {
+            QGD_Kernel2x2 kernel = calc_tape_kernel( instruction, parameters, parameters_loc );
+            apply_tape_kernel_to( instruction.kernel_type, kernel, input, instruction.target_qbit, instruction.control_qbit, matrix_size );
+        }
+
+#ifdef DEBUG
+        if (input.isnan()) {
+            std::stringstream sstream;
+	    sstream << "Gates_block::apply_tape_to: transformed matrix contains NaN." << std::endl;
+            print(sstream, 0);	
+        }
+#endif
+
+    }
+
+}
+
+
+/**
+@brief Call to apply a range of instructions of a compiled tape on a list of input arrays/matrices. The instructions are fused once for all the inputs (see apply_fused_gates_to_list).
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be applied
+@param tape_end The index after the last instruction to be applied
+@param parameters The parameter array of the compiled gates
+@param input The list of the input arrays on which the instructions are applied
+*/
+void 
+Gates_block::apply_tape_to_list( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, std::vector<Matrix>& input ) {
+
+    std::vector<Fused_Gate>&& fused_gates = get_fused_gates( tape, tape_start, tape_end, parameters );
+
+    apply_fused_gates_to_list( fused_gates, input );
+
+}
+
+
+/**
+@brief Call to apply a range of instructions of a compiled tape from the right on the input array/matrix. (The instructions are applied in reversed order of the tape.)
+@param tape The compiled tape
+@param tape_start The index of the first instruction in the range
+@param tape_end The index after the last instruction in the range
+@param parameters The parameter array of the compiled gates
+@param input The input array on which the instructions are applied
+*/
+void 
+Gates_block::apply_tape_from_right( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, Matrix& input ) {
+
+    if (input.cols != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in Gates_block apply_from_right" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+    // the view pointed to the parameters of the individual gates
+    Matrix_real parameters_loc( parameters, 1, 0 );
+
+    for (int idx=tape_end-1; idx>=tape_start; idx--) {
+
+        Tape_Instruction& instruction = tape[idx];
+
+        if ( instruction.kernel_type == TAPE_GATE ) {
+            set_tape_parameters( instruction, parameters, parameters_loc );
+            apply_gate_from_right( instruction.gate, parameters_loc, input );
+        }
+        else {
+            QGD_Kernel2x2 kernel = calc_tape_kernel( instruction, parameters, parameters_loc );
+            apply_tape_kernel_from_right( instruction.kernel_type, kernel, input, instruction.target_qbit, instruction.control_qbit );
+        }
+
+#ifdef DEBUG
+        if (input.isnan()) { 
+            std::stringstream sstream;
+	    sstream << "Gates_block::apply_tape_from_right: transformed matrix contains NaN." << std::endl;
+            print(sstream, 0);	            
+        }
+#endif
+
+    }
+
+}
+
+
+/**
+@brief Call to fuse the consecutive gates acting on the same one or two qubits into 2x2 or 4x4 kernels for the given parameters. (The fusion is done once per parameter vector, and the resulting sequence can be applied on any number of inputs by apply_fused_gates_to.)
+@param parameters_mtx An array of parameters of the gates.
+@return Returns with the list of the fused gates in the order of their application.
+*/
+std::vector<Fused_Gate> 
+Gates_block::get_fused_gates( Matrix_real& parameters_mtx ) {
+
+    std::vector<Tape_Instruction>& tape = get_tape();
+
+    return get_fused_gates( tape, 0, tape.size(), parameters_mtx.get_data() );
+
+}
+
+
+/**
+@brief Call to fuse the consecutive instructions in a range of a compiled tape into 2x2 or 4x4 kernels for the given parameters.
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be fused
+@param tape_end The index after the last instruction to be fused
+@param parameters The parameter array of the compiled gates
+@return Returns with the list of the fused gates in the order of their application.
+*/
+std::vector<Fused_Gate> 
+Gates_block::get_fused_gates( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters ) {
+
+    std::vector<Fused_Gate> ret;
+    ret.reserve( tape_end - tape_start );
+
+    // the view pointed to the parameters of the individual gates
+    Matrix_real parameters_loc( parameters, 1, 0 );
+
+    // the instructions tape[run_start], ..., tape[idx-1] are collected into the current fused kernel
+    int run_start = tape_start;
+    // the qubits on which the collected instructions act
+    int run_qbits[2] = {-1, -1};
+    int run_qbit_num = 0;
+
+    for( int idx=tape_start; idx<tape_end; idx++) {
+
+        Tape_Instruction& instruction = tape[idx];
+
+        if ( instruction.kernel_type == TAPE_GATE ) {
+
+            fuse_gates( tape, run_start, idx, run_qbits, run_qbit_num, parameters, parameters_loc, ret );
+            run_start = idx+1;
+            run_qbit_num = 0;
+
+            Fused_Gate fused_gate;
+            fused_gate.kernel_type = TAPE_GATE;
+            fused_gate.gate = instruction.gate;
+            fused_gate.parameters = parameters + instruction.parameter_idx;
+            fused_gate.parameter_num = instruction.parameter_num;
+            fused_gate.inner_qbit = -1;
+            fused_gate.outer_qbit = -1;
+            fused_gate.control_qbit = -1;
+            ret.push_back( fused_gate );
+            continue;
+
+        }
+
+        int involved_qbits[4] = {run_qbits[0], run_qbits[1], -1, -1};
+        int involved_qbit_num = run_qbit_num;
+        add_involved_qbit( involved_qbits, involved_qbit_num, instruction.target_qbit );
+        add_involved_qbit( involved_qbits, involved_qbit_num, instruction.control_qbit );
+
+        if ( involved_qbit_num > 2 ) {
+            // the gate does not fit into the current fused kernel
+            fuse_gates( tape, run_start, idx, run_qbits, run_qbit_num, parameters, parameters_loc, ret );
+            run_start = idx;
+
+            involved_qbit_num = 0;
+            add_involved_qbit( involved_qbits, involved_qbit_num, instruction.target_qbit );
+            add_involved_qbit( involved_qbits, involved_qbit_num, instruction.control_qbit );
+        }
+
+        run_qbits[0] = involved_qbits[0];
+        run_qbits[1] = involved_qbits[1];
+        run_qbit_num = involved_qbit_num;
+
+    }
+
+    fuse_gates( tape, run_start, tape_end, run_qbits, run_qbit_num, parameters, parameters_loc, ret );
+
+    return ret;
+
+}
+
+
+/**
+@brief Call to fuse a run of compiled instructions acting on at most two qubits into a single 2x2 (one qubit) or 4x4 (two qubits) kernel. If the fused kernel would be more expensive to apply than the individual gates, the kernels of the gates are added without fusion.
+@param tape The compiled tape
+@param run_start The index of the first instruction of the run
+@param run_end The index after the last instruction of the run
+@param run_qbits The qubits on which the instructions of the run act
+@param run_qbit_num The number of the qubits in run_qbits
+@param parameters The parameter array of the compiled gates
+@param parameters_loc A view of the parameter array used to evaluate the kernels of the gates
+@param fused_gates The list of the fused gates to which the result is appended
+*/
+void 
+Gates_block::fuse_gates( std::vector<Tape_Instruction>& tape, int run_start, int run_end, int* run_qbits, int run_qbit_num, double* parameters, Matrix_real& parameters_loc, std::vector<Fused_Gate>& fused_gates ) {
+
+    if ( run_end <= run_start ) {
+        return;
+    }
+
+    int cost = 0;
+    for (int idx=run_start; idx<run_end; idx++) {
+        cost = cost + get_kernel_cost( tape[idx] );
+    }
+
+    // a 4x4 kernel costs 4 complex multiplications per element, a 2x2 kernel costs 2
+    int fused_cost = run_qbit_num > 1 ? 4 : 2;
+
+    if ( run_end - run_start < 2 || cost < fused_cost ) {
+
+        for (int idx=run_start; idx<run_end; idx++) {
+            Tape_Instruction& instruction = tape[idx];
+
+            Fused_Gate fused_gate;
+            fused_gate.kernel_type = instruction.kernel_type;
+            fused_gate.gate = NULL;
+            fused_gate.parameters = NULL;
+            fused_gate.parameter_num = 0;
+            fused_gate.kernel_1qbit = calc_tape_kernel( instruction, parameters, parameters_loc );
+            fused_gate.inner_qbit = instruction.target_qbit;
+            fused_gate.outer_qbit = -1;
+            fused_gate.control_qbit = instruction.control_qbit;
+            fused_gates.push_back( fused_gate );
+        }
+
+        return;
+    }
+
+
+    Fused_Gate fused_gate;
+    fused_gate.gate = NULL;
+    fused_gate.parameters = NULL;
+    fused_gate.parameter_num = 0;
+    fused_gate.inner_qbit = run_qbits[0];
+    fused_gate.outer_qbit = run_qbit_num > 1 ? run_qbits[1] : -1;
+    fused_gate.control_qbit = -1;
+    if ( fused_gate.outer_qbit >= 0 && fused_gate.outer_qbit < fused_gate.inner_qbit ) {
+        std::swap( fused_gate.inner_qbit, fused_gate.outer_qbit );
+    }
+    fused_gate.kernel_type = fused_gate.outer_qbit >= 0 ? TAPE_TWO_QUBIT_KERNEL : TAPE_KERNEL;
+
+    if ( fused_gate.outer_qbit >= 0 ) {
+        // the fused kernel starts from the identity
+        for (int idx=0; idx<16; idx++) {
+            fused_gate.kernel[idx].real = idx % 5 == 0 ? 1.0 : 0.0;
+            fused_gate.kernel[idx].imag = 0.0;
+        }
+    }
+
+    for (int idx=run_start; idx<run_end; idx++) {
+
+        Tape_Instruction& instruction = tape[idx];
+        QGD_Kernel2x2 kernel = calc_tape_kernel( instruction, parameters, parameters_loc );
+
+        // the later gates act from the left
+        if ( fused_gate.outer_qbit >= 0 ) {
+            apply_kernel_to_4x4( kernel, instruction.target_qbit, instruction.control_qbit, fused_gate.inner_qbit, fused_gate.kernel );
+        }
+        else {
+            fused_gate.kernel_1qbit = idx == run_start ? kernel : dot( kernel, fused_gate.kernel_1qbit );
+        }
+
+    }
+
+    fused_gates.push_back( fused_gate );
+
+}
+
+
+/**
+@brief Call to apply a sequence of fused gates (obtained by get_fused_gates) on the input array/matrix.
+@param fused_gates The list of the fused gates in the order of their application
+@param input The input array on which the gates are applied
+*/
+void 
+Gates_block::apply_fused_gates_to( std::vector<Fused_Gate>& fused_gates, Matrix& input ) {
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in Gates_block apply" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+    // the view pointed to the parameters of the individual gates (the same view is reused for all the gates)
+    Matrix_real parameters_loc( (double*)NULL, 1, 0 );
+
+    for (size_t idx=0; idx<fused_gates.size(); idx++) {
+
+        Fused_Gate& fused_gate = fused_gates[idx];
+
+        if ( fused_gate.kernel_type == TAPE_GATE ) {
+            parameters_loc.data = fused_gate.parameters;
+            parameters_loc.cols = fused_gate.parameter_num;
+            parameters_loc.stride = fused_gate.parameter_num;
+            apply_gate_to( fused_gate.gate, parameters_loc, input );
+        }
+        else if ( fused_gate.kernel_type == TAPE_TWO_QUBIT_KERNEL ) {
+            apply_two_qubit_kernel_to_input( fused_gate.kernel, input, fused_gate.inner_qbit, fused_gate.outer_qbit, matrix_size );
+        }
+        else {
+            apply_tape_kernel_to( fused_gate.kernel_type, fused_gate.kernel_1qbit, input, fused_gate.inner_qbit, fused_gate.control_qbit, matrix_size );
+        }
+
+#ifdef DEBUG
+        if (input.isnan()) {
+            std::stringstream sstream;
+	    sstream << "Gates_block::apply_to: transformed matrix contains NaN." << std::endl;
+            print(sstream, 0);	
+        }
+#endif
+
+    }
+
+}
+
+
+/**
+@brief Call to apply a sequence of fused gates (obtained by get_fused_gates) on a list of input arrays/matrices. The kernels are calculated once for all the inputs. The inputs are transformed in parallel when the individual kernels are too small to be parallelized over the rows, otherwise one after the other by the parallel kernels.
+@param fused_gates The list of the fused gates in the order of their application
+@param input The list of the input arrays on which the gates are applied
+*/
+void 
+Gates_block::apply_fused_gates_to_list( std::vector<Fused_Gate>& fused_gates, std::vector<Matrix>& input ) {
+
+    int input_num = input.size();
+    if ( input_num == 0 ) {
+        return;
+    }
+
+    // the kernels split the rows of a large input among the threads
+    if ( get_kernel_grain_size( matrix_size/2, 2*input[0].cols ) < matrix_size/2 ) {
+        for (int idx=0; idx<input_num; idx++) {
+            apply_fused_gates_to( fused_gates, input[idx] );
+        }
+        return;
+    }
+
+    tbb::parallel_for( 0, input_num, 1, [&](int idx) {
+        apply_fused_gates_to( fused_gates, input[idx] );
+    });
+
+}
+
+
+/**
+@brief Call to apply the gate on the input array/matrix by input*Gate_block
+@param input The input array on which the gate is applied
+*/
+void 
+Gates_block::apply_from_right( Matrix_real& parameters_mtx, Matrix& input ) {
+
+    std::vector<Tape_Instruction>& tape = get_tape();
+    apply_tape_from_right( tape, 0, tape.size(), parameters_mtx.get_data(), input );
+
+}
+
+
+
+/**
+@brief ???????????????
+*/
+std::vector<Matrix> 
+Gates_block::apply_derivate_to( Matrix_real& parameters_mtx_in, Matrix& input ) {
+
+    //The stringstream input to store the output messages.
+    std::stringstream sstream;
+  
+    std::vector<Matrix> grad(parameter_num, Matrix(0,0));
+
+    if ( parameter_num == 0 ) {
+        return grad;
+    }
+
+    for( int idx=0; idx<(int)gates.size(); idx++) {
+
+        Gate* operation = gates[idx];
+
+        if (operation->get_type() == SYC_OPERATION) {
+            sstream << "Sycamore operation not supported in gardient calculation" << std::endl;			
+            print(sstream, 0);	                    
+            exit(-1);
+        }
+        else if (operation->get_type() == UN_OPERATION) {
+            sstream << "UN operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
+        }
+        else if (operation->get_type() == ON_OPERATION) {
+            sstream << "ON operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
+        }
+        else if (operation->get_type() == COMPOSITE_OPERATION) {
+            sstream << "Composite  operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
+        }
+
+    }
+
+    // the gates are compiled once for all the gradient components
+    std::vector<Tape_Instruction>& tape = get_tape();
 
-    if ( idx>= (int)gates.size() ) return;
+    // the instructions of the gates gates[idx], gates[idx+1], ... are stored in tape[0], ..., tape[tape_offsets[idx]-1]
+    std::vector<int> tape_offsets( gates.size()+1, 0 );
+    for( int idx=gates.size()-1; idx>=0; idx--) {
+        int tape_offset = tape_offsets[idx+1];
+        while ( tape_offset < (int)tape.size() && tape[tape_offset].gate_idx == idx ) {
+            tape_offset++;
+        }
+        tape_offsets[idx] = tape_offset;
+    }
 
-    // fist decrese the number of parameters
-    Gate* gate = gates[idx];
-    parameter_num -= gate->get_parameter_num();
+    double* parameters = parameters_mtx_in.get_data();
 
-    gates.erase( gates.begin() + idx );
+    // deriv_idx ... the index of the gate block for which the gradient is to be calculated
+    tbb::parallel_for( tbb::blocked_range<int>(0,gates.size()), [&](tbb::blocked_range<int> r) {
+        for (int deriv_idx=r.begin(); deriv_idx<r.end(); ++deriv_idx) { 
 
-}
 
-/**
-@brief Call to retrieve the operation matrix (Which is the product of all the operation matrices stored in the operation block)
-@param parameters An array pointing to the parameters of the gates
-@return Returns with the operation matrix
-*/
-Matrix
-Gates_block::get_matrix( Matrix_real& parameters ) {
+            Gate* gate_deriv = gates[deriv_idx];
 
-    //The stringstream input to store the output messages.
-    std::stringstream sstream;
+            // for constant gate no gardient component is calculated
+            if ( gate_deriv->get_parameter_num() == 0 ) {
+                continue;
+            }
 
-    // create matrix representation of the gate operations
-    Matrix block_mtx = create_identity(matrix_size);
-    apply_to(parameters, block_mtx);
+            int deriv_parameter_idx = 0;
+            for ( int idx=0; idx<deriv_idx; idx++ ) {
+                deriv_parameter_idx += gates[idx]->get_parameter_num();
+            }
 
-#ifdef DEBUG
-    if (block_mtx.isnan()) {
-        std::stringstream sstream;
-	sstream << "Gates_block::get_matrix: block_mtx contains NaN." << std::endl;
-        print(sstream, 0);		       
-    }
-#endif
+            Matrix&& input_loc = input.copy();
 
-    return block_mtx;
+            // the gates applied on the input before the differentiated gate
+            apply_tape_to( tape, 0, tape_offsets[deriv_idx+1], parameters, input_loc );
 
+            Matrix_real parameters_mtx(parameters + deriv_parameter_idx, 1, gate_deriv->get_parameter_num());
+            std::vector<Matrix> grad_loc = apply_gate_derivate_to( gate_deriv, parameters_mtx, input_loc );
 
-}
+            // the gates applied on the derivatives after the differentiated gate
+            apply_tape_to_list( tape, tape_offsets[deriv_idx], tape.size(), parameters, grad_loc );
 
 
+            for ( int idx = 0; idx<(int)grad_loc.size(); idx++ ) {
+                grad[deriv_parameter_idx+idx] = grad_loc[idx];
+            }
 
-/**
-@brief Call to apply the gate on the input array/matrix by U3*input
-@param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
-*/
-void 
-Gates_block::apply_to_list( Matrix_real& parameters_mtx, std::vector<Matrix> input ) {
 
+        } // tbb range end
+    
+    });
 
-    for ( std::vector<Matrix>::iterator it=input.begin(); it != input.end(); it++ ) {
-        apply_to( parameters_mtx, *it );
-    }
+    return grad;
 
 }
 
 
 /**
-@brief Call to apply the gate on the input array/matrix Gates_block*input
-@param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@brief Call to apply the inverse of the gates on the input array/matrix by Gates_block^dagger*input
+@param parameters_mtx An array of parameters to calculate the matrices of the gates.
+@param input The input array on which the inverse of the gates is applied
 */
 void 
-Gates_block::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
+Gates_block::apply_inverse_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
     double* parameters = parameters_mtx.get_data();
 
-    parameters = parameters + parameter_num;
-
-    for( int idx=gates.size()-1; idx>=0; idx--) {
+    // the inverse of the product g_0*g_1*...*g_{n-1} is applied in reversed order compared to apply_to
+    for( int idx=0; idx<(int)gates.size(); idx++) {
 
         Gate* operation = gates[idx];
-        parameters = parameters - operation->get_parameter_num();
         Matrix_real parameters_mtx(parameters, 1, operation->get_parameter_num());
 
         if (operation->get_type() == CNOT_OPERATION) {
@@ -292,29 +1386,25 @@ Gates_block::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
             CH* ch_operation = static_cast<CH*>(operation);
             ch_operation->apply_to(input);
         }
-        else if (operation->get_type() == SYC_OPERATION) {
-            SYC* syc_operation = static_cast<SYC*>(operation);
-            syc_operation->apply_to(input);
-        }
         else if (operation->get_type() == U3_OPERATION) {
             U3* u3_operation = static_cast<U3*>(operation);
-            u3_operation->apply_to( parameters_mtx, input );    
+            u3_operation->apply_inverse_to( parameters_mtx, input );    
         }
         else if (operation->get_type() == RX_OPERATION) {
             RX* rx_operation = static_cast<RX*>(operation);
-            rx_operation->apply_to( parameters_mtx, input ); 
+            rx_operation->apply_inverse_to( parameters_mtx, input ); 
         }
         else if (operation->get_type() == RY_OPERATION) {
             RY* ry_operation = static_cast<RY*>(operation);
-            ry_operation->apply_to( parameters_mtx, input ); 
+            ry_operation->apply_inverse_to( parameters_mtx, input ); 
         }
         else if (operation->get_type() == CRY_OPERATION) {
             CRY* cry_operation = static_cast<CRY*>(operation);
-            cry_operation->apply_to( parameters_mtx, input ); 
+            cry_operation->apply_inverse_to( parameters_mtx, input ); 
         }
         else if (operation->get_type() == RZ_OPERATION) {
             RZ* rz_operation = static_cast<RZ*>(operation);
-            rz_operation->apply_to( parameters_mtx, input ); 
+            rz_operation->apply_inverse_to( parameters_mtx, input ); 
         }
         else if (operation->get_type() == X_OPERATION) {
             X* x_operation = static_cast<X*>(operation);
@@ -330,427 +1420,351 @@ Gates_block::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
         }
         else if (operation->get_type() == SX_OPERATION) {
             SX* sx_operation = static_cast<SX*>(operation);
-            sx_operation->apply_to( input ); 
+            sx_operation->apply_inverse_to( input ); 
         }
         else if (operation->get_type() == GENERAL_OPERATION) {
-            operation->apply_to(input);
-        }
-        else if (operation->get_type() == UN_OPERATION) {
-            UN* un_operation = static_cast<UN*>(operation);
-            un_operation->apply_to(parameters_mtx, input);
-        }
-        else if (operation->get_type() == ON_OPERATION) {
-            ON* on_operation = static_cast<ON*>(operation);
-            on_operation->apply_to(parameters_mtx, input);
+            operation->apply_inverse_to(input);
         }
         else if (operation->get_type() == BLOCK_OPERATION) {
             Gates_block* block_operation = static_cast<Gates_block*>(operation);
-            block_operation->apply_to(parameters_mtx, input);
-        }
-        else if (operation->get_type() == COMPOSITE_OPERATION) {
-            Composite* com_operation = static_cast<Composite*>(operation);
-            com_operation->apply_to(parameters_mtx, input);
+            block_operation->apply_inverse_to(parameters_mtx, input);
         }
         else if (operation->get_type() == ADAPTIVE_OPERATION) {
             Adaptive* ad_operation = static_cast<Adaptive*>(operation);
-            ad_operation->apply_to( parameters_mtx, input ); 
+            ad_operation->apply_inverse_to( parameters_mtx, input ); 
         }
         else {
-            std::string err("Gates_block::apply_to: unimplemented gate"); 
+            std::string err("Gates_block::apply_inverse_to: unimplemented gate"); 
             throw err;
         }
 
-#ifdef DEBUG
-        if (input.isnan()) {
-            std::stringstream sstream;
-	    sstream << "Gates_block::apply_to: transformed matrix contains NaN." << std::endl;
-            print(sstream, 0);	
-        }
-#endif
-
+        parameters = parameters + operation->get_parameter_num();
 
     }
 
-
-
 }
 
 
+
 /**
-@brief Call to apply the gate on the input array/matrix by input*Gate_block
-@param input The input array on which the gate is applied
+@brief Call to calculate the gradient components of the real functional Re Tr(seed^dagger * Gates_block*input) in reverse (adjoint) mode. The transformed matrix and the adjoint matrix are swept through the gates once, so the gradient costs O(number of gates) gate applications instead of O(number of gates^2).
+@param parameters_mtx An array of parameters of the gates.
+@param transformed The matrix Gates_block*input. On exit the matrix is transformed back into input.
+@param adjoint The seed matrix (i.e. the derivative of the cost function with respect to the elements of the transformed matrix). On exit the matrix is transformed into Gates_block^dagger*seed.
+@param grad Preallocated array of parameter_num elements to store the calculated gradient components.
 */
 void 
-Gates_block::apply_from_right( Matrix_real& parameters_mtx, Matrix& input ) {
-
-
-    //The stringstream input to store the output messages.
-    std::stringstream sstream;
+Gates_block::apply_adjoint_derivate_to( Matrix_real& parameters_mtx, Matrix& transformed, Matrix& adjoint, Matrix_real& grad ) {
 
     double* parameters = parameters_mtx.get_data();
+    double* grad_data = grad.get_data();
 
+    // Before the idx-th gate: transformed = g_idx*...*g_{n-1}*input and adjoint = (g_0*...*g_{idx-1})^dagger*seed,
+    // thus the gradient component of gate idx is Re Tr( adjoint^dagger * d(g_idx) * (g_idx^dagger*transformed) )
     for( int idx=0; idx<(int)gates.size(); idx++) {
 
         Gate* operation = gates[idx];
-        Matrix_real parameters_mtx(parameters, 1, operation->get_parameter_num());
+        int parameter_num_loc = operation->get_parameter_num();
+        Matrix_real parameters_mtx(parameters, 1, parameter_num_loc);
 
         if (operation->get_type() == CNOT_OPERATION) {
             CNOT* cnot_operation = static_cast<CNOT*>(operation);
-            cnot_operation->apply_from_right(input);
+            tbb::parallel_invoke(
+                [&]{ cnot_operation->apply_to( transformed ); },
+                [&]{ cnot_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == CZ_OPERATION) {
             CZ* cz_operation = static_cast<CZ*>(operation);
-            cz_operation->apply_from_right(input);
+            tbb::parallel_invoke(
+                [&]{ cz_operation->apply_to( transformed ); },
+                [&]{ cz_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == CH_OPERATION) {
             CH* ch_operation = static_cast<CH*>(operation);
-            ch_operation->apply_from_right(input);
+            tbb::parallel_invoke(
+                [&]{ ch_operation->apply_to( transformed ); },
+                [&]{ ch_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == SYC_OPERATION) {
-            SYC* syc_operation = static_cast<SYC*>(operation);
-            syc_operation->apply_from_right(input);
+            std::stringstream sstream;
+            sstream << "Sycamore operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	                    
+            exit(-1);
         }
         else if (operation->get_type() == U3_OPERATION) {
             U3* u3_operation = static_cast<U3*>(operation);
-            u3_operation->apply_from_right( parameters_mtx, input ); 
+            u3_operation->apply_inverse_to( parameters_mtx, transformed );
+            u3_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            u3_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else if (operation->get_type() == RX_OPERATION) {
             RX* rx_operation = static_cast<RX*>(operation);
-            rx_operation->apply_from_right( parameters_mtx, input ); 
+            rx_operation->apply_inverse_to( parameters_mtx, transformed );
+            rx_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            rx_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else if (operation->get_type() == RY_OPERATION) {
             RY* ry_operation = static_cast<RY*>(operation);
-            ry_operation->apply_from_right( parameters_mtx, input ); 
+            ry_operation->apply_inverse_to( parameters_mtx, transformed );
+            ry_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            ry_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else if (operation->get_type() == CRY_OPERATION) {
             CRY* cry_operation = static_cast<CRY*>(operation);
-            cry_operation->apply_from_right( parameters_mtx, input ); 
+            cry_operation->apply_inverse_to( parameters_mtx, transformed );
+            cry_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            cry_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else if (operation->get_type() == RZ_OPERATION) {
             RZ* rz_operation = static_cast<RZ*>(operation);
-            rz_operation->apply_from_right( parameters_mtx, input );         
+            rz_operation->apply_inverse_to( parameters_mtx, transformed );
+            rz_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            rz_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else if (operation->get_type() == X_OPERATION) {
             X* x_operation = static_cast<X*>(operation);
-            x_operation->apply_from_right( input ); 
+            tbb::parallel_invoke(
+                [&]{ x_operation->apply_to( transformed ); },
+                [&]{ x_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == Y_OPERATION) {
             Y* y_operation = static_cast<Y*>(operation);
-            y_operation->apply_from_right( input ); 
+            tbb::parallel_invoke(
+                [&]{ y_operation->apply_to( transformed ); },
+                [&]{ y_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == Z_OPERATION) {
             Z* z_operation = static_cast<Z*>(operation);
-            z_operation->apply_from_right( input ); 
+            tbb::parallel_invoke(
+                [&]{ z_operation->apply_to( transformed ); },
+                [&]{ z_operation->apply_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == SX_OPERATION) {
             SX* sx_operation = static_cast<SX*>(operation);
-            sx_operation->apply_from_right( input ); 
+            tbb::parallel_invoke(
+                [&]{ sx_operation->apply_inverse_to( transformed ); },
+                [&]{ sx_operation->apply_inverse_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == GENERAL_OPERATION) {
-            operation->apply_from_right(input);
+            tbb::parallel_invoke(
+                [&]{ operation->apply_inverse_to( transformed ); },
+                [&]{ operation->apply_inverse_to( adjoint ); }
+            );
         }
         else if (operation->get_type() == UN_OPERATION) {
-            UN* un_operation = static_cast<UN*>(operation);
-            un_operation->apply_from_right( parameters_mtx, input ); 
+            std::stringstream sstream;
+            sstream << "UN operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
         }
         else if (operation->get_type() == ON_OPERATION) {
-            ON* on_operation = static_cast<ON*>(operation);
-            on_operation->apply_from_right( parameters_mtx, input ); 
+            std::stringstream sstream;
+            sstream << "ON operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
         }
         else if (operation->get_type() == BLOCK_OPERATION) {
+            // the nested block transforms both matrices and fills up its gradient components
             Gates_block* block_operation = static_cast<Gates_block*>(operation);
-            block_operation->apply_from_right(parameters_mtx, input);
+            Matrix_real grad_loc(grad_data, 1, parameter_num_loc);
+            block_operation->apply_adjoint_derivate_to( parameters_mtx, transformed, adjoint, grad_loc );
         }
         else if (operation->get_type() == COMPOSITE_OPERATION) {
-            Composite* com_operation = static_cast<Composite*>(operation);
-            com_operation->apply_from_right( parameters_mtx, input ); 
+            std::stringstream sstream;
+            sstream << "Composite  operation not supported in gardient calculation" << std::endl;
+            print(sstream, 0);	
+            exit(-1);
         }
         else if (operation->get_type() == ADAPTIVE_OPERATION) {
             Adaptive* ad_operation = static_cast<Adaptive*>(operation);
-            ad_operation->apply_from_right( parameters_mtx, input ); 
+            ad_operation->apply_inverse_to( parameters_mtx, transformed );
+            ad_operation->apply_derivate_overlap_to( parameters_mtx, adjoint, transformed, grad_data );
+            ad_operation->apply_inverse_to( parameters_mtx, adjoint );
         }
         else {
-            std::string err("Gates_block::apply_from_right: unimplemented gate"); 
+            std::string err("Gates_block::apply_adjoint_derivate_to: unimplemented gate"); 
             throw err;
         }
 
-        parameters = parameters + operation->get_parameter_num();
-
-#ifdef DEBUG
-        if (input.isnan()) { 
-            std::stringstream sstream;
-	    sstream << "Gates_block::apply_from_right: transformed matrix contains NaN." << std::endl;
-            print(sstream, 0);	            
-        }
-#endif
 
+        parameters = parameters + parameter_num_loc;
+        grad_data  = grad_data + parameter_num_loc;
 
     }
 
-
 }
 
 
+/**
+@brief Call to store the 2x2 kernel of a gate (or its adjoint) in a lane of a batch of kernels (see apply_kernel_to_batched_input.h).
+@param kernels The batch of the kernels
+@param lane_idx The index of the lane
+@param kernel The 2x2 kernel of the gate
+@param adjoint Set true to store the adjoint of the kernel, or false otherwise.
+*/
+static inline void
+set_batched_kernel( Matrix_real& kernels, int lane_idx, QGD_Kernel2x2& kernel, bool adjoint ) {
+
+    for (int element_idx=0; element_idx<4; element_idx++) {
+
+        // the adjoint kernel is the conjugate of the transposed kernel (the off-diagonal elements 1 and 2 are swapped)
+        int element_idx_loc = adjoint && (element_idx == 1 || element_idx == 2) ? 3 - element_idx : element_idx;
+        QGD_Complex16& element = kernel[element_idx_loc];
+
+        kernels[(2*element_idx)*kernels.stride + lane_idx] = element.real;
+        kernels[(2*element_idx+1)*kernels.stride + lane_idx] = adjoint ? -element.imag : element.imag;
+
+    }
+
+}
+
 
 /**
-@brief ???????????????
+@brief Call to calculate the traces Tr(Gates_block*input) and their derivatives with respect to the parameters of the gates for a batch of problems in lockstep. The problems share the gates, but each of them has its own input matrix and parameters, and they are stored in the lanes of a structure of arrays batch (see apply_kernel_to_batched_input.h). The derivatives are obtained by sweeping the batch back through the gates once (in adjoint mode).
+@param parameters The parameters of the problems. (The parameters of the lane_idx-th problem are stored in the lane_idx-th row.)
+@param input The batch of the input matrices. The batch is overwritten during the calculation.
+@param traces Preallocated array of lane_num elements to store the traces of the problems.
+@param trace_derivatives Preallocated matrix of lane_num rows and parameter_num columns to store the derivatives of the traces of the problems.
 */
-std::vector<Matrix> 
-Gates_block::apply_derivate_to( Matrix_real& parameters_mtx_in, Matrix& input ) {
+void 
+Gates_block::get_trace_derivatives_batched( Matrix_real& parameters, Matrix_real& input, Matrix& traces, Matrix& trace_derivatives ) {
 
-    //The stringstream input to store the output messages.
-    std::stringstream sstream;
-  
-    std::vector<Matrix> grad(parameter_num, Matrix(0,0));
+    int lane_num = input.cols;
 
-    // deriv_idx ... the index of the gate block for which the gradient is to be calculated
-    tbb::parallel_for( tbb::blocked_range<int>(0,gates.size()), [&](tbb::blocked_range<int> r) {
-        for (int deriv_idx=r.begin(); deriv_idx<r.end(); ++deriv_idx) { 
+    if ( input.rows != 2*matrix_size*matrix_size || parameters.rows != lane_num || parameters.cols != parameter_num || traces.size() != lane_num || 
+         trace_derivatives.rows != lane_num || trace_derivatives.cols != parameter_num ) {
+        std::string err("Gates_block::get_trace_derivatives_batched: the sizes of the batches do not match the gates"); 
+        throw err;
+    }
 
+    std::vector<Tape_Instruction>& tape = get_tape();
 
-            Gate* gate_deriv = gates[deriv_idx];
+    for (size_t idx=0; idx<tape.size(); idx++) {
+        if ( tape[idx].kernel_type == TAPE_GATE ) {
+            std::string err("Gates_block::get_trace_derivatives_batched: only gates given by (controlled) 2x2 kernels are supported"); 
+            throw err;
+        }
+    }
 
-            // for constant gate no gardient component is calculated
-            if ( gate_deriv->get_parameter_num() == 0 ) {
-                continue;
-            }
+    // the view pointed to the parameters of the individual gates
+    Matrix_real parameters_loc( parameters.get_data(), 1, 0 );
 
-            int deriv_parameter_idx = 0;
-            for ( int idx=0; idx<deriv_idx; idx++ ) {
-                deriv_parameter_idx += gates[idx]->get_parameter_num();
-            }
+    // the kernels of the gate in the lanes and their adjoints
+    Matrix_real kernels(8, lane_num);
+    Matrix_real kernels_adjoint(8, lane_num);
 
-            Matrix&& input_loc = input.copy();
 
-            double* parameters = parameters_mtx_in.get_data();
-            parameters = parameters + parameter_num;
+    // transformed = Gates_block*input (the gates are applied in the order of the tape)
+    for (int idx=0; idx<(int)tape.size(); idx++) {
 
+        Tape_Instruction& instruction = tape[idx];
 
-            std::vector<Matrix> grad_loc;
+        for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+            QGD_Kernel2x2 kernel = calc_tape_kernel( instruction, parameters.get_data() + lane_idx*parameters.stride, parameters_loc );
+            set_batched_kernel( kernels, lane_idx, kernel, false );
+        }
 
-            for( int idx=gates.size()-1; idx>=0; idx--) {
+        apply_kernel_to_batched_input( kernels, input, instruction.target_qbit, instruction.control_qbit, matrix_size );
 
-                Gate* operation = gates[idx];
-                parameters = parameters - operation->get_parameter_num();
-                Matrix_real parameters_mtx(parameters, 1, operation->get_parameter_num());
+    }
 
-                if (operation->get_type() == CNOT_OPERATION) {
-                    CNOT* cnot_operation = static_cast<CNOT*>(operation);
-                    if ( deriv_idx < idx ) {
-                        cnot_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        cnot_operation->Gate::apply_to_list(grad_loc );
-                    }
-                }
-                else if (operation->get_type() == CZ_OPERATION) {
-                    CZ* cz_operation = static_cast<CZ*>(operation);
-                    if ( deriv_idx < idx ) {
-                        cz_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        cz_operation->Gate::apply_to_list(grad_loc );
-                    }
-                }
-                else if (operation->get_type() == CH_OPERATION) {
-                    CH* ch_operation = static_cast<CH*>(operation);
-                    if ( deriv_idx < idx ) {
-                        ch_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        ch_operation->Gate::apply_to_list(grad_loc );
-                    }
-                }    
-    
-                else if (operation->get_type() == SYC_OPERATION) {
-                        std::stringstream sstream;
-	    	        sstream << "Sycamore operation not supported in gardient calculation" << std::endl;			
-			print(sstream, 0);	                    
-			exit(-1);
-                }
+    for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+        traces[lane_idx].real = 0.0;
+        traces[lane_idx].imag = 0.0;
+    }
 
-                else if (operation->get_type() == U3_OPERATION) {
-    
-                    U3* u3_operation = static_cast<U3*>(operation);
-                    if ( deriv_idx < idx ) {
-                        u3_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-    
-                        grad_loc = u3_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        u3_operation->apply_to_list( parameters_mtx, grad_loc );
-                    }
-                }
+    for (int row_idx=0; row_idx<matrix_size; row_idx++) {
 
-                else if (operation->get_type() == RX_OPERATION) {
-                    RX* rx_operation = static_cast<RX*>(operation);
-                    if ( deriv_idx < idx ) {
-                        rx_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-    
-                        grad_loc = rx_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        rx_operation->apply_to_list( parameters_mtx, grad_loc );
-                    }
-                }
+        double* element_real = input.get_data() + 2*(row_idx*matrix_size + row_idx)*input.stride;
+        double* element_imag = element_real + input.stride;
 
+        for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+            traces[lane_idx].real += element_real[lane_idx];
+            traces[lane_idx].imag += element_imag[lane_idx];
+        }
 
-                else if (operation->get_type() == RY_OPERATION) {
-                    RY* ry_operation = static_cast<RY*>(operation);
-                    if ( deriv_idx < idx ) {
-                        ry_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-    
-                        grad_loc = ry_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        ry_operation->apply_to_list( parameters_mtx, grad_loc );    
-                    }    
-                }
+    }
 
-                else if (operation->get_type() == CRY_OPERATION) {
-                    CRY* cry_operation = static_cast<CRY*>(operation);
-                    if ( deriv_idx < idx ) {
-                        cry_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-                        grad_loc = cry_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        cry_operation->apply_to_list( parameters_mtx, grad_loc );
-                    }
-                }
 
-                else if (operation->get_type() == RZ_OPERATION) {
-                    RZ* rz_operation = static_cast<RZ*>(operation);
-                    if ( deriv_idx < idx ) {
-                        rz_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-    
-                        grad_loc = rz_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        rz_operation->apply_to_list( parameters_mtx, grad_loc );
-                    }
-                }
+    // Before the gate g of the tape instruction idx: transformed = g*X*g_0*...*g_{k-1}, where g_0*...*g_{k-1} are the gates applied
+    // after g, and X = (the gates applied before g)*input, thus the derivative of the trace with respect to a parameter of g is 
+    // Tr( d(g) * (g^dagger*transformed) ) by the cyclic property of the trace. Then transformed is moved to the next gate by g^dagger*transformed*g.
+    for (int idx=(int)tape.size()-1; idx>=0; idx--) {
 
-                else if (operation->get_type() == X_OPERATION) {
-                    X* x_operation = static_cast<X*>(operation);
-                    if ( deriv_idx < idx ) {
-                        x_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        x_operation->Gate::apply_to_list( grad_loc );
-                    }
-                }
-                else if (operation->get_type() == Y_OPERATION) {
-                    Y* y_operation = static_cast<Y*>(operation);
-                    if ( deriv_idx < idx ) {
-                        y_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        y_operation->Gate::apply_to_list( grad_loc );
-                    }
-                }
-                else if (operation->get_type() == Z_OPERATION) {
-                    Z* z_operation = static_cast<Z*>(operation);
-                    if ( deriv_idx < idx ) {
-                        z_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        z_operation->Gate::apply_to_list( grad_loc );
-                    }
-                }
-                else if (operation->get_type() == SX_OPERATION) {
-                    SX* sx_operation = static_cast<SX*>(operation);
-                    if ( deriv_idx < idx ) {
-                        sx_operation->apply_to( input_loc );    
-                    }
-                    else {
-                        sx_operation->Gate::apply_to_list(grad_loc );
-                    }
-                }
-                else if (operation->get_type() == GENERAL_OPERATION) {
-                    if ( deriv_idx < idx ) {
-                        operation->apply_to( input_loc );    
-                    }
-                    else {
-                        operation->apply_to_list( grad_loc );
-                    }
-                }
+        Tape_Instruction& instruction = tape[idx];
 
-                else if (operation->get_type() == UN_OPERATION) {
-                        std::stringstream sstream;
-	    	        sstream << "UN operation not supported in gardient calculation" << std::endl;
-			print(sstream, 0);	
-			exit(-1);
-                }
-                else if (operation->get_type() == ON_OPERATION) {
-                        std::stringstream sstream;
-		        sstream << "ON operation not supported in gardient calculation" << std::endl;
-			print(sstream, 0);	
-			exit(-1);
-                }
+        for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+            QGD_Kernel2x2 kernel = calc_tape_kernel( instruction, parameters.get_data() + lane_idx*parameters.stride, parameters_loc );
+            set_batched_kernel( kernels, lane_idx, kernel, false );
+            set_batched_kernel( kernels_adjoint, lane_idx, kernel, true );
+        }
 
-                else if (operation->get_type() == BLOCK_OPERATION) {
-                    Gates_block* block_operation = static_cast<Gates_block*>(operation);
-                    if ( deriv_idx < idx ) {
-                        block_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-                        grad_loc = block_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        block_operation->apply_to_list( parameters_mtx, grad_loc );
-                    }
-                }
+        apply_kernel_to_batched_input( kernels_adjoint, input, instruction.target_qbit, instruction.control_qbit, matrix_size );
 
-                else if (operation->get_type() == COMPOSITE_OPERATION) {
-                        std::stringstream sstream;
-	    	        sstream << "Composite  operation not supported in gardient calculation" << std::endl;
-			print(sstream, 0);	
-	                exit(-1);
-                }
+        if ( instruction.parameter_num > 0 ) {
+
+            // the gates with free parameters given by 2x2 kernels are derived from U3
+            U3* u3_operation = static_cast<U3*>(instruction.gate);
+
+            int index_step_target = 1 << instruction.target_qbit;
+            int pair_num = get_pair_num(matrix_size, instruction.control_qbit);
+
+            for (int lane_idx=0; lane_idx<lane_num; lane_idx++) {
+
+                set_tape_parameters( instruction, parameters.get_data() + lane_idx*parameters.stride, parameters_loc );
+                std::vector<QGD_Kernel2x2>&& derivate_kernels = u3_operation->calc_derivate_kernels( parameters_loc );
+
+                for (int parameter_idx=0; parameter_idx<instruction.parameter_num; parameter_idx++) {
+
+                    QGD_Kernel2x2& derivate_kernel = derivate_kernels[parameter_idx];
+                    QGD_Complex16 trace_derivative;
+                    trace_derivative.real = 0.0;
+                    trace_derivative.imag = 0.0;
+
+                    // the derivative of a controlled gate vanishes on the subspace where the control qubit is in state |0>
+                    for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+                        int row_idx = get_pair_row_index(pair_idx, instruction.target_qbit, instruction.control_qbit);
+                        int row_pair_idx = row_idx + index_step_target;
+
+                        int element_offsets[4] = { row_idx*matrix_size + row_idx, row_pair_idx*matrix_size + row_idx, row_idx*matrix_size + row_pair_idx, row_pair_idx*matrix_size + row_pair_idx };
+
+                        // Tr( d(g)*transformed ) over the pair of rows: d00*t00 + d01*t10 + d10*t01 + d11*t11
+                        for (int element_idx=0; element_idx<4; element_idx++) {
+
+                            double* element_real = input.get_data() + 2*element_offsets[element_idx]*input.stride + lane_idx;
+                            double element_imag = element_real[input.stride];
+
+                            trace_derivative.real += derivate_kernel[element_idx].real*element_real[0] - derivate_kernel[element_idx].imag*element_imag;
+                            trace_derivative.imag += derivate_kernel[element_idx].real*element_imag + derivate_kernel[element_idx].imag*element_real[0];
+
+                        }
 
-                else if (operation->get_type() == ADAPTIVE_OPERATION) {
-                    Adaptive* ad_operation = static_cast<Adaptive*>(operation);
-                    if ( deriv_idx < idx ) {
-                        ad_operation->apply_to( parameters_mtx, input_loc );    
-                    }
-                    else if ( deriv_idx == idx ) {
-                        grad_loc = ad_operation->apply_derivate_to( parameters_mtx, input_loc );    
-                    }
-                    else {
-                        ad_operation->apply_to_list( parameters_mtx, grad_loc );
                     }
-                }
-                else {
-                    std::string err("Gates_block::apply_derivate_to: unimplemented gate"); 
-                    throw err;
-                }
 
-            }
+                    trace_derivatives[lane_idx*trace_derivatives.stride + instruction.parameter_idx + parameter_idx] = trace_derivative;
 
+                }
 
-            for ( int idx = 0; idx<(int)grad_loc.size(); idx++ ) {
-                grad[deriv_parameter_idx+idx] = grad_loc[idx];
             }
 
+        }
 
-        } // tbb range end
-    
-    });
+        apply_kernel_from_right_to_batched_input( kernels, input, instruction.target_qbit, instruction.control_qbit, matrix_size );
 
-    return grad;
+    }
 
 }
 
+
+
 /**
 @brief Append a U3 gate to the list of gates
 @param target_qbit The identification number of the targt qubit. (0 <= target_qbit <= qbit_num-1)
@@ -1319,6 +2333,8 @@ void Gates_block::add_gate_to_end( Gate* gate ) {
             layer_num = layer_num + 1;
         }
 
+        invalidate_tape();
+
 }
 
 /**
@@ -1341,6 +2357,8 @@ void Gates_block::add_gate_to_end( Gate* gate ) {
             layer_num = layer_num + 1;
         }
 
+        invalidate_tape();
+
 }
 
 
@@ -1366,6 +2384,8 @@ Gates_block::insert_gate( Gate* gate, int idx ) {
             layer_num = layer_num + 1;
         }
 
+        invalidate_tape();
+
 
 }
 
@@ -1871,6 +2891,8 @@ void Gates_block::reorder_qubits( std::vector<int>  qbit_list) {
 
     }
 
+    invalidate_tape();
+
 }
 
 
@@ -2061,6 +3083,8 @@ void Gates_block::combine(Gates_block* op_block) {
 
     }
 
+    invalidate_tape();
+
 }
 
 
@@ -2157,6 +3181,8 @@ void Gates_block::set_qbit_num( int qbit_num_in ) {
             throw err;
         }
     }
+
+    invalidate_tape();
 }
 
 
@@ -140,19 +140,33 @@ RY::apply_to( Matrix_real& parameters, Matrix& input, const double scale ) {
     }
 
 
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
+
+
+    apply_kernel_to( u3_1qbit, input );
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+RY::calc_kernel( Matrix_real& parameters ) {
+
     double ThetaOver2, Phi, Lambda;
 
     ThetaOver2 = parameters[0];
     Phi = phi0;
     Lambda = lambda0;
-    
 
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
-
-
-    apply_kernel_to( u3_1qbit, input );
-
+    return calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
 
 }
 
@@ -173,15 +187,8 @@ RY::apply_from_right( Matrix_real& parameters, Matrix& input ) {
         exit(-1);
     }
 
-    double ThetaOver2, Phi, Lambda;
-
-    ThetaOver2 = parameters[0];
-    Phi = phi0;
-    Lambda = lambda0;
-    
-
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
 
 
     apply_kernel_from_right(u3_1qbit, input);
@@ -192,6 +199,32 @@ RY::apply_from_right( Matrix_real& parameters, Matrix& input ) {
 
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by RY^dagger*input
+@param parameters An array of parameters to calculate the matrix of the RY gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+RY::apply_inverse_to( Matrix_real& parameters, Matrix& input ) {
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in RY apply_inverse_to" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
+
+    apply_kernel_inverse_to( u3_1qbit, input );
+
+
+}
+
+
+
 /**
 @brief ???????????????
 */
@@ -223,6 +256,31 @@ RY::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
 
 
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+std::vector<QGD_Kernel2x2> 
+RY::calc_derivate_kernels( Matrix_real& parameters_mtx ) {
+
+    std::vector<QGD_Kernel2x2> ret;
+
+    double ThetaOver2, Phi, Lambda;
+
+    ThetaOver2 = parameters_mtx[0] + M_PI/2;
+    Phi = phi0;
+    Lambda = lambda0;
+
+    QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
+    ret.push_back(u3_1qbit);
+
+    return ret;
+
+}
+
+
+
 /**
 @brief Call to set the final optimized parameters of the gate.
 @param ThetaOver2 Real parameter standing for the parameter theta.
@@ -146,19 +146,33 @@ RZ::apply_to( Matrix_real& parameters, Matrix& input ) {
         exit(-1);
     }
 
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
+
+
+    apply_diagonal_kernel_to( u3_1qbit, input );
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+RZ::calc_kernel( Matrix_real& parameters ) {
+
     double Theta, Phi, Lambda;
 
     Theta = theta0;
     Phi = parameters[0];
     Lambda = lambda0;
-    
 
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(Theta, Phi, Lambda );
-
-
-    apply_kernel_to( u3_1qbit, input );
-
+    return calc_one_qubit_u3(Theta, Phi, Lambda );
 
 }
 
@@ -180,21 +194,44 @@ RZ::apply_from_right( Matrix_real& parameters, Matrix& input ) {
         exit(-1);
     }
 
-    double Theta, Phi, Lambda;
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
 
-    Theta = theta0;
-    Phi = parameters[0];
-    Lambda = lambda0;
-    
 
-    // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(Theta, Phi, Lambda );
+    apply_diagonal_kernel_from_right(u3_1qbit, input);
 
 
-    apply_kernel_from_right(u3_1qbit, input);
+
+}
 
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by RZ^dagger*input
+@param parameters An array of parameters to calculate the matrix of the RZ gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+RZ::apply_inverse_to( Matrix_real& parameters, Matrix& input ) {
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in RZ apply_inverse_to" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters );
+
+    // the adjoint of the diagonal kernel
+    u3_1qbit[0].imag = -u3_1qbit[0].imag;
+    u3_1qbit[3].imag = -u3_1qbit[3].imag;
+
+    apply_diagonal_kernel_to( u3_1qbit, input );
+
+
 }
 
 
@@ -222,11 +259,11 @@ RZ::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
     
 
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(Theta, Phi, Lambda );
+    QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(Theta, Phi, Lambda );
     memset(u3_1qbit.get_data(), 0.0, 2*sizeof(QGD_Complex16));
 
 
-    apply_kernel_to( u3_1qbit, res_mtx );
+    apply_diagonal_kernel_to( u3_1qbit, res_mtx );
 
     std::vector<Matrix> ret;
     ret.push_back(res_mtx);
@@ -239,6 +276,32 @@ RZ::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
 
 
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+std::vector<QGD_Kernel2x2> 
+RZ::calc_derivate_kernels( Matrix_real& parameters_mtx ) {
+
+    std::vector<QGD_Kernel2x2> ret;
+
+    double Theta, Phi, Lambda;
+
+    Theta = theta0;
+    Phi = parameters_mtx[0] + M_PI/2;
+    Lambda = lambda0;
+
+    QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(Theta, Phi, Lambda );
+    memset(u3_1qbit.get_data(), 0.0, 2*sizeof(QGD_Complex16));
+    ret.push_back(u3_1qbit);
+
+    return ret;
+
+}
+
+
+
 
 /**
 @brief Call to set the final optimized parameters of the gate.
@@ -139,11 +139,8 @@ SX::apply_to( Matrix& input ) {
 
 
     // the SX gate of one qubit
-    Matrix sx_1qbit(2,2);
-    sx_1qbit[0].real = 0.5; sx_1qbit[0].imag = 0.5;
-    sx_1qbit[1].real = 0.5; sx_1qbit[1].imag = -0.5;
-    sx_1qbit[2].real = 0.5; sx_1qbit[2].imag = -0.5;
-    sx_1qbit[3].real = 0.5; sx_1qbit[3].imag = 0.5;
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 sx_1qbit = calc_kernel( parameters_mtx );
 
    
     //apply_kernel_to function to SX gate 
@@ -201,6 +198,26 @@ SX::apply_to( Matrix& input ) {
 
 
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+SX::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 sx_1qbit;
+    sx_1qbit[0].real = 0.5; sx_1qbit[0].imag = 0.5;
+    sx_1qbit[1].real = 0.5; sx_1qbit[1].imag = -0.5;
+    sx_1qbit[2].real = 0.5; sx_1qbit[2].imag = -0.5;
+    sx_1qbit[3].real = 0.5; sx_1qbit[3].imag = 0.5;
+
+    return sx_1qbit;
+
+}
+
+
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
@@ -219,7 +236,7 @@ SX::apply_from_right( Matrix& input ) {
     }
 
     // the SX gate of one qubit
-    Matrix sx_1qbit(2,2);
+    QGD_Kernel2x2 sx_1qbit;
     sx_1qbit[0].real = 0.5; sx_1qbit[0].imag = 0.5;
     sx_1qbit[1].real = 0.5; sx_1qbit[1].imag = -0.5;
     sx_1qbit[2].real = 0.5; sx_1qbit[2].imag = -0.5;
@@ -283,6 +300,33 @@ SX::apply_from_right( Matrix& input ) {
 
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by SX^dagger*input
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+SX::apply_inverse_to( Matrix& input ) {
+
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in SX apply_inverse_to" << std::endl;
+        print(sstream, 0);	
+        exit(-1);
+    }
+
+    // the SX gate of one qubit
+    QGD_Kernel2x2 sx_1qbit;
+    sx_1qbit[0].real = 0.5; sx_1qbit[0].imag = 0.5;
+    sx_1qbit[1].real = 0.5; sx_1qbit[1].imag = -0.5;
+    sx_1qbit[2].real = 0.5; sx_1qbit[2].imag = -0.5;
+    sx_1qbit[3].real = 0.5; sx_1qbit[3].imag = 0.5;
+
+    apply_kernel_inverse_to( sx_1qbit, input );
+
+}
+
+
 /**
 @brief Call to create a clone of the present class
 @return Return with a pointer pointing to the cloned object
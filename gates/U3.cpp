@@ -171,17 +171,28 @@ U3::get_matrix( Matrix_real& parameters ) {
 }
 
 /**
-@brief Call to apply the gate on the input array/matrix by U3*input
+@brief Call to apply the gate on a list of input arrays/matrices by U3*input. The kernel of the gate is calculated once, and the inputs are transformed in parallel.
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@param input The list of the input arrays on which the gate is applied
 */
 void 
 U3::apply_to_list( Matrix_real& parameters_mtx, std::vector<Matrix>& input ) {
 
+    // the kernel is calculated once for all the inputs
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters_mtx );
 
-    for ( std::vector<Matrix>::iterator it=input.begin(); it != input.end(); it++ ) {
-        apply_to( parameters_mtx, *it );
-    }
+    tbb::parallel_for( 0, (int)input.size(), 1, [&](int idx) {
+
+        if (input[idx].rows != matrix_size ) {
+            std::stringstream sstream;
+	    sstream << "Wrong matrix size in U3 gate apply" << std::endl;
+            print(sstream, 0);	        
+            exit(-1);
+        }
+
+        apply_kernel_to( u3_1qbit, input[idx] );
+
+    });
 
 }
 
@@ -204,6 +215,25 @@ U3::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
     }
 
 
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters_mtx );
+
+
+    apply_kernel_to( u3_1qbit, input );
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters_mtx An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+U3::calc_kernel( Matrix_real& parameters_mtx ) {
+
     double ThetaOver2, Phi, Lambda;
 
     if (theta && !phi && lambda) {
@@ -256,11 +286,7 @@ U3::apply_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
 
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
-
-
-    apply_kernel_to( u3_1qbit, input );
-
+    return calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
 
 }
 
@@ -337,7 +363,7 @@ U3::apply_from_right( Matrix_real& parameters_mtx, Matrix& input ) {
     }
 
     // get the U3 gate of one qubit
-    Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
+    QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda );
 
 
     apply_kernel_from_right(u3_1qbit, input);
@@ -348,6 +374,31 @@ U3::apply_from_right( Matrix_real& parameters_mtx, Matrix& input ) {
 
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by U3^dagger*input
+@param parameters An array of parameters to calculate the matrix of the U3 gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+void 
+U3::apply_inverse_to( Matrix_real& parameters_mtx, Matrix& input ) {
+
+    if (input.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in U3 apply_inverse_to" << std::endl;
+        print(sstream, 0);	        
+        exit(-1);
+    }
+
+
+    // get the U3 gate of one qubit
+    QGD_Kernel2x2 u3_1qbit = calc_kernel( parameters_mtx );
+
+    apply_kernel_inverse_to( u3_1qbit, input );
+
+}
+
+
+
 /**
 @brief ???????????????
 */
@@ -364,6 +415,34 @@ U3::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
     std::vector<Matrix> ret;
 
+    std::vector<QGD_Kernel2x2>&& derivate_kernels = calc_derivate_kernels( parameters_mtx );
+
+    for (size_t idx=0; idx<derivate_kernels.size(); idx++) {
+
+        Matrix res_mtx = input.copy();
+        apply_kernel_to( derivate_kernels[idx], res_mtx );
+        ret.push_back(res_mtx);
+
+    }
+
+
+    return ret;
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters. The derivative of the gate with respect to the i-th parameter is given by applying the i-th kernel on the target qubit.
+@param parameters_mtx An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+std::vector<QGD_Kernel2x2> 
+U3::calc_derivate_kernels( Matrix_real& parameters_mtx ) {
+
+    std::vector<QGD_Kernel2x2> ret;
+
     double ThetaOver2, Phi, Lambda;
 
     if (theta && !phi && lambda) {
@@ -417,12 +496,11 @@ U3::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
 
 
+
     if (theta) {
 
-        Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2+M_PIOver2, Phi, Lambda);
-        Matrix res_mtx = input.copy();
-        apply_kernel_to( u3_1qbit, res_mtx );
-        ret.push_back(res_mtx);
+        QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(ThetaOver2+M_PIOver2, Phi, Lambda);
+        ret.push_back(u3_1qbit);
 
     }
 
@@ -430,12 +508,9 @@ U3::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
     if (phi) {
 
-        Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi+M_PIOver2, Lambda );
+        QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi+M_PIOver2, Lambda );
         memset(u3_1qbit.get_data(), 0.0, 2*sizeof(QGD_Complex16) );
-
-        Matrix res_mtx = input.copy();
-        apply_kernel_to( u3_1qbit, res_mtx );
-        ret.push_back(res_mtx);
+        ret.push_back(u3_1qbit);
 
     }
 
@@ -443,13 +518,10 @@ U3::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
     if (lambda) {
 
-        Matrix u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda+M_PIOver2 );
+        QGD_Kernel2x2 u3_1qbit = calc_one_qubit_u3(ThetaOver2, Phi, Lambda+M_PIOver2 );
         memset(u3_1qbit.get_data(), 0.0, sizeof(QGD_Complex16) );
         memset(u3_1qbit.get_data()+2, 0.0, sizeof(QGD_Complex16) );
-
-        Matrix res_mtx = input.copy();
-        apply_kernel_to( u3_1qbit, res_mtx );
-        ret.push_back(res_mtx);
+        ret.push_back(u3_1qbit);
 
     }
 
@@ -459,6 +531,36 @@ U3::apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input ) {
 
 }
 
+
+
+/**
+@brief Call to evaluate the gradient components Re Tr( adjoint^dagger * dU/dp_i * input ) of the gate with respect to its free parameters without allocating the derivative matrices.
+@param parameters_mtx An array of the free parameters of the gate.
+@param adjoint The adjoint matrix against which the derivatives are contracted
+@param input The input array/matrix on which the derivatives of the gate would be applied
+@param grad Pointer to the gradient components to be filled up (one for each free parameter)
+*/
+void 
+U3::apply_derivate_overlap_to( Matrix_real& parameters_mtx, Matrix& adjoint, Matrix& input, double* grad ) {
+
+    if (input.rows != matrix_size || adjoint.rows != matrix_size ) {
+        std::stringstream sstream;
+	sstream << "Wrong matrix size in U3 apply_derivate_overlap_to" << std::endl;
+        print(sstream, 0);	   
+        exit(-1);
+    }
+
+    std::vector<QGD_Kernel2x2>&& derivate_kernels = calc_derivate_kernels( parameters_mtx );
+
+    // the derivative of the identity block of a controlled gate is zero
+    bool deriv = true;
+
+    for (size_t idx=0; idx<derivate_kernels.size(); idx++) {
+        grad[idx] = get_kernel_overlap( derivate_kernels[idx], adjoint, input, deriv );
+    }
+
+}
+
 /**
 @brief Call to set the number of qubits spanning the matrix of the gate
 @param qbit_num_in The number of qubits
@@ -517,9 +619,9 @@ bool U3::is_lambda_parameter() {
 @param Lambda Real parameter standing for the parameter lambda.
 @return Returns with the matrix of the one-qubit matrix.
 */
-Matrix U3::calc_one_qubit_u3(double ThetaOver2, double Phi, double Lambda ) {
+QGD_Kernel2x2 U3::calc_one_qubit_u3(double ThetaOver2, double Phi, double Lambda ) {
 
-    Matrix u3_1qbit = Matrix(2,2);
+    QGD_Kernel2x2 u3_1qbit;
 
 #ifdef DEBUG
     if (isnan(ThetaOver2)) {
@@ -139,14 +139,11 @@ X::apply_to( Matrix& input ) {
 
 
     // the X gate of one qubit
-    Matrix x_1qbit(2,2);
-    x_1qbit[0].real = 0.0; x_1qbit[0].imag = 0.0; 
-    x_1qbit[1].real = 1.0; x_1qbit[1].imag = 0.0;
-    x_1qbit[2].real = 1.0; x_1qbit[2].imag = 0.0;
-    x_1qbit[3].real = 0.0; x_1qbit[3].imag = 0.0;
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 x_1qbit = calc_kernel( parameters_mtx );
 
-    //apply_kernel_to function to X gate 
-    apply_kernel_to( x_1qbit, input );
+    // the rows are swapped by the anti-diagonal kernel
+    apply_antidiagonal_kernel_to( x_1qbit, input );
    
 
 
@@ -195,6 +192,26 @@ X::apply_to( Matrix& input ) {
 
 
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+X::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 x_1qbit;
+    x_1qbit[0].real = 0.0; x_1qbit[0].imag = 0.0;
+    x_1qbit[1].real = 1.0; x_1qbit[1].imag = 0.0;
+    x_1qbit[2].real = 1.0; x_1qbit[2].imag = 0.0;
+    x_1qbit[3].real = 0.0; x_1qbit[3].imag = 0.0;
+
+    return x_1qbit;
+
+}
+
+
+
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
@@ -214,14 +231,14 @@ X::apply_from_right( Matrix& input ) {
     }
 
     // the X gate of one qubit
-    Matrix x_1qbit(2,2);
+    QGD_Kernel2x2 x_1qbit;
     x_1qbit[0].real = 0.0; x_1qbit[0].imag = 0.0; 
     x_1qbit[1].real = 1.0; x_1qbit[1].imag = 0.0;
     x_1qbit[2].real = 1.0; x_1qbit[2].imag = 0.0;
     x_1qbit[3].real = 0.0; x_1qbit[3].imag = 0.0;
    
-    //apply_kernel_from_right function to X gate 
-    apply_kernel_from_right(x_1qbit, input);
+    // the columns are swapped by the anti-diagonal kernel
+    apply_antidiagonal_kernel_from_right(x_1qbit, input);
 
 
    /* int index_step = Power_of_2(target_qbit);
@@ -139,16 +139,33 @@ Y::apply_to( Matrix& input ) {
 
 
     // the X gate of one qubit
-    Matrix y_1qbit(2,2);
-    y_1qbit[0].real = 0.0; y_1qbit[0].imag = 0.0; 
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 y_1qbit = calc_kernel( parameters_mtx );
+
+    // the rows are swapped by the anti-diagonal kernel
+    apply_antidiagonal_kernel_to( y_1qbit, input );
+   
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+Y::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 y_1qbit;
+    y_1qbit[0].real = 0.0; y_1qbit[0].imag = 0.0;
     y_1qbit[1].real = 0.0; y_1qbit[1].imag = -1.0;
     y_1qbit[2].real = 0.0; y_1qbit[2].imag = 1.0;
     y_1qbit[3].real = 0.0; y_1qbit[3].imag = 0.0;
 
-    //apply_kernel_to function to X gate 
-    apply_kernel_to( y_1qbit, input );
-   
-
+    return y_1qbit;
 
 }
 
@@ -173,15 +190,15 @@ Y::apply_from_right( Matrix& input ) {
     }
 
     // the X gate of one qubit
-    Matrix y_1qbit(2,2);
+    QGD_Kernel2x2 y_1qbit;
     y_1qbit[0].real = 0.0; y_1qbit[0].imag = 0.0; 
     y_1qbit[1].real = 0.0; y_1qbit[1].imag = -1.0;
     y_1qbit[2].real = 0.0; y_1qbit[2].imag = 1.0;
     y_1qbit[3].real = 0.0; y_1qbit[3].imag = 0.0;
 
    
-    //apply_kernel_from_right function to X gate 
-    apply_kernel_from_right(y_1qbit, input);
+    // the columns are swapped by the anti-diagonal kernel
+    apply_antidiagonal_kernel_from_right(y_1qbit, input);
 
 }
 
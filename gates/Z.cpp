@@ -139,16 +139,33 @@ Z::apply_to( Matrix& input ) {
 
 
     // the Z gate of one qubit
-    Matrix z_1qbit(2,2);
-    z_1qbit[0].real = 1.0; z_1qbit[0].imag = 0.0; 
+    Matrix_real parameters_mtx;
+    QGD_Kernel2x2 z_1qbit = calc_kernel( parameters_mtx );
+
+    // the rows are rescaled by the diagonal kernel
+    apply_diagonal_kernel_to( z_1qbit, input );
+   
+
+
+}
+
+
+
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+QGD_Kernel2x2
+Z::calc_kernel( Matrix_real& parameters ) {
+
+    QGD_Kernel2x2 z_1qbit;
+    z_1qbit[0].real = 1.0; z_1qbit[0].imag = 0.0;
     z_1qbit[1].real = 0.0; z_1qbit[1].imag = 0.0;
     z_1qbit[2].real = 0.0; z_1qbit[2].imag = 0.0;
     z_1qbit[3].real = -1.0; z_1qbit[3].imag = 0.0;
 
-    //apply_kernel_to function to Z gate 
-    apply_kernel_to( z_1qbit, input );
-   
-
+    return z_1qbit;
 
 }
 
@@ -173,14 +190,14 @@ Z::apply_from_right( Matrix& input ) {
     }
 
     // the Z gate of one qubit
-    Matrix z_1qbit(2,2);
+    QGD_Kernel2x2 z_1qbit;
     z_1qbit[0].real = 1.0; z_1qbit[0].imag = 0.0; 
     z_1qbit[1].real = 0.0; z_1qbit[1].imag = 0.0;
     z_1qbit[2].real = 0.0; z_1qbit[2].imag = 0.0;
     z_1qbit[3].real = -1.0; z_1qbit[3].imag = 0.0;
    
-    //apply_kernel_from_right function to Z gate 
-    apply_kernel_from_right(z_1qbit, input);
+    // the columns are rescaled by the diagonal kernel
+    apply_diagonal_kernel_from_right(z_1qbit, input);
 
 
 
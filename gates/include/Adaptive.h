@@ -89,6 +89,13 @@ Adaptive(int qbit_num_in, int target_qbit_in, int control_qbit_in, int limit_in)
 */
 std::vector<Matrix> apply_derivate_to( Matrix_real& parameters, Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+std::vector<QGD_Kernel2x2> calc_derivate_kernels( Matrix_real& parameters );
+
 
 
 /**
@@ -98,6 +105,13 @@ std::vector<Matrix> apply_derivate_to( Matrix_real& parameters, Matrix& input );
 */
 virtual void apply_to( Matrix_real& parameters, Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
@@ -107,6 +121,14 @@ virtual void apply_to( Matrix_real& parameters, Matrix& input );
 void apply_from_right( Matrix_real& parameters, Matrix& input );
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by Adaptive^dagger*input
+@param parameters An array of parameters to calculate the matrix of the gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+void apply_inverse_to( Matrix_real& parameters, Matrix& input );
+
+
 /**
 @brief ???????????
 */
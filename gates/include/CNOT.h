@@ -71,6 +71,13 @@ Matrix get_matrix();
 */
 void apply_to( Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*CNOT
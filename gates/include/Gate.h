@@ -27,6 +27,7 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #include <vector>
 #include "common.h"
 #include "matrix.h"
+#include "matrix_real.h"
 #include "logging.h"
 
 
@@ -89,9 +90,8 @@ Gate(int qbit_num_in);
 Matrix get_matrix();
 
 /**
-@brief Call to apply the gate on the input array/matrix by U3*input
-@param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@brief Call to apply the gate on a list of input arrays/matrices by Gate*input. The inputs are placed side by side into a single matrix, so the gate is applied by one matrix product for all of them.
+@param input The list of the input arrays on which the gate is applied
 */
 void apply_to_list( std::vector<Matrix>& input );
 
@@ -102,6 +102,13 @@ void apply_to_list( std::vector<Matrix>& input );
 */
 virtual void apply_to( Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit. (Implemented by the gates acting on a single target qubit, optionally controlled by another qubit.)
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*Gate
@@ -109,6 +116,13 @@ virtual void apply_to( Matrix& input );
 */
 virtual void apply_from_right( Matrix& input );
 
+
+/**
+@brief Call to apply the inverse (i.e. the adjoint) of the gate on the input array/matrix by Gate^dagger*input
+@param input The input array on which the inverse of the gate is applied
+*/
+virtual void apply_inverse_to( Matrix& input );
+
 /**
 @brief Call to set the stored matrix in the operation.
 @param input The operation matrix to be stored. The matrix is stored by attribute matrix_alloc.
@@ -173,12 +187,68 @@ protected:
 /**
 @brief ???????????
 */
-void apply_kernel_to( Matrix& u3_1qbit, Matrix& input, bool deriv=false );
+void apply_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input, bool deriv=false );
+
+/**
+@brief Call to apply a 2x2 kernel on the given target qubit of the input array/matrix. (Used to apply the kernels of fused gates)
+@param u3_1qbit The 2x2 kernel to be applied
+@param input The input array on which the kernel is applied
+@param target_qbit_loc The index of the target qubit
+@param control_qbit_loc The index of the control qubit (-1 for no control)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>, false to leave them unchanged
+*/
+void apply_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input, int target_qbit_loc, int control_qbit_loc, bool deriv=false );
 
 /**
 @brief ???????????
 */
-void apply_kernel_from_right( Matrix& u3_1qbit, Matrix& input );
+void apply_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input );
+
+/**
+@brief Call to apply the adjoint of a 2x2 kernel on the input array/matrix. (Used to apply the inverse of the gates)
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input array on which the adjoint kernel is applied
+*/
+void apply_kernel_inverse_to( QGD_Kernel2x2& u3_1qbit, Matrix& input );
+
+/**
+@brief Call to apply a diagonal 2x2 kernel on the input array/matrix by rescaling the rows. (Used to apply the Z, CZ and RZ gates without the full complex 2x2 multiplication)
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>, false to leave them unchanged
+*/
+void apply_diagonal_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input, bool deriv=false );
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel on the input array/matrix by swapping the pairs of rows. (Used to apply the X, Y and CNOT gates without the full complex 2x2 multiplication)
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+*/
+void apply_antidiagonal_kernel_to( QGD_Kernel2x2& u3_1qbit, Matrix& input );
+
+/**
+@brief Call to apply a diagonal 2x2 kernel on the input array/matrix from the right by rescaling the columns.
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+*/
+void apply_diagonal_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input );
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel on the input array/matrix from the right by swapping the pairs of columns.
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input array on which the kernel is applied
+*/
+void apply_antidiagonal_kernel_from_right( QGD_Kernel2x2& u3_1qbit, Matrix& input );
+
+/**
+@brief Call to evaluate the real part of the overlap Tr( adjoint^dagger * K * input ) of a 2x2 kernel K applied on the input, without modifying the input and without storing the transformed matrix. (Used to contract the derivatives of the gates in the adjoint gradient)
+@param u3_1qbit The 2x2 kernel of the gate
+@param adjoint The matrix against which the transformed input is contracted
+@param input The input array/matrix on which the kernel would be applied
+@param deriv Set true to treat the rows where the control qubit is in state |0> as zero (derivative of a controlled gate), false to leave them as identity
+@return Returns with the real part of the overlap
+*/
+double get_kernel_overlap( QGD_Kernel2x2& u3_1qbit, Matrix& adjoint, Matrix& input, bool deriv=false );
 
 
 
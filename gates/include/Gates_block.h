@@ -25,6 +25,7 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #define GATES_BLOCK_H
 
 #include <vector>
+#include <atomic>
 #include "common.h"
 #include "matrix_real.h"
 #include "Gate.h"
@@ -34,6 +35,58 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 #endif
 
 
+/// @brief Type definition of the kinds of the instructions in a compiled gate tape (see Gates_block::compile_tape) and of the elements of a fused gate sequence
+typedef enum tape_kernel_type {TAPE_GATE, TAPE_KERNEL, TAPE_DIAGONAL_KERNEL, TAPE_ANTIDIAGONAL_KERNEL, TAPE_TWO_QUBIT_KERNEL} tape_kernel_type;
+
+
+/**
+@brief Structure representing an instruction of a compiled gate tape: a gate given by a (controlled) 2x2 kernel, or a gate applied by its own apply_to/apply_from_right methods (TAPE_GATE).
+*/
+struct Tape_Instruction {
+    /// The kind of the kernel of the gate
+    tape_kernel_type kernel_type;
+    /// The compiled gate
+    Gate* gate;
+    /// The index of the target qubit
+    int target_qbit;
+    /// The index of the control qubit (-1 for no control)
+    int control_qbit;
+    /// The offset of the parameters of the gate in the parameter array of the compiled gates
+    int parameter_idx;
+    /// The number of the free parameters of the gate
+    int parameter_num;
+    /// The index of the compiled gate in the gate list (gates of nested blocks inherit the index of the block)
+    int gate_idx;
+    /// The 2x2 kernel of a gate without free parameters (calculated at compilation)
+    QGD_Kernel2x2 kernel;
+};
+
+
+/**
+@brief Structure representing an element of the fused gate sequence of a Gates_block: either a 2x2 or 4x4 kernel of fused gates, the 2x2 kernel of a single gate, or a gate applied by its own apply_to method.
+*/
+struct Fused_Gate {
+    /// The kind of the element
+    tape_kernel_type kernel_type;
+    /// The gate applied by its own apply_to method (NULL for a kernel)
+    Gate* gate;
+    /// Pointer to the parameters of the gate applied by its own apply_to method
+    double* parameters;
+    /// The number of the parameters of the gate applied by its own apply_to method
+    int parameter_num;
+    /// The 2x2 kernel of a single gate or of the gates fused on a single qubit
+    QGD_Kernel2x2 kernel_1qbit;
+    /// The 4x4 kernel of the gates fused on two qubits
+    QGD_Kernel4x4 kernel;
+    /// The target qubit of a 2x2 kernel, or the inner (lower) qubit of a 4x4 kernel
+    int inner_qbit;
+    /// The outer (higher) qubit of a 4x4 kernel (-1 for a 2x2 kernel)
+    int outer_qbit;
+    /// The control qubit of a 2x2 kernel (-1 for no control)
+    int control_qbit;
+};
+
+
 /**
 @brief A class responsible for grouping two-qubit (CNOT,CZ,CH) and one-qubit gates into layers
 */
@@ -45,6 +98,14 @@ protected:
     std::vector<Gate*> gates;
     /// number of gate layers
     int layer_num;
+    /// The version of the stored gates, renewed at each modification (see invalidate_tape)
+    int64_t structure_version;
+    /// The compiled tape of the gates cached by get_tape
+    std::vector<Tape_Instruction> tape_cache;
+    /// The structure version (see get_structure_version) of the gates at the compilation of the cached tape (-1 if no tape was compiled)
+    std::atomic<int64_t> tape_version;
+    /// mutual exclusion to compile the cached tape only once when the gates are applied concurrently
+    tbb::spin_mutex tape_mutex;
 
 public:
 
@@ -59,6 +120,19 @@ Gates_block();
 */
 Gates_block(int qbit_num_in);
 
+/**
+@brief Copy constructor of the class. The cached tape is not copied, it is compiled again for the copy when needed.
+@param block The gate block to be copied
+*/
+Gates_block(const Gates_block& block);
+
+/**
+@brief Assignment operator of the class. The cached tape is not copied, it is compiled again when needed.
+@param block The gate block to be copied
+@return Returns with the instance of the class.
+*/
+Gates_block& operator=(const Gates_block& block);
+
 
 /**
 @brief Destructor of the class.
@@ -84,20 +158,129 @@ Matrix get_matrix( Matrix_real& parameters );
 
 
 /**
-@brief Call to apply the gate on the input array/matrix by U3*input
-@param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@brief Call to apply the gates on a list of input arrays/matrices by Gates_block*input. The gates are fused once for all the inputs (see apply_fused_gates_to_list).
+@param parameters An array of parameters to calculate the matrices of the gates.
+@param input The list of the input arrays on which the gates are applied
 */
 void apply_to_list( Matrix_real& parameters, std::vector<Matrix> input );
 
 /**
-@brief Call to apply the gate on the input array/matrix Gates_block*input
+@brief Call to apply the gate on the input array/matrix Gates_block*input. Consecutive gates acting on the same one or two qubits are fused into a single 2x2 or 4x4 kernel before they are applied on the input.
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
 @param input The input array on which the gate is applied
 */
 void apply_to( Matrix_real& parameters_mtx, Matrix& input );
 
 
+
+/**
+@brief Call to compile the gates into a linear tape of instructions. (The compilation depends only on the structure of the gates, so the tape can be applied with any parameter vector by apply_tape_to and apply_tape_from_right.)
+@return Returns with the instructions in the order of their application on the input (the last gate first).
+*/
+std::vector<Tape_Instruction> compile_tape();
+
+/**
+@brief Call to get the compiled tape of the gates. The tape is compiled by compile_tape at the first call and cached until the gates are modified (see invalidate_tape).
+@return Returns with a reference to the cached tape.
+*/
+std::vector<Tape_Instruction>& get_tape();
+
+/**
+@brief Call to invalidate the cached tape of the gates. It should be called after any modification of the stored gates.
+*/
+void invalidate_tape();
+
+/**
+@brief Call to get the structure version of the gates: the latest version of the gate block and of the nested gate blocks. (It changes whenever the block or any nested block is modified, so the cached tape of the outer block is recompiled as well.)
+@return Returns with the structure version.
+*/
+int64_t get_structure_version();
+
+/**
+@brief Call to compile a sequence of gates into a linear tape of instructions in the order of their application on the input (the last gate first). Nested gate blocks are flattened into the tape.
+@param gates_it An iterator pointing to the first gate.
+@param num_of_gates The number of gates to be compiled
+@param parameter_idx The offset of the parameters of the first gate in the parameter array
+@param tape The tape to which the instructions are appended
+@param gate_idx The gate index recorded in the instructions (-1 to record the index of the gates in the sequence)
+*/
+void compile_tape( std::vector<Gate*>::iterator gates_it, int num_of_gates, int parameter_idx, std::vector<Tape_Instruction>& tape, int gate_idx=-1 );
+
+/**
+@brief Call to apply a range of instructions of a compiled tape on the input array/matrix in the order of the tape.
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be applied
+@param tape_end The index after the last instruction to be applied
+@param parameters The parameter array of the compiled gates
+@param input The input array on which the instructions are applied
+*/
+void apply_tape_to( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, Matrix& input );
+
+/**
+@brief Call to apply a range of instructions of a compiled tape on a list of input arrays/matrices. The instructions are fused once for all the inputs (see apply_fused_gates_to_list).
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be applied
+@param tape_end The index after the last instruction to be applied
+@param parameters The parameter array of the compiled gates
+@param input The list of the input arrays on which the instructions are applied
+*/
+void apply_tape_to_list( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, std::vector<Matrix>& input );
+
+/**
+@brief Call to apply a range of instructions of a compiled tape from the right on the input array/matrix. (The instructions are applied in reversed order of the tape.)
+@param tape The compiled tape
+@param tape_start The index of the first instruction in the range
+@param tape_end The index after the last instruction in the range
+@param parameters The parameter array of the compiled gates
+@param input The input array on which the instructions are applied
+*/
+void apply_tape_from_right( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters, Matrix& input );
+
+/**
+@brief Call to fuse the consecutive gates acting on the same one or two qubits into 2x2 or 4x4 kernels for the given parameters. (The fusion is done once per parameter vector, and the resulting sequence can be applied on any number of inputs by apply_fused_gates_to.)
+@param parameters_mtx An array of parameters of the gates.
+@return Returns with the list of the fused gates in the order of their application.
+*/
+std::vector<Fused_Gate> get_fused_gates( Matrix_real& parameters_mtx );
+
+/**
+@brief Call to fuse the consecutive instructions in a range of a compiled tape into 2x2 or 4x4 kernels for the given parameters.
+@param tape The compiled tape
+@param tape_start The index of the first instruction to be fused
+@param tape_end The index after the last instruction to be fused
+@param parameters The parameter array of the compiled gates
+@return Returns with the list of the fused gates in the order of their application.
+*/
+std::vector<Fused_Gate> get_fused_gates( std::vector<Tape_Instruction>& tape, int tape_start, int tape_end, double* parameters );
+
+/**
+@brief Call to fuse a run of compiled instructions acting on at most two qubits into a single 2x2 (one qubit) or 4x4 (two qubits) kernel. If the fused kernel would be more expensive to apply than the individual gates, the kernels of the gates are added without fusion.
+@param tape The compiled tape
+@param run_start The index of the first instruction of the run
+@param run_end The index after the last instruction of the run
+@param run_qbits The qubits on which the instructions of the run act
+@param run_qbit_num The number of the qubits in run_qbits
+@param parameters The parameter array of the compiled gates
+@param parameters_loc A view of the parameter array used to evaluate the kernels of the gates
+@param fused_gates The list of the fused gates to which the result is appended
+*/
+void fuse_gates( std::vector<Tape_Instruction>& tape, int run_start, int run_end, int* run_qbits, int run_qbit_num, double* parameters, Matrix_real& parameters_loc, std::vector<Fused_Gate>& fused_gates );
+
+/**
+@brief Call to apply a sequence of fused gates (obtained by get_fused_gates) on the input array/matrix.
+@param fused_gates The list of the fused gates in the order of their application
+@param input The input array on which the gates are applied
+*/
+void apply_fused_gates_to( std::vector<Fused_Gate>& fused_gates, Matrix& input );
+
+/**
+@brief Call to apply a sequence of fused gates (obtained by get_fused_gates) on a list of input arrays/matrices. The kernels are calculated once for all the inputs, and the inputs are transformed in parallel when the individual kernels are too small to be parallelized over the rows.
+@param fused_gates The list of the fused gates in the order of their application
+@param input The list of the input arrays on which the gates are applied
+*/
+void apply_fused_gates_to_list( std::vector<Fused_Gate>& fused_gates, std::vector<Matrix>& input );
+
+
 /**
 @brief Call to apply the gate on the input array/matrix by input*CNOT
 @param input The input array on which the gate is applied
@@ -111,6 +294,34 @@ void apply_from_right( Matrix_real& parameters_mtx, Matrix& input );
 std::vector<Matrix> apply_derivate_to( Matrix_real& parameters_mtx, Matrix& input );
 
 
+/**
+@brief Call to apply the inverse of the gates on the input array/matrix by Gates_block^dagger*input
+@param parameters_mtx An array of parameters to calculate the matrices of the gates.
+@param input The input array on which the inverse of the gates is applied
+*/
+void apply_inverse_to( Matrix_real& parameters_mtx, Matrix& input );
+
+
+/**
+@brief Call to calculate the gradient components of the real functional Re Tr(seed^dagger * Gates_block*input) in reverse (adjoint) mode with O(number of gates) gate applications.
+@param parameters_mtx An array of parameters of the gates.
+@param transformed The matrix Gates_block*input. On exit the matrix is transformed back into input.
+@param adjoint The seed matrix. On exit the matrix is transformed into Gates_block^dagger*seed.
+@param grad Preallocated array of parameter_num elements to store the calculated gradient components.
+*/
+void apply_adjoint_derivate_to( Matrix_real& parameters_mtx, Matrix& transformed, Matrix& adjoint, Matrix_real& grad );
+
+/**
+@brief Call to calculate the traces Tr(Gates_block*input) and their derivatives with respect to the parameters of the gates for a batch of problems in lockstep. The problems share the gates, but each of them has its own input matrix and parameters, and they are stored in the lanes of a structure of arrays batch (see apply_kernel_to_batched_input.h). The derivatives are obtained by sweeping the batch back through the gates once (in adjoint mode).
+@param parameters The parameters of the problems. (The parameters of the lane_idx-th problem are stored in the lane_idx-th row.)
+@param input The batch of the input matrices. The batch is overwritten during the calculation.
+@param traces Preallocated array of lane_num elements to store the traces of the problems.
+@param trace_derivatives Preallocated matrix of lane_num rows and parameter_num columns to store the derivatives of the traces of the problems.
+*/
+void get_trace_derivatives_batched( Matrix_real& parameters, Matrix_real& input, Matrix& traces, Matrix& trace_derivatives );
+
+
+
 
 
 /**
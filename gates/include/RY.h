@@ -74,6 +74,13 @@ virtual ~RY();
 */
 virtual void apply_to( Matrix_real& parameters, Matrix& input, const double scale=1.0 );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
@@ -82,11 +89,26 @@ virtual void apply_to( Matrix_real& parameters, Matrix& input, const double scal
 */
 virtual void apply_from_right( Matrix_real& parameters, Matrix& input );
 
+
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by RY^dagger*input
+@param parameters An array of parameters to calculate the matrix of the RY gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+virtual void apply_inverse_to( Matrix_real& parameters, Matrix& input );
+
 /**
 @brief ???????????????
 */
 virtual std::vector<Matrix> apply_derivate_to( Matrix_real& parameters, Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+virtual std::vector<QGD_Kernel2x2> calc_derivate_kernels( Matrix_real& parameters );
+
 /**
 @brief Call to set the final optimized parameters of the gate.
 @param Theta Real parameter standing for the parameter theta.
@@ -76,6 +76,13 @@ Matrix get_matrix( );
 */
 void apply_to( Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate. (The gate has no free parameters, the array is not used.)
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief Call to apply the gate on the input array/matrix by input*U3
@@ -85,6 +92,13 @@ void apply_to( Matrix& input );
 void apply_from_right( Matrix& input );
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by SX^dagger*input
+@param input The input array on which the inverse of the gate is applied
+*/
+void apply_inverse_to( Matrix& input );
+
+
 /**
 @brief Call to create a clone of the present class
 @return Return with a pointer pointing to the cloned object
@@ -85,9 +85,9 @@ U3(int qbit_num_in, int target_qbit_in, bool theta_in, bool phi_in, bool lambda_
 Matrix get_matrix( Matrix_real& parameters );
 
 /**
-@brief Call to apply the gate on the input array/matrix by U3*input
+@brief Call to apply the gate on a list of input arrays/matrices by U3*input. The kernel of the gate is calculated once, and the inputs are transformed in parallel.
 @param parameters An array of parameters to calculate the matrix of the U3 gate.
-@param input The input array on which the gate is applied
+@param input The list of the input arrays on which the gate is applied
 */
 void apply_to_list( Matrix_real& parameters, std::vector<Matrix>& input );
 
@@ -99,12 +99,35 @@ void apply_to_list( Matrix_real& parameters, std::vector<Matrix>& input );
 */
 virtual void apply_to( Matrix_real& parameters, Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernel of the gate acting on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the 2x2 kernel of the gate
+*/
+virtual QGD_Kernel2x2 calc_kernel( Matrix_real& parameters );
+
 
 /**
 @brief ???????????????
 */
 virtual std::vector<Matrix> apply_derivate_to( Matrix_real& parameters, Matrix& input );
 
+/**
+@brief Call to calculate the 2x2 kernels of the derivatives of the gate with respect to its free parameters. The derivative of the gate with respect to the i-th parameter is given by applying the i-th kernel on the target qubit.
+@param parameters An array of the free parameters of the gate.
+@return Returns with the list of the 2x2 derivative kernels (one for each free parameter)
+*/
+virtual std::vector<QGD_Kernel2x2> calc_derivate_kernels( Matrix_real& parameters );
+
+/**
+@brief Call to evaluate the gradient components Re Tr( adjoint^dagger * dU/dp_i * input ) of the gate with respect to its free parameters without allocating the derivative matrices.
+@param parameters An array of the free parameters of the gate.
+@param adjoint The adjoint matrix against which the derivatives are contracted
+@param input The input array/matrix on which the derivatives of the gate would be applied
+@param grad Pointer to the gradient components to be filled up (one for each free parameter)
+*/
+void apply_derivate_overlap_to( Matrix_real& parameters, Matrix& adjoint, Matrix& input, double* grad );
+
 
 
 /**
@@ -115,6 +138,14 @@ virtual std::vector<Matrix> apply_derivate_to( Matrix_real& parameters, Matrix&
 virtual void apply_from_right( Matrix_real& parameters, Matrix& input );
 
 
+/**
+@brief Call to apply the inverse of the gate on the input array/matrix by U3^dagger*input
+@param parameters An array of parameters to calculate the matrix of the U3 gate.
+@param input The input array on which the inverse of the gate is applied
+*/
+virtual void apply_inverse_to( Matrix_real& parameters, Matrix& input );
+
+
 
 /**
 @brief Call to set the number of qubits spanning the matrix of the gate
@@ -157,7 +188,7 @@ bool is_lambda_parameter();
 @param Lambda Real parameter standing for the parameter lambda.
 @return Returns with the matrix of the one-qubit matrix.
 */
-Matrix calc_one_qubit_u3(double Theta, double Phi, double Lambda );
+QGD_Kernel2x2 calc_one_qubit_u3(double Theta, double Phi, double Lambda );
 
 
 /**
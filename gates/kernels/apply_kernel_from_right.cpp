@@ -0,0 +1,109 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_from_right.cpp
+    \brief Kernel to apply single qubit gate kernel on an input matrix from the right (input*K), dispatching to the instruction set chosen at runtime
+*/
+
+
+#include "apply_kernel_from_right.h"
+#include "kernel_variant.h"
+#include "kernel_indexing.h"
+
+
+/**
+@brief Call to apply single qubit gate kernel on an input matrix from the right (input*K) using the kernel variant returned by get_kernel_variant.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void
+apply_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit) {
+
+#ifdef USE_AVX
+    // the AVX2 kernel is used by the AVX-512 variant as well
+    if ( get_kernel_variant() >= AVX2_KERNEL ) {
+        apply_kernel_from_right_AVX(u3_1qbit, input, target_qbit, control_qbit);
+        return;
+    }
+#endif
+
+    apply_kernel_from_right_scalar(u3_1qbit, input, target_qbit, control_qbit);
+
+}
+
+
+/**
+@brief Scalar kernel to apply single qubit gate kernel on an input matrix from the right (input*K). The matrix is traversed row by row, so the pairs of columns are read from contiguous memory.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void
+apply_kernel_from_right_scalar(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit) {
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the column pairs where the control qubit is in state |1> are enumerated, in blocks of adjacent columns
+    int pair_num = get_pair_num(input.cols, control_qbit);
+    int block_size = get_pair_block_size(target_qbit, control_qbit);
+
+    kernel_parallel_for( input.rows, input.cols, [&](tbb::blocked_range<int> r) {
+
+        QGD_Complex16 u00 = u3_1qbit[0];
+        QGD_Complex16 u01 = u3_1qbit[1];
+        QGD_Complex16 u10 = u3_1qbit[2];
+        QGD_Complex16 u11 = u3_1qbit[3];
+
+        for (int row_idx=r.begin(); row_idx<r.end(); row_idx++) {
+
+            QGD_Complex16* row = input.get_data() + row_idx*input.stride;
+
+            for (int pair_idx=0; pair_idx<pair_num; pair_idx=pair_idx+block_size) {
+
+                QGD_Complex16* element_block = row + get_pair_row_index(pair_idx, target_qbit, control_qbit);
+                QGD_Complex16* element_pair_block = element_block + index_step_target;
+
+                for (int idx=0; idx<block_size; idx++) {
+
+                    QGD_Complex16& element      = element_block[idx];
+                    QGD_Complex16& element_pair = element_pair_block[idx];
+
+                    // the columns of the kernel applied on the pair of elements (the complex products are inlined to let the compiler vectorize the loop)
+                    double res_real      = element.real*u00.real - element.imag*u00.imag + element_pair.real*u10.real - element_pair.imag*u10.imag;
+                    double res_imag      = element.real*u00.imag + element.imag*u00.real + element_pair.real*u10.imag + element_pair.imag*u10.real;
+                    double res_pair_real = element.real*u01.real - element.imag*u01.imag + element_pair.real*u11.real - element_pair.imag*u11.imag;
+                    double res_pair_imag = element.real*u01.imag + element.imag*u01.real + element_pair.real*u11.imag + element_pair.imag*u11.real;
+
+                    element.real      = res_real;
+                    element.imag      = res_imag;
+                    element_pair.real = res_pair_real;
+                    element_pair.imag = res_pair_imag;
+
+                }
+
+            }
+
+        }
+
+    });
+
+}
@@ -0,0 +1,172 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_from_right_AVX.cpp
+    \brief AVX2 kernel to apply single qubit gate kernel on an input matrix from the right (input*K)
+*/
+
+
+#include "apply_kernel_from_right.h"
+#include "kernel_indexing.h"
+#include "kernel_variant.h"
+#include "complex_AVX.h"
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on an input matrix from the right (input*K) (using FMA instructions). The matrix is traversed by pairs of rows, the column pairs are loaded from contiguous memory two elements at a time.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void QGD_TARGET_AVX2
+apply_kernel_from_right_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit) {
+
+    int index_step_target = 1 << target_qbit;
+
+    if ( target_qbit == 0 ) {
+
+        // the two elements of a column pair are adjacent in memory, so a pair fits into one 256bit register.
+        // The transformed pairs form contiguous runs of columns: the whole row, or the blocks of columns where the control qubit is in state |1>
+        int run_length = control_qbit < 0 ? input.cols : 1 << control_qbit;
+        int run_step = 2*run_length;
+        int run_start = control_qbit < 0 ? 0 : run_length;
+
+        kernel_parallel_for( input.rows, input.cols, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX2 {
+
+            // new[c] = u00*e[c] + u10*e[c+1] and new[c+1] = u01*e[c] + u11*e[c+1], so the kernel is split into the lane-wise parts
+            // [u00, u11] multiplying the pair and [u10, u01] multiplying the swapped pair
+            __m256d u3_diag_r_vec = _mm256_set_pd(u3_1qbit[3].real, u3_1qbit[3].real, u3_1qbit[0].real, u3_1qbit[0].real);
+            __m256d u3_diag_i_vec = _mm256_set_pd(u3_1qbit[3].imag, u3_1qbit[3].imag, u3_1qbit[0].imag, u3_1qbit[0].imag);
+            __m256d u3_offdiag_r_vec = _mm256_set_pd(u3_1qbit[1].real, u3_1qbit[1].real, u3_1qbit[2].real, u3_1qbit[2].real);
+            __m256d u3_offdiag_i_vec = _mm256_set_pd(u3_1qbit[1].imag, u3_1qbit[1].imag, u3_1qbit[2].imag, u3_1qbit[2].imag);
+
+            // two rows are transformed in one sweep over the columns to keep more memory streams in flight
+            for (int row_idx=r.begin(); row_idx<r.end(); row_idx=row_idx+2) {
+
+                double* row = (double*)(input.get_data() + row_idx*input.stride);
+                // the second row is the same as the first one if the number of rows is odd (then it is not stored twice)
+                double* row2 = row_idx+1 < r.end() ? row + 2*input.stride : row;
+                bool two_rows = row2 != row;
+
+                for (int run_idx=run_start; run_idx<input.cols; run_idx=run_idx+run_step) {
+
+                    for (int col_idx=2*run_idx; col_idx<2*(run_idx+run_length); col_idx=col_idx+4) {
+
+                        __m256d element_vec = _mm256_loadu_pd(row + col_idx);
+                        __m256d element2_vec = _mm256_loadu_pd(row2 + col_idx);
+                        __m256d element_swapped_vec = _mm256_permute2f128_pd(element_vec, element_vec, 1);
+                        __m256d element2_swapped_vec = _mm256_permute2f128_pd(element2_vec, element2_vec, 1);
+
+                        __m256d res_vec = complex_combination_AVX(u3_diag_r_vec, u3_diag_i_vec, element_vec, u3_offdiag_r_vec, u3_offdiag_i_vec, element_swapped_vec);
+                        __m256d res2_vec = complex_combination_AVX(u3_diag_r_vec, u3_diag_i_vec, element2_vec, u3_offdiag_r_vec, u3_offdiag_i_vec, element2_swapped_vec);
+
+                        _mm256_storeu_pd(row + col_idx, res_vec);
+
+                        if ( two_rows ) {
+                            _mm256_storeu_pd(row2 + col_idx, res2_vec);
+                        }
+
+                    }
+
+                }
+
+            }
+
+        });
+
+        return;
+
+    }
+
+
+    // For target_qbit > 0 the column pairs come in blocks of adjacent columns (of even size), two successive column pairs
+    // (c, c+step) and (c+1, c+1+step) are transformed in one step.
+    // When the control qubit is 0, the columns c and c+1 differ in the control bit, hence all the column pairs are transformed
+    // and the results are kept only in the upper lanes (control qubit in state |1>).
+    int control_loc = control_qbit == 0 ? -1 : control_qbit;
+    int block_size = get_pair_block_size(target_qbit, control_loc);
+    int control_bits = control_loc < 0 ? 0 : 1 << control_loc;
+    int fixed_bits = index_step_target | control_bits;
+    bool blend = control_qbit == 0;
+
+    kernel_parallel_for( input.rows, input.cols, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX2 {
+
+        // load elements of the U3 unitary into 256bit registers (8 registers)
+        __m256d u3_1bit_00r_vec = _mm256_broadcast_sd(&u3_1qbit[0].real);
+        __m256d u3_1bit_00i_vec = _mm256_broadcast_sd(&u3_1qbit[0].imag);
+        __m256d u3_1bit_01r_vec = _mm256_broadcast_sd(&u3_1qbit[1].real);
+        __m256d u3_1bit_01i_vec = _mm256_broadcast_sd(&u3_1qbit[1].imag);
+        __m256d u3_1bit_10r_vec = _mm256_broadcast_sd(&u3_1qbit[2].real);
+        __m256d u3_1bit_10i_vec = _mm256_broadcast_sd(&u3_1qbit[2].imag);
+        __m256d u3_1bit_11r_vec = _mm256_broadcast_sd(&u3_1qbit[3].real);
+        __m256d u3_1bit_11i_vec = _mm256_broadcast_sd(&u3_1qbit[3].imag);
+
+        // two rows are transformed in one sweep over the columns to keep more memory streams in flight
+        for (int row_idx=r.begin(); row_idx<r.end(); row_idx=row_idx+2) {
+
+            double* row = (double*)(input.get_data() + row_idx*input.stride);
+            // the second row is the same as the first one if the number of rows is odd (then it is not stored twice)
+            double* row2 = row_idx+1 < r.end() ? row + 2*input.stride : row;
+            bool two_rows = row2 != row;
+
+            // the blocks are enumerated by incrementing the column index over the bits other than the target and control bits
+            // (cheaper than calling get_pair_row_index for short blocks)
+            for (int col_idx=control_bits; col_idx<input.cols; col_idx=(((col_idx | fixed_bits) + block_size) & ~fixed_bits) | control_bits) {
+
+                int col_offset = 2*col_idx;
+                int col_offset_pair = col_offset + 2*index_step_target;
+
+                for (int idx=0; idx<2*block_size; idx=idx+4) {
+
+                    __m256d element_vec = _mm256_loadu_pd(row + col_offset + idx);
+                    __m256d element_pair_vec = _mm256_loadu_pd(row + col_offset_pair + idx);
+                    __m256d element2_vec = _mm256_loadu_pd(row2 + col_offset + idx);
+                    __m256d element2_pair_vec = _mm256_loadu_pd(row2 + col_offset_pair + idx);
+
+                    // new[c] = u00*e[c] + u10*e[c+step], new[c+step] = u01*e[c] + u11*e[c+step]
+                    __m256d res_vec = complex_combination_AVX(u3_1bit_00r_vec, u3_1bit_00i_vec, element_vec, u3_1bit_10r_vec, u3_1bit_10i_vec, element_pair_vec);
+                    __m256d res_pair_vec = complex_combination_AVX(u3_1bit_01r_vec, u3_1bit_01i_vec, element_vec, u3_1bit_11r_vec, u3_1bit_11i_vec, element_pair_vec);
+                    __m256d res2_vec = complex_combination_AVX(u3_1bit_00r_vec, u3_1bit_00i_vec, element2_vec, u3_1bit_10r_vec, u3_1bit_10i_vec, element2_pair_vec);
+                    __m256d res2_pair_vec = complex_combination_AVX(u3_1bit_01r_vec, u3_1bit_01i_vec, element2_vec, u3_1bit_11r_vec, u3_1bit_11i_vec, element2_pair_vec);
+
+                    if ( blend ) {
+                        res_vec = _mm256_blend_pd(element_vec, res_vec, 0xC);
+                        res_pair_vec = _mm256_blend_pd(element_pair_vec, res_pair_vec, 0xC);
+                        res2_vec = _mm256_blend_pd(element2_vec, res2_vec, 0xC);
+                        res2_pair_vec = _mm256_blend_pd(element2_pair_vec, res2_pair_vec, 0xC);
+                    }
+
+                    _mm256_storeu_pd(row + col_offset + idx, res_vec);
+                    _mm256_storeu_pd(row + col_offset_pair + idx, res_pair_vec);
+
+                    if ( two_rows ) {
+                        _mm256_storeu_pd(row2 + col_offset + idx, res2_vec);
+                        _mm256_storeu_pd(row2 + col_offset_pair + idx, res2_pair_vec);
+                    }
+
+                }
+
+            }
+
+        }
+
+    });
+
+}
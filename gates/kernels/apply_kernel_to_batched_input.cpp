@@ -0,0 +1,188 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_batched_input.cpp
+    \brief Kernels to apply single qubit gate kernels on a batch of matrices stored in structure of arrays layout, dispatching to the instruction set chosen at runtime
+*/
+
+
+#include "apply_kernel_to_batched_input.h"
+#include "kernel_variant.h"
+#include "kernel_indexing.h"
+
+
+/**
+@brief Call to transform a pair of elements of the matrices in all the lanes: new = a*element + b*element_pair and new_pair = c*element + d*element_pair.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param a_idx The index (0-3) of the kernel element a
+@param b_idx The index (0-3) of the kernel element b
+@param c_idx The index (0-3) of the kernel element c
+@param d_idx The index (0-3) of the kernel element d
+@param element The row of the real parts of the element in the batch (the imaginary parts are stored in the next row)
+@param element_pair The row of the real parts of the pair element in the batch (the imaginary parts are stored in the next row)
+@param stride The row stride of the batch
+*/
+static inline void
+transform_element_pair_lanes( Matrix_real& u3_1qbit, const int a_idx, const int b_idx, const int c_idx, const int d_idx, double* element, double* element_pair, const int stride ) {
+
+    const double* a_r = u3_1qbit.get_data() + (2*a_idx)*u3_1qbit.stride;
+    const double* a_i = a_r + u3_1qbit.stride;
+    const double* b_r = u3_1qbit.get_data() + (2*b_idx)*u3_1qbit.stride;
+    const double* b_i = b_r + u3_1qbit.stride;
+    const double* c_r = u3_1qbit.get_data() + (2*c_idx)*u3_1qbit.stride;
+    const double* c_i = c_r + u3_1qbit.stride;
+    const double* d_r = u3_1qbit.get_data() + (2*d_idx)*u3_1qbit.stride;
+    const double* d_i = d_r + u3_1qbit.stride;
+
+    double* element_real = element;
+    double* element_imag = element + stride;
+    double* element_pair_real = element_pair;
+    double* element_pair_imag = element_pair + stride;
+
+    for (int lane_idx=0; lane_idx<u3_1qbit.cols; lane_idx++) {
+
+        double e_r = element_real[lane_idx];
+        double e_i = element_imag[lane_idx];
+        double p_r = element_pair_real[lane_idx];
+        double p_i = element_pair_imag[lane_idx];
+
+        element_real[lane_idx]      = a_r[lane_idx]*e_r - a_i[lane_idx]*e_i + b_r[lane_idx]*p_r - b_i[lane_idx]*p_i;
+        element_imag[lane_idx]      = a_r[lane_idx]*e_i + a_i[lane_idx]*e_r + b_r[lane_idx]*p_i + b_i[lane_idx]*p_r;
+        element_pair_real[lane_idx] = c_r[lane_idx]*e_r - c_i[lane_idx]*e_i + d_r[lane_idx]*p_r - d_i[lane_idx]*p_i;
+        element_pair_imag[lane_idx] = c_r[lane_idx]*e_i + c_i[lane_idx]*e_r + d_r[lane_idx]*p_i + d_i[lane_idx]*p_r;
+
+    }
+
+}
+
+
+/**
+@brief Call to apply the single qubit gate kernels of the lanes on a batch of matrices (K*input for each lane) using the kernel variant returned by get_kernel_variant. The batches are small, so the kernel is executed serially (the batches are processed in parallel by the caller).
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void
+apply_kernel_to_batched_input(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+#ifdef USE_AVX
+    // the AVX2 kernel is used by the AVX-512 variant as well
+    if ( get_kernel_variant() >= AVX2_KERNEL ) {
+        apply_kernel_to_batched_input_AVX(u3_1qbit, input, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+    apply_kernel_to_batched_input_scalar(u3_1qbit, input, target_qbit, control_qbit, matrix_size);
+
+}
+
+
+/**
+@brief Scalar kernel to apply the single qubit gate kernels of the lanes on a batch of matrices (K*input for each lane). The loops over the lanes are innermost, so the compiler can vectorize them.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void
+apply_kernel_to_batched_input_scalar(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int index_step_target = 1 << target_qbit;
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+        int row_idx = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+        int row_pair_idx = row_idx + index_step_target;
+
+        for (int col_idx=0; col_idx<matrix_size; col_idx++) {
+
+            double* element = input.get_data() + 2*(row_idx*matrix_size + col_idx)*input.stride;
+            double* element_pair = input.get_data() + 2*(row_pair_idx*matrix_size + col_idx)*input.stride;
+
+            // new = u00*element + u01*element_pair and new_pair = u10*element + u11*element_pair
+            transform_element_pair_lanes( u3_1qbit, 0, 1, 2, 3, element, element_pair, input.stride );
+
+        }
+
+    }
+
+}
+
+
+/**
+@brief Call to apply the single qubit gate kernels of the lanes on a batch of matrices from the right (input*K for each lane) using the kernel variant returned by get_kernel_variant. The batches are small, so the kernel is executed serially (the batches are processed in parallel by the caller).
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void
+apply_kernel_from_right_to_batched_input(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+#ifdef USE_AVX
+    // the AVX2 kernel is used by the AVX-512 variant as well
+    if ( get_kernel_variant() >= AVX2_KERNEL ) {
+        apply_kernel_from_right_to_batched_input_AVX(u3_1qbit, input, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+    apply_kernel_from_right_to_batched_input_scalar(u3_1qbit, input, target_qbit, control_qbit, matrix_size);
+
+}
+
+
+/**
+@brief Scalar kernel to apply the single qubit gate kernels of the lanes on a batch of matrices from the right (input*K for each lane). The loops over the lanes are innermost, so the compiler can vectorize them.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void
+apply_kernel_from_right_to_batched_input_scalar(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int index_step_target = 1 << target_qbit;
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    for (int row_idx=0; row_idx<matrix_size; row_idx++) {
+
+        for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+            int col_idx = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int col_pair_idx = col_idx + index_step_target;
+
+            double* element = input.get_data() + 2*(row_idx*matrix_size + col_idx)*input.stride;
+            double* element_pair = input.get_data() + 2*(row_idx*matrix_size + col_pair_idx)*input.stride;
+
+            // new = u00*element + u10*element_pair and new_pair = u01*element + u11*element_pair
+            transform_element_pair_lanes( u3_1qbit, 0, 2, 1, 3, element, element_pair, input.stride );
+
+        }
+
+    }
+
+}
@@ -0,0 +1,151 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_input.cpp
+    \brief Kernel to apply single qubit gate kernel on an input matrix, dispatching to the instruction set chosen at runtime
+*/
+
+
+#include "apply_kernel_to_input.h"
+#include "apply_kernel_to_state_vector_input.h"
+#include "kernel_variant.h"
+#include "kernel_indexing.h"
+
+#ifdef USE_AVX
+#include "apply_kernel_to_input_AVX.h"
+#include "apply_kernel_to_small_input.h"
+#endif
+
+#ifdef USE_AVX512F
+#include "apply_kernel_to_input_AVX512.h"
+#endif
+
+
+/**
+@brief Call to apply single qubit gate kernel on an input matrix using the kernel variant returned by get_kernel_variant.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_kernel_to_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    // the kernels below are vectorized across the columns, a state vector is transformed by the kernels vectorized across the amplitude pairs
+    if ( input.cols == 1 ) {
+        apply_kernel_to_state_vector_input(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+
+    kernel_variant_type variant = get_kernel_variant();
+
+#ifdef USE_AVX
+    // the unitaries of few qubits are transformed by kernels specialized for the qubit count and for the target and control qubits
+    if ( variant >= AVX2_KERNEL && is_small_kernel_input(input, matrix_size) ) {
+        apply_kernel_to_small_input_AVX(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+#ifdef USE_AVX512F
+    // the AVX-512 kernel processes eight columns in one step
+    if ( variant == AVX512_KERNEL && input.cols >= 8 ) {
+        apply_kernel_to_input_AVX512(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+#ifdef USE_AVX
+    if ( variant == AVX_KERNEL || ( variant >= AVX2_KERNEL && matrix_size < 16 ) ) {
+        apply_kernel_to_input_AVX_small(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+    else if ( variant >= AVX2_KERNEL ) {
+        apply_kernel_to_input_AVX(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+    apply_kernel_to_input_scalar(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+
+}
+
+
+/**
+@brief Scalar kernel to apply single qubit gate kernel on an input matrix
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_kernel_to_input_scalar(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the row pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    kernel_parallel_for( pair_num, 2*input.cols, [&](tbb::blocked_range<int> r) {
+
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int current_idx_pair_loc = current_idx_loc | index_step_target;
+
+            int row_offset = current_idx_loc*input.stride;
+            int row_offset_pair = current_idx_pair_loc*input.stride;
+
+            for ( int col_idx=0; col_idx<input.cols; col_idx++) {
+   			
+                int index      = row_offset+col_idx;
+                int index_pair = row_offset_pair+col_idx;                
+
+                QGD_Complex16 element      = input[index];
+                QGD_Complex16 element_pair = input[index_pair];              
+
+                QGD_Complex16 tmp1 = mult(u3_1qbit[0], element);
+                QGD_Complex16 tmp2 = mult(u3_1qbit[1], element_pair);
+ 
+                input[index].real = tmp1.real + tmp2.real;
+                input[index].imag = tmp1.imag + tmp2.imag;
+
+                tmp1 = mult(u3_1qbit[2], element);
+                tmp2 = mult(u3_1qbit[3], element_pair);
+
+                input[index_pair].real = tmp1.real + tmp2.real;
+                input[index_pair].imag = tmp1.imag + tmp2.imag;
+
+            }
+
+        }
+
+    });
+
+
+    if ( deriv && control_qbit >= 0 ) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_rows(input, control_qbit, matrix_size);
+    }
+
+}
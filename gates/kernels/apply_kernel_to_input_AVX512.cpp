@@ -0,0 +1,154 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_input_AVX512.cpp
+    \brief AVX-512 kernel to apply single qubit gate kernel on an input matrix
+*/
+
+
+#include "apply_kernel_to_input_AVX512.h"
+#include "kernel_indexing.h"
+#include "kernel_variant.h"
+#include <immintrin.h>
+
+
+/**
+@brief AVX-512 kernel to apply single qubit gate kernel on an input matrix
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void QGD_TARGET_AVX512
+apply_kernel_to_input_AVX512(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+
+    int index_step_target = 1 << target_qbit;
+
+
+    // only the row pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    kernel_parallel_for( pair_num, 2*input.cols, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX512 {
+
+        // load elements of the U3 unitary into 512bit registers (8 registers)
+        __m512d u3_1bit_00r_vec = _mm512_set1_pd(u3_1qbit[0].real);
+        __m512d u3_1bit_00i_vec = _mm512_set1_pd(u3_1qbit[0].imag);
+        __m512d u3_1bit_01r_vec = _mm512_set1_pd(u3_1qbit[1].real);
+        __m512d u3_1bit_01i_vec = _mm512_set1_pd(u3_1qbit[1].imag);
+        __m512d u3_1bit_10r_vec = _mm512_set1_pd(u3_1qbit[2].real);
+        __m512d u3_1bit_10i_vec = _mm512_set1_pd(u3_1qbit[2].imag);
+        __m512d u3_1bit_11r_vec = _mm512_set1_pd(u3_1qbit[3].real);
+        __m512d u3_1bit_11i_vec = _mm512_set1_pd(u3_1qbit[3].imag);
+
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int current_idx_pair_loc = current_idx_loc | index_step_target;
+
+            int row_offset = current_idx_loc * input.stride;
+            int row_offset_pair = current_idx_pair_loc * input.stride;
+
+            double* element = (double*)input.get_data() + 2 * row_offset;
+            double* element_pair = (double*)input.get_data() + 2 * row_offset_pair;
+
+            int col_idx = 0;
+
+            // eight successive elements of the rows are processed in one step
+            for ( ; col_idx + 8 <= input.cols; col_idx = col_idx + 8) {
+
+                // extract successive elements from arrays element, element_pair and separate the real and imaginary parts
+                __m512d element_vec = _mm512_loadu_pd(element + 2*col_idx);
+                __m512d element_vec2 = _mm512_loadu_pd(element + 2*col_idx + 8);
+                __m512d tmp = _mm512_shuffle_pd(element_vec, element_vec2, 0);
+                element_vec2 = _mm512_shuffle_pd(element_vec, element_vec2, 0xff);
+                element_vec = tmp;
+
+                __m512d element_pair_vec = _mm512_loadu_pd(element_pair + 2*col_idx);
+                __m512d element_pair_vec2 = _mm512_loadu_pd(element_pair + 2*col_idx + 8);
+                tmp = _mm512_shuffle_pd(element_pair_vec, element_pair_vec2, 0);
+                element_pair_vec2 = _mm512_shuffle_pd(element_pair_vec, element_pair_vec2, 0xff);
+                element_pair_vec = tmp;
+
+                __m512d vec3 = _mm512_mul_pd(u3_1bit_00r_vec, element_vec);
+                vec3 = _mm512_fnmadd_pd(u3_1bit_00i_vec, element_vec2, vec3);
+                __m512d vec4 = _mm512_mul_pd(u3_1bit_01r_vec, element_pair_vec);
+                vec4 = _mm512_fnmadd_pd(u3_1bit_01i_vec, element_pair_vec2, vec4);
+                vec3 = _mm512_add_pd(vec3, vec4);
+                __m512d vec5 = _mm512_mul_pd(u3_1bit_00r_vec, element_vec2);
+                vec5 = _mm512_fmadd_pd(u3_1bit_00i_vec, element_vec, vec5);
+                __m512d vec6 = _mm512_mul_pd(u3_1bit_01r_vec, element_pair_vec2);
+                vec6 = _mm512_fmadd_pd(u3_1bit_01i_vec, element_pair_vec, vec6);
+                vec5 = _mm512_add_pd(vec5, vec6);
+
+                // interleave the real and imaginary parts and store the transformed elements
+                _mm512_storeu_pd(element + 2*col_idx, _mm512_shuffle_pd(vec3, vec5, 0));
+                _mm512_storeu_pd(element + 2*col_idx + 8, _mm512_shuffle_pd(vec3, vec5, 0xff));
+
+                __m512d vec7 = _mm512_mul_pd(u3_1bit_10r_vec, element_vec);
+                vec7 = _mm512_fnmadd_pd(u3_1bit_10i_vec, element_vec2, vec7);
+                __m512d vec8 = _mm512_mul_pd(u3_1bit_11r_vec, element_pair_vec);
+                vec8 = _mm512_fnmadd_pd(u3_1bit_11i_vec, element_pair_vec2, vec8);
+                vec7 = _mm512_add_pd(vec7, vec8);
+                __m512d vec9 = _mm512_mul_pd(u3_1bit_10r_vec, element_vec2);
+                vec9 = _mm512_fmadd_pd(u3_1bit_10i_vec, element_vec, vec9);
+                __m512d vec10 = _mm512_mul_pd(u3_1bit_11r_vec, element_pair_vec2);
+                vec10 = _mm512_fmadd_pd(u3_1bit_11i_vec, element_pair_vec, vec10);
+                vec9 = _mm512_add_pd(vec9, vec10);
+
+                // interleave the real and imaginary parts and store the transformed elements
+                _mm512_storeu_pd(element_pair + 2*col_idx, _mm512_shuffle_pd(vec7, vec9, 0));
+                _mm512_storeu_pd(element_pair + 2*col_idx + 8, _mm512_shuffle_pd(vec7, vec9, 0xff));
+            }
+
+            for ( ; col_idx < input.cols; col_idx++) {
+
+                int index = row_offset + col_idx;
+                int index_pair = row_offset_pair + col_idx;
+
+                QGD_Complex16 element = input[index];
+                QGD_Complex16 element_pair = input[index_pair];
+
+                QGD_Complex16 tmp1 = mult(u3_1qbit[0], element);
+                QGD_Complex16 tmp2 = mult(u3_1qbit[1], element_pair);
+
+                input[index].real = tmp1.real + tmp2.real;
+                input[index].imag = tmp1.imag + tmp2.imag;
+
+                tmp1 = mult(u3_1qbit[2], element);
+                tmp2 = mult(u3_1qbit[3], element_pair);
+
+                input[index_pair].real = tmp1.real + tmp2.real;
+                input[index_pair].imag = tmp1.imag + tmp2.imag;
+
+            }
+
+        }
+
+    });
+
+
+    if (deriv && control_qbit >= 0) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_rows(input, control_qbit, matrix_size);
+    }
+
+}
@@ -0,0 +1,290 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_small_input_AVX.cpp
+    \brief AVX2 gate kernels specialized at compile time for the qubit count and for the involved qubits. On the small unitaries of few qubits the loop bounds, the row strides and the row indices of the pairs become compile time constants, so the loops are unrolled by the compiler.
+*/
+
+
+#include "apply_kernel_to_small_input.h"
+#include "complex_AVX.h"
+#include "kernel_variant.h"
+#include <immintrin.h>
+
+
+/// @brief Type definition of the specialized single qubit kernels operating on the data of the input matrix
+typedef void (*small_kernel_fnc)( QGD_Kernel2x2& u3_1qbit, double* data );
+
+/// @brief Type definition of the specialized two-qubit kernels operating on the data of the input matrix
+typedef void (*small_two_qubit_kernel_fnc)( QGD_Kernel4x4& two_qbit_unitary, double* data );
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on a square matrix of QBIT_NUM qubits stored without padding
+@param u3_1qbit The 2x2 kernel of the gate
+@param data The data of the input matrix on which the kernel is applied. (The output is returned via this array)
+*/
+template<int QBIT_NUM, int TARGET_QBIT, int CONTROL_QBIT>
+static void QGD_TARGET_AVX2
+apply_kernel_to_small_input_AVX_spec( QGD_Kernel2x2& u3_1qbit, double* data ) {
+
+    const int matrix_size = 1 << QBIT_NUM;
+    const int index_step_target = 1 << TARGET_QBIT;
+
+    // only the row pairs where the control qubit is in state |1> are enumerated
+    const int pair_num = CONTROL_QBIT < 0 ? matrix_size >> 1 : matrix_size >> 2;
+
+    // load elements of the U3 unitary into 256bit registers (8 registers)
+    __m256d u3_1bit_00r_vec = _mm256_broadcast_sd(&u3_1qbit[0].real);
+    __m256d u3_1bit_00i_vec = _mm256_broadcast_sd(&u3_1qbit[0].imag);
+    __m256d u3_1bit_01r_vec = _mm256_broadcast_sd(&u3_1qbit[1].real);
+    __m256d u3_1bit_01i_vec = _mm256_broadcast_sd(&u3_1qbit[1].imag);
+    __m256d u3_1bit_10r_vec = _mm256_broadcast_sd(&u3_1qbit[2].real);
+    __m256d u3_1bit_10i_vec = _mm256_broadcast_sd(&u3_1qbit[2].imag);
+    __m256d u3_1bit_11r_vec = _mm256_broadcast_sd(&u3_1qbit[3].real);
+    __m256d u3_1bit_11i_vec = _mm256_broadcast_sd(&u3_1qbit[3].imag);
+
+    for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+        const int current_idx_loc = get_pair_row_index(pair_idx, TARGET_QBIT, CONTROL_QBIT);
+
+        double* element = data + 2*current_idx_loc*matrix_size;
+        double* element_pair = data + 2*(current_idx_loc | index_step_target)*matrix_size;
+
+        // two successive elements of the rows are processed in one step
+        for (int col_idx=0; col_idx<2*matrix_size; col_idx=col_idx+4) {
+
+            __m256d element_vec = _mm256_loadu_pd(element + col_idx);
+            __m256d element_pair_vec = _mm256_loadu_pd(element_pair + col_idx);
+
+            _mm256_storeu_pd(element + col_idx, complex_combination_AVX(u3_1bit_00r_vec, u3_1bit_00i_vec, element_vec, u3_1bit_01r_vec, u3_1bit_01i_vec, element_pair_vec));
+            _mm256_storeu_pd(element_pair + col_idx, complex_combination_AVX(u3_1bit_10r_vec, u3_1bit_10i_vec, element_vec, u3_1bit_11r_vec, u3_1bit_11i_vec, element_pair_vec));
+
+        }
+
+    }
+
+}
+
+
+/**
+@brief AVX2 kernel to apply a two-qubit gate kernel on a square matrix of QBIT_NUM qubits stored without padding. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param data The data of the input matrix on which the kernel is applied. (The output is returned via this array)
+*/
+template<int QBIT_NUM, int INNER_QBIT, int OUTER_QBIT>
+static void QGD_TARGET_AVX2
+apply_two_qubit_kernel_to_small_input_AVX_spec( QGD_Kernel4x4& two_qbit_unitary, double* data ) {
+
+    const int matrix_size = 1 << QBIT_NUM;
+    const int index_step_inner = 1 << INNER_QBIT;
+    const int index_step_outer = 1 << OUTER_QBIT;
+
+    const int group_num = matrix_size >> 2;
+
+    // local copy of the kernel elements
+    double kernel_real[16];
+    double kernel_imag[16];
+    for (int idx=0; idx<16; idx++) {
+        kernel_real[idx] = two_qbit_unitary[idx].real;
+        kernel_imag[idx] = two_qbit_unitary[idx].imag;
+    }
+
+    for (int group_idx=0; group_idx<group_num; group_idx++) {
+
+        // insert zero bits at the positions of the inner and outer qubits
+        const int current_idx = insert_zero_bit( insert_zero_bit(group_idx, INNER_QBIT), OUTER_QBIT );
+
+        double* rows[4];
+        rows[0] = data + 2*current_idx*matrix_size;
+        rows[1] = data + 2*(current_idx | index_step_inner)*matrix_size;
+        rows[2] = data + 2*(current_idx | index_step_outer)*matrix_size;
+        rows[3] = data + 2*(current_idx | index_step_inner | index_step_outer)*matrix_size;
+
+        // four successive elements of the rows are processed in one step with their real and imaginary parts separated into different registers
+        for (int col_idx=0; col_idx<2*matrix_size; col_idx=col_idx+8) {
+
+            __m256d element_vec = _mm256_loadu_pd( rows[0] + col_idx );
+            __m256d element_vec2 = _mm256_loadu_pd( rows[0] + col_idx + 4 );
+            __m256d element_real_vec0 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+            __m256d element_imag_vec0 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+            element_vec = _mm256_loadu_pd( rows[1] + col_idx );
+            element_vec2 = _mm256_loadu_pd( rows[1] + col_idx + 4 );
+            __m256d element_real_vec1 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+            __m256d element_imag_vec1 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+            element_vec = _mm256_loadu_pd( rows[2] + col_idx );
+            element_vec2 = _mm256_loadu_pd( rows[2] + col_idx + 4 );
+            __m256d element_real_vec2 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+            __m256d element_imag_vec2 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+            element_vec = _mm256_loadu_pd( rows[3] + col_idx );
+            element_vec2 = _mm256_loadu_pd( rows[3] + col_idx + 4 );
+            __m256d element_real_vec3 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+            __m256d element_imag_vec3 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+            for (int row_idx=0; row_idx<4; row_idx++) {
+
+                const double* kernel_real_row = kernel_real + 4*row_idx;
+                const double* kernel_imag_row = kernel_imag + 4*row_idx;
+
+                __m256d kernel_real_vec = _mm256_broadcast_sd( kernel_real_row );
+                __m256d kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row );
+                __m256d res_real_vec = _mm256_mul_pd( kernel_real_vec, element_real_vec0 );
+                __m256d res_imag_vec = _mm256_mul_pd( kernel_real_vec, element_imag_vec0 );
+                res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec0, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec0, res_imag_vec );
+
+                kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 1 );
+                kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 1 );
+                res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec1, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec1, res_imag_vec );
+                res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec1, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec1, res_imag_vec );
+
+                kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 2 );
+                kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 2 );
+                res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec2, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec2, res_imag_vec );
+                res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec2, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec2, res_imag_vec );
+
+                kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 3 );
+                kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 3 );
+                res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec3, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec3, res_imag_vec );
+                res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec3, res_real_vec );
+                res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec3, res_imag_vec );
+
+                // interleave the real and imaginary parts again and store the transformed elements
+                _mm256_storeu_pd( rows[row_idx] + col_idx, _mm256_shuffle_pd(res_real_vec, res_imag_vec, 0) );
+                _mm256_storeu_pd( rows[row_idx] + col_idx + 4, _mm256_shuffle_pd(res_real_vec, res_imag_vec, 0xf) );
+            }
+
+        }
+
+    }
+
+}
+
+
+/**
+@brief Entry of the dispatch table of the specialized single qubit kernels. Invalid combinations of the qubits are not instantiated and have a NULL entry.
+*/
+template<int QBIT_NUM, int TARGET_QBIT, int CONTROL_QBIT, bool VALID = (TARGET_QBIT < QBIT_NUM && CONTROL_QBIT < QBIT_NUM && TARGET_QBIT != CONTROL_QBIT)>
+struct Small_Kernel_Entry {
+    static small_kernel_fnc get() { return &apply_kernel_to_small_input_AVX_spec<QBIT_NUM, TARGET_QBIT, CONTROL_QBIT>; }
+};
+
+template<int QBIT_NUM, int TARGET_QBIT, int CONTROL_QBIT>
+struct Small_Kernel_Entry<QBIT_NUM, TARGET_QBIT, CONTROL_QBIT, false> {
+    static small_kernel_fnc get() { return NULL; }
+};
+
+
+/**
+@brief Entry of the dispatch table of the specialized two-qubit kernels. Invalid combinations of the qubits are not instantiated and have a NULL entry.
+*/
+template<int QBIT_NUM, int INNER_QBIT, int OUTER_QBIT, bool VALID = (INNER_QBIT < OUTER_QBIT && OUTER_QBIT < QBIT_NUM)>
+struct Small_Two_Qubit_Kernel_Entry {
+    static small_two_qubit_kernel_fnc get() { return &apply_two_qubit_kernel_to_small_input_AVX_spec<QBIT_NUM, INNER_QBIT, OUTER_QBIT>; }
+};
+
+template<int QBIT_NUM, int INNER_QBIT, int OUTER_QBIT>
+struct Small_Two_Qubit_Kernel_Entry<QBIT_NUM, INNER_QBIT, OUTER_QBIT, false> {
+    static small_two_qubit_kernel_fnc get() { return NULL; }
+};
+
+
+// rows of the dispatch tables for the possible control (-1 for no control) and outer qubits
+#define SMALL_KERNEL_CONTROLS(Q, T) { Small_Kernel_Entry<Q,T,-1>::get(), Small_Kernel_Entry<Q,T,0>::get(), Small_Kernel_Entry<Q,T,1>::get(), Small_Kernel_Entry<Q,T,2>::get(), Small_Kernel_Entry<Q,T,3>::get(), Small_Kernel_Entry<Q,T,4>::get(), Small_Kernel_Entry<Q,T,5>::get() }
+#define SMALL_KERNEL_TARGETS(Q) { SMALL_KERNEL_CONTROLS(Q,0), SMALL_KERNEL_CONTROLS(Q,1), SMALL_KERNEL_CONTROLS(Q,2), SMALL_KERNEL_CONTROLS(Q,3), SMALL_KERNEL_CONTROLS(Q,4), SMALL_KERNEL_CONTROLS(Q,5) }
+
+#define SMALL_TWO_QUBIT_KERNEL_OUTERS(Q, I) { Small_Two_Qubit_Kernel_Entry<Q,I,0>::get(), Small_Two_Qubit_Kernel_Entry<Q,I,1>::get(), Small_Two_Qubit_Kernel_Entry<Q,I,2>::get(), Small_Two_Qubit_Kernel_Entry<Q,I,3>::get(), Small_Two_Qubit_Kernel_Entry<Q,I,4>::get(), Small_Two_Qubit_Kernel_Entry<Q,I,5>::get() }
+#define SMALL_TWO_QUBIT_KERNEL_INNERS(Q) { SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,0), SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,1), SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,2), SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,3), SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,4), SMALL_TWO_QUBIT_KERNEL_OUTERS(Q,5) }
+
+
+/// dispatch table of the single qubit kernels indexed by [qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][target_qbit][control_qbit+1]
+static const small_kernel_fnc small_kernels[SMALL_KERNEL_MAX_QBIT_NUM-SMALL_KERNEL_MIN_QBIT_NUM+1][SMALL_KERNEL_MAX_QBIT_NUM][SMALL_KERNEL_MAX_QBIT_NUM+1] = {
+    SMALL_KERNEL_TARGETS(2), SMALL_KERNEL_TARGETS(3), SMALL_KERNEL_TARGETS(4), SMALL_KERNEL_TARGETS(5), SMALL_KERNEL_TARGETS(6) };
+
+/// dispatch table of the two-qubit kernels indexed by [qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][inner_qbit][outer_qbit]
+static const small_two_qubit_kernel_fnc small_two_qubit_kernels[SMALL_KERNEL_MAX_QBIT_NUM-SMALL_KERNEL_MIN_QBIT_NUM+1][SMALL_KERNEL_MAX_QBIT_NUM][SMALL_KERNEL_MAX_QBIT_NUM] = {
+    SMALL_TWO_QUBIT_KERNEL_INNERS(2), SMALL_TWO_QUBIT_KERNEL_INNERS(3), SMALL_TWO_QUBIT_KERNEL_INNERS(4), SMALL_TWO_QUBIT_KERNEL_INNERS(5), SMALL_TWO_QUBIT_KERNEL_INNERS(6) };
+
+
+/**
+@brief Call to get the number of qubits of a matrix
+@param matrix_size The number of rows in the matrix
+@return Returns with the number of qubits
+*/
+static inline int
+get_small_qbit_num( const int matrix_size ) {
+
+    int qbit_num = 0;
+    while ( (1 << qbit_num) < matrix_size ) {
+        qbit_num++;
+    }
+
+    return qbit_num;
+
+}
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on a small input matrix (using FMA instructions). The kernel specialized for the number of qubits and for the target and control qubits is looked up in a dispatch table. The input should satisfy is_small_kernel_input.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void QGD_TARGET_AVX2
+apply_kernel_to_small_input_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int qbit_num = get_small_qbit_num( matrix_size );
+
+    small_kernels[qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][target_qbit][control_qbit+1]( u3_1qbit, (double*)input.get_data() );
+
+    if (deriv && control_qbit >= 0) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_rows(input, control_qbit, matrix_size);
+    }
+
+}
+
+
+/**
+@brief AVX2 kernel to apply a two-qubit gate kernel on a small input matrix (using FMA instructions). The kernel specialized for the number of qubits and for the inner and outer qubits is looked up in a dispatch table. The input should satisfy is_small_kernel_input. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void QGD_TARGET_AVX2
+apply_two_qubit_kernel_to_small_input_AVX(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size) {
+
+    int qbit_num = get_small_qbit_num( matrix_size );
+
+    small_two_qubit_kernels[qbit_num-SMALL_KERNEL_MIN_QBIT_NUM][inner_qbit][outer_qbit]( two_qbit_unitary, (double*)input.get_data() );
+
+}
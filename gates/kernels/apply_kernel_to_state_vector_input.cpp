@@ -0,0 +1,144 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_state_vector_input.cpp
+    \brief Kernels to apply single qubit gate kernel on a state vector (an input matrix with a single column), dispatching to the instruction set chosen at runtime
+*/
+
+
+#include "apply_kernel_to_state_vector_input.h"
+#include "kernel_variant.h"
+#include "kernel_indexing.h"
+
+
+/**
+@brief Call to apply single qubit gate kernel on a state vector using the kernel variant returned by get_kernel_variant. The kernels are vectorized and parallelized across the pairs of amplitudes.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void
+apply_kernel_to_state_vector_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+#ifdef USE_AVX
+    // the AVX2 kernel is used by the AVX-512 variant as well, it needs the amplitudes to be stored contiguously
+    if ( get_kernel_variant() >= AVX2_KERNEL && input.stride == 1 ) {
+        apply_kernel_to_state_vector_input_AVX(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+        return;
+    }
+#endif
+
+    apply_kernel_to_state_vector_input_scalar(u3_1qbit, input, deriv, target_qbit, control_qbit, matrix_size);
+
+}
+
+
+/**
+@brief Scalar kernel to apply single qubit gate kernel on a state vector. (Used for state vectors with a stride differing from 1 as well.)
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void
+apply_kernel_to_state_vector_input_scalar(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the amplitude pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    kernel_parallel_for( pair_num, 2, [&](tbb::blocked_range<int> r) {
+
+        QGD_Complex16 u00 = u3_1qbit[0];
+        QGD_Complex16 u01 = u3_1qbit[1];
+        QGD_Complex16 u10 = u3_1qbit[2];
+        QGD_Complex16 u11 = u3_1qbit[3];
+
+        QGD_Complex16* data = input.get_data();
+
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+            int current_idx = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+
+            QGD_Complex16& element      = data[current_idx*input.stride];
+            QGD_Complex16& element_pair = data[(current_idx | index_step_target)*input.stride];
+
+            double res_real      = u00.real*element.real - u00.imag*element.imag + u01.real*element_pair.real - u01.imag*element_pair.imag;
+            double res_imag      = u00.real*element.imag + u00.imag*element.real + u01.real*element_pair.imag + u01.imag*element_pair.real;
+            double res_pair_real = u10.real*element.real - u10.imag*element.imag + u11.real*element_pair.real - u11.imag*element_pair.imag;
+            double res_pair_imag = u10.real*element.imag + u10.imag*element.real + u11.real*element_pair.imag + u11.imag*element_pair.real;
+
+            element.real      = res_real;
+            element.imag      = res_imag;
+            element_pair.real = res_pair_real;
+            element_pair.imag = res_pair_imag;
+
+        }
+
+    });
+
+
+    if (deriv && control_qbit >= 0) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_amplitudes(input, control_qbit, matrix_size);
+    }
+
+}
+
+
+/**
+@brief Call to set the amplitudes of a state vector to zero where the control qubit is in state |0>. (Used in the derivative kernels of the controlled gates)
+@param input The state vector (a matrix with a single column)
+@param control_qbit The index of the control qubit
+@param matrix_size The number of amplitudes in the state vector
+*/
+void
+zero_inactive_control_amplitudes(Matrix& input, const int& control_qbit, const int& matrix_size) {
+
+    // the amplitudes with the control qubit in state |0> form runs of 2^control_qbit successive amplitudes
+    int run_length = 1 << control_qbit;
+    int run_num = matrix_size >> (control_qbit+1);
+
+    kernel_parallel_for( run_num, run_length, [&](tbb::blocked_range<int> r) {
+
+        for (int run_idx=r.begin(); run_idx<r.end(); run_idx++) {
+
+            QGD_Complex16* run = input.get_data() + 2*run_idx*run_length*input.stride;
+
+            if ( input.stride == 1 ) {
+                memset( run, 0.0, run_length*sizeof(QGD_Complex16) );
+            }
+            else {
+                for (int idx=0; idx<run_length; idx++) {
+                    run[idx*input.stride].real = 0.0;
+                    run[idx*input.stride].imag = 0.0;
+                }
+            }
+
+        }
+
+    });
+
+}
@@ -0,0 +1,145 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_state_vector_input_AVX.cpp
+    \brief AVX2 kernel to apply single qubit gate kernel on a state vector (an input matrix with a single column)
+*/
+
+
+#include "apply_kernel_to_state_vector_input.h"
+#include "kernel_indexing.h"
+#include "kernel_variant.h"
+#include "complex_AVX.h"
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on a state vector stored contiguously in memory (using FMA instructions). Two pairs of amplitudes are transformed in one step.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column and stride 1). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void QGD_TARGET_AVX2
+apply_kernel_to_state_vector_input_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    int index_step_target = 1 << target_qbit;
+
+    if ( target_qbit == 0 ) {
+
+        // the two amplitudes of a pair are adjacent in memory, so a pair fits into one 256bit register
+        int pair_num = get_pair_num(matrix_size, control_qbit);
+        int control_bits = control_qbit < 0 ? 0 : 1 << control_qbit;
+        int fixed_bits = 1 | control_bits;
+
+        kernel_parallel_for( pair_num, 2, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX2 {
+
+            // new[i] = u00*v[i] + u01*v[i+1] and new[i+1] = u10*v[i] + u11*v[i+1], so the kernel is split into the lane-wise parts
+            // [u00, u11] multiplying the pair and [u01, u10] multiplying the swapped pair
+            __m256d u3_diag_r_vec = _mm256_set_pd(u3_1qbit[3].real, u3_1qbit[3].real, u3_1qbit[0].real, u3_1qbit[0].real);
+            __m256d u3_diag_i_vec = _mm256_set_pd(u3_1qbit[3].imag, u3_1qbit[3].imag, u3_1qbit[0].imag, u3_1qbit[0].imag);
+            __m256d u3_offdiag_r_vec = _mm256_set_pd(u3_1qbit[2].real, u3_1qbit[2].real, u3_1qbit[1].real, u3_1qbit[1].real);
+            __m256d u3_offdiag_i_vec = _mm256_set_pd(u3_1qbit[2].imag, u3_1qbit[2].imag, u3_1qbit[1].imag, u3_1qbit[1].imag);
+
+            // the index of the next pair is obtained by incrementing the index over the bits other than the target and control bits
+            // (cheaper than calling get_pair_row_index for every pair)
+            int current_idx = get_pair_row_index(r.begin(), 0, control_qbit);
+
+            for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+                double* element = (double*)(input.get_data() + current_idx);
+
+                __m256d element_vec = _mm256_loadu_pd(element);
+                __m256d element_swapped_vec = _mm256_permute2f128_pd(element_vec, element_vec, 1);
+
+                __m256d res_vec = complex_combination_AVX(u3_diag_r_vec, u3_diag_i_vec, element_vec, u3_offdiag_r_vec, u3_offdiag_i_vec, element_swapped_vec);
+
+                _mm256_storeu_pd(element, res_vec);
+
+                current_idx = (((current_idx | fixed_bits) + 2) & ~fixed_bits) | control_bits;
+
+            }
+
+        });
+
+    }
+    else {
+
+        // For target_qbit > 0 two successive amplitude pairs (i, i+step) and (i+1, i+1+step) are transformed in one step.
+        // When the control qubit is 0, the amplitudes i and i+1 differ in the control bit, hence all the amplitude pairs are transformed
+        // and the results are kept only in the upper lanes (control qubit in state |1>).
+        int control_loc = control_qbit == 0 ? -1 : control_qbit;
+        int pair_num = get_pair_num(matrix_size, control_loc);
+        int control_bits = control_loc < 0 ? 0 : 1 << control_loc;
+        int fixed_bits = index_step_target | control_bits;
+        bool blend = control_qbit == 0;
+
+        // the loop runs over couples of successive pairs (the number of pairs is even for target_qbit > 0)
+        kernel_parallel_for( pair_num/2, 4, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX2 {
+
+            // load elements of the U3 unitary into 256bit registers (8 registers)
+            __m256d u3_1bit_00r_vec = _mm256_broadcast_sd(&u3_1qbit[0].real);
+            __m256d u3_1bit_00i_vec = _mm256_broadcast_sd(&u3_1qbit[0].imag);
+            __m256d u3_1bit_01r_vec = _mm256_broadcast_sd(&u3_1qbit[1].real);
+            __m256d u3_1bit_01i_vec = _mm256_broadcast_sd(&u3_1qbit[1].imag);
+            __m256d u3_1bit_10r_vec = _mm256_broadcast_sd(&u3_1qbit[2].real);
+            __m256d u3_1bit_10i_vec = _mm256_broadcast_sd(&u3_1qbit[2].imag);
+            __m256d u3_1bit_11r_vec = _mm256_broadcast_sd(&u3_1qbit[3].real);
+            __m256d u3_1bit_11i_vec = _mm256_broadcast_sd(&u3_1qbit[3].imag);
+
+            // the index of the next couple of pairs is obtained by incrementing the index over the bits other than the target and control bits
+            // (cheaper than calling get_pair_row_index for every couple)
+            int current_idx = get_pair_row_index(2*r.begin(), target_qbit, control_loc);
+
+            for (int couple_idx=r.begin(); couple_idx<r.end(); couple_idx++) {
+
+                double* element = (double*)(input.get_data() + current_idx);
+                double* element_pair = element + 2*index_step_target;
+
+                __m256d element_vec = _mm256_loadu_pd(element);
+                __m256d element_pair_vec = _mm256_loadu_pd(element_pair);
+
+                // new[i] = u00*v[i] + u01*v[i+step], new[i+step] = u10*v[i] + u11*v[i+step]
+                __m256d res_vec = complex_combination_AVX(u3_1bit_00r_vec, u3_1bit_00i_vec, element_vec, u3_1bit_01r_vec, u3_1bit_01i_vec, element_pair_vec);
+                __m256d res_pair_vec = complex_combination_AVX(u3_1bit_10r_vec, u3_1bit_10i_vec, element_vec, u3_1bit_11r_vec, u3_1bit_11i_vec, element_pair_vec);
+
+                if ( blend ) {
+                    res_vec = _mm256_blend_pd(element_vec, res_vec, 0xC);
+                    res_pair_vec = _mm256_blend_pd(element_pair_vec, res_pair_vec, 0xC);
+                }
+
+                _mm256_storeu_pd(element, res_vec);
+                _mm256_storeu_pd(element_pair, res_pair_vec);
+
+                current_idx = (((current_idx | fixed_bits) + 2) & ~fixed_bits) | control_bits;
+
+            }
+
+        });
+
+    }
+
+
+    if (deriv && control_qbit >= 0) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_amplitudes(input, control_qbit, matrix_size);
+    }
+
+}
@@ -0,0 +1,352 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_sparse_kernel_to_input.cpp
+    \brief Kernels to apply diagonal and anti-diagonal single qubit gate kernels (Z, CZ, RZ and X, Y, CNOT gates) on an input matrix
+*/
+
+
+#include "apply_sparse_kernel_to_input.h"
+#include "kernel_indexing.h"
+#include <algorithm>
+#include <string.h>
+
+
+/// @brief Type definition of the classes of kernel elements that can be applied without complex multiplication
+typedef enum factor_type {ZERO_FACTOR, ONE_FACTOR, MINUS_ONE_FACTOR, PLUS_I_FACTOR, MINUS_I_FACTOR, GENERAL_FACTOR} factor_type;
+
+
+/**
+@brief Call to classify a kernel element
+@param factor The element of the kernel
+@return Returns with the class of the element
+*/
+static factor_type
+get_factor_type( const QGD_Complex16& factor ) {
+
+    if ( factor.imag == 0.0 ) {
+        if ( factor.real == 0.0 ) return ZERO_FACTOR;
+        if ( factor.real == 1.0 ) return ONE_FACTOR;
+        if ( factor.real == -1.0 ) return MINUS_ONE_FACTOR;
+    }
+    else if ( factor.real == 0.0 ) {
+        if ( factor.imag == 1.0 ) return PLUS_I_FACTOR;
+        if ( factor.imag == -1.0 ) return MINUS_I_FACTOR;
+    }
+
+    return GENERAL_FACTOR;
+
+}
+
+
+/**
+@brief Call to multiply a row of a matrix by a kernel element. The class of the element is resolved outside of the loops, so the loops are either pure data movement or a single complex multiplication.
+@param row Pointer to the first element of the row
+@param cols The number of elements in the row
+@param factor The element of the kernel
+@param type The class of the element (see get_factor_type)
+*/
+static void
+scale_row( QGD_Complex16* row, const int cols, const QGD_Complex16 factor, const factor_type type ) {
+
+    // the row is processed as an array of doubles to let the compiler vectorize the loops
+    double* data = (double*)row;
+    int data_num = 2*cols;
+
+    switch ( type ) {
+
+    case ONE_FACTOR:
+        return;
+
+    case ZERO_FACTOR:
+        memset( row, 0.0, cols*sizeof(QGD_Complex16) );
+        return;
+
+    case MINUS_ONE_FACTOR:
+        for ( int idx=0; idx<data_num; idx++ ) {
+            data[idx] = -data[idx];
+        }
+        return;
+
+    case PLUS_I_FACTOR:
+        for ( int idx=0; idx<data_num; idx+=2 ) {
+            double real = data[idx];
+            data[idx]   = -data[idx+1];
+            data[idx+1] = real;
+        }
+        return;
+
+    case MINUS_I_FACTOR:
+        for ( int idx=0; idx<data_num; idx+=2 ) {
+            double real = data[idx];
+            data[idx]   = data[idx+1];
+            data[idx+1] = -real;
+        }
+        return;
+
+    default: {
+        double factor_real = factor.real;
+        double factor_imag = factor.imag;
+        for ( int idx=0; idx<data_num; idx+=2 ) {
+            double real = data[idx];
+            double imag = data[idx+1];
+            data[idx]   = factor_real*real - factor_imag*imag;
+            data[idx+1] = factor_real*imag + factor_imag*real;
+        }
+        return;
+    }
+
+    }
+
+}
+
+
+/**
+@brief Call to swap two rows of a matrix.
+@param row Pointer to the first element of the first row
+@param row_pair Pointer to the first element of the second row
+@param cols The number of elements in the rows
+*/
+static void
+swap_rows( QGD_Complex16* row, QGD_Complex16* row_pair, const int cols ) {
+
+    // the rows are processed as arrays of doubles to let the compiler vectorize the loop
+    double* data      = (double*)row;
+    double* data_pair = (double*)row_pair;
+    int data_num = 2*cols;
+
+    for ( int idx=0; idx<data_num; idx++ ) {
+        double tmp     = data[idx];
+        data[idx]      = data_pair[idx];
+        data_pair[idx] = tmp;
+    }
+
+}
+
+
+/**
+@brief Call to multiply a single matrix element by a kernel element.
+@param element The matrix element to be rescaled
+@param factor The element of the kernel
+@param type The class of the element (see get_factor_type)
+*/
+static inline void
+scale_element( QGD_Complex16& element, const QGD_Complex16& factor, const factor_type& type ) {
+
+    double real = element.real;
+
+    switch ( type ) {
+
+    case ONE_FACTOR:
+        return;
+
+    case ZERO_FACTOR:
+        element.real = 0.0;
+        element.imag = 0.0;
+        return;
+
+    case MINUS_ONE_FACTOR:
+        element.real = -real;
+        element.imag = -element.imag;
+        return;
+
+    case PLUS_I_FACTOR:
+        element.real = -element.imag;
+        element.imag = real;
+        return;
+
+    case MINUS_I_FACTOR:
+        element.real = element.imag;
+        element.imag = -real;
+        return;
+
+    default:
+        element.real = factor.real*real - factor.imag*element.imag;
+        element.imag = factor.real*element.imag + factor.imag*real;
+        return;
+
+    }
+
+}
+
+
+/**
+@brief Call to apply a diagonal 2x2 kernel diag(u3_1qbit[0], u3_1qbit[3]) on an input matrix. The rows are only rescaled: the elements equal to 1 leave the rows untouched, elements -1 and +-i are applied by sign flips and swaps of the real and imaginary parts.
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_diagonal_kernel_to_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    factor_type type      = get_factor_type( u3_1qbit[0] );
+    factor_type type_pair = get_factor_type( u3_1qbit[3] );
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the row pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    kernel_parallel_for( pair_num, 2*input.cols, [&](tbb::blocked_range<int> r) {
+
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+
+            QGD_Complex16* row      = input.get_data() + current_idx_loc*input.stride;
+            QGD_Complex16* row_pair = input.get_data() + (current_idx_loc | index_step_target)*input.stride;
+
+            scale_row( row, input.cols, u3_1qbit[0], type );
+            scale_row( row_pair, input.cols, u3_1qbit[3], type_pair );
+
+        }
+
+    });
+
+    if ( deriv && control_qbit >= 0 ) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_rows(input, control_qbit, matrix_size);
+    }
+
+}
+
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel (u3_1qbit[1] and u3_1qbit[2] being the nonzero elements) on an input matrix. The pairs of rows are swapped and rescaled in the same way as in apply_diagonal_kernel_to_input.
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_antidiagonal_kernel_to_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size) {
+
+    factor_type type      = get_factor_type( u3_1qbit[1] );
+    factor_type type_pair = get_factor_type( u3_1qbit[2] );
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the row pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(matrix_size, control_qbit);
+
+    kernel_parallel_for( pair_num, 2*input.cols, [&](tbb::blocked_range<int> r) {
+
+        for (int pair_idx=r.begin(); pair_idx<r.end(); pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+
+            QGD_Complex16* row      = input.get_data() + current_idx_loc*input.stride;
+            QGD_Complex16* row_pair = input.get_data() + (current_idx_loc | index_step_target)*input.stride;
+
+            // the new row is u3_1qbit[1] times the pair row, the new pair row is u3_1qbit[2] times the row
+            swap_rows( row, row_pair, input.cols );
+            scale_row( row, input.cols, u3_1qbit[1], type );
+            scale_row( row_pair, input.cols, u3_1qbit[2], type_pair );
+
+        }
+
+    });
+
+    if ( deriv && control_qbit >= 0 ) {
+        // when calculating derivatives, the constant element should be zeros
+        zero_inactive_control_rows(input, control_qbit, matrix_size);
+    }
+
+}
+
+
+/**
+@brief Call to apply a diagonal 2x2 kernel on an input matrix from the right (input*K).
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void
+apply_diagonal_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit) {
+
+    factor_type type      = get_factor_type( u3_1qbit[0] );
+    factor_type type_pair = get_factor_type( u3_1qbit[3] );
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the column pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(input.cols, control_qbit);
+
+    for ( int row_idx=0; row_idx<input.rows; row_idx++) {
+
+        QGD_Complex16* row = input.get_data() + row_idx*input.stride;
+
+        for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int current_idx_pair_loc = current_idx_loc | index_step_target;
+
+            scale_element( row[current_idx_loc], u3_1qbit[0], type );
+            scale_element( row[current_idx_pair_loc], u3_1qbit[3], type_pair );
+
+        }
+
+    }
+
+}
+
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel on an input matrix from the right (input*K).
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void
+apply_antidiagonal_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit) {
+
+    // the new column is u3_1qbit[2] times the pair column, the new pair column is u3_1qbit[1] times the column
+    factor_type type      = get_factor_type( u3_1qbit[2] );
+    factor_type type_pair = get_factor_type( u3_1qbit[1] );
+
+    int index_step_target = 1 << target_qbit;
+
+    // only the column pairs where the control qubit is in state |1> are enumerated
+    int pair_num = get_pair_num(input.cols, control_qbit);
+
+    for ( int row_idx=0; row_idx<input.rows; row_idx++) {
+
+        QGD_Complex16* row = input.get_data() + row_idx*input.stride;
+
+        for (int pair_idx=0; pair_idx<pair_num; pair_idx++) {
+
+            int current_idx_loc = get_pair_row_index(pair_idx, target_qbit, control_qbit);
+            int current_idx_pair_loc = current_idx_loc | index_step_target;
+
+            std::swap( row[current_idx_loc], row[current_idx_pair_loc] );
+            scale_element( row[current_idx_loc], u3_1qbit[2], type );
+            scale_element( row[current_idx_pair_loc], u3_1qbit[1], type_pair );
+
+        }
+
+    }
+
+}
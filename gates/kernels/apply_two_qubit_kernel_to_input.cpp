@@ -0,0 +1,129 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_two_qubit_kernel_to_input.cpp
+    \brief Kernel to apply a two-qubit gate kernel (a 4x4 unitary) on an input matrix
+*/
+
+
+#include "apply_two_qubit_kernel_to_input.h"
+#include "kernel_variant.h"
+#include "kernel_indexing.h"
+
+#ifdef USE_AVX
+#include "apply_kernel_to_small_input.h"
+#endif
+
+
+/**
+@brief Kernel to apply a two-qubit gate kernel on an input matrix using the kernel variant returned by get_kernel_variant. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_two_qubit_kernel_to_input(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size) {
+
+#ifdef USE_AVX
+    // the AVX2 kernel is used by the AVX-512 variant as well
+    if ( get_kernel_variant() >= AVX2_KERNEL ) {
+        if ( is_small_kernel_input(input, matrix_size) ) {
+            apply_two_qubit_kernel_to_small_input_AVX(two_qbit_unitary, input, inner_qbit, outer_qbit, matrix_size);
+            return;
+        }
+        apply_two_qubit_kernel_to_input_AVX(two_qbit_unitary, input, inner_qbit, outer_qbit, matrix_size);
+        return;
+    }
+#endif
+
+    apply_two_qubit_kernel_to_input_scalar(two_qbit_unitary, input, inner_qbit, outer_qbit, matrix_size);
+
+}
+
+
+/**
+@brief Scalar kernel to apply a two-qubit gate kernel on an input matrix. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void
+apply_two_qubit_kernel_to_input_scalar(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size) {
+
+    int index_step_inner = 1 << inner_qbit;
+    int index_step_outer = 1 << outer_qbit;
+
+    int group_num = matrix_size >> 2;
+
+    kernel_parallel_for( group_num, 4*input.cols, [&](tbb::blocked_range<int> r) {
+
+        // local copy of the kernel elements
+        double kernel_real[16];
+        double kernel_imag[16];
+        for (int idx=0; idx<16; idx++) {
+            kernel_real[idx] = two_qbit_unitary[idx].real;
+            kernel_imag[idx] = two_qbit_unitary[idx].imag;
+        }
+
+        for (int group_idx=r.begin(); group_idx<r.end(); group_idx++) {
+
+            // insert zero bits at the positions of the inner and outer qubits
+            int current_idx = ((group_idx >> inner_qbit) << (inner_qbit+1)) | (group_idx & (index_step_inner-1));
+            current_idx = ((current_idx >> outer_qbit) << (outer_qbit+1)) | (current_idx & (index_step_outer-1));
+
+            QGD_Complex16* rows[4];
+            rows[0] = input.get_data() + current_idx*input.stride;
+            rows[1] = input.get_data() + (current_idx | index_step_inner)*input.stride;
+            rows[2] = input.get_data() + (current_idx | index_step_outer)*input.stride;
+            rows[3] = input.get_data() + (current_idx | index_step_inner | index_step_outer)*input.stride;
+
+            for ( int col_idx=0; col_idx<input.cols; col_idx++) {
+
+                double element_real[4];
+                double element_imag[4];
+                for (int idx=0; idx<4; idx++) {
+                    element_real[idx] = rows[idx][col_idx].real;
+                    element_imag[idx] = rows[idx][col_idx].imag;
+                }
+
+                for (int row_idx=0; row_idx<4; row_idx++) {
+
+                    double res_real = 0.0;
+                    double res_imag = 0.0;
+
+                    for (int idx=0; idx<4; idx++) {
+                        res_real += kernel_real[4*row_idx+idx]*element_real[idx] - kernel_imag[4*row_idx+idx]*element_imag[idx];
+                        res_imag += kernel_real[4*row_idx+idx]*element_imag[idx] + kernel_imag[4*row_idx+idx]*element_real[idx];
+                    }
+
+                    rows[row_idx][col_idx].real = res_real;
+                    rows[row_idx][col_idx].imag = res_imag;
+                }
+
+            }
+
+        }
+
+    });
+
+}
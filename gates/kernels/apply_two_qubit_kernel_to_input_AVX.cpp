@@ -0,0 +1,163 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_two_qubit_kernel_to_input_AVX.cpp
+    \brief AVX2 kernel to apply a two-qubit gate kernel (a 4x4 unitary) on an input matrix
+*/
+
+
+#include "apply_two_qubit_kernel_to_input.h"
+#include "kernel_indexing.h"
+#include "kernel_variant.h"
+#include <immintrin.h>
+
+
+/**
+@brief AVX2 kernel to apply a two-qubit gate kernel on an input matrix (using FMA instructions). The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void QGD_TARGET_AVX2
+apply_two_qubit_kernel_to_input_AVX(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size) {
+
+    int index_step_inner = 1 << inner_qbit;
+    int index_step_outer = 1 << outer_qbit;
+
+    int group_num = matrix_size >> 2;
+
+    kernel_parallel_for( group_num, 4*input.cols, [&](tbb::blocked_range<int> r) QGD_TARGET_AVX2 {
+
+        // local copy of the kernel elements
+        double kernel_real[16];
+        double kernel_imag[16];
+        for (int idx=0; idx<16; idx++) {
+            kernel_real[idx] = two_qbit_unitary[idx].real;
+            kernel_imag[idx] = two_qbit_unitary[idx].imag;
+        }
+
+        for (int group_idx=r.begin(); group_idx<r.end(); group_idx++) {
+
+            // insert zero bits at the positions of the inner and outer qubits
+            int current_idx = ((group_idx >> inner_qbit) << (inner_qbit+1)) | (group_idx & (index_step_inner-1));
+            current_idx = ((current_idx >> outer_qbit) << (outer_qbit+1)) | (current_idx & (index_step_outer-1));
+
+            QGD_Complex16* rows[4];
+            rows[0] = input.get_data() + current_idx*input.stride;
+            rows[1] = input.get_data() + (current_idx | index_step_inner)*input.stride;
+            rows[2] = input.get_data() + (current_idx | index_step_outer)*input.stride;
+            rows[3] = input.get_data() + (current_idx | index_step_inner | index_step_outer)*input.stride;
+
+            int col_start = 0;
+
+            // four successive elements of the rows are processed in one step with their real and imaginary parts separated into different registers
+            for ( ; col_start+4 <= input.cols; col_start = col_start + 4) {
+
+                __m256d element_vec = _mm256_loadu_pd( (double*)(rows[0] + col_start) );
+                __m256d element_vec2 = _mm256_loadu_pd( (double*)(rows[0] + col_start) + 4 );
+                __m256d element_real_vec0 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+                __m256d element_imag_vec0 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+                element_vec = _mm256_loadu_pd( (double*)(rows[1] + col_start) );
+                element_vec2 = _mm256_loadu_pd( (double*)(rows[1] + col_start) + 4 );
+                __m256d element_real_vec1 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+                __m256d element_imag_vec1 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+                element_vec = _mm256_loadu_pd( (double*)(rows[2] + col_start) );
+                element_vec2 = _mm256_loadu_pd( (double*)(rows[2] + col_start) + 4 );
+                __m256d element_real_vec2 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+                __m256d element_imag_vec2 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+                element_vec = _mm256_loadu_pd( (double*)(rows[3] + col_start) );
+                element_vec2 = _mm256_loadu_pd( (double*)(rows[3] + col_start) + 4 );
+                __m256d element_real_vec3 = _mm256_shuffle_pd(element_vec, element_vec2, 0);
+                __m256d element_imag_vec3 = _mm256_shuffle_pd(element_vec, element_vec2, 0xf);
+
+                for (int row_idx=0; row_idx<4; row_idx++) {
+
+                    const double* kernel_real_row = kernel_real + 4*row_idx;
+                    const double* kernel_imag_row = kernel_imag + 4*row_idx;
+
+                    __m256d kernel_real_vec = _mm256_broadcast_sd( kernel_real_row );
+                    __m256d kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row );
+                    __m256d res_real_vec = _mm256_mul_pd( kernel_real_vec, element_real_vec0 );
+                    __m256d res_imag_vec = _mm256_mul_pd( kernel_real_vec, element_imag_vec0 );
+                    res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec0, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec0, res_imag_vec );
+
+                    kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 1 );
+                    kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 1 );
+                    res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec1, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec1, res_imag_vec );
+                    res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec1, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec1, res_imag_vec );
+
+                    kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 2 );
+                    kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 2 );
+                    res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec2, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec2, res_imag_vec );
+                    res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec2, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec2, res_imag_vec );
+
+                    kernel_real_vec = _mm256_broadcast_sd( kernel_real_row + 3 );
+                    kernel_imag_vec = _mm256_broadcast_sd( kernel_imag_row + 3 );
+                    res_real_vec = _mm256_fmadd_pd( kernel_real_vec, element_real_vec3, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_real_vec, element_imag_vec3, res_imag_vec );
+                    res_real_vec = _mm256_fnmadd_pd( kernel_imag_vec, element_imag_vec3, res_real_vec );
+                    res_imag_vec = _mm256_fmadd_pd( kernel_imag_vec, element_real_vec3, res_imag_vec );
+
+                    // interleave the real and imaginary parts again and store the transformed elements
+                    _mm256_storeu_pd( (double*)(rows[row_idx] + col_start), _mm256_shuffle_pd(res_real_vec, res_imag_vec, 0) );
+                    _mm256_storeu_pd( (double*)(rows[row_idx] + col_start) + 4, _mm256_shuffle_pd(res_real_vec, res_imag_vec, 0xf) );
+                }
+
+            }
+
+            for ( int col_idx=col_start; col_idx<input.cols; col_idx++) {
+
+                double element_real[4];
+                double element_imag[4];
+                for (int idx=0; idx<4; idx++) {
+                    element_real[idx] = rows[idx][col_idx].real;
+                    element_imag[idx] = rows[idx][col_idx].imag;
+                }
+
+                for (int row_idx=0; row_idx<4; row_idx++) {
+
+                    double res_real = 0.0;
+                    double res_imag = 0.0;
+
+                    for (int idx=0; idx<4; idx++) {
+                        res_real += kernel_real[4*row_idx+idx]*element_real[idx] - kernel_imag[4*row_idx+idx]*element_imag[idx];
+                        res_imag += kernel_real[4*row_idx+idx]*element_imag[idx] + kernel_imag[4*row_idx+idx]*element_real[idx];
+                    }
+
+                    rows[row_idx][col_idx].real = res_real;
+                    rows[row_idx][col_idx].imag = res_imag;
+                }
+
+            }
+
+        }
+
+    });
+
+}
@@ -0,0 +1,61 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_from_right.h
+    \brief Kernel to apply single qubit gate kernel on an input matrix from the right (input*K)
+*/
+
+
+#ifndef apply_kernel_from_right_H
+#define apply_kernel_from_right_H
+
+#include "matrix.h"
+#include "common.h"
+
+/**
+@brief Call to apply single qubit gate kernel on an input matrix from the right (input*K) using the kernel variant returned by get_kernel_variant.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void apply_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit);
+
+
+/**
+@brief Scalar kernel to apply single qubit gate kernel on an input matrix from the right (input*K). The matrix is traversed row by row, so the pairs of columns are read from contiguous memory.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void apply_kernel_from_right_scalar(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit);
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on an input matrix from the right (input*K) (using FMA instructions). The matrix is traversed by pairs of rows, the column pairs are loaded from contiguous memory two elements at a time.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void apply_kernel_from_right_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit);
+
+
+#endif
@@ -0,0 +1,103 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_batched_input.h
+    \brief Kernels to apply single qubit gate kernels on a batch of matrices stored in structure of arrays layout
+
+    A batch of lane_num square matrices of the same size is stored in a Matrix_real of 2*matrix_size*matrix_size rows and lane_num columns:
+    row 2*(row_idx*matrix_size+col_idx) holds the real parts and the following row holds the imaginary parts of the element (row_idx, col_idx)
+    of the matrices, while the columns (lanes) correspond to the individual matrices. The batched 2x2 kernels are stored in a Matrix_real of 8 rows
+    holding the real and imaginary parts of the elements u00, u01, u10 and u11 of the kernels of the lanes. Every arithmetic operation of the kernels
+    is thus the same for all the lanes, and the lanes are processed by the vector instructions without shuffling the elements.
+*/
+
+
+#ifndef apply_kernel_to_batched_input_H
+#define apply_kernel_to_batched_input_H
+
+#include "matrix_real.h"
+
+
+/**
+@brief Call to apply the single qubit gate kernels of the lanes on a batch of matrices (K*input for each lane) using the kernel variant returned by get_kernel_variant. The batches are small, so the kernel is executed serially (the batches are processed in parallel by the caller).
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_to_batched_input(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Scalar kernel to apply the single qubit gate kernels of the lanes on a batch of matrices (K*input for each lane). The loops over the lanes are innermost, so the compiler can vectorize them.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_to_batched_input_scalar(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief AVX2 kernel to apply the single qubit gate kernels of the lanes on a batch of matrices (K*input for each lane) (using FMA instructions). Four lanes are transformed by one instruction, the remaining lanes are transformed by scalar operations.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_to_batched_input_AVX(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Call to apply the single qubit gate kernels of the lanes on a batch of matrices from the right (input*K for each lane) using the kernel variant returned by get_kernel_variant. The batches are small, so the kernel is executed serially (the batches are processed in parallel by the caller).
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_from_right_to_batched_input(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Scalar kernel to apply the single qubit gate kernels of the lanes on a batch of matrices from the right (input*K for each lane). The loops over the lanes are innermost, so the compiler can vectorize them.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_from_right_to_batched_input_scalar(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief AVX2 kernel to apply the single qubit gate kernels of the lanes on a batch of matrices from the right (input*K for each lane) (using FMA instructions). Four lanes are transformed by one instruction, the remaining lanes are transformed by scalar operations.
+@param u3_1qbit The batched 2x2 kernels of the gate
+@param input The batch of matrices on which the kernels are applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows (and columns) of the matrices in the batch
+*/
+void apply_kernel_from_right_to_batched_input_AVX(Matrix_real& u3_1qbit, Matrix_real& input, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+#endif
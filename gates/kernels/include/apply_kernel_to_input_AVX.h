@@ -33,7 +33,7 @@ along with this program.  If not, see http://www.gnu.org/licenses/.
 @param ????????
 @param ?????????
 */
-void apply_kernel_to_input_AVX_small(Matrix& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+void apply_kernel_to_input_AVX_small(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
 
 
 
@@ -42,7 +42,7 @@ void apply_kernel_to_input_AVX_small(Matrix& u3_1qbit, Matrix& input, const bool
 @param ????????
 @param ?????????
 */
-void apply_kernel_to_input_AVX(Matrix& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+void apply_kernel_to_input_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
 
 
 #endif
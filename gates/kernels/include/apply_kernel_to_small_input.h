@@ -0,0 +1,79 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_small_input.h
+    \brief Gate kernels specialized at compile time for the qubit count and for the target and control qubits, used on the small unitaries of few qubits
+*/
+
+
+#ifndef apply_kernel_to_small_input_H
+#define apply_kernel_to_small_input_H
+
+#include "matrix.h"
+#include "common.h"
+#include "kernel_indexing.h"
+
+
+/// The minimal number of qubits for which specialized kernels are compiled
+#define SMALL_KERNEL_MIN_QBIT_NUM 2
+/// The maximal number of qubits for which specialized kernels are compiled
+#define SMALL_KERNEL_MAX_QBIT_NUM 6
+
+
+/**
+@brief Call to check whether the specialized kernels can be applied on an input matrix: the input should be a square matrix of SMALL_KERNEL_MIN_QBIT_NUM to SMALL_KERNEL_MAX_QBIT_NUM qubits stored without padding, small enough to be transformed serially (see get_kernel_grain_size)
+@param input The input matrix
+@param matrix_size The number of rows in the input matrix
+@return Returns with true if the specialized kernels can be used, false otherwise
+*/
+inline bool
+is_small_kernel_input( Matrix& input, const int& matrix_size ) {
+
+    return matrix_size >= (1 << SMALL_KERNEL_MIN_QBIT_NUM) && matrix_size <= (1 << SMALL_KERNEL_MAX_QBIT_NUM) &&
+           input.rows == matrix_size && input.cols == matrix_size && input.stride == matrix_size &&
+           (long long)matrix_size*matrix_size < 2*KERNEL_PARALLEL_MIN_ELEMENTS;
+
+}
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on a small input matrix (using FMA instructions). The kernel specialized for the number of qubits and for the target and control qubits is looked up in a dispatch table. The input should satisfy is_small_kernel_input.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_kernel_to_small_input_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+
+/**
+@brief AVX2 kernel to apply a two-qubit gate kernel on a small input matrix (using FMA instructions). The kernel specialized for the number of qubits and for the inner and outer qubits is looked up in a dispatch table. The input should satisfy is_small_kernel_input. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_two_qubit_kernel_to_small_input_AVX(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size);
+
+
+#endif
@@ -0,0 +1,76 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_kernel_to_state_vector_input.h
+    \brief Kernels to apply single qubit gate kernel on a state vector (an input matrix with a single column)
+*/
+
+
+#ifndef apply_kernel_to_state_vector_input_H
+#define apply_kernel_to_state_vector_input_H
+
+#include "matrix.h"
+#include "common.h"
+
+/**
+@brief Call to apply single qubit gate kernel on a state vector using the kernel variant returned by get_kernel_variant. The kernels are vectorized and parallelized across the pairs of amplitudes.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void apply_kernel_to_state_vector_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Scalar kernel to apply single qubit gate kernel on a state vector. (Used for state vectors with a stride differing from 1 as well.)
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void apply_kernel_to_state_vector_input_scalar(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief AVX2 kernel to apply single qubit gate kernel on a state vector stored contiguously in memory (using FMA instructions). Two pairs of amplitudes are transformed in one step.
+@param u3_1qbit The 2x2 kernel of the gate
+@param input The state vector on which the kernel is applied (a matrix with a single column and stride 1). (The output is returned via this matrix)
+@param deriv Set true to set the amplitudes to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of amplitudes in the state vector
+*/
+void apply_kernel_to_state_vector_input_AVX(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Call to set the amplitudes of a state vector to zero where the control qubit is in state |0>. (Used in the derivative kernels of the controlled gates)
+@param input The state vector (a matrix with a single column)
+@param control_qbit The index of the control qubit
+@param matrix_size The number of amplitudes in the state vector
+*/
+void zero_inactive_control_amplitudes(Matrix& input, const int& control_qbit, const int& matrix_size);
+
+
+#endif
@@ -0,0 +1,75 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_sparse_kernel_to_input.h
+    \brief Kernels to apply diagonal and anti-diagonal single qubit gate kernels (Z, CZ, RZ and X, Y, CNOT gates) on an input matrix
+*/
+
+
+#ifndef apply_sparse_kernel_to_input_H
+#define apply_sparse_kernel_to_input_H
+
+#include "matrix.h"
+#include "common.h"
+
+/**
+@brief Call to apply a diagonal 2x2 kernel diag(u3_1qbit[0], u3_1qbit[3]) on an input matrix. The rows are only rescaled: the elements equal to 1 leave the rows untouched, elements -1 and +-i are applied by sign flips and swaps of the real and imaginary parts.
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_diagonal_kernel_to_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel (u3_1qbit[1] and u3_1qbit[2] being the nonzero elements) on an input matrix. The pairs of rows are swapped and rescaled in the same way as in apply_diagonal_kernel_to_input.
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param deriv Set true to set the rows to zero where the control qubit is in state |0>
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_antidiagonal_kernel_to_input(QGD_Kernel2x2& u3_1qbit, Matrix& input, const bool& deriv, const int& target_qbit, const int& control_qbit, const int& matrix_size);
+
+
+/**
+@brief Call to apply a diagonal 2x2 kernel on an input matrix from the right (input*K).
+@param u3_1qbit The 2x2 kernel of the gate (the off-diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void apply_diagonal_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit);
+
+
+/**
+@brief Call to apply an anti-diagonal 2x2 kernel on an input matrix from the right (input*K).
+@param u3_1qbit The 2x2 kernel of the gate (the diagonal elements are not referenced)
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+*/
+void apply_antidiagonal_kernel_from_right(QGD_Kernel2x2& u3_1qbit, Matrix& input, const int& target_qbit, const int& control_qbit);
+
+
+#endif
@@ -0,0 +1,66 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file apply_two_qubit_kernel_to_input.h
+    \brief Kernel to apply a two-qubit gate kernel (a 4x4 unitary) on an input matrix
+*/
+
+
+#ifndef apply_two_qubit_kernel_to_input_H
+#define apply_two_qubit_kernel_to_input_H
+
+#include "matrix.h"
+#include "common.h"
+
+/**
+@brief Kernel to apply a two-qubit gate kernel on an input matrix using the kernel variant returned by get_kernel_variant. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_two_qubit_kernel_to_input(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size);
+
+
+
+/**
+@brief Scalar kernel to apply a two-qubit gate kernel on an input matrix. The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_two_qubit_kernel_to_input_scalar(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size);
+
+
+
+/**
+@brief AVX2 kernel to apply a two-qubit gate kernel on an input matrix (using FMA instructions). The rows and columns of the kernel are labeled by the local index x_inner + 2*x_outer, where x_inner and x_outer are the states of the inner and outer qubits.
+@param two_qbit_unitary The 4x4 kernel of the two-qubit gate
+@param input The input matrix on which the kernel is applied. (The output is returned via this matrix)
+@param inner_qbit The index of the inner (lower) qubit
+@param outer_qbit The index of the outer (higher) qubit
+@param matrix_size The number of rows in the input matrix
+*/
+void apply_two_qubit_kernel_to_input_AVX(QGD_Kernel4x4& two_qbit_unitary, Matrix& input, const int& inner_qbit, const int& outer_qbit, const int& matrix_size);
+
+
+#endif
@@ -0,0 +1,59 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file complex_AVX.h
+    \brief Complex arithmetic on 256bit registers holding two complex numbers (to be used in functions compiled for AVX2 and FMA, see QGD_TARGET_AVX2)
+*/
+
+
+#ifndef complex_AVX_H
+#define complex_AVX_H
+
+#include "kernel_variant.h"
+#include <immintrin.h>
+
+
+/**
+@brief Call to calculate the linear combination a*vec + b*vec_pair of the complex numbers stored in 256bit registers (using FMA instructions)
+@param a_r The real part of the coefficient a (broadcasted)
+@param a_i The imaginary part of the coefficient a (broadcasted)
+@param vec Two complex numbers
+@param b_r The real part of the coefficient b (broadcasted)
+@param b_i The imaginary part of the coefficient b (broadcasted)
+@param vec_pair Two complex numbers
+@return Returns with the two results
+*/
+static inline __m256d QGD_TARGET_AVX2
+complex_combination_AVX( const __m256d& a_r, const __m256d& a_i, const __m256d& vec, const __m256d& b_r, const __m256d& b_i, const __m256d& vec_pair ) {
+
+    // (a+ib)*(c+id) = (ac-bd) + i(ad+bc): the products with the imaginary parts of the coefficients are taken with the swapped real and imaginary parts
+    // and are subtracted from the real lanes and added to the imaginary lanes
+    __m256d vec_swapped = _mm256_permute_pd(vec, 0x5);
+    __m256d vec_pair_swapped = _mm256_permute_pd(vec_pair, 0x5);
+
+    __m256d res_imag_part = _mm256_mul_pd(a_i, vec_swapped);
+    res_imag_part = _mm256_fmadd_pd(b_i, vec_pair_swapped, res_imag_part);
+
+    __m256d res = _mm256_fmaddsub_pd(a_r, vec, res_imag_part);
+    return _mm256_fmadd_pd(b_r, vec_pair, res);
+
+}
+
+
+#endif
@@ -0,0 +1,194 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file kernel_indexing.h
+    \brief Index helpers for the gate kernels to enumerate the row pairs transformed by a (controlled) single qubit gate
+*/
+
+
+#ifndef kernel_indexing_H
+#define kernel_indexing_H
+
+#include "matrix.h"
+#include <string.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/partitioner.h>
+#include <tbb/task_arena.h>
+
+
+#ifndef KERNEL_PARALLEL_MIN_ELEMENTS
+/// The minimal number of matrix elements transformed by one parallel task of the gate kernels (smaller tasks would not amortize the scheduling overhead)
+#define KERNEL_PARALLEL_MIN_ELEMENTS (1 << 14)
+#endif
+
+
+/**
+@brief Call to insert a zero bit into an index at the given position.
+@param idx The index
+@param bit The position of the inserted bit
+@return Returns with the index extended by a zero bit at position bit
+*/
+inline int
+insert_zero_bit( const int idx, const int bit ) {
+
+    return ((idx >> bit) << (bit+1)) | (idx & ((1 << bit)-1));
+
+}
+
+
+/**
+@brief Call to get the number of row pairs transformed by a single qubit gate. For a controlled gate only the pairs in the subspace where the control qubit is in state |1> are counted.
+@param matrix_size The number of rows in the input matrix
+@param control_qbit The index of the control qubit (-1 for no control)
+@return Returns with the number of row pairs
+*/
+inline int
+get_pair_num( const int matrix_size, const int control_qbit ) {
+
+    return control_qbit < 0 ? matrix_size >> 1 : matrix_size >> 2;
+
+}
+
+
+/**
+@brief Call to get the row index of the pair_idx-th row pair transformed by a single qubit gate. The target qubit is in state |0> in the returned row, the pair row is obtained by setting the target bit. For a controlled gate the control qubit is in state |1>, so rows with an inactive control are never visited.
+@param pair_idx The index of the row pair (0 <= pair_idx < get_pair_num(matrix_size, control_qbit))
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@return Returns with the row index
+*/
+inline int
+get_pair_row_index( const int pair_idx, const int target_qbit, const int control_qbit ) {
+
+    if ( control_qbit < 0 ) {
+        return insert_zero_bit( pair_idx, target_qbit );
+    }
+
+    // the bits are inserted starting from the lower position
+    int idx;
+    if ( control_qbit < target_qbit ) {
+        idx = insert_zero_bit( insert_zero_bit( pair_idx, control_qbit ), target_qbit );
+    }
+    else {
+        idx = insert_zero_bit( insert_zero_bit( pair_idx, target_qbit ), control_qbit );
+    }
+
+    return idx | (1 << control_qbit);
+
+}
+
+
+/**
+@brief Call to get the number of successive row pairs (as enumerated by get_pair_row_index) that are stored in consecutive rows. These blocks are bounded by the lower one of the target and control bits.
+@param target_qbit The index of the target qubit
+@param control_qbit The index of the control qubit (-1 for no control)
+@return Returns with the number of row pairs in a block
+*/
+inline int
+get_pair_block_size( const int target_qbit, const int control_qbit ) {
+
+    if ( control_qbit < 0 || target_qbit < control_qbit ) {
+        return 1 << target_qbit;
+    }
+
+    return 1 << control_qbit;
+
+}
+
+
+/**
+@brief Call to determine the grain size of the parallel loop over the row pairs (or groups of rows) of a gate kernel. The grain is a power of two, so the chunks of the loop consist of whole blocks of consecutive row pairs for any target qubit.
+@param item_num The number of iterations of the loop (the number of row pairs or groups of rows)
+@param item_size The number of matrix elements transformed in one iteration
+@return Returns with the grain size, or with item_num if the loop should be executed serially
+*/
+inline int
+get_kernel_grain_size( const int item_num, const int item_size ) {
+
+    int thread_num = tbb::this_task_arena::max_concurrency();
+
+    // small problems are processed serially
+    if ( thread_num < 2 || (long long)item_num*item_size < 2*KERNEL_PARALLEL_MIN_ELEMENTS ) {
+        return item_num;
+    }
+
+    // the tasks should be large enough to amortize the scheduling overhead
+    int grain_size = 1;
+    while ( (long long)grain_size*item_size < KERNEL_PARALLEL_MIN_ELEMENTS ) {
+        grain_size = grain_size << 1;
+    }
+
+    // but not more than about four tasks per thread are needed for load balancing
+    while ( item_num/grain_size > 4*thread_num ) {
+        grain_size = grain_size << 1;
+    }
+
+    return grain_size < item_num ? grain_size : item_num;
+
+}
+
+
+/**
+@brief Call to execute the loop of a gate kernel in parallel if the problem is large enough (see get_kernel_grain_size), otherwise serially on the calling thread.
+@param item_num The number of iterations of the loop (the number of row pairs or groups of rows)
+@param item_size The number of matrix elements transformed in one iteration
+@param body The body of the loop called with a tbb::blocked_range<int> of iterations
+*/
+template<typename Body>
+inline void
+kernel_parallel_for( const int item_num, const int item_size, const Body& body ) {
+
+    int grain_size = get_kernel_grain_size( item_num, item_size );
+
+    if ( grain_size >= item_num ) {
+        body( tbb::blocked_range<int>(0, item_num) );
+    }
+    else {
+        // the simple partitioner splits the range into power of two chunks of at most grain_size iterations
+        tbb::parallel_for( tbb::blocked_range<int>(0, item_num, grain_size), body, tbb::simple_partitioner() );
+    }
+
+}
+
+
+/**
+@brief Call to set the rows to zero where the control qubit is in state |0>. (Used in the derivative kernels of the controlled gates, where the constant part of the gate drops out)
+@param input The input matrix
+@param control_qbit The index of the control qubit
+@param matrix_size The number of rows in the input matrix
+*/
+inline void
+zero_inactive_control_rows( Matrix& input, const int control_qbit, const int matrix_size ) {
+
+    int row_num = matrix_size >> 1;
+
+    kernel_parallel_for( row_num, input.cols, [&](tbb::blocked_range<int> r) {
+
+        for ( int idx=r.begin(); idx<r.end(); idx++ ) {
+            int row_idx = insert_zero_bit( idx, control_qbit );
+            memset( input.get_data() + row_idx*input.stride, 0.0, input.cols*sizeof(QGD_Complex16) );
+        }
+
+    });
+
+}
+
+
+#endif
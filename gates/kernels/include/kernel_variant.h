@@ -0,0 +1,66 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file kernel_variant.h
+    \brief Runtime selection of the instruction set used by the gate kernels
+*/
+
+
+#ifndef kernel_variant_H
+#define kernel_variant_H
+
+
+// The kernel sources are compiled with the flags of the rest of the library, and only the kernel functions (together with the lambdas in them) are
+// compiled for the wider instruction sets by these attributes. So the inline functions and template instances shared with the other sources
+// (e.g. kernel_indexing.h or the TBB headers) never contain instructions beyond the baseline, whichever copy is kept by the linker.
+// (MSVC accepts the intrinsics without enabling the instruction set.)
+#if defined(__GNUC__) || defined(__clang__)
+/// Attribute compiling a function for the AVX kernel variant
+#define QGD_TARGET_AVX __attribute__((target("avx")))
+/// Attribute compiling a function for the AVX2 kernel variant
+#define QGD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+/// Attribute compiling a function for the AVX-512 kernel variant
+#define QGD_TARGET_AVX512 __attribute__((target("avx512f,fma")))
+#else
+#define QGD_TARGET_AVX
+#define QGD_TARGET_AVX2
+#define QGD_TARGET_AVX512
+#endif
+
+
+/// @brief Type definition of the gate kernel variants in the order of increasing vector width
+typedef enum kernel_variant_type {SCALAR_KERNEL, AVX_KERNEL, AVX2_KERNEL, AVX512_KERNEL} kernel_variant_type;
+
+
+/**
+@brief Call to get the kernel variant used to apply the gate kernels. The widest variant supported by both the build and the CPU (checked via cpuid) is chosen on the first call. The choice can be overridden by the environment variable QGD_KERNEL_VARIANT (scalar, avx, avx2 or avx512), variants not supported by the CPU are replaced by the widest supported one.
+@return Returns with the kernel variant
+*/
+kernel_variant_type get_kernel_variant();
+
+
+/**
+@brief Call to get the name of a kernel variant
+@param variant The kernel variant
+@return Returns with the name of the variant (as accepted by the environment variable QGD_KERNEL_VARIANT)
+*/
+const char* get_kernel_variant_name( kernel_variant_type variant );
+
+
+#endif
@@ -0,0 +1,170 @@
+/*
+Created on Fri Jun 26 14:13:26 2020
+Copyright (C) 2020 Peter Rakyta, Ph.D.
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+
+@author: Peter Rakyta, Ph.D.
+*/
+/*! \file kernel_variant.cpp
+    \brief Runtime selection of the instruction set used by the gate kernels
+*/
+
+
+#include "kernel_variant.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(USE_AVX) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+/**
+@brief Call to determine the widest kernel variant supported by the CPU and compiled into the library.
+@return Returns with the kernel variant
+*/
+static kernel_variant_type
+detect_kernel_variant() {
+
+#ifdef USE_AVX
+
+    bool avx = false;
+    bool avx2 = false;
+    bool avx512f = false;
+
+#ifdef _MSC_VER
+
+    int info[4];
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+
+    __cpuid(info, 1);
+    bool osxsave = (info[2] >> 27) & 1;
+    bool fma = (info[2] >> 12) & 1;
+
+    // the OS must save the YMM (and for AVX-512 the ZMM) registers on context switch
+    unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+
+    avx = osxsave && ((info[2] >> 28) & 1) && (xcr0 & 0x6) == 0x6;
+
+    if ( avx && max_leaf >= 7 ) {
+        __cpuidex(info, 7, 0);
+        avx2 = fma && ((info[1] >> 5) & 1);
+        avx512f = fma && ((info[1] >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+    }
+
+#else
+
+    __builtin_cpu_init();
+    avx = __builtin_cpu_supports("avx");
+    avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    avx512f = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("fma");
+
+#endif // _MSC_VER
+
+#ifdef USE_AVX512F
+    if ( avx512f ) {
+        return AVX512_KERNEL;
+    }
+#endif
+
+    if ( avx2 ) {
+        return AVX2_KERNEL;
+    }
+    else if ( avx ) {
+        return AVX_KERNEL;
+    }
+
+#endif // USE_AVX
+
+    return SCALAR_KERNEL;
+
+}
+
+
+/**
+@brief Call to determine the kernel variant from the CPU capabilities and the environment variable QGD_KERNEL_VARIANT.
+@return Returns with the kernel variant
+*/
+static kernel_variant_type
+select_kernel_variant() {
+
+    kernel_variant_type supported = detect_kernel_variant();
+
+    const char* requested_name = getenv("QGD_KERNEL_VARIANT");
+    if ( requested_name == NULL ) {
+        return supported;
+    }
+
+    for (int idx=SCALAR_KERNEL; idx<=AVX512_KERNEL; idx++) {
+
+        kernel_variant_type variant = (kernel_variant_type)idx;
+        if ( strcmp(requested_name, get_kernel_variant_name(variant)) != 0 ) {
+            continue;
+        }
+
+        if ( variant > supported ) {
+            std::cout << "QGD_KERNEL_VARIANT: the " << requested_name << " kernels are not supported on this machine, using the " << get_kernel_variant_name(supported) << " kernels instead." << std::endl;
+            return supported;
+        }
+
+        return variant;
+
+    }
+
+    std::cout << "QGD_KERNEL_VARIANT: unknown kernel variant " << requested_name << " (expected scalar, avx, avx2 or avx512), using the " << get_kernel_variant_name(supported) << " kernels." << std::endl;
+    return supported;
+
+}
+
+
+/**
+@brief Call to get the kernel variant used to apply the gate kernels. The widest variant supported by both the build and the CPU (checked via cpuid) is chosen on the first call. The choice can be overridden by the environment variable QGD_KERNEL_VARIANT (scalar, avx, avx2 or avx512), variants not supported by the CPU are replaced by the widest supported one.
+@return Returns with the kernel variant
+*/
+kernel_variant_type
+get_kernel_variant() {
+
+    // determined once, the initialization of a function-local static is thread safe
+    static const kernel_variant_type variant = select_kernel_variant();
+    return variant;
+
+}
+
+
+/**
+@brief Call to get the name of a kernel variant
+@param variant The kernel variant
+@return Returns with the name of the variant (as accepted by the environment variable QGD_KERNEL_VARIANT)
+*/
+const char* 
+get_kernel_variant_name( kernel_variant_type variant ) {
+
+    if ( variant == AVX512_KERNEL ) {
+        return "avx512";
+    }
+    else if ( variant == AVX2_KERNEL ) {
+        return "avx2";
+    }
+    else if ( variant == AVX_KERNEL ) {
+        return "avx";
+    }
+    else {
+        return "scalar";
+    }
+
+}
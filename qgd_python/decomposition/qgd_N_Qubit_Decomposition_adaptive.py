@@ -485,7 +485,7 @@ class qgd_N_Qubit_Decomposition_adaptive(qgd_N_Qubit_Decomposition_adaptive_Wrap
         return super(qgd_N_Qubit_Decomposition_adaptive, self).apply_Imported_Gate_Structure()
 ## 
 # @brief Call to set the optimizer used in the gate synthesis process
-# @param optimizer String indicating the optimizer. Possible values: "BFGS" ,"ADAM", "BFGS2", "ADAM_BATCHED".
+# @param optimizer String indicating the optimizer. Possible values: "BFGS" ,"ADAM", "BFGS2", "ADAM_BATCHED", "AMSGRAD", "ADAMW", "MOMENTUM_SGD".
     def set_Optimizer( self, optimizer="BFGS" ):
 
         # Set the optimizer
@@ -541,6 +541,125 @@ class qgd_N_Qubit_Decomposition_adaptive(qgd_N_Qubit_Decomposition_adaptive_Wrap
         return super(qgd_N_Qubit_Decomposition_adaptive, self).get_Trace_Offset()  
 
 
+## 
+# @brief Call to set the number of columns sampled to estimate the trace in the cost function and its gradient. The trace is estimated by column sampling: N/k times the sum of the diagonal elements of k distinct columns chosen uniformly at random. The number of sampled columns is increased during the optimization if needed, and the exact trace is used when the cost function gets below the optimization tolerance. The trace is estimated only with the first order optimizers (ADAM, AMSGRAD, ADAMW and MOMENTUM_SGD).
+# @param probe_num The number of sampled columns (0 to calculate the trace exactly)
+    def set_Trace_Estimation( self, probe_num=0 ):
+
+        # Set the number of sampled columns
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Trace_Estimation(probe_num=probe_num)  
+
+
+## 
+# @brief Call to get the number of columns sampled to estimate the trace in the cost function
+# @return Returns with the number of sampled columns
+    def get_Trace_Estimation( self ):
+
+        return super(qgd_N_Qubit_Decomposition_adaptive, self).get_Trace_Estimation()  
+
+
+## 
+# @brief Call to set whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle. The first half of the gates is applied on the unitary and the second half on the identity in parallel, which reduces the latency of a cost function evaluation on many cores. (Has effect with the cost functions depending only on the trace.)
+# @param meet_in_the_middle Set True to use the meet in the middle evaluation
+    def set_Meet_In_The_Middle( self, meet_in_the_middle=False ):
+
+        # Set the evaluation strategy of the trace
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Meet_In_The_Middle(meet_in_the_middle=meet_in_the_middle)  
+
+
+## 
+# @brief Call to get whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle
+# @return Returns with True if the meet in the middle evaluation is used
+    def get_Meet_In_The_Middle( self ):
+
+        return bool( super(qgd_N_Qubit_Decomposition_adaptive, self).get_Meet_In_The_Middle() )
+
+
+## 
+# @brief Call to set the number of optimizations started in parallel from different initial parameters when determining the initial gate structure. The available cores are shared evenly between the optimizations, and the remaining ones are cancelled once one of them reaches the optimization tolerance.
+# @param multi_start_num The number of starting points (values smaller than 2 run a single optimization)
+    def set_Multi_Start_Num( self, multi_start_num=1 ):
+
+        # Set the number of starting points
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Multi_Start_Num(multi_start_num=multi_start_num)  
+
+
+## 
+# @brief Call to get the number of optimizations started in parallel when determining the initial gate structure
+# @return Returns with the number of starting points
+    def get_Multi_Start_Num( self ):
+
+        return super(qgd_N_Qubit_Decomposition_adaptive, self).get_Multi_Start_Num()  
+
+
+## 
+# @brief Call to set whether the gate structure compression is speculative. The layer removal candidates are re-optimized concurrently in each compression iteration. In speculative compression the candidates still being optimized are cancelled once a candidate converges with a penalty no other candidate can go below (i.e. removing two layers in one step), so the number of the remaining layers is the same as when all the candidates are evaluated.
+# @param speculative_compression Set True to cancel the remaining candidates after a converged candidate reaching the lowest possible penalty
+    def set_Speculative_Compression( self, speculative_compression=False ):
+
+        # Set the compression strategy
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Speculative_Compression(speculative_compression=speculative_compression)  
+
+
+## 
+# @brief Call to get whether the gate structure compression is speculative
+# @return Returns with True if the speculative compression is used
+    def get_Speculative_Compression( self ):
+
+        return bool( super(qgd_N_Qubit_Decomposition_adaptive, self).get_Speculative_Compression() )
+
+
+## 
+# @brief Call to set whether the gate structure compression re-optimizes the layers next to a removed layer in the environment of the fixed layers before re-optimizing the whole circuit. The fixed layers are merged into the unitary, so only a few layers are applied in the cost function evaluations. The whole circuit is re-optimized only if the re-optimization of the window does not reach the optimization tolerance. (Applied for the FROBENIUS_NORM and HILBERT_SCHMIDT_TEST cost functions without trace offset.)
+# @param window_compression Set True to re-optimize the layers next to a removed layer first
+    def set_Window_Compression( self, window_compression=False ):
+
+        # Set the compression strategy
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Window_Compression(window_compression=window_compression)  
+
+
+## 
+# @brief Call to get whether the gate structure compression re-optimizes the layers next to a removed layer first
+# @return Returns with True if the layers next to a removed layer are re-optimized first
+    def get_Window_Compression( self ):
+
+        return bool( super(qgd_N_Qubit_Decomposition_adaptive, self).get_Window_Compression() )
+
+
+## 
+# @brief Call to set whether the circuit depths are warm started in the search for the initial gate structure. The gate structure of the next depth is obtained by adding new decomposing layers to the previous one, and the optimization is continued from the optimized parameters of the previous depth with close to identity parameters of the new layers.
+# @param warm_start_levels Set True to warm start the circuit depths
+    def set_Warm_Start_Levels( self, warm_start_levels=False ):
+
+        # Set the initial parameters of the circuit depths
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Warm_Start_Levels(warm_start_levels=warm_start_levels)  
+
+
+## 
+# @brief Call to get whether the circuit depths are warm started in the search for the initial gate structure
+# @return Returns with True if the circuit depths are warm started
+    def get_Warm_Start_Levels( self ):
+
+        return bool( super(qgd_N_Qubit_Decomposition_adaptive, self).get_Warm_Start_Levels() )
+
+
+## 
+# @brief Call to set the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure. The available cores are shared evenly between the depths, and the remaining optimizations are cancelled once one of the depths reaches the optimization tolerance.
+# @param concurrent_level_num The number of concurrently optimized circuit depths (values smaller than 2 optimize the depths one after the other)
+    def set_Concurrent_Level_Num( self, concurrent_level_num=1 ):
+
+        # Set the number of concurrently optimized circuit depths
+        super(qgd_N_Qubit_Decomposition_adaptive, self).set_Concurrent_Level_Num(concurrent_level_num=concurrent_level_num)  
+
+
+## 
+# @brief Call to get the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure
+# @return Returns with the number of concurrently optimized circuit depths
+    def get_Concurrent_Level_Num( self ):
+
+        return super(qgd_N_Qubit_Decomposition_adaptive, self).get_Concurrent_Level_Num()  
+
+
 ## 
 # @brief Call to evaluate the cost function.
 # @param parameters A float64 numpy array
@@ -573,6 +692,24 @@ class qgd_N_Qubit_Decomposition_adaptive(qgd_N_Qubit_Decomposition_adaptive_Wrap
 
         return cost_function, grad
 
+
+## 
+# @brief Call to estimate the cost function and the gradient components by column sampling. The trace of the transformed unitary is estimated from probe_num distinct, uniformly sampled columns (the estimator used by the optimizers when the trace estimation is turned on).
+# @param parameters A float64 numpy array
+# @param probe_num The number of the sampled columns (at most the dimension of the unitary)
+    def Optimization_Problem_Combined_Estimated( self, parameters=None, probe_num=1 ):
+
+        if parameters is None:
+            print( "Optimization_Problem_Combined_Estimated: array of input parameters is None")
+            return None
+
+        # estimate the cost function and gradients
+        cost_function, grad = super(qgd_N_Qubit_Decomposition_adaptive, self).Optimization_Problem_Combined_Estimated(parameters, probe_num)  
+
+        grad = grad.reshape( (-1,))
+
+        return cost_function, grad
+
 ## 
 # @brief Call to prepare the circuit to be exported into Qiskit format. (parameters and gates gets bound together, gate block structure is converted to plain structure).
     def Prepare_Gates_To_Export(self):
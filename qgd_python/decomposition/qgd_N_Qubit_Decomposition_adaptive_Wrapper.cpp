@@ -1454,6 +1454,74 @@ qgd_N_Qubit_Decomposition_adaptive_Wrapper_Optimization_Problem_Combined( qgd_N_
 
 
 
+/**
+@brief Wrapper function to estimate the cost function and the gradient components from randomly sampled columns of the unitary.
+@return Returns with a tuple of the estimated cost function and the gradient components of the estimate
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_Optimization_Problem_Combined_Estimated( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args)
+{
+
+
+    PyObject* parameters_arg = NULL;
+    int probe_num = 1;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTuple(args, "|Oi", &parameters_arg, &probe_num )) {
+
+        std::string err( "Unsuccessful argument parsing not ");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;      
+
+    } 
+
+    // establish memory contiguous arrays for C calculations
+    if ( PyArray_IS_C_CONTIGUOUS(parameters_arg) && PyArray_TYPE(parameters_arg) == NPY_FLOAT64 ){
+        Py_INCREF(parameters_arg);
+    }
+    else if (PyArray_TYPE(parameters_arg) == NPY_FLOAT64 ) {
+        parameters_arg = PyArray_FROM_OTF(parameters_arg, NPY_FLOAT64, NPY_ARRAY_IN_ARRAY);
+    }
+    else {
+        std::string err( "Parameters should be should be real (given in float64 format)");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    Matrix_real parameters_mtx = numpy2matrix_real( parameters_arg );
+    Matrix_real grad_mtx(parameters_mtx.size(), 1);
+    double f0;
+
+    try {
+        self->decomp->optimization_problem_combined_estimated(parameters_mtx, probe_num, &f0, grad_mtx );
+    }
+    catch (std::string err ) {
+        Py_DECREF(parameters_arg);
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+    catch (...) {
+        Py_DECREF(parameters_arg);
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+    // convert to numpy array
+    grad_mtx.set_owner(false);
+    PyObject *grad_py = matrix_real_to_numpy( grad_mtx );
+
+    Py_DECREF(parameters_arg);
+
+
+    return Py_BuildValue("(dO)", f0, grad_py);
+}
+
+
+
+
 static PyObject *
 qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Unitary( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args ) {
 
@@ -1697,6 +1765,15 @@ qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Optimizer( qgd_N_Qubit_Decomposit
     else if ( strcmp("bfgs2", optimizer_C)==0 or strcmp("BFGS2", optimizer_C)==0) {
         qgd_optimizer = BFGS2;        
     }
+    else if ( strcmp("amsgrad", optimizer_C)==0 or strcmp("AMSGRAD", optimizer_C)==0) {
+        qgd_optimizer = AMSGRAD;        
+    }
+    else if ( strcmp("adamw", optimizer_C)==0 or strcmp("ADAMW", optimizer_C)==0) {
+        qgd_optimizer = ADAMW;        
+    }
+    else if ( strcmp("momentum_sgd", optimizer_C)==0 or strcmp("MOMENTUM_SGD", optimizer_C)==0) {
+        qgd_optimizer = MOMENTUM_SGD;        
+    }
     else {
         std::cout << "Wrong optimizer. Using default: BFGS" << std::endl; 
         qgd_optimizer = BFGS;     
@@ -1894,17 +1971,109 @@ qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Trace_Offset( qgd_N_Qubit_Decompo
 
 
 
+/**
+@brief Wrapper function to set the number of columns sampled to estimate the trace in the cost function (0 to calculate the trace exactly).
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Trace_Estimation( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"probe_num", NULL};
+
+    int probe_num_arg = 0;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &probe_num_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_trace_estimation(probe_num_arg);
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
 
 /**
-@brief Call to upload the unitary to the DFE. (Has no effect for non-DFE builds)
+@brief Wrapper function to get the number of columns sampled to estimate the trace in the cost function
+@return Returns with the number of sampled columns
 */
 static PyObject *
-qgd_N_Qubit_Decomposition_adaptive_Wrapper_Upload_Umtx_to_DFE(qgd_N_Qubit_Decomposition_adaptive_Wrapper *self ) {
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Trace_Estimation( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    int probe_num = 0;
 
-#ifdef __DFE__
+    try {
+        probe_num = self->decomp->get_trace_estimation();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", probe_num);
+
+}
+
+
+
+
+/**
+@brief Wrapper function to set whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle.
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Meet_In_The_Middle( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"meet_in_the_middle", NULL};
+
+    bool meet_in_the_middle_arg = false;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|b", kwlist, &meet_in_the_middle_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
 
     try {
-        self->decomp->upload_Umtx_to_DFE();
+        self->decomp->set_meet_in_the_middle(meet_in_the_middle_arg);
     }
     catch (std::string err) {
         PyErr_SetString(PyExc_Exception, err.c_str());
@@ -1917,22 +2086,70 @@ qgd_N_Qubit_Decomposition_adaptive_Wrapper_Upload_Umtx_to_DFE(qgd_N_Qubit_Decomp
         return NULL;
     }
 
-#endif
 
     return Py_BuildValue("i", 0);
-    
+
 }
 
 
 
 /**
-@brief Call to prepare the circuit to be exported into Qiskit format. (parameters and gates gets bound together, gate block structure is converted to plain structure).
+@brief Wrapper function to get whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle
+@return Returns with 1 if the meet in the middle evaluation is used, 0 otherwise
 */
 static PyObject *
-qgd_N_Qubit_Decomposition_adaptive_Wrapper_Prepare_Gates_To_Export(qgd_N_Qubit_Decomposition_adaptive_Wrapper *self ) {
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Meet_In_The_Middle( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    bool meet_in_the_middle = false;
 
     try {
-        self->decomp->prepare_gates_to_export();
+        meet_in_the_middle = self->decomp->get_meet_in_the_middle();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", (int)meet_in_the_middle);
+
+}
+
+
+
+/**
+@brief Wrapper function to set the number of optimizations started in parallel from different initial parameters when determining the initial gate structure.
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Multi_Start_Num( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"multi_start_num", NULL};
+
+    int multi_start_num_arg = 1;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &multi_start_num_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_multi_start_num(multi_start_num_arg);
     }
     catch (std::string err) {
         PyErr_SetString(PyExc_Exception, err.c_str());
@@ -1947,54 +2164,447 @@ qgd_N_Qubit_Decomposition_adaptive_Wrapper_Prepare_Gates_To_Export(qgd_N_Qubit_D
 
 
     return Py_BuildValue("i", 0);
-    
+
 }
 
 
+
 /**
-@brief Structure containing metadata about the members of class qgd_N_Qubit_Decomposition_adaptive_Wrapper.
+@brief Wrapper function to get the number of optimizations started in parallel when determining the initial gate structure.
+@return Returns with the number of starting points
 */
-static PyMemberDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_members[] = {
-    {NULL}  /* Sentinel */
-};
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Multi_Start_Num( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    int multi_start_num = 1;
+
+    try {
+        multi_start_num = self->decomp->get_multi_start_num();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", multi_start_num);
+
+}
+
+
 
 /**
-@brief Structure containing metadata about the methods of class qgd_N_Qubit_Decomposition_adaptive_Wrapper.
+@brief Wrapper function to set whether the gate structure compression is speculative (the layer removal candidates still being optimized are cancelled once a candidate converges with the lowest possible penalty).
+@return Returns with zero on success.
 */
-static PyMethodDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_methods[] = {
-    {"Start_Decomposition", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_Start_Decomposition, METH_VARARGS | METH_KEYWORDS,
-     "Method to start the decomposition."
-    },
-    {"get_Gate_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gate_num, METH_NOARGS,
-     "Method to get the number of decomposing gates."
-    },
-    {"get_Parameter_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Parameter_Num, METH_NOARGS,
-     "Call to get the number of free parameters in the gate structure used for the decomposition"
-    },
-    {"get_Optimized_Parameters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Optimized_Parameters, METH_NOARGS,
-     "Method to get the array of optimized parameters."
-    },
-    {"set_Optimized_Parameters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Optimized_Parameters, METH_VARARGS,
-     "Method to set the initial array of optimized parameters."
-    },
-    {"get_Gate", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gate, METH_VARARGS,
-     "Method to get the i-th decomposing gates."
-    },
-    {"get_Gates", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gates, METH_NOARGS,
-     "Method to get the tuple of decomposing gates."
-    },
-    {"List_Gates", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_List_Gates, METH_NOARGS,
-     "Call to print the decomposing nitaries on standard output"
-    },
-    {"get_Num_of_Iters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Num_of_Iters, METH_NOARGS,
-     "Method to get the number of iterations."
-    },
-    {"set_Max_Layer_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Max_Layer_Num, METH_VARARGS,
-     "Call to set the maximal number of layers used in the subdecomposition of the qbit-th qubit."
-    },
-    {"set_Iteration_Loops", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Iteration_Loops, METH_VARARGS,
-     "Call to set the number of iteration loops during the subdecomposition of the qbit-th qubit."
-    },
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Speculative_Compression( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"speculative_compression", NULL};
+
+    bool speculative_compression_arg = false;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|b", kwlist, &speculative_compression_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_speculative_compression(speculative_compression_arg);
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
+
+/**
+@brief Wrapper function to get whether the gate structure compression is speculative
+@return Returns with 1 if the speculative compression is used, 0 otherwise
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Speculative_Compression( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    bool speculative_compression = false;
+
+    try {
+        speculative_compression = self->decomp->get_speculative_compression();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", (int)speculative_compression);
+
+}
+
+
+
+/**
+@brief Wrapper function to set whether the gate structure compression re-optimizes the layers next to a removed layer in the environment of the fixed layers before re-optimizing the whole circuit.
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Window_Compression( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"window_compression", NULL};
+
+    bool window_compression_arg = false;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|b", kwlist, &window_compression_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_window_compression(window_compression_arg);
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
+
+/**
+@brief Wrapper function to get whether the gate structure compression re-optimizes the layers next to a removed layer first
+@return Returns with 1 if the layers next to a removed layer are re-optimized first, 0 otherwise
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Window_Compression( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    bool window_compression = false;
+
+    try {
+        window_compression = self->decomp->get_window_compression();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", (int)window_compression);
+
+}
+
+
+
+/**
+@brief Wrapper function to set whether the circuit depths are warm started from the optimized parameters of the previous depth in the search for the initial gate structure.
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Warm_Start_Levels( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"warm_start_levels", NULL};
+
+    bool warm_start_levels_arg = false;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|b", kwlist, &warm_start_levels_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_warm_start_levels(warm_start_levels_arg);
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
+
+/**
+@brief Wrapper function to get whether the circuit depths are warm started in the search for the initial gate structure
+@return Returns with 1 if the circuit depths are warm started, 0 otherwise
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Warm_Start_Levels( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    bool warm_start_levels = false;
+
+    try {
+        warm_start_levels = self->decomp->get_warm_start_levels();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", (int)warm_start_levels);
+
+}
+
+
+
+/**
+@brief Wrapper function to set the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure.
+@return Returns with zero on success.
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Concurrent_Level_Num( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"concurrent_level_num", NULL};
+
+    int concurrent_level_num_arg = 1;
+
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &concurrent_level_num_arg)) {
+
+        std::string err( "Unsuccessful argument parsing");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;       
+ 
+    }
+   
+
+    try {
+        self->decomp->set_concurrent_level_num(concurrent_level_num_arg);
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
+
+/**
+@brief Wrapper function to get the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure
+@return Returns with the number of concurrently optimized circuit depths
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Concurrent_Level_Num( qgd_N_Qubit_Decomposition_adaptive_Wrapper *self )
+{
+   
+    int concurrent_level_num = 1;
+
+    try {
+        concurrent_level_num = self->decomp->get_concurrent_level_num();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", concurrent_level_num);
+
+}
+
+
+
+
+/**
+@brief Call to upload the unitary to the DFE. (Has no effect for non-DFE builds)
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_Upload_Umtx_to_DFE(qgd_N_Qubit_Decomposition_adaptive_Wrapper *self ) {
+
+#ifdef __DFE__
+
+    try {
+        self->decomp->upload_Umtx_to_DFE();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+#endif
+
+    return Py_BuildValue("i", 0);
+    
+}
+
+
+
+/**
+@brief Call to prepare the circuit to be exported into Qiskit format. (parameters and gates gets bound together, gate block structure is converted to plain structure).
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_adaptive_Wrapper_Prepare_Gates_To_Export(qgd_N_Qubit_Decomposition_adaptive_Wrapper *self ) {
+
+    try {
+        self->decomp->prepare_gates_to_export();
+    }
+    catch (std::string err) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        std::cout << err << std::endl;
+        return NULL;
+    }
+    catch(...) {
+        std::string err( "Invalid pointer to decomposition class");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+    
+}
+
+
+/**
+@brief Structure containing metadata about the members of class qgd_N_Qubit_Decomposition_adaptive_Wrapper.
+*/
+static PyMemberDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_members[] = {
+    {NULL}  /* Sentinel */
+};
+
+/**
+@brief Structure containing metadata about the methods of class qgd_N_Qubit_Decomposition_adaptive_Wrapper.
+*/
+static PyMethodDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_methods[] = {
+    {"Start_Decomposition", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_Start_Decomposition, METH_VARARGS | METH_KEYWORDS,
+     "Method to start the decomposition."
+    },
+    {"get_Gate_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gate_num, METH_NOARGS,
+     "Method to get the number of decomposing gates."
+    },
+    {"get_Parameter_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Parameter_Num, METH_NOARGS,
+     "Call to get the number of free parameters in the gate structure used for the decomposition"
+    },
+    {"get_Optimized_Parameters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Optimized_Parameters, METH_NOARGS,
+     "Method to get the array of optimized parameters."
+    },
+    {"set_Optimized_Parameters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Optimized_Parameters, METH_VARARGS,
+     "Method to set the initial array of optimized parameters."
+    },
+    {"get_Gate", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gate, METH_VARARGS,
+     "Method to get the i-th decomposing gates."
+    },
+    {"get_Gates", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_gates, METH_NOARGS,
+     "Method to get the tuple of decomposing gates."
+    },
+    {"List_Gates", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_List_Gates, METH_NOARGS,
+     "Call to print the decomposing nitaries on standard output"
+    },
+    {"get_Num_of_Iters", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Num_of_Iters, METH_NOARGS,
+     "Method to get the number of iterations."
+    },
+    {"set_Max_Layer_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Max_Layer_Num, METH_VARARGS,
+     "Call to set the maximal number of layers used in the subdecomposition of the qbit-th qubit."
+    },
+    {"set_Iteration_Loops", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Iteration_Loops, METH_VARARGS,
+     "Call to set the number of iteration loops during the subdecomposition of the qbit-th qubit."
+    },
     {"set_Verbose", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Verbose, METH_VARARGS,
      "Call to set the verbosity of the qgd_N_Qubit_Decomposition class."
     },
@@ -2085,6 +2695,9 @@ static PyMethodDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_methods[] = {
     {"Optimization_Problem_Combined", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_Optimization_Problem_Combined, METH_VARARGS,
      "Wrapper function to evaluate the cost function and the gradient components."
     },
+    {"Optimization_Problem_Combined_Estimated", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_Optimization_Problem_Combined_Estimated, METH_VARARGS,
+     "Wrapper function to estimate the cost function and the gradient components by column sampling: the trace of the transformed unitary is estimated from the given number of distinct, uniformly sampled columns."
+    },
     {"Upload_Umtx_to_DFE", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_Upload_Umtx_to_DFE, METH_NOARGS,
      "Call to upload the unitary to the DFE. (Has no effect for non-DFE builds)"
     },
@@ -2097,6 +2710,48 @@ static PyMethodDef qgd_N_Qubit_Decomposition_adaptive_Wrapper_methods[] = {
     {"set_Trace_Offset", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Trace_Offset, METH_VARARGS | METH_KEYWORDS,
      "Call to set the trace offset used in the cost function. In this case Tr(A) = sum_(i-offset=j) A_{ij}"
     },
+    {"get_Trace_Estimation", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Trace_Estimation, METH_NOARGS,
+     "Call to get the number of columns sampled to estimate the trace in the cost function (column sampling estimator)."
+    },
+    {"set_Trace_Estimation", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Trace_Estimation, METH_VARARGS | METH_KEYWORDS,
+     "Call to set the number of columns sampled to estimate the trace in the cost function and its gradient (0 to calculate the trace exactly). The trace is estimated by N/k times the sum of the diagonal elements of k distinct columns chosen uniformly at random."
+    },
+    {"get_Meet_In_The_Middle", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Meet_In_The_Middle, METH_NOARGS,
+     "Call to get whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle."
+    },
+    {"set_Meet_In_The_Middle", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Meet_In_The_Middle, METH_VARARGS | METH_KEYWORDS,
+     "Call to set whether the trace in the cost function is evaluated by meeting the two halves of the gate sequence in the middle (the two halves of the gates are applied in parallel)."
+    },
+    {"get_Multi_Start_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Multi_Start_Num, METH_NOARGS,
+     "Call to get the number of optimizations started in parallel from different initial parameters when determining the initial gate structure."
+    },
+    {"set_Multi_Start_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Multi_Start_Num, METH_VARARGS | METH_KEYWORDS,
+     "Call to set the number of optimizations started in parallel from different initial parameters when determining the initial gate structure (the remaining optimizations are cancelled once one of them reaches the optimization tolerance)."
+    },
+    {"get_Speculative_Compression", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Speculative_Compression, METH_NOARGS,
+     "Call to get whether the gate structure compression is speculative."
+    },
+    {"set_Speculative_Compression", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Speculative_Compression, METH_VARARGS | METH_KEYWORDS,
+     "Call to set whether the gate structure compression is speculative (the layer removal candidates still being optimized are cancelled once a candidate converges with the lowest possible penalty)."
+    },
+    {"get_Window_Compression", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Window_Compression, METH_NOARGS,
+     "Call to get whether the gate structure compression re-optimizes the layers next to a removed layer first."
+    },
+    {"set_Window_Compression", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Window_Compression, METH_VARARGS | METH_KEYWORDS,
+     "Call to set whether the gate structure compression re-optimizes the layers next to a removed layer in the environment of the fixed layers before re-optimizing the whole circuit."
+    },
+    {"get_Warm_Start_Levels", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Warm_Start_Levels, METH_NOARGS,
+     "Call to get whether the circuit depths are warm started in the search for the initial gate structure."
+    },
+    {"set_Warm_Start_Levels", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Warm_Start_Levels, METH_VARARGS | METH_KEYWORDS,
+     "Call to set whether the circuit depths are warm started from the optimized parameters of the previous depth in the search for the initial gate structure (the new layers start close to the identity)."
+    },
+    {"get_Concurrent_Level_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_get_Concurrent_Level_Num, METH_NOARGS,
+     "Call to get the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure."
+    },
+    {"set_Concurrent_Level_Num", (PyCFunction) qgd_N_Qubit_Decomposition_adaptive_Wrapper_set_Concurrent_Level_Num, METH_VARARGS | METH_KEYWORDS,
+     "Call to set the number of consecutive circuit depths optimized concurrently in the search for the initial gate structure (the remaining optimizations are cancelled once one of the depths reaches the optimization tolerance)."
+    },
     {NULL}  /* Sentinel */
 };
 
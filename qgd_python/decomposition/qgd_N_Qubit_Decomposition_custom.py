@@ -60,6 +60,20 @@ class qgd_N_Qubit_Decomposition_custom(qgd_N_Qubit_Decomposition_custom_Wrapper)
         super(qgd_N_Qubit_Decomposition_custom, self).Start_Decomposition(prepare_export=prepare_export)
 
 
+##
+# @brief Wrapper function to call the start_decomposition_batched method of C++ class N_Qubit_Decomposition_custom. The decompositions sharing the same gate structure are optimized together, with their cost functions and gradients evaluated in lockstep.
+# @param decompositions The list of the decompositions (instances of qgd_N_Qubit_Decomposition_custom with the same gate structure and a first order optimizer).
+# @param prepare_export Logical parameter. Set true to prepare the list of gates to be exported, or false otherwise.
+    @staticmethod
+    def Start_Decomposition_Batched( decompositions, prepare_export=True ):
+
+        if len(decompositions) == 0:
+            return
+
+	# call the C wrapper function
+        super(qgd_N_Qubit_Decomposition_custom, decompositions[0]).Start_Decomposition_Batched(list(decompositions), prepare_export=prepare_export)
+
+
 ##
 # @brief Call to reorder the qubits in the matrix of the gate
 # @param qbit_list The reordered list of qubits spanning the matrix
@@ -355,7 +369,7 @@ class qgd_N_Qubit_Decomposition_custom(qgd_N_Qubit_Decomposition_custom_Wrapper)
 
 ## 
 # @brief Call to set the optimizer used in the gate synthesis process
-# @param optimizer String indicating the optimizer. Possible values: "BFGS" ,"ADAM", "BFGS2".
+# @param optimizer String indicating the optimizer. Possible values: "BFGS" ,"ADAM", "BFGS2", "AMSGRAD", "ADAMW", "MOMENTUM_SGD".
 # @return An instance of the class
     def set_Optimizer( self, optimizer="BFGS" ):
 
@@ -247,6 +247,67 @@ qgd_N_Qubit_Decomposition_custom_Wrapper_Start_Decomposition(qgd_N_Qubit_Decompo
 
 
 
+/**
+@brief Wrapper function to call the start_decomposition_batched method of C++ class N_Qubit_Decomposition_custom
+@param self A pointer pointing to an instance of the class qgd_N_Qubit_Decomposition_custom_Wrapper. (The type of the decompositions in the batch is checked against it.)
+@param args A tuple of the input arguments: decompositions (list of qgd_N_Qubit_Decomposition_custom_Wrapper instances), prepare_export (bool)
+@param kwds A tuple of keywords
+*/
+static PyObject *
+qgd_N_Qubit_Decomposition_custom_Wrapper_Start_Decomposition_Batched(qgd_N_Qubit_Decomposition_custom_Wrapper *self, PyObject *args, PyObject *kwds)
+{
+
+    // The tuple of expected keywords
+    static char *kwlist[] = {(char*)"decompositions", (char*)"prepare_export", NULL};
+
+    // initiate variables for input arguments
+    PyObject* decompositions_arg = NULL;
+    bool  prepare_export = true; 
+
+    // parsing input arguments
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|b", kwlist,
+                                     &decompositions_arg, &prepare_export))
+        return Py_BuildValue("i", -1);
+
+
+    if ( !PyList_Check(decompositions_arg) ) {
+        std::string err( "The decompositions should be given as a list");
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+    std::vector<N_Qubit_Decomposition_custom*> decompositions;
+
+    for (Py_ssize_t idx=0; idx<PyList_Size(decompositions_arg); idx++) {
+
+        PyObject* decomposition_arg = PyList_GetItem(decompositions_arg, idx);
+
+        if ( !PyObject_TypeCheck(decomposition_arg, Py_TYPE(self)) ) {
+            std::string err( "The decompositions should be instances of the custom decomposition class");
+            PyErr_SetString(PyExc_Exception, err.c_str());
+            return NULL;
+        }
+
+        decompositions.push_back( ((qgd_N_Qubit_Decomposition_custom_Wrapper*)decomposition_arg)->decomp );
+
+    }
+
+
+    // starting the decompositions
+    try {
+        N_Qubit_Decomposition_custom::start_decomposition_batched(decompositions, prepare_export);
+    }
+    catch (std::string err ) {
+        PyErr_SetString(PyExc_Exception, err.c_str());
+        return NULL;
+    }
+
+
+    return Py_BuildValue("i", 0);
+
+}
+
+
 
 /**
 @brief Wrapper function to get the number of decomposing gates.
@@ -975,6 +1036,15 @@ qgd_N_Qubit_Decomposition_custom_Wrapper_set_Optimizer( qgd_N_Qubit_Decompositio
     else if ( strcmp("bfgs2", optimizer_C)==0 or strcmp("BFGS2", optimizer_C)==0) {
         qgd_optimizer = BFGS2;        
     }
+    else if ( strcmp("amsgrad", optimizer_C)==0 or strcmp("AMSGRAD", optimizer_C)==0) {
+        qgd_optimizer = AMSGRAD;        
+    }
+    else if ( strcmp("adamw", optimizer_C)==0 or strcmp("ADAMW", optimizer_C)==0) {
+        qgd_optimizer = ADAMW;        
+    }
+    else if ( strcmp("momentum_sgd", optimizer_C)==0 or strcmp("MOMENTUM_SGD", optimizer_C)==0) {
+        qgd_optimizer = MOMENTUM_SGD;        
+    }
     else {
         std::cout << "Wrong optimizer. Using default: BFGS rrrrrrrrrrrrrrr" << std::endl; 
         qgd_optimizer = BFGS;     
@@ -1045,6 +1115,9 @@ static PyMethodDef qgd_N_Qubit_Decomposition_custom_Wrapper_methods[] = {
     {"Start_Decomposition", (PyCFunction) qgd_N_Qubit_Decomposition_custom_Wrapper_Start_Decomposition, METH_VARARGS | METH_KEYWORDS,
      "Method to start the decomposition."
     },
+    {"Start_Decomposition_Batched", (PyCFunction) qgd_N_Qubit_Decomposition_custom_Wrapper_Start_Decomposition_Batched, METH_VARARGS | METH_KEYWORDS,
+     "Method to start the batched decomposition of a list of decompositions sharing the same gate structure."
+    },
     {"get_Gate_Num", (PyCFunction) qgd_N_Qubit_Decomposition_custom_Wrapper_get_gate_num, METH_NOARGS,
      "Method to get the number of decomposing gates."
     },
@@ -0,0 +1,235 @@
+# -*- coding: utf-8 -*-
+"""
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+"""
+## \file test_adaptive_decomposition.py
+## \brief Functionality test cases for the optimization strategies of the qgd_N_Qubit_Decomposition_adaptive class.
+
+
+from scipy.stats import unitary_group
+import numpy as np
+
+
+class Test_Adaptive_Decomposition:
+    """This is a test class of the optimization strategies of the adaptive decomposition of the QGD package"""
+
+    def create_unitary(self, qbit_num=3):
+        r"""
+        Create a unitary of qbit_num qubits exactly representable by a single layer of adaptive gates.
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+        np.random.seed(42)
+
+        # determine the soze of the unitary to be decomposed
+        matrix_size = int(2**qbit_num)
+
+        # a decomposing layer with random parameters defines the unitary to be decomposed
+        circuit = qgd_N_Qubit_Decomposition_adaptive( unitary_group.rvs(matrix_size, random_state=42), level_limit_max=5, level_limit_min=0 )
+        circuit.add_Adaptive_Layers()
+        circuit.add_Finalyzing_Layer_To_Gate_Structure()
+
+        parameters = np.random.rand( circuit.get_Parameter_Num() )*2*np.pi
+
+        return circuit.get_Matrix( parameters )
+
+
+    def decompose(self, configure, qbit_num=3, infidelity_max=1e-6):
+        r"""
+        Decompose the unitary of qbit_num qubits with the decomposition configured by the given function and check that the infidelity of the decomposition is below infidelity_max.
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+        Umtx = self.create_unitary( qbit_num )
+
+        # creating an instance of the C++ class
+        decomp = qgd_N_Qubit_Decomposition_adaptive( Umtx.conj().T, level_limit_max=5, level_limit_min=0 )
+
+        # setting the verbosity of the decomposition
+        decomp.set_Verbose( -1 )
+
+        configure( decomp )
+
+        # start the decomposition
+        decomp.Start_Decomposition()
+
+        # the unitary of the decomposing circuit
+        parameters = decomp.get_Optimized_Parameters()
+        decomposed_matrix = decomp.get_Matrix( parameters )
+
+        # the decomposing circuit reproduces the unitary up to a global phase
+        matrix_size = Umtx.shape[0]
+        fidelity = np.abs( np.trace( decomposed_matrix.conj().T @ Umtx ) )/matrix_size
+
+        print( "Decomposition with ", decomp.get_Gate_Num(), " layers, infidelity: ", 1-fidelity )
+        assert( 1-fidelity < infidelity_max )
+
+        return decomp
+
+
+    def test_BFGS(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 3-qubit unitary with the limited-memory BFGS optimizers
+
+        """
+
+        for optimizer in ["BFGS", "BFGS2"]:
+            self.decompose( lambda decomp: decomp.set_Optimizer( optimizer ) )
+
+
+    def test_first_order_optimizers(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 2-qubit unitary with the first order optimizers. (They converge slower than the BFGS optimizers, so the infidelity is checked against a looser bound.)
+
+        """
+
+        for optimizer in ["ADAM", "AMSGRAD", "ADAMW", "MOMENTUM_SGD", "ADAM_BATCHED"]:
+            self.decompose( lambda decomp: decomp.set_Optimizer( optimizer ), qbit_num=2, infidelity_max=1e-2 )
+
+
+    def test_multi_start(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 3-qubit unitary with several concurrent starting points of the initial optimization
+
+        """
+
+        def configure( decomp ):
+            decomp.set_Multi_Start_Num( 4 )
+            assert( decomp.get_Multi_Start_Num() == 4 )
+
+        self.decompose( configure )
+
+    def test_speculative_compression(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 3-qubit unitary with the speculative compression of the gate structure
+
+        """
+
+        def configure( decomp ):
+            decomp.set_Speculative_Compression( True )
+            assert( decomp.get_Speculative_Compression() )
+
+        self.decompose( configure )
+
+    def test_warm_start_levels(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 3-qubit unitary with the circuit depths continued from the optimized shallower circuits
+
+        """
+
+        def configure( decomp ):
+            decomp.set_Warm_Start_Levels( True )
+            assert( decomp.get_Warm_Start_Levels() )
+
+        self.decompose( configure )
+
+    def test_concurrent_levels(self):
+        r"""
+        This method is called by pytest.
+        Test to decompose a 3-qubit unitary with several circuit depths optimized concurrently
+
+        """
+
+        def configure( decomp ):
+            decomp.set_Concurrent_Level_Num( 3 )
+            assert( decomp.get_Concurrent_Level_Num() == 3 )
+
+        self.decompose( configure )
+
+
+    def test_trace_estimation(self):
+        r"""
+        This method is called by pytest.
+        Test to compare the cost function and the gradient estimated by column sampling with the exact ones
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+        Umtx = self.create_unitary()
+
+        # creating an instance of the C++ class
+        decomp = qgd_N_Qubit_Decomposition_adaptive( Umtx.conj().T, level_limit_max=5, level_limit_min=0 )
+        decomp.set_Verbose( -1 )
+        decomp.add_Adaptive_Layers()
+        decomp.add_Finalyzing_Layer_To_Gate_Structure()
+
+        parameters = np.random.rand( decomp.get_Parameter_Num() )*2*np.pi
+
+        cost_function, grad = decomp.Optimization_Problem_Combined( parameters )
+
+        # sampling all the columns gives the exact cost function and gradient
+        matrix_size = Umtx.shape[0]
+        cost_function_estimated, grad_estimated = decomp.Optimization_Problem_Combined_Estimated( parameters, matrix_size )
+
+        assert( np.abs( cost_function_estimated - cost_function ) < 1e-10 )
+        assert( np.linalg.norm( grad_estimated - grad ) < 1e-10 )
+
+        # the estimate from fewer columns is unbiased: its mean over many samples agrees with the exact values within the statistical error
+        sample_num = 2000
+        cost_function_samples = np.zeros( (sample_num,) )
+        grad_samples = np.zeros( (sample_num, grad.size) )
+        for idx in range( sample_num ):
+            cost_function_samples[idx], grad_samples[idx,:] = decomp.Optimization_Problem_Combined_Estimated( parameters, matrix_size//2 )
+
+        cost_function_error = np.std( cost_function_samples )/np.sqrt( sample_num )
+        grad_error = np.std( grad_samples, axis=0 )/np.sqrt( sample_num )
+
+        print( "Estimated cost function: ", np.mean( cost_function_samples ), " exact: ", cost_function )
+        assert( np.abs( np.mean( cost_function_samples ) - cost_function ) < 5*cost_function_error )
+        assert( np.all( np.abs( np.mean( grad_samples, axis=0 ) - grad ) < 5*grad_error + 1e-12 ) )
+
+        # decompose with the estimated cost function
+        self.decompose( lambda decomp: decomp.set_Trace_Estimation( 2 ) )
+
+    def test_meet_in_the_middle(self):
+        r"""
+        This method is called by pytest.
+        Test to compare the cost function evaluated by meeting the two halves of the circuit in the middle with the direct evaluation
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+        Umtx = self.create_unitary()
+
+        # creating an instance of the C++ class
+        decomp = qgd_N_Qubit_Decomposition_adaptive( Umtx.conj().T, level_limit_max=5, level_limit_min=0 )
+        decomp.set_Verbose( -1 )
+        decomp.add_Adaptive_Layers()
+        decomp.add_Finalyzing_Layer_To_Gate_Structure()
+
+        parameters = np.random.rand( decomp.get_Parameter_Num() )*2*np.pi
+
+        cost_function = decomp.Optimization_Problem( parameters )
+
+        decomp.set_Meet_In_The_Middle( True )
+        assert( decomp.get_Meet_In_The_Middle() )
+
+        cost_function_meet_in_the_middle = decomp.Optimization_Problem( parameters )
+
+        print( "Cost function met in the middle: ", cost_function_meet_in_the_middle, " direct: ", cost_function )
+        assert( np.abs( cost_function_meet_in_the_middle - cost_function ) < 1e-10 )
+
+        # decompose with the cost function evaluated in the middle
+        self.decompose( lambda decomp: decomp.set_Meet_In_The_Middle( True ) )
@@ -148,3 +148,61 @@ class Test_Decomposition:
 
 
 
+
+    def test_N_Qubit_Decomposition_custom_batched(self):
+        r"""
+        This method is called by pytest. 
+        Test to decompose a batch of 2-qubit unitaries sharing the same custom gate structure in lockstep
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_custom import qgd_N_Qubit_Decomposition_custom
+        from qgd_python.gates.qgd_Gates_Block import qgd_Gates_Block
+
+        # the number of qubits spanning the unitaries
+        qbit_num = 2
+
+        # determine the soze of the unitaries to be decomposed
+        matrix_size = int(2**qbit_num)
+
+        # the gate structure shared by the decompositions
+        gate_structure = qgd_Gates_Block( qbit_num )
+        for layer_idx in range(2):
+            gate_structure.add_U3( 0, True, True, True )
+            gate_structure.add_U3( 1, True, True, True )
+            gate_structure.add_CNOT( 1, 0 )
+        gate_structure.add_U3( 0, True, True, True )
+        gate_structure.add_U3( 1, True, True, True )
+
+        # the number of the unitaries in the batch (not a multiple of the SIMD width, so partially filled batches are tested as well)
+        problem_num = 7
+
+        # creating unitaries that can be decomposed exactly by the gate structure
+        Umtx_list = []
+        decompositions = []
+        for idx in range(problem_num):
+
+            parameters = np.random.rand( 18 )*2*np.pi
+            Umtx = gate_structure.get_Matrix( parameters ).conj().T
+            Umtx_list.append( Umtx )
+
+            decomp = qgd_N_Qubit_Decomposition_custom( Umtx, initial_guess="random" )
+            decomp.set_Gate_Structure( gate_structure )
+            decomp.set_Optimizer( "ADAM" )
+            decomp.set_Verbose( 0 )
+            decompositions.append( decomp )
+
+        # start the decompositions in lockstep
+        qgd_N_Qubit_Decomposition_custom.Start_Decomposition_Batched( decompositions )
+
+        for idx in range(problem_num):
+
+            # the decomposing gates should transform the unitary into the identity (up to a global phase)
+            parameters = decompositions[idx].get_Optimized_Parameters()
+            product_matrix = np.dot( gate_structure.get_Matrix( parameters ), Umtx_list[idx] )
+            decomposition_error = 1.0 - np.abs(np.trace(product_matrix))/matrix_size
+
+            print('The error of the decomposition ' + str(idx) + ' is ' + str(decomposition_error))
+
+            # the first order optimizers converge slowly close to the solution
+            assert( decomposition_error < 1e-2 )
@@ -0,0 +1,79 @@
+# -*- coding: utf-8 -*-
+"""
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+"""
+## \file test_gradient.py
+## \brief Functionality test cases for the gradient of the cost functions provided by the adjoint method.
+
+
+from scipy.stats import unitary_group
+import numpy as np
+
+
+class Test_Gradient:
+    """This is a test class of the gradient of the cost functions of the QGD package"""
+
+    def test_adjoint_gradient_vs_finite_differences(self):
+        r"""
+        This method is called by pytest. 
+        Test to compare the gradient of the cost functions with the central finite differences of the cost functions
+
+        """
+
+        from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+        np.random.seed(42)
+
+        # the number of qubits spanning the unitary
+        qbit_num = 3
+
+        # determine the soze of the unitary to be decomposed
+        matrix_size = int(2**qbit_num)
+   
+        # creating a random unitary to be decomposed
+        Umtx = unitary_group.rvs(matrix_size, random_state=42)
+
+        # creating an instance of the C++ class
+        decomp = qgd_N_Qubit_Decomposition_adaptive( Umtx.conj().T, level_limit_max=5, level_limit_min=0 )
+
+        # adding decomposing layers to the gate structure
+        decomp.add_Adaptive_Layers()
+        decomp.add_Finalyzing_Layer_To_Gate_Structure()
+
+        parameter_num = decomp.get_Parameter_Num()
+        parameters = np.random.rand( parameter_num )*2*np.pi
+
+        # step size of the finite differences
+        epsilon = 1e-6
+
+        for cost_function_variant in range(6):
+
+            decomp.set_Cost_Function_Variant( cost_function_variant )
+
+            cost_function, grad = decomp.Optimization_Problem_Combined( parameters )
+
+            assert( abs( cost_function - decomp.Optimization_Problem( parameters ) ) < 1e-10 )
+
+            grad_fd = np.zeros( parameter_num )
+            for idx in range( parameter_num ):
+                parameters_plus = parameters.copy()
+                parameters_plus[idx] = parameters_plus[idx] + epsilon
+                parameters_minus = parameters.copy()
+                parameters_minus[idx] = parameters_minus[idx] - epsilon
+
+                grad_fd[idx] = ( decomp.Optimization_Problem_Combined( parameters_plus )[0] - decomp.Optimization_Problem_Combined( parameters_minus )[0] )/(2*epsilon)
+
+            print( "cost function variant ", cost_function_variant, ": max abs difference of the gradients ", np.max( np.abs( grad - grad_fd ) ) )
+            assert( np.max( np.abs( grad - grad_fd ) ) < 1e-6 )
+
@@ -0,0 +1,152 @@
+# -*- coding: utf-8 -*-
+"""
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see http://www.gnu.org/licenses/.
+"""
+## \file test_kernel_variants.py
+## \brief Test cases comparing the results of the gate kernel variants selected by the environment variable QGD_KERNEL_VARIANT.
+
+
+import os
+import sys
+import subprocess
+import tempfile
+import numpy as np
+
+
+def apply_gates( filename ):
+    r"""
+    Apply the gates on test matrices with the kernel variant selected for the current process and save the results into a numpy file.
+
+    """
+
+    from scipy.stats import unitary_group
+    from qgd_python.gates.qgd_U3 import qgd_U3
+    from qgd_python.gates.qgd_CNOT import qgd_CNOT
+    from qgd_python.gates.qgd_Gates_Block import qgd_Gates_Block
+    from qgd_python.decomposition.qgd_N_Qubit_Decomposition_adaptive import qgd_N_Qubit_Decomposition_adaptive
+
+    np.random.seed(42)
+
+    results = {}
+
+    # single and two-qubit gates on matrices (small matrices use the specialized kernels) and on state vectors
+    for qbit_num in range(1,9):
+
+        matrix_size = int(2**qbit_num)
+
+        test_matrix = unitary_group.rvs(matrix_size, random_state=qbit_num) if qbit_num > 1 else np.identity(2, dtype=complex)
+        test_state = np.ascontiguousarray( test_matrix[:,0:1] )
+
+        parameters = np.random.rand( 3 )*2*np.pi
+
+        for target_qbit in range(qbit_num):
+
+            U3 = qgd_U3( qbit_num, target_qbit, True, True, True )
+
+            matrix = test_matrix.copy()
+            U3.apply_to( parameters, matrix )
+            results["U3_%d_%d" % (qbit_num, target_qbit)] = matrix
+
+            state = test_state.copy()
+            U3.apply_to( parameters, state )
+            results["U3_state_%d_%d" % (qbit_num, target_qbit)] = state
+
+            for control_qbit in range(qbit_num):
+                if control_qbit == target_qbit:
+                    continue
+
+                CNOT = qgd_CNOT( qbit_num, target_qbit, control_qbit )
+
+                matrix = test_matrix.copy()
+                CNOT.apply_to( matrix )
+                results["CNOT_%d_%d_%d" % (qbit_num, target_qbit, control_qbit)] = matrix
+
+
+    # gate blocks (fused two-qubit kernels)
+    for qbit_num in range(2,8):
+
+        block = qgd_Gates_Block( qbit_num )
+        parameter_num = 0
+        for layer in range(3):
+            for qbit in range(qbit_num-1):
+                block.add_U3( qbit, True, True, True )
+                block.add_U3( qbit+1, True, True, True )
+                block.add_CNOT( qbit+1, qbit )
+                block.add_RY( qbit )
+                block.add_RZ( qbit+1 )
+                block.add_CZ( qbit, qbit+1 )
+                block.add_CH( qbit+1, qbit )
+                parameter_num = parameter_num + 8
+
+        parameters = np.random.rand( parameter_num )*2*np.pi
+        results["Gates_Block_%d" % qbit_num] = block.get_Matrix( parameters )
+
+
+    # cost functions and gradients of the decomposition (derivative kernels and kernels applied from the right)
+    for qbit_num in [3,5]:
+
+        matrix_size = int(2**qbit_num)
+
+        decomp = qgd_N_Qubit_Decomposition_adaptive( unitary_group.rvs(matrix_size, random_state=42), level_limit_max=5, level_limit_min=0 )
+        decomp.add_Adaptive_Layers()
+        decomp.add_Adaptive_Layers()
+        decomp.add_Finalyzing_Layer_To_Gate_Structure()
+
+        parameters = np.random.rand( decomp.get_Parameter_Num() )*2*np.pi
+
+        cost_function, grad = decomp.Optimization_Problem_Combined( parameters )
+        results["cost_function_%d" % qbit_num] = np.array( [cost_function] )
+        results["grad_%d" % qbit_num] = grad
+
+    np.savez( filename, **results )
+
+
+
+class Test_Kernel_Variants:
+    """This is a test class of the gate kernel variants of the QGD package"""
+
+    def test_kernel_variants(self):
+        r"""
+        This method is called by pytest.
+        Test to compare the results of the gates applied with the scalar, AVX and AVX2 kernels. The kernel variant is chosen once per process, so the
+        gates are applied in subprocesses. (Variants not supported by the CPU fall back to the widest supported one.)
+
+        """
+
+        env = os.environ.copy()
+        env["PYTHONPATH"] = os.pathsep.join( sys.path )
+
+        results = {}
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+
+            for variant in ["scalar", "avx", "avx2", "avx512"]:
+
+                filename = os.path.join( tmpdir, variant + ".npz" )
+                env["QGD_KERNEL_VARIANT"] = variant
+
+                subprocess.run( [sys.executable, "-c", "from qgd_python.gates.test.test_kernel_variants import apply_gates; apply_gates(%r)" % filename], env=env, check=True )
+
+                with np.load( filename ) as data:
+                    results[variant] = { key: data[key] for key in data.files }
+
+
+        reference = results["scalar"]
+
+        for variant in ["avx", "avx2", "avx512"]:
+            for key in reference:
+                error = np.max( np.abs( results[variant][key] - reference[key] ) )
+                print( variant, key, error )
+                assert( error < 1e-10 )
+